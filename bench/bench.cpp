@@ -0,0 +1,342 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "bench/bench.h"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <iostream>
+#include <iterator>
+#include <numeric>
+#include <sstream>
+
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    /** Escape @p s for use as a JSON string */
+    std::string
+    json_string(std::string const& s)
+    {
+        std::string result{"\""};
+        for (char c: s)
+        {
+            switch (c)
+            {
+            case '"':  result += "\\\""; break;
+            case '\\': result += "\\\\"; break;
+            case '\n': result += "\\n"; break;
+            default:   result += c; break;
+            }
+        }
+        return result + "\"";
+    }
+
+    /** Scale @p rate to something readable with an SI prefix */
+    std::string
+    si_rate(double rate, char const* unit)
+    {
+        if (rate <= 0.0)
+        {
+            return "-";
+        }
+
+        static char const* const prefixes[] = { "", "k", "M", "G", "T" };
+        std::size_t prefix = 0;
+        while (rate >= 1000.0 && prefix < std::size(prefixes) - 1)
+        {
+            rate /= 1000.0;
+            ++prefix;
+        }
+        std::ostringstream ostr;
+        ostr << std::fixed << std::setprecision(2) << rate << " " << prefixes[prefix] << unit << "/s";
+        return ostr.str();
+    }
+
+    constexpr std::size_t counter_count = static_cast<std::size_t>(PerfCounters::Event::Count_);
+
+    std::optional<double> const&
+    counter(BenchResult const& result, PerfCounters::Event event)
+    {
+        return result.counters_[static_cast<std::size_t>(event)];
+    }
+
+    /** Format an optional count, or "-" if there isn't one */
+    std::string
+    optional_count(std::optional<double> const& count, int precision)
+    {
+        if (!count)
+        {
+            return "-";
+        }
+        std::ostringstream ostr;
+        ostr << std::fixed << std::setprecision(precision) << *count;
+        return ostr.str();
+    }
+} // anonymous namespace
+
+
+std::optional<double> BenchResult::
+ipc() const
+{
+    auto const& cycles = counter(*this, PerfCounters::Event::Cycles);
+    auto const& instructions = counter(*this, PerfCounters::Event::Instructions);
+    if (!cycles || !instructions || *cycles <= 0.0)
+    {
+        return std::nullopt;
+    }
+    return *instructions / *cycles;
+}
+
+
+double BenchResult::
+bytes_per_second() const
+{
+    return median_ns_ > 0.0 ? bytes_ * 1e9 / median_ns_ : 0.0;
+}
+
+
+double BenchResult::
+items_per_second() const
+{
+    return median_ns_ > 0.0 ? items_ * 1e9 / median_ns_ : 0.0;
+}
+
+
+BenchHarness::
+BenchHarness(Options const& options)
+: options_{options}
+{
+    options_.repetitions_ = std::max<std::size_t>(options_.repetitions_, 1);
+    if (options_.counters_)
+    {
+        counters_ = std::make_unique<PerfCounters>();
+        if (!counters_->available())
+        {
+            std::cerr << "hardware counters unavailable: " << counters_->unavailable_reason() << "\n";
+        }
+    }
+}
+
+
+BenchHarness::
+~BenchHarness() = default;
+
+
+bool BenchHarness::
+selected(std::string const& name) const
+{
+    return options_.filter_.empty() || name.find(options_.filter_) != std::string::npos;
+}
+
+
+std::vector<BenchResult> const& BenchHarness::
+results() const
+{
+    return results_;
+}
+
+
+void BenchHarness::
+measure(std::string const& name, std::uint64_t bytes, std::uint64_t items, bool count_events, Body const& body)
+{
+    auto time = [&body](std::uint64_t iterations) {
+        auto start = Clock::now();
+        body(iterations);
+        return Clock::now() - start;
+    };
+
+    // Calibrate.
+    std::uint64_t iterations = 1;
+    while (time(iterations) < options_.min_repetition_time_ && iterations < (std::uint64_t(1) << 40))
+    {
+        iterations *= 2;
+    }
+
+    for (std::size_t i = 0; i < options_.warmup_; ++i)
+    {
+        time(iterations);
+    }
+
+    std::vector<double> samples;
+    samples.reserve(options_.repetitions_);
+    PerfCounters::Counts counts;
+    PerfCounters* counters = count_events ? counters_.get() : nullptr;
+    for (std::size_t i = 0; i < options_.repetitions_; ++i)
+    {
+        if (counters)
+        {
+            counters->start();
+        }
+        auto elapsed = std::chrono::duration_cast<std::chrono::duration<double, std::nano>>(time(iterations));
+        if (counters)
+        {
+            PerfCounters::Counts repetition_counts = counters->stop();
+            for (std::size_t c = 0; c < counter_count; ++c)
+            {
+                if (repetition_counts[c])
+                {
+                    counts[c] = counts[c].value_or(0.0) + *repetition_counts[c];
+                }
+            }
+        }
+        samples.push_back(elapsed.count() / iterations);
+    }
+    std::sort(samples.begin(), samples.end());
+
+    std::size_t n = samples.size();
+    BenchResult result;
+    result.name_ = name;
+    result.repetitions_ = n;
+    result.iterations_ = iterations;
+    result.median_ns_ = n % 2 ? samples[n / 2] : (samples[n / 2 - 1] + samples[n / 2]) / 2.0;
+    result.p99_ns_ = samples[static_cast<std::size_t>(std::ceil(0.99 * n)) - 1];
+    result.min_ns_ = samples.front();
+    result.mean_ns_ = std::accumulate(samples.begin(), samples.end(), 0.0) / n;
+    result.bytes_ = bytes;
+    result.items_ = items;
+    for (std::size_t c = 0; c < counter_count; ++c)
+    {
+        if (counts[c])
+        {
+            result.counters_[c] = *counts[c] / (static_cast<double>(iterations) * n);
+        }
+    }
+    results_.push_back(result);
+}
+
+
+void BenchHarness::
+report(std::ostream& ostr, Format format) const
+{
+    switch (format)
+    {
+    case Format::Text:
+    {
+        std::size_t width = 9;
+        for (auto const& result: results_)
+        {
+            width = std::max(width, result.name_.size());
+        }
+        ostr << std::left << std::setw(width) << "benchmark" << std::right
+             << std::setw(14) << "median ns" << std::setw(14) << "p99 ns"
+             << std::setw(16) << "bytes" << std::setw(16) << "items"
+             << std::setw(12) << "iterations";
+        if (counters_)
+        {
+            ostr << std::setw(14) << "cycles" << std::setw(8) << "IPC"
+                 << std::setw(14) << "cache misses" << std::setw(14) << "branch misses";
+        }
+        ostr << "\n";
+        for (auto const& result: results_)
+        {
+            ostr << std::left << std::setw(width) << result.name_ << std::right
+                 << std::fixed << std::setprecision(1)
+                 << std::setw(14) << result.median_ns_ << std::setw(14) << result.p99_ns_
+                 << std::setw(16) << si_rate(result.bytes_per_second(), "B")
+                 << std::setw(16) << si_rate(result.items_per_second(), "")
+                 << std::setw(12) << result.iterations_;
+            if (counters_)
+            {
+                ostr << std::setw(14) << optional_count(counter(result, PerfCounters::Event::Cycles), 1)
+                     << std::setw(8) << optional_count(result.ipc(), 2)
+                     << std::setw(14) << optional_count(counter(result, PerfCounters::Event::CacheMisses), 2)
+                     << std::setw(14) << optional_count(counter(result, PerfCounters::Event::BranchMisses), 2);
+            }
+            ostr << "\n";
+        }
+        break;
+    }
+
+    case Format::Json:
+        ostr << "{\n  \"benchmarks\": [";
+        for (std::size_t i = 0; i < results_.size(); ++i)
+        {
+            auto const& result = results_[i];
+            ostr << (i ? ",\n" : "\n") << std::setprecision(17)
+                 << "    { \"name\": " << json_string(result.name_)
+                 << ", \"repetitions\": " << result.repetitions_
+                 << ", \"iterations\": " << result.iterations_
+                 << ", \"median_ns\": " << result.median_ns_
+                 << ", \"p99_ns\": " << result.p99_ns_
+                 << ", \"min_ns\": " << result.min_ns_
+                 << ", \"mean_ns\": " << result.mean_ns_
+                 << ", \"bytes\": " << result.bytes_
+                 << ", \"items\": " << result.items_
+                 << ", \"bytes_per_second\": " << result.bytes_per_second()
+                 << ", \"items_per_second\": " << result.items_per_second();
+            for (std::size_t c = 0; c < counter_count; ++c)
+            {
+                if (result.counters_[c])
+                {
+                    ostr << ", \"" << PerfCounters::event_name(static_cast<PerfCounters::Event>(c)) << "\": "
+                         << *result.counters_[c];
+                }
+            }
+            if (result.ipc())
+            {
+                ostr << ", \"ipc\": " << *result.ipc();
+            }
+            ostr << " }";
+        }
+        ostr << "\n  ]\n}\n";
+        break;
+
+    case Format::Csv:
+        ostr << "name,repetitions,iterations,median_ns,p99_ns,min_ns,mean_ns,bytes,items,bytes_per_second,items_per_second";
+        if (counters_)
+        {
+            for (std::size_t c = 0; c < counter_count; ++c)
+            {
+                ostr << "," << PerfCounters::event_name(static_cast<PerfCounters::Event>(c));
+            }
+            ostr << ",ipc";
+        }
+        ostr << "\n";
+        for (auto const& result: results_)
+        {
+            ostr << std::setprecision(17)
+                 << result.name_ << "," << result.repetitions_ << "," << result.iterations_ << ","
+                 << result.median_ns_ << "," << result.p99_ns_ << ","
+                 << result.min_ns_ << "," << result.mean_ns_ << ","
+                 << result.bytes_ << "," << result.items_ << ","
+                 << result.bytes_per_second() << "," << result.items_per_second();
+            if (counters_)
+            {
+                // unavailable counters are left empty
+                for (auto const& count: result.counters_)
+                {
+                    ostr << ",";
+                    if (count)
+                    {
+                        ostr << *count;
+                    }
+                }
+                ostr << ",";
+                if (result.ipc())
+                {
+                    ostr << *result.ipc();
+                }
+            }
+            ostr << "\n";
+        }
+        break;
+    }
+}
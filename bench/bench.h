@@ -0,0 +1,189 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef EDHELIND_BENCH_BENCH_H
+#define EDHELIND_BENCH_BENCH_H
+
+#include "bench/perfcounters.h"
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <iosfwd>
+#include <memory>
+#include <optional>
+#include <string>
+#include <utility>
+#include <vector>
+
+
+/**
+ * Keep the compiler from optimizing away the computation of @p value.
+ */
+template<typename T>
+inline void
+do_not_optimize(T const& value)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    asm volatile("" : : "r,m"(value) : "memory");
+#else
+    static volatile char const* sink;
+    sink = reinterpret_cast<char const volatile*>(&value);
+#endif
+}
+
+
+/**
+ * The timings of one benchmark.
+ *
+ * All times and hardware counts are per iteration of the benchmarked code;
+ * the byte and item counts are what one iteration processes.
+ */
+struct BenchResult
+{
+    std::string   name_;
+    std::size_t   repetitions_;
+    std::uint64_t iterations_;
+    double        median_ns_;
+    double        p99_ns_;
+    double        min_ns_;
+    double        mean_ns_;
+    std::uint64_t bytes_;
+    std::uint64_t items_;
+    PerfCounters::Counts counters_;
+
+    /** Instructions per cycle, if both were counted */
+    std::optional<double>
+    ipc() const;
+
+    /** Bytes processed per second at the median time, or 0 if not counted */
+    double
+    bytes_per_second() const;
+
+    /** Items processed per second at the median time, or 0 if not counted */
+    double
+    items_per_second() const;
+};
+
+
+/**
+ * A small benchmark harness.
+ *
+ * Each benchmark is first calibrated: the number of iterations making up one
+ * repetition is doubled until a repetition takes at least the minimum
+ * repetition time, so that timer resolution does not matter even for
+ * nanosecond-scale operations.  A few repetitions are then run and discarded
+ * to warm up caches and branch predictors, and the rest are timed to give the
+ * median and 99th percentile time per iteration.
+ *
+ * Hardware performance counters can also be collected over the timed
+ * repetitions, where the platform has them.  They count the calling thread
+ * only, so benchmarks that farm work out to other threads get none.
+ */
+class BenchHarness
+{
+public:
+    struct Options
+    {
+        std::size_t               warmup_ = 3;
+        std::size_t               repetitions_ = 25;
+        std::chrono::microseconds min_repetition_time_ = std::chrono::microseconds(2000);
+        std::string               filter_;
+        bool                      counters_ = false;
+    };
+
+    enum class Format
+    {
+        Text,
+        Json,
+        Csv,
+    };
+
+public:
+    explicit BenchHarness(Options const& options);
+
+    ~BenchHarness();
+
+    /** Whether the benchmark @p name is selected by the filter */
+    bool
+    selected(std::string const& name) const;
+
+    /**
+     * Benchmark @p fn under @p name.
+     *
+     * @param[in] name   The name of the benchmark
+     * @param[in] bytes  The number of bytes one call of @p fn processes, or 0
+     * @param[in] items  The number of items one call of @p fn processes, or 0
+     * @param[in] fn     The code to benchmark
+     */
+    template<typename Fn>
+    void
+    run(std::string const& name, std::uint64_t bytes, std::uint64_t items, Fn&& fn)
+    {
+        if (selected(name))
+        {
+            measure(name, bytes, items, true, [&fn](std::uint64_t iterations) {
+                for (std::uint64_t i = 0; i < iterations; ++i)
+                {
+                    fn();
+                }
+            });
+        }
+    }
+
+    /**
+     * Benchmark @p fn, which does its work on other threads, under @p name.
+     *
+     * This is run() without the hardware counters, which would see only
+     * what the calling thread did.
+     */
+    template<typename Fn>
+    void
+    run_threaded(std::string const& name, std::uint64_t bytes, std::uint64_t items, Fn&& fn)
+    {
+        if (selected(name))
+        {
+            measure(name, bytes, items, false, [&fn](std::uint64_t iterations) {
+                for (std::uint64_t i = 0; i < iterations; ++i)
+                {
+                    fn();
+                }
+            });
+        }
+    }
+
+    std::vector<BenchResult> const&
+    results() const;
+
+    /** Write all results to @p ostr in @p format */
+    void
+    report(std::ostream& ostr, Format format) const;
+
+private:
+    using Body = std::function<void(std::uint64_t iterations)>;
+
+    void
+    measure(std::string const& name, std::uint64_t bytes, std::uint64_t items, bool count_events, Body const& body);
+
+private:
+    Options                       options_;
+    std::unique_ptr<PerfCounters> counters_;
+    std::vector<BenchResult>      results_;
+};
+
+#endif /* EDHELIND_BENCH_BENCH_H */
@@ -0,0 +1,722 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "bench/bench_elf.h"
+
+#include "bench/bench.h"
+#include "elfgen/elfgen.h"
+#include "libedhel/bulkdecode.h"
+#include "libedhel/dwarf.h"
+#include "libedhel/dwarfaranges.h"
+#include "libedhel/dwarffunctions.h"
+#include "libedhel/dwarfline.h"
+#include "libedhel/dwarfnames.h"
+#include "libedhel/elf.h"
+#include "libedhel/elffile.h"
+#include "libedhel/elfheader.h"
+#include "libedhel/elfprobe.h"
+#include "libedhel/note.h"
+#include "libedhel/section.h"
+#include "libedhel/section_strtab.h"
+#include "libedhel/section_symtab.h"
+#include "libedhel/segment.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <initializer_list>
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+
+namespace
+{
+    /** Read every @p width-byte word of @p view with @p get */
+    template<typename Get>
+    void
+    bench_get_uint(BenchHarness& harness, std::string const& name, ElfImageView const& view,
+                   std::size_t width, Get get)
+    {
+        std::size_t count = view.size() / width;
+        harness.run(name, count * width, count, [&]() {
+            std::uint64_t sum = 0;
+            for (std::size_t offset = 0; offset + width <= view.size(); offset += width)
+            {
+                sum += get(view, offset);
+            }
+            do_not_optimize(sum);
+        });
+    }
+
+    /** Where a field lies in a table entry, and how wide it is */
+    struct Field
+    {
+        std::size_t offset_;
+        std::size_t width_;
+    };
+
+    /**
+     * Decode the tables in @p views two ways: a field at a time through
+     * ElfImageView, the way the parsers read them, and a table at a time with
+     * decode_table().  Both add up every field of every entry.
+     */
+    template<typename Entry, typename Sum>
+    void
+    bench_decode(BenchHarness& harness, std::string const& table, std::string const& label,
+                 std::vector<ElfImageView> const& views, std::initializer_list<Field> fields, Sum sum_entry)
+    {
+        std::uint64_t bytes = 0;
+        std::uint64_t count = 0;
+        for (auto const& view: views)
+        {
+            bytes += view.size();
+            count += view.size() / sizeof(Entry);
+        }
+        if (count == 0)
+        {
+            return;
+        }
+
+        harness.run(table + "_decode_fields/" + label, bytes, count, [&]() {
+            std::uint64_t sum = 0;
+            for (auto const& view: views)
+            {
+                for (std::size_t entry = 0; entry + sizeof(Entry) <= view.size(); entry += sizeof(Entry))
+                {
+                    for (auto const& field: fields)
+                    {
+                        switch (field.width_)
+                        {
+                        case 1: sum += view.get_uint8(entry + field.offset_); break;
+                        case 2: sum += view.get_uint16(entry + field.offset_); break;
+                        case 4: sum += view.get_uint32(entry + field.offset_); break;
+                        case 8: sum += view.get_uint64(entry + field.offset_); break;
+                        }
+                    }
+                }
+            }
+            do_not_optimize(sum);
+        });
+
+        std::vector<Entry> entries;
+        harness.run(table + "_decode_bulk/" + label, bytes, count, [&]() {
+            std::uint64_t sum = 0;
+            for (auto const& view: views)
+            {
+                std::size_t n = view.size() / sizeof(Entry);
+                entries.resize(n);
+                decode_table(view.get_bytes(0), n, sizeof(Entry), view.isBigEndian(), entries.data());
+                for (auto const& entry: entries)
+                {
+                    sum += sum_entry(entry);
+                }
+            }
+            do_not_optimize(sum);
+        });
+    }
+
+    /** Append @p value to @p bytes as a ULEB128 */
+    void
+    put_leb128(std::vector<std::byte>& bytes, std::uint64_t value)
+    {
+        do
+        {
+            std::uint8_t byte = value & 0x7f;
+            value >>= 7;
+            bytes.push_back(std::byte(value != 0 ? byte | 0x80 : byte));
+        } while (value != 0);
+    }
+
+    /** Append @p value to @p bytes as an SLEB128 */
+    void
+    put_leb128(std::vector<std::byte>& bytes, std::int64_t value)
+    {
+        for (;;)
+        {
+            std::uint8_t byte = value & 0x7f;
+            value >>= 7;
+            bool done = (value == 0 && (byte & 0x40) == 0) || (value == -1 && (byte & 0x40) != 0);
+            bytes.push_back(std::byte(done ? byte : byte | 0x80));
+            if (done)
+            {
+                return;
+            }
+        }
+    }
+
+    /**
+     * Decode the LEB128 encodings of @p values two ways: a value at a time
+     * through ElfImageView, the way a parser walking a structure reads them,
+     * and all at once with the bulk decoder.  Both add up every value.
+     */
+    template<typename Value>
+    void
+    bench_leb128(BenchHarness& harness, std::string const& encoding, std::string const& label,
+                 std::vector<Value> const& values)
+    {
+        if (values.empty())
+        {
+            return;
+        }
+        std::vector<std::byte> bytes;
+        for (Value value: values)
+        {
+            put_leb128(bytes, value);
+        }
+        ElfImage image(bytes);
+        ElfImageView view = image.view(0, image.size());
+        bool constexpr is_signed = std::is_signed<Value>::value;
+
+        harness.run(encoding + "_decode_view/" + label, bytes.size(), values.size(), [&]() {
+            std::uint64_t sum = 0;
+            std::size_t length = 0;
+            for (std::size_t offset = 0; offset < view.size(); offset += length)
+            {
+                sum += is_signed ? view.get_sleb128(offset, length) : view.get_uleb128(offset, length);
+            }
+            do_not_optimize(sum);
+        });
+
+        // Decoded a batch at a time, the way a consumer would, so the values
+        // stay in cache.
+        Value decoded[256];
+        harness.run(encoding + "_decode_bulk/" + label, bytes.size(), values.size(), [&]() {
+            std::uint64_t sum = 0;
+            for (std::size_t offset = 0; offset < view.size(); )
+            {
+                Leb128Run run;
+                if constexpr (is_signed)
+                {
+                    run = view.get_sleb128s(offset, std::size(decoded), decoded);
+                }
+                else
+                {
+                    run = view.get_uleb128s(offset, std::size(decoded), decoded);
+                }
+                for (std::size_t i = 0; i < run.count_; ++i)
+                {
+                    sum += decoded[i];
+                }
+                offset += run.size_;
+            }
+            do_not_optimize(sum);
+        });
+    }
+
+    /** Files in the malformed corpus, and how many of them are broken */
+    constexpr std::size_t corpus_size = 20;
+    constexpr std::size_t corpus_malformed = 6;
+
+    /** Break a generated ELF file in the @p n th of a few different ways */
+    void
+    corrupt(std::vector<std::byte>& bytes, bool is_64bit, std::size_t n)
+    {
+        switch (n % 4)
+        {
+        case 0:     // truncated, losing the section header table at the end
+            bytes.resize(bytes.size() / 2);
+            break;
+        case 1:     // not an ELF file after all
+            bytes[1] = std::byte{'Q'};
+            break;
+        case 2:     // section header table offset off in the weeds
+            std::memset(&bytes[is_64bit ? offsetof(Elf64_Ehdr, e_shoff) : offsetof(Elf32_Ehdr, e_shoff)],
+                        0x7f, is_64bit ? 8 : 4);
+            break;
+        case 3:     // too short to hold a header
+            bytes.resize(32);
+            break;
+        }
+    }
+
+    void
+    write_bytes(std::vector<std::byte> const& bytes, std::string const& file_name)
+    {
+        std::FILE* file = std::fopen(file_name.c_str(), "wb");
+        if (file == nullptr || std::fwrite(bytes.data(), 1, bytes.size(), file) != bytes.size())
+        {
+            if (file)
+            {
+                std::fclose(file);
+            }
+            throw std::runtime_error("error writing '" + file_name + "'");
+        }
+        std::fclose(file);
+    }
+} // anonymous namespace
+
+
+void
+bench_elf_file(BenchHarness& harness, std::string const& file_name, std::string const& label)
+{
+    auto name = [&label](char const* bench) {
+        return std::string(bench) + "/" + label;
+    };
+
+    ElfFile elf_file(file_name);
+    std::uint64_t file_size = elf_file.size();
+
+    harness.run(name("elfimage_load"), file_size, 0, [&]() {
+        ElfImage image(file_name);
+        do_not_optimize(image.size());
+    });
+
+    harness.run(name("elf_probe"), 0, 0, [&]() {
+        ElfProbe probe = probe_elf(file_name, true);
+        do_not_optimize(probe.entry_);
+    });
+
+    harness.run(name("elffile_parse"), file_size, 0, [&]() {
+        ElfFile parsed(file_name);
+        do_not_optimize(parsed.size());
+    });
+
+    harness.run_threaded(name("elffile_parse_parallel"), file_size, 0, [&]() {
+        ElfFile parsed(file_name, ParseOptions{0});
+        do_not_optimize(parsed.size());
+    });
+
+    // Byte-order conversion is the interesting part of get_uint*(), so read
+    // the same bytes both ways round.  Reads from a validated image skip their
+    // bounds checks, so read them with and without validation too.
+    for (bool big_endian: { false, true })
+    {
+        for (bool validated: { false, true })
+        {
+            ElfImage image(file_name);
+            image.setBigEndian(big_endian);
+            image.set_validated(validated);
+            ElfImageView view = image.view(0, image.size());
+            std::string suffix = std::string(big_endian ? "_be" : "_le") + (validated ? "_validated" : "");
+
+            bench_get_uint(harness, name(("get_uint8" + suffix).c_str()), view, 1,
+                           [](ElfImageView const& v, std::size_t offset) { return v.get_uint8(offset); });
+            bench_get_uint(harness, name(("get_uint16" + suffix).c_str()), view, 2,
+                           [](ElfImageView const& v, std::size_t offset) { return v.get_uint16(offset); });
+            bench_get_uint(harness, name(("get_uint32" + suffix).c_str()), view, 4,
+                           [](ElfImageView const& v, std::size_t offset) { return v.get_uint32(offset); });
+            bench_get_uint(harness, name(("get_uint64" + suffix).c_str()), view, 8,
+                           [](ElfImageView const& v, std::size_t offset) { return v.get_uint64(offset); });
+        }
+    }
+
+    std::vector<Section const*> sections;
+    std::vector<Section_SYMTAB const*> symtabs;
+    std::vector<Section_STRTAB const*> strtabs;
+    std::vector<ElfImageView> note_views;
+    elf_file.section_table().iterate_sections([&](Section const& section) {
+        sections.push_back(&section);
+        if (auto symtab = dynamic_cast<Section_SYMTAB const*>(&section))
+        {
+            symtabs.push_back(symtab);
+        }
+        else if (auto strtab = dynamic_cast<Section_STRTAB const*>(&section))
+        {
+            strtabs.push_back(strtab);
+        }
+        else if (section.type() == SType::SHT_NOTE)
+        {
+            note_views.push_back(elf_file.view(section.offset(), section.size()));
+        }
+    });
+    std::size_t segment_count = 0;
+    elf_file.segment_table().iterate_segments([&](Segment const&) { ++segment_count; });
+
+    harness.run(name("sectiontable_construct"), 0, sections.size(), [&]() {
+        SectionTable table(elf_file);
+        do_not_optimize(table);
+    });
+
+    harness.run(name("segmenttable_construct"), 0, segment_count, [&]() {
+        SegmentTable table(elf_file);
+        do_not_optimize(table);
+    });
+
+    std::uint64_t symbol_count = 0;
+    std::uint64_t symbol_bytes = 0;
+    for (auto symtab: symtabs)
+    {
+        symbol_count += symtab->symbol_count();
+        symbol_bytes += symtab->size();
+    }
+    if (symbol_count != 0)
+    {
+        harness.run(name("symtab_iterate"), symbol_bytes, symbol_count, [&]() {
+            std::uint64_t sum = 0;
+            for (auto symtab: symtabs)
+            {
+                symtab->iterate_symbols([&sum](Symbol const& symbol) {
+                    sum += symbol.value() + symbol.name();
+                });
+            }
+            do_not_optimize(sum);
+        });
+    }
+
+    // The same tables decoded a field at a time and a table at a time, which
+    // is where the byte order of the target costs the most.
+    std::vector<ElfImageView> symtab_views;
+    for (auto symtab: symtabs)
+    {
+        symtab_views.push_back(elf_file.view(symtab->offset(), symtab->size()));
+    }
+    std::vector<ElfImageView> shdr_views;
+    ElfHeader const& elf_header = elf_file.elf_header();
+    if (elf_header.shnum() != 0 && elf_header.shentsize() != 0)
+    {
+        std::size_t shdr_bytes = std::size_t(elf_header.shnum()) * elf_header.shentsize();
+        shdr_views.push_back(elf_file.view(elf_header.shoff(), shdr_bytes));
+    }
+    std::vector<ElfImageView> rela_views;
+    for (auto section: sections)
+    {
+        if (section->type() == SType::SHT_RELA)
+        {
+            rela_views.push_back(elf_file.view(section->offset(), section->size()));
+        }
+    }
+    if (elf_file.is_64bit())
+    {
+        bench_decode<Elf64::Sym>(harness, "symtab", label, symtab_views,
+                                 { { 0, 4 }, { 4, 1 }, { 5, 1 }, { 6, 2 }, { 8, 8 }, { 16, 8 } },
+                                 [](Elf64::Sym const& s) {
+                                     return s.st_name + s.st_info + s.st_other + s.st_shndx + s.st_value + s.st_size;
+                                 });
+        bench_decode<Elf64_Shdr>(harness, "shdr", label, shdr_views,
+                                 { { 0, 4 }, { 4, 4 }, { 8, 8 }, { 16, 8 }, { 24, 8 }, { 32, 8 },
+                                   { 40, 4 }, { 44, 4 }, { 48, 8 }, { 56, 8 } },
+                                 [](Elf64_Shdr const& h) {
+                                     return h.sh_name + static_cast<std::uint32_t>(h.sh_type) + h.sh_flags + h.sh_addr
+                                          + h.sh_offset + h.sh_size + h.sh_link + h.sh_info + h.sh_addralign + h.sh_entsize;
+                                 });
+        bench_decode<Elf64_Rela>(harness, "rela", label, rela_views,
+                                 { { 0, 8 }, { 8, 8 }, { 16, 8 } },
+                                 [](Elf64_Rela const& r) {
+                                     return r.r_offset + r.r_info + std::uint64_t(r.r_addend);
+                                 });
+    }
+    else
+    {
+        bench_decode<Elf32::Sym>(harness, "symtab", label, symtab_views,
+                                 { { 0, 4 }, { 4, 4 }, { 8, 4 }, { 12, 1 }, { 13, 1 }, { 14, 2 } },
+                                 [](Elf32::Sym const& s) {
+                                     return std::uint64_t(s.st_name) + s.st_value + s.st_size
+                                          + s.st_info + s.st_other + s.st_shndx;
+                                 });
+        bench_decode<Elf32_Shdr>(harness, "shdr", label, shdr_views,
+                                 { { 0, 4 }, { 4, 4 }, { 8, 4 }, { 12, 4 }, { 16, 4 },
+                                   { 20, 4 }, { 24, 4 }, { 28, 4 }, { 32, 4 }, { 36, 4 } },
+                                 [](Elf32_Shdr const& h) {
+                                     return std::uint64_t(h.sh_name) + static_cast<std::uint32_t>(h.sh_type) + h.sh_flags
+                                          + h.sh_addr + h.sh_offset + h.sh_size + h.sh_link + h.sh_info + h.sh_addralign + h.sh_entsize;
+                                 });
+        bench_decode<Elf32_Rela>(harness, "rela", label, rela_views,
+                                 { { 0, 4 }, { 4, 4 }, { 8, 4 } },
+                                 [](Elf32_Rela const& r) {
+                                     return std::uint64_t(r.r_offset) + r.r_info + std::uint32_t(r.r_addend);
+                                 });
+    }
+
+    // LEB128 streams made of the symbols: their names and sizes are the small
+    // unsigned values DWARF is full of, and the distances between their
+    // addresses the signed deltas of line programs and packed relocations.
+    std::vector<std::uint64_t> unsigned_values;
+    std::vector<std::int64_t> signed_values;
+    for (auto symtab: symtabs)
+    {
+        std::uint64_t previous = 0;
+        symtab->iterate_symbols([&](Symbol const& symbol) {
+            unsigned_values.push_back(symbol.name());
+            unsigned_values.push_back(symbol.size());
+            signed_values.push_back(static_cast<std::int64_t>(symbol.value() - previous));
+            previous = symbol.value();
+        });
+    }
+    bench_leb128(harness, "uleb128", label, unsigned_values);
+    bench_leb128(harness, "sleb128", label, signed_values);
+
+    std::uint64_t string_count = 0;
+    std::uint64_t string_bytes = 0;
+    for (auto strtab: strtabs)
+    {
+        strtab->iterate_strings([&string_count](std::uint32_t, std::string const&) { ++string_count; });
+        string_bytes += strtab->size();
+    }
+    if (string_count != 0)
+    {
+        harness.run(name("strtab_iterate_strings"), string_bytes, string_count, [&]() {
+            std::uint64_t sum = 0;
+            for (auto strtab: strtabs)
+            {
+                strtab->iterate_strings([&sum](std::uint32_t, std::string const& s) {
+                    sum += s.size();
+                });
+            }
+            do_not_optimize(sum);
+        });
+    }
+
+    if (!note_views.empty())
+    {
+        std::uint64_t note_count = 0;
+        std::uint64_t note_bytes = 0;
+        for (auto const& view: note_views)
+        {
+            NoteTable(view).iterate_notes([&note_count](Note const&) { ++note_count; });
+            note_bytes += view.size();
+        }
+        harness.run(name("notetable_parse"), note_bytes, note_count, [&]() {
+            for (auto const& view: note_views)
+            {
+                NoteTable notes(view);
+                do_not_optimize(notes);
+            }
+        });
+    }
+
+    std::ostringstream formatted;
+    for (auto section: sections)
+    {
+        formatted << *section;
+    }
+    harness.run(name("section_printTo"), formatted.str().size(), sections.size(), [&]() {
+        std::ostringstream ostr;
+        for (auto section: sections)
+        {
+            ostr << *section;
+        }
+        do_not_optimize(ostr);
+    });
+
+    DwarfSection debug_line = find_dwarf_section(elf_file, ".debug_line");
+    if (debug_line)
+    {
+        harness.run(name("line_index_build"), debug_line.size_, 0, [&]() {
+            LineIndex index(elf_file);
+            do_not_optimize(index.row_count());
+        });
+
+        harness.run_threaded(name("line_index_build_parallel"), debug_line.size_, 0, [&]() {
+            LineIndex index(elf_file, 0);
+            do_not_optimize(index.row_count());
+        });
+
+        // Look up the address of every row, shuffled so the sequences aren't
+        // visited in order.
+        LineIndex index(elf_file);
+        std::vector<std::uint64_t> addresses;
+        for (auto const& table: index.tables())
+        {
+            for (auto const& row: table.rows_)
+            {
+                addresses.push_back(row.address_);
+            }
+        }
+        std::uint64_t state = 0x9e3779b97f4a7c15ULL;
+        for (std::size_t i = addresses.size(); i > 1; --i)
+        {
+            state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+            std::swap(addresses[i - 1], addresses[(state >> 33) % i]);
+        }
+        std::vector<LineLocation> locations(addresses.size());
+
+        harness.run(name("line_lookup"), 0, addresses.size(), [&]() {
+            for (std::size_t i = 0; i < addresses.size(); ++i)
+            {
+                locations[i] = index.lookup(addresses[i]);
+            }
+            do_not_optimize(locations.data());
+        });
+
+        harness.run(name("line_lookup_batch"), 0, addresses.size(), [&]() {
+            index.lookup(addresses.data(), addresses.size(), locations.data());
+            do_not_optimize(locations.data());
+        });
+    }
+
+    DwarfSection debug_info = find_dwarf_section(elf_file, ".debug_info");
+    if (debug_info)
+    {
+        harness.run(name("function_index_build"), debug_info.size_, 0, [&]() {
+            FunctionIndex index(elf_file);
+            do_not_optimize(index.functions().size());
+        });
+
+        harness.run_threaded(name("function_index_build_parallel"), debug_info.size_, 0, [&]() {
+            FunctionIndex index(elf_file, 0);
+            do_not_optimize(index.functions().size());
+        });
+
+        // Look up the start of every function and a little way into it, in
+        // a shuffled order.
+        FunctionIndex index(elf_file);
+        std::vector<std::uint64_t> addresses;
+        for (auto const& function: index.functions())
+        {
+            addresses.push_back(function.low_pc_);
+            addresses.push_back(function.low_pc_ + (function.high_pc_ - function.low_pc_) / 3);
+        }
+        std::uint64_t state = 0x9e3779b97f4a7c15ULL;
+        for (std::size_t i = addresses.size(); i > 1; --i)
+        {
+            state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+            std::swap(addresses[i - 1], addresses[(state >> 33) % i]);
+        }
+
+        harness.run(name("function_lookup"), 0, addresses.size(), [&]() {
+            std::size_t depth = 0;
+            for (std::uint64_t address: addresses)
+            {
+                depth += index.lookup(address).size();
+            }
+            do_not_optimize(depth);
+        });
+
+        DwarfSection debug_aranges = find_dwarf_section(elf_file, ".debug_aranges");
+        harness.run(name("unit_range_index_build"), debug_aranges.size_, 0, [&]() {
+            UnitRangeIndex units(elf_file);
+            do_not_optimize(units.ranges().size());
+        });
+
+        UnitRangeIndex units(elf_file);
+        harness.run(name("unit_lookup"), 0, addresses.size(), [&]() {
+            std::uint64_t sum = 0;
+            for (std::uint64_t address: addresses)
+            {
+                sum += units.lookup(address);
+            }
+            do_not_optimize(sum);
+        });
+
+        // Look up every function with a name of its own, in a shuffled
+        // order: first straight after opening the name index, as a debugger
+        // setting a breakpoint does, then once it is warm.  Linkage names
+        // would be unique too, but .gdb_index leaves them out.
+        std::vector<std::string_view> names;
+        for (auto const& function: index.functions())
+        {
+            if (!function.inlined_)
+            {
+                names.push_back(function.name_);
+            }
+        }
+        std::sort(names.begin(), names.end());
+        std::vector<std::string_view> unique_names;
+        for (std::size_t i = 0; i < names.size(); ++i)
+        {
+            if ((i == 0 || names[i - 1] != names[i]) && (i + 1 == names.size() || names[i + 1] != names[i]))
+            {
+                unique_names.push_back(names[i]);
+            }
+        }
+        names.swap(unique_names);
+        for (std::size_t i = names.size(); i > 1; --i)
+        {
+            state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+            std::swap(names[i - 1], names[(state >> 33) % i]);
+        }
+        if (!names.empty())
+        {
+            harness.run(name("name_first_lookup"), 0, 1, [&]() {
+                NameIndex name_index(elf_file);
+                do_not_optimize(name_index.lookup(names.front()).size());
+            });
+
+            NameIndex name_index(elf_file);
+            name_index.lookup(names.front());
+            harness.run(name("name_lookup"), 0, names.size(), [&]() {
+                std::size_t found = 0;
+                for (std::string_view function_name: names)
+                {
+                    found += name_index.lookup(function_name).size();
+                }
+                do_not_optimize(found);
+            });
+        }
+    }
+}
+
+
+void
+bench_malformed_corpus(BenchHarness& harness, std::string const& directory, std::string const& label)
+{
+    auto name = [&label](char const* bench) {
+        return std::string(bench) + "/" + label;
+    };
+
+    // Malformed files are spread through the corpus rather than bunched up.
+    std::vector<std::string> corpus;
+    std::uint64_t corpus_bytes = 0;
+    for (std::size_t i = 0; i < corpus_size; ++i)
+    {
+        ElfSpec spec;
+        spec.is_64bit_ = i % 3 != 0;
+        spec.big_endian_ = i % 2 != 0;
+        spec.seed_ = i;
+        std::vector<std::byte> bytes = generate_elf(spec);
+        std::size_t malformed = i * corpus_malformed / corpus_size;
+        if ((i + 1) * corpus_malformed / corpus_size != malformed)
+        {
+            corrupt(bytes, spec.is_64bit_, malformed);
+        }
+        corpus.push_back((std::filesystem::path(directory) / ("libedhel_corpus_" + std::to_string(i) + ".elf")).string());
+        write_bytes(bytes, corpus.back());
+        corpus_bytes += bytes.size();
+    }
+
+    harness.run(name("corpus_parse_throwing"), corpus_bytes, corpus.size(), [&]() {
+        std::size_t parsed = 0;
+        for (auto const& file: corpus)
+        {
+            try
+            {
+                ElfFile elf_file(file);
+                ++parsed;
+            }
+            catch (std::exception const&)
+            {
+            }
+        }
+        do_not_optimize(parsed);
+    });
+
+    harness.run(name("corpus_parse_status"), corpus_bytes, corpus.size(), [&]() {
+        std::size_t parsed = 0;
+        for (auto const& file: corpus)
+        {
+            ParseResult result = ElfFile::parse(file);
+            if (result.elf_file_)
+            {
+                ++parsed;
+            }
+        }
+        do_not_optimize(parsed);
+    });
+
+    for (auto const& file: corpus)
+    {
+        std::remove(file.c_str());
+    }
+}
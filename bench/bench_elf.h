@@ -0,0 +1,49 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef EDHELIND_BENCH_BENCH_ELF_H
+#define EDHELIND_BENCH_BENCH_ELF_H
+
+#include <string>
+
+class BenchHarness;
+
+
+/**
+ * Run the libedhel hot-path benchmarks against the ELF file @p file_name,
+ * naming each result "<benchmark>/<label>".
+ *
+ * @throws std::runtime_error if @p file_name can not be read as an ELF file
+ */
+void
+bench_elf_file(BenchHarness& harness, std::string const& file_name, std::string const& label);
+
+
+/**
+ * Run the parsing benchmarks against a generated corpus in which 30% of the
+ * files are malformed, once catching exceptions and once using the
+ * non-throwing ElfFile::parse(), naming each result "<benchmark>/<label>".
+ *
+ * The corpus is written to and removed from @p directory.
+ *
+ * @throws std::runtime_error if the corpus can not be written
+ */
+void
+bench_malformed_corpus(BenchHarness& harness, std::string const& directory, std::string const& label);
+
+#endif /* EDHELIND_BENCH_BENCH_ELF_H */
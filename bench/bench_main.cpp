@@ -0,0 +1,258 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "bench/bench.h"
+#include "bench/bench_elf.h"
+#include "elfgen/elfgen.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include <vector>
+
+
+namespace
+{
+    void
+    usage(char const* program)
+    {
+        std::cerr << "usage: " << program << " [options] [FILE...]\n"
+                  << "\n"
+                  << "Benchmark libedhel against each ELF FILE (default: this program,\n"
+                  << "or just the synthetic files if --synthetic is given).\n"
+                  << "\n"
+                  << "options:\n"
+                  << "  --filter=TEXT        only run benchmarks whose name contains TEXT\n"
+                  << "  --repetitions=N      timed repetitions per benchmark (default 25)\n"
+                  << "  --warmup=N           untimed repetitions per benchmark (default 3)\n"
+                  << "  --min-time-us=N      minimum time of one repetition (default 2000)\n"
+                  << "  --format=FORMAT      text, json or csv (default text)\n"
+                  << "  --counters           also collect hardware performance counters\n"
+                  << "                       (cycles, IPC, cache and branch misses) where\n"
+                  << "                       the platform allows it\n"
+                  << "  --synthetic          also run against a generated corpus of ELF files\n"
+                  << "                       ranging from tiny to pathological\n";
+    }
+
+    /** If @p arg is "--@p option=VALUE" put VALUE in @p value */
+    bool
+    option_value(char const* arg, char const* option, std::string& value)
+    {
+        std::size_t len = std::strlen(option);
+        if (std::strncmp(arg, "--", 2) == 0 && std::strncmp(arg + 2, option, len) == 0 && arg[2 + len] == '=')
+        {
+            value = arg + 3 + len;
+            return true;
+        }
+        return false;
+    }
+
+    /** A generated benchmark input */
+    struct SyntheticFile
+    {
+        char const* label_;
+        ElfSpec     spec_;
+    };
+
+    ElfSpec
+    make_spec(bool is_64bit, bool big_endian, std::uint32_t sections, std::uint32_t symbols,
+              std::uint32_t notes, std::uint32_t relocations)
+    {
+        ElfSpec spec;
+        spec.is_64bit_ = is_64bit;
+        spec.big_endian_ = big_endian;
+        spec.section_count_ = sections;
+        spec.symbol_count_ = symbols;
+        spec.note_count_ = notes;
+        spec.relocation_count_ = relocations;
+        return spec;
+    }
+
+    ElfSpec
+    make_line_spec(std::uint32_t units, std::uint32_t rows_per_unit, std::uint32_t functions_per_unit = 0)
+    {
+        ElfSpec spec = make_spec(true, false, 4, 32, 2, 0);
+        spec.dwarf_unit_count_ = units;
+        spec.line_rows_per_unit_ = rows_per_unit;
+        spec.functions_per_unit_ = functions_per_unit;
+        return spec;
+    }
+
+    ElfSpec
+    make_names_spec(std::uint32_t units, std::uint32_t rows_per_unit, std::uint32_t functions_per_unit,
+                    bool gdb_index)
+    {
+        ElfSpec spec = make_line_spec(units, rows_per_unit, functions_per_unit);
+        spec.dwarf_names_ = gdb_index ? 0 : units;
+        spec.gdb_index_ = gdb_index;
+        return spec;
+    }
+
+    /**
+     * Sizes sweep from tiny to more sections than the ELF header can count,
+     * then line number tables up to a few million rows, and .debug_info
+     * describing a couple of hundred thousand functions, without a name
+     * index and with each kind of one.
+     */
+    std::vector<SyntheticFile> const synthetic_files {
+        { "synthetic-tiny-64le",  make_spec(true,  false,     4,     32,   2,      0) },
+        { "synthetic-small-64le", make_spec(true,  false,    32,   1000,   8,   1000) },
+        { "synthetic-small-64be", make_spec(true,  true,     32,   1000,   8,   1000) },
+        { "synthetic-small-32le", make_spec(false, false,    32,   1000,   8,   1000) },
+        { "synthetic-small-32be", make_spec(false, true,     32,   1000,   8,   1000) },
+        { "synthetic-large-64le", make_spec(true,  false,   512, 100000,  64, 100000) },
+        { "synthetic-large-64be", make_spec(true,  true,    512, 100000,  64, 100000) },
+        { "synthetic-huge-64le",  make_spec(true,  false, 70000, 200000, 256, 200000) },
+        { "synthetic-lines-small-64le", make_line_spec(  16, 1000) },
+        { "synthetic-lines-large-64le", make_line_spec(1000, 4000) },
+        { "synthetic-functions-64le", make_line_spec(1000, 800, 64) },
+        { "synthetic-debug-names-64le", make_names_spec(1000, 800, 64, false) },
+        { "synthetic-gdb-index-64le", make_names_spec(1000, 800, 64, true) },
+    };
+
+    /** The last component of @p path */
+    std::string
+    base_name(std::string const& path)
+    {
+        std::size_t slash = path.find_last_of("/\\");
+        return slash == std::string::npos ? path : path.substr(slash + 1);
+    }
+} // anonymous namespace
+
+
+int
+main(int argc, char* argv[])
+{
+    BenchHarness::Options options;
+    BenchHarness::Format format = BenchHarness::Format::Text;
+    std::vector<std::string> files;
+    bool synthetic = false;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        std::string value;
+        if (option_value(argv[i], "filter", value))
+        {
+            options.filter_ = value;
+        }
+        else if (option_value(argv[i], "repetitions", value))
+        {
+            options.repetitions_ = std::strtoul(value.c_str(), nullptr, 10);
+        }
+        else if (option_value(argv[i], "warmup", value))
+        {
+            options.warmup_ = std::strtoul(value.c_str(), nullptr, 10);
+        }
+        else if (option_value(argv[i], "min-time-us", value))
+        {
+            options.min_repetition_time_ = std::chrono::microseconds(std::strtoul(value.c_str(), nullptr, 10));
+        }
+        else if (option_value(argv[i], "format", value))
+        {
+            if (value == "text")
+            {
+                format = BenchHarness::Format::Text;
+            }
+            else if (value == "json")
+            {
+                format = BenchHarness::Format::Json;
+            }
+            else if (value == "csv")
+            {
+                format = BenchHarness::Format::Csv;
+            }
+            else
+            {
+                usage(argv[0]);
+                return EXIT_FAILURE;
+            }
+        }
+        else if (std::strcmp(argv[i], "--counters") == 0)
+        {
+            options.counters_ = true;
+        }
+        else if (std::strcmp(argv[i], "--synthetic") == 0)
+        {
+            synthetic = true;
+        }
+        else if (argv[i][0] == '-')
+        {
+            usage(argv[0]);
+            return std::strcmp(argv[i], "--help") == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+        else
+        {
+            files.push_back(argv[i]);
+        }
+    }
+    if (files.empty() && !synthetic)
+    {
+        files.push_back(argv[0]);
+    }
+
+    BenchHarness harness(options);
+    for (auto const& file: files)
+    {
+        try
+        {
+            bench_elf_file(harness, file, base_name(file));
+        }
+        catch (std::exception const& ex)
+        {
+            std::cerr << argv[0] << ": " << file << ": " << ex.what() << "\n";
+            return EXIT_FAILURE;
+        }
+    }
+
+    if (synthetic)
+    {
+        try
+        {
+            bench_malformed_corpus(harness, std::filesystem::temp_directory_path().string(), "synthetic-corpus-30pc-malformed");
+        }
+        catch (std::exception const& ex)
+        {
+            std::cerr << argv[0] << ": " << ex.what() << "\n";
+            return EXIT_FAILURE;
+        }
+
+        std::string file = (std::filesystem::temp_directory_path() / "libedhel_bench.elf").string();
+        for (auto const& synthetic_file: synthetic_files)
+        {
+            try
+            {
+                write_elf(synthetic_file.spec_, file);
+                bench_elf_file(harness, file, synthetic_file.label_);
+                std::remove(file.c_str());
+            }
+            catch (std::exception const& ex)
+            {
+                std::remove(file.c_str());
+                std::cerr << argv[0] << ": " << synthetic_file.label_ << ": " << ex.what() << "\n";
+                return EXIT_FAILURE;
+            }
+        }
+    }
+
+    harness.report(std::cout, format);
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,185 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "bench/perfcounters.h"
+
+#if defined(__linux__)
+# include <cerrno>
+# include <cstring>
+# include <linux/perf_event.h>
+# include <sys/ioctl.h>
+# include <sys/syscall.h>
+# include <unistd.h>
+#endif
+
+
+namespace
+{
+#if defined(__linux__)
+    /** The perf_event_attr type and config for each counter */
+    struct EventConfig
+    {
+        std::uint32_t type_;
+        std::uint64_t config_;
+    };
+
+    constexpr EventConfig event_configs[] = {
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+        { PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES },
+    };
+
+    int
+    open_counter(EventConfig const& event_config)
+    {
+        perf_event_attr attr;
+        std::memset(&attr, 0, sizeof(attr));
+        attr.size = sizeof(attr);
+        attr.type = event_config.type_;
+        attr.config = event_config.config_;
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+        attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        return static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+    }
+#endif
+} // anonymous namespace
+
+
+PerfCounters::
+PerfCounters()
+{
+    fds_.fill(-1);
+#if defined(__linux__)
+    int error = 0;
+    for (std::size_t i = 0; i < fds_.size(); ++i)
+    {
+        fds_[i] = open_counter(event_configs[i]);
+        if (fds_[i] == -1 && error == 0)
+        {
+            error = errno;
+        }
+    }
+    if (!available())
+    {
+        unavailable_reason_ = std::string("perf_event_open: ") + std::strerror(error);
+        if (error == EACCES || error == EPERM)
+        {
+            unavailable_reason_ += " (see /proc/sys/kernel/perf_event_paranoid)";
+        }
+    }
+#else
+    unavailable_reason_ = "hardware counters are only supported on Linux";
+#endif
+}
+
+
+PerfCounters::
+~PerfCounters()
+{
+#if defined(__linux__)
+    for (int fd: fds_)
+    {
+        if (fd != -1)
+        {
+            ::close(fd);
+        }
+    }
+#endif
+}
+
+
+bool PerfCounters::
+available() const
+{
+    for (int fd: fds_)
+    {
+        if (fd != -1)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+std::string const& PerfCounters::
+unavailable_reason() const
+{
+    return unavailable_reason_;
+}
+
+
+char const* PerfCounters::
+event_name(Event event)
+{
+    switch (event)
+    {
+    case Event::Cycles:       return "cycles";
+    case Event::Instructions: return "instructions";
+    case Event::CacheMisses:  return "cache_misses";
+    case Event::BranchMisses: return "branch_misses";
+    case Event::Count_:       break;
+    }
+    return "?";
+}
+
+
+void PerfCounters::
+start()
+{
+#if defined(__linux__)
+    for (int fd: fds_)
+    {
+        if (fd != -1)
+        {
+            ::ioctl(fd, PERF_EVENT_IOC_RESET, 0);
+            ::ioctl(fd, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+#endif
+}
+
+
+PerfCounters::Counts PerfCounters::
+stop()
+{
+    Counts counts;
+#if defined(__linux__)
+    for (int fd: fds_)
+    {
+        if (fd != -1)
+        {
+            ::ioctl(fd, PERF_EVENT_IOC_DISABLE, 0);
+        }
+    }
+    for (std::size_t i = 0; i < fds_.size(); ++i)
+    {
+        // value, time enabled, time running
+        std::uint64_t values[3];
+        if (fds_[i] == -1 || ::read(fds_[i], values, sizeof(values)) != sizeof(values) || values[2] == 0)
+        {
+            continue;
+        }
+        counts[i] = static_cast<double>(values[0]) * values[1] / values[2];
+    }
+#endif
+    return counts;
+}
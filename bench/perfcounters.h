@@ -0,0 +1,89 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef EDHELIND_BENCH_PERFCOUNTERS_H
+#define EDHELIND_BENCH_PERFCOUNTERS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+
+
+/**
+ * Hardware performance counters for the calling thread.
+ *
+ * On Linux these come from perf_event_open(2) and count user-space events
+ * only.  Each counter is opened on its own, so one the CPU or kernel does not
+ * offer (a virtual machine often has no cache-miss counter, say) is simply
+ * missing rather than taking the others with it.  Everywhere else, and when
+ * perf events are not permitted, no counters are available and reading them
+ * gives nothing.
+ */
+class PerfCounters
+{
+public:
+    enum class Event
+    {
+        Cycles,
+        Instructions,
+        CacheMisses,
+        BranchMisses,
+        Count_
+    };
+
+    using Counts = std::array<std::optional<double>, static_cast<std::size_t>(Event::Count_)>;
+
+public:
+    PerfCounters();
+
+    PerfCounters(PerfCounters const&) = delete;
+    PerfCounters& operator=(PerfCounters const&) = delete;
+
+    ~PerfCounters();
+
+    /** Whether any counter could be opened */
+    bool
+    available() const;
+
+    /** Why no counter could be opened, if none could */
+    std::string const&
+    unavailable_reason() const;
+
+    static char const*
+    event_name(Event event);
+
+    /** Reset and start counting */
+    void
+    start();
+
+    /**
+     * Stop counting and return the counts since start(), scaled up if the
+     * kernel had to multiplex the counters.  Counters that could not be opened
+     * have no value.
+     */
+    Counts
+    stop();
+
+private:
+    std::array<int, static_cast<std::size_t>(Event::Count_)> fds_;
+    std::string                                               unavailable_reason_;
+};
+
+#endif /* EDHELIND_BENCH_PERFCOUNTERS_H */
@@ -0,0 +1,126 @@
+/**
+ * Latest-wins background job runner
+ */
+/*
+ * Copyright 2020 Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ *
+ * This file is part of Edhelind.
+ *
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Edhelind is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Edhelind.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "edhelind/backgroundworker.h"
+
+#include <exception>
+#include <utility>
+
+
+BackgroundWorker::
+BackgroundWorker(Failed on_failure)
+: on_failure_{std::move(on_failure)}
+, busy_{false}
+, generation_{0}
+{
+}
+
+
+BackgroundWorker::
+~BackgroundWorker()
+{
+    this->cancel();
+}
+
+
+void BackgroundWorker::
+post(Job job)
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    pending_ = std::move(job);
+    ++generation_;
+    if (!busy_)
+    {
+        busy_ = true;
+        group_.run([this]{ this->run(); });
+    }
+}
+
+
+void BackgroundWorker::
+cancel() noexcept
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pending_ = nullptr;
+        ++generation_;
+    }
+    try
+    {
+        group_.wait();
+    }
+    catch (...)
+    {
+        // run() lets nothing out, so there's nothing here worth dying for.
+    }
+}
+
+
+/**
+ * Run jobs until there are none left waiting.  Only one of these is ever
+ * queued or running at a time, which is what keeps the jobs in order, and it
+ * must always get to the end: if a job's exception got out, busy_ would stay
+ * set and the group would skip every run() queued after it.
+ */
+void BackgroundWorker::
+run()
+{
+    std::unique_lock<std::mutex> lock(mutex_);
+    while (pending_)
+    {
+        Job job = std::move(pending_);
+        pending_ = nullptr;
+        std::uint64_t generation = generation_;
+        lock.unlock();
+
+        try
+        {
+            job([this, generation]{ return generation_ != generation; });
+        }
+        catch (std::exception const& ex)
+        {
+            this->fail(ex.what());
+        }
+        catch (...)
+        {
+            this->fail("unknown exception");
+        }
+
+        lock.lock();
+    }
+    busy_ = false;
+}
+
+
+void BackgroundWorker::
+fail(std::string const& what) noexcept
+{
+    try
+    {
+        if (on_failure_)
+        {
+            on_failure_(what);
+        }
+    }
+    catch (...)
+    {
+    }
+}
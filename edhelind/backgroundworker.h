@@ -0,0 +1,94 @@
+/**
+ * Latest-wins background job runner
+ */
+/*
+ * Copyright 2020 Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ *
+ * This file is part of Edhelind.
+ *
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Edhelind is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Edhelind.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef EDHELIND_BACKGROUNDWORKER_H
+#define EDHELIND_BACKGROUNDWORKER_H
+
+#include <atomic>
+#include <cstdint>
+#include <functional>
+#include "libedhel/threadpool.h"
+#include <mutex>
+#include <string>
+
+
+/**
+ * Run jobs one at a time on the shared ThreadPool, newest request wins.
+ *
+ * Posting a new job cancels any job that is still waiting to run and asks the
+ * running job to stop at its next convenient point.  Jobs poll the predicate
+ * they are handed to find out if they have been superseded.  This is the
+ * pattern needed for things like sort-on-click and filter-as-you-type, where
+ * only the result of the most recent request is interesting.
+ *
+ * A job that throws is abandoned and the exception handed to the failure
+ * callback; it never reaches the worker's task group, so the worker carries
+ * on with the next job and cancel() never throws.
+ */
+class BackgroundWorker
+{
+public:
+    using IsCancelled = std::function<bool()>;
+    using Job = std::function<void(IsCancelled const&)>;
+    using Failed = std::function<void(std::string const& what)>;
+
+public:
+    /**
+     * @param[in] on_failure Called on the worker's thread with what a job
+     *                       that threw had to say for itself (may be null)
+     */
+    explicit BackgroundWorker(Failed on_failure = nullptr);
+
+    /** Cancels any outstanding work and waits for the worker to finish. */
+    ~BackgroundWorker();
+
+    BackgroundWorker(BackgroundWorker const&) = delete;
+    BackgroundWorker& operator=(BackgroundWorker const&) = delete;
+
+    /** Queue @p job to run, superseding any pending or running job. */
+    void
+    post(Job job);
+
+    /**
+     * Cancel any pending or running job and wait until the worker is idle.
+     *
+     * Use this before destroying anything a running job may still refer to.
+     */
+    void
+    cancel() noexcept;
+
+private:
+    void
+    run();
+
+    void
+    fail(std::string const& what) noexcept;
+
+private:
+    Failed                     on_failure_;
+    std::mutex                 mutex_;
+    Job                        pending_;
+    bool                       busy_;
+    std::atomic<std::uint64_t> generation_;
+    TaskGroup                  group_;
+};
+
+#endif /* EDHELIND_BACKGROUNDWORKER_H */
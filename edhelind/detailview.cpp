@@ -0,0 +1,161 @@
+/**
+ * Paged view of the details of a Detailable
+ */
+/*
+ * Copyright 2020 Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ *
+ * This file is part of Edhelind.
+ *
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Edhelind is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Edhelind.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "edhelind/detailview.h"
+
+#include <algorithm>
+#include <limits>
+#include "libedhel/detailable.h"
+#include <QFontMetrics>
+#include <QPainter>
+#include <QPaintEvent>
+#include <QScrollBar>
+#include <sstream>
+#include <string>
+
+
+namespace
+{
+    constexpr int tab_width = 8;
+
+    /** Convert a line of detail to display text, expanding any tabs */
+    QString
+    expand_tabs(std::string const& line)
+    {
+        std::string expanded;
+        for (char c: line)
+        {
+            if (c == '\t')
+            {
+                expanded.append(tab_width - expanded.size() % tab_width, ' ');
+            }
+            else
+            {
+                expanded.push_back(c);
+            }
+        }
+        return QString::fromStdString(expanded);
+    }
+} // anonymous
+
+
+DetailView::
+DetailView(QWidget* parent)
+: QAbstractScrollArea{parent}
+, detailable_{nullptr}
+, line_count_{0}
+, widest_line_{0}
+{
+    QFont font("DejaVu Sans Mono");
+    font.setStyleHint(QFont::TypeWriter);
+    this->setFont(font);
+}
+
+
+void DetailView::
+set_detailable(Detailable const* detailable)
+{
+    detailable_ = detailable;
+    line_count_ = detailable_ ? detailable_->lineCount() : 0;
+    widest_line_ = 0;
+    this->update_scroll_bars();
+    this->verticalScrollBar()->setValue(0);
+    this->horizontalScrollBar()->setValue(0);
+    this->viewport()->update();
+}
+
+
+void DetailView::
+paintEvent(QPaintEvent* event)
+{
+    QPainter painter(this->viewport());
+    painter.fillRect(event->rect(), this->palette().color(QPalette::Base));
+    if (detailable_ == nullptr)
+    {
+        return;
+    }
+
+    QFontMetrics metrics(this->font());
+    int const line_height = metrics.height();
+    int const char_width = metrics.averageCharWidth();
+    int const x0 = char_width / 2 - this->horizontalScrollBar()->value();
+
+    std::ostringstream ostr;
+    detailable_->printLinesTo(ostr, this->verticalScrollBar()->value(), this->visible_lines() + 1);
+
+    painter.setPen(this->palette().color(QPalette::Text));
+    std::istringstream lines(ostr.str());
+    std::string line;
+    int widest = widest_line_;
+    for (int y = 0; std::getline(lines, line); y += line_height)
+    {
+        QString text = expand_tabs(line);
+        painter.drawText(x0, y + metrics.ascent(), text);
+        widest = std::max(widest, static_cast<int>(text.size()) * char_width + char_width);
+    }
+
+    // The widest line is only known for lines that have been seen, so the
+    // horizontal scroll range grows as more of the detail is looked at.
+    if (widest != widest_line_)
+    {
+        widest_line_ = widest;
+        this->update_scroll_bars();
+    }
+}
+
+
+void DetailView::
+resizeEvent(QResizeEvent* event)
+{
+    QAbstractScrollArea::resizeEvent(event);
+    this->update_scroll_bars();
+}
+
+
+void DetailView::
+scrollContentsBy(int, int)
+{
+    this->viewport()->update();
+}
+
+
+int DetailView::
+visible_lines() const
+{
+    QFontMetrics metrics(this->font());
+    return std::max(1, this->viewport()->height() / metrics.height());
+}
+
+
+void DetailView::
+update_scroll_bars()
+{
+    int page = this->visible_lines();
+    std::size_t max_first = line_count_ > static_cast<std::size_t>(page) ? line_count_ - page : 0;
+    max_first = std::min<std::size_t>(max_first, std::numeric_limits<int>::max());
+    this->verticalScrollBar()->setRange(0, static_cast<int>(max_first));
+    this->verticalScrollBar()->setPageStep(page);
+    this->verticalScrollBar()->setSingleStep(1);
+
+    int width = this->viewport()->width();
+    this->horizontalScrollBar()->setRange(0, std::max(0, widest_line_ - width));
+    this->horizontalScrollBar()->setPageStep(width);
+}
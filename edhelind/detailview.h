@@ -0,0 +1,73 @@
+/**
+ * Paged view of the details of a Detailable
+ */
+/*
+ * Copyright 2020 Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ *
+ * This file is part of Edhelind.
+ *
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Edhelind is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Edhelind.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef EDHELIND_DETAILVIEW_H
+#define EDHELIND_DETAILVIEW_H
+
+#include <cstddef>
+#include <QAbstractScrollArea>
+
+
+class Detailable;
+
+/**
+ * Display the details of a Detailable one screenful at a time.
+ *
+ * Only the lines in the viewport are ever formatted: each paint asks the
+ * Detailable for just those lines, so the cost of scrolling does not depend on
+ * how large the whole detail is.
+ */
+class DetailView
+: public QAbstractScrollArea
+{
+    Q_OBJECT
+
+public:
+    explicit DetailView(QWidget* parent = nullptr);
+
+    /** Show the details of @p detailable, or nothing if it is null. */
+    void
+    set_detailable(Detailable const* detailable);
+
+protected:
+    void
+    paintEvent(QPaintEvent* event) override;
+
+    void
+    resizeEvent(QResizeEvent* event) override;
+
+    void
+    scrollContentsBy(int dx, int dy) override;
+
+private:
+    int
+    visible_lines() const;
+
+    void
+    update_scroll_bars();
+
+private:
+    Detailable const* detailable_;
+    std::size_t       line_count_;
+    int               widest_line_;
+};
+
+#endif /* EDHELIND_DETAILVIEW_H */
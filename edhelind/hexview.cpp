@@ -0,0 +1,231 @@
+/**
+ * Hex and ASCII view of an ELF image
+ */
+/*
+ * Copyright 2020 Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ *
+ * This file is part of Edhelind.
+ *
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Edhelind is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Edhelind.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "edhelind/hexview.h"
+
+#include <algorithm>
+#include <limits>
+#include <QFontMetrics>
+#include <QPainter>
+#include <QPaintEvent>
+#include <QScrollBar>
+
+
+namespace
+{
+    constexpr int bytes_per_row = 16;
+
+    /**
+     * The largest scroll bar range used.  Images with more rows than this
+     * (a bit over 30 GB) scroll several rows per scroll bar step.
+     */
+    constexpr std::uint64_t max_scroll_steps = std::numeric_limits<int>::max() / 2;
+
+    /** Column (in characters) where the hex cell for byte @p i starts */
+    int
+    hex_column(int address_digits, int i)
+    {
+        return address_digits + 2 + i * 3 + (i >= bytes_per_row / 2 ? 1 : 0);
+    }
+
+    /** Column (in characters) where the ASCII cell for byte @p i starts */
+    int
+    ascii_column(int address_digits, int i)
+    {
+        return hex_column(address_digits, bytes_per_row) + 2 + i;
+    }
+} // anonymous
+
+
+HexView::
+HexView(QWidget* parent)
+: QAbstractScrollArea{parent}
+, has_image_{false}
+, highlight_offset_{0}
+, highlight_size_{0}
+, rows_per_step_{1}
+{
+    QFont font("DejaVu Sans Mono");
+    font.setStyleHint(QFont::TypeWriter);
+    this->setFont(font);
+}
+
+
+void HexView::
+set_image(ElfImageView const& image)
+{
+    image_ = image;
+    has_image_ = true;
+    highlight_offset_ = 0;
+    highlight_size_ = 0;
+    this->update_scroll_bar();
+    this->verticalScrollBar()->setValue(0);
+    this->viewport()->update();
+}
+
+
+void HexView::
+clear()
+{
+    has_image_ = false;
+    highlight_size_ = 0;
+    this->update_scroll_bar();
+    this->viewport()->update();
+}
+
+
+void HexView::
+set_highlight(std::uint64_t offset, std::uint64_t size)
+{
+    highlight_offset_ = offset;
+    highlight_size_ = size;
+    this->viewport()->update();
+}
+
+
+void HexView::
+scroll_to(std::uint64_t offset)
+{
+    std::uint64_t row = offset / bytes_per_row;
+    this->verticalScrollBar()->setValue(static_cast<int>(row / rows_per_step_));
+}
+
+
+void HexView::
+paintEvent(QPaintEvent* event)
+{
+    QPainter painter(this->viewport());
+    painter.fillRect(event->rect(), this->palette().color(QPalette::Base));
+    if (!has_image_)
+    {
+        return;
+    }
+
+    QFontMetrics metrics(this->font());
+    int const line_height = metrics.height();
+    int const char_width = metrics.averageCharWidth();
+    int const x0 = char_width / 2 - this->horizontalScrollBar()->value();
+    int const address_digits = image_.size() > std::numeric_limits<std::uint32_t>::max() ? 16 : 8;
+
+    QColor highlight = this->palette().color(QPalette::Highlight);
+    highlight.setAlpha(80);
+    painter.setPen(this->palette().color(QPalette::Text));
+
+    std::uint64_t const rows = this->row_count();
+    std::uint64_t row = this->first_row();
+    for (int line = 0; line <= this->visible_rows() && row < rows; ++line, ++row)
+    {
+        int const y = line * line_height;
+        std::uint64_t const row_offset = row * bytes_per_row;
+
+        QString text = QString("%1  ").arg(row_offset, address_digits, 16, QChar('0'));
+        QString ascii;
+        for (int i = 0; i < bytes_per_row; ++i)
+        {
+            std::uint64_t const at = row_offset + i;
+            if (i == bytes_per_row / 2)
+            {
+                text += ' ';
+            }
+            if (at >= image_.size())
+            {
+                text += "   ";
+                ascii += ' ';
+                continue;
+            }
+
+            if (at >= highlight_offset_ && at - highlight_offset_ < highlight_size_)
+            {
+                painter.fillRect(QRect(x0 + hex_column(address_digits, i) * char_width, y,
+                                       char_width * 3, line_height), highlight);
+                painter.fillRect(QRect(x0 + ascii_column(address_digits, i) * char_width, y,
+                                       char_width, line_height), highlight);
+            }
+
+            std::uint8_t byte = image_.get_uint8(at);
+            text += QString("%1 ").arg(byte, 2, 16, QChar('0'));
+            ascii += (byte >= 0x20 && byte < 0x7f) ? QChar(byte) : QChar('.');
+        }
+        text += " " + ascii;
+        painter.drawText(x0, y + metrics.ascent(), text);
+    }
+}
+
+
+void HexView::
+resizeEvent(QResizeEvent* event)
+{
+    QAbstractScrollArea::resizeEvent(event);
+    this->update_scroll_bar();
+}
+
+
+void HexView::
+scrollContentsBy(int, int)
+{
+    this->viewport()->update();
+}
+
+
+std::uint64_t HexView::
+row_count() const
+{
+    if (!has_image_)
+    {
+        return 0;
+    }
+    return (static_cast<std::uint64_t>(image_.size()) + bytes_per_row - 1) / bytes_per_row;
+}
+
+
+std::uint64_t HexView::
+first_row() const
+{
+    return static_cast<std::uint64_t>(this->verticalScrollBar()->value()) * rows_per_step_;
+}
+
+
+int HexView::
+visible_rows() const
+{
+    QFontMetrics metrics(this->font());
+    return std::max(1, this->viewport()->height() / metrics.height());
+}
+
+
+void HexView::
+update_scroll_bar()
+{
+    std::uint64_t rows = this->row_count();
+    int page = this->visible_rows();
+
+    rows_per_step_ = std::max<std::uint64_t>(1, (rows + max_scroll_steps - 1) / max_scroll_steps);
+    std::uint64_t steps = rows > static_cast<std::uint64_t>(page) ? (rows - page) / rows_per_step_ + 1 : 0;
+    this->verticalScrollBar()->setRange(0, static_cast<int>(steps));
+    this->verticalScrollBar()->setPageStep(std::max(1, static_cast<int>(page / rows_per_step_)));
+    this->verticalScrollBar()->setSingleStep(1);
+
+    QFontMetrics metrics(this->font());
+    int const address_digits = has_image_ && image_.size() > std::numeric_limits<std::uint32_t>::max() ? 16 : 8;
+    int const content_width = (ascii_column(address_digits, bytes_per_row) + 1) * metrics.averageCharWidth();
+    this->horizontalScrollBar()->setRange(0, std::max(0, content_width - this->viewport()->width()));
+    this->horizontalScrollBar()->setPageStep(this->viewport()->width());
+}
@@ -0,0 +1,94 @@
+/**
+ * Hex and ASCII view of an ELF image
+ */
+/*
+ * Copyright 2020 Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ *
+ * This file is part of Edhelind.
+ *
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Edhelind is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Edhelind.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef EDHELIND_HEXVIEW_H
+#define EDHELIND_HEXVIEW_H
+
+#include <cstdint>
+#include "libedhel/elfimage.h"
+#include <QAbstractScrollArea>
+
+
+/**
+ * A classic hex dump of an ElfImageView: offset, 16 bytes in hex, and the same
+ * bytes as ASCII.
+ *
+ * Nothing is formatted ahead of time.  Bytes are read straight out of the
+ * image when a row is painted and only the rows in the viewport are ever
+ * painted, so the size of the image makes no difference.  A byte range can be
+ * highlighted to show where the currently selected section or segment lives.
+ */
+class HexView
+: public QAbstractScrollArea
+{
+    Q_OBJECT
+
+public:
+    explicit HexView(QWidget* parent = nullptr);
+
+    /** Show the bytes of @p image. */
+    void
+    set_image(ElfImageView const& image);
+
+    /** Show nothing at all. */
+    void
+    clear();
+
+    /** Highlight @p size bytes starting at @p offset, or nothing if @p size is 0. */
+    void
+    set_highlight(std::uint64_t offset, std::uint64_t size);
+
+    /** Scroll so the row containing @p offset is at the top of the view. */
+    void
+    scroll_to(std::uint64_t offset);
+
+protected:
+    void
+    paintEvent(QPaintEvent* event) override;
+
+    void
+    resizeEvent(QResizeEvent* event) override;
+
+    void
+    scrollContentsBy(int dx, int dy) override;
+
+private:
+    std::uint64_t
+    row_count() const;
+
+    std::uint64_t
+    first_row() const;
+
+    int
+    visible_rows() const;
+
+    void
+    update_scroll_bar();
+
+private:
+    ElfImageView  image_;
+    bool          has_image_;
+    std::uint64_t highlight_offset_;
+    std::uint64_t highlight_size_;
+    std::uint64_t rows_per_step_;
+};
+
+#endif /* EDHELIND_HEXVIEW_H */
@@ -22,6 +22,10 @@
 #include "edhelind_config.h"
 
 #include "edhelind/mainwindow.h"
+#include <exception>
+#include <iostream>
+#include "libedhel/elffile.h"
+#include "libedhel/trace.h"
 #include <QApplication>
 #include <QCommandLineParser>
 
@@ -38,11 +42,46 @@ main(int argc, char* argv[])
     cli_parser.setApplicationDescription(QCoreApplication::applicationName());
     cli_parser.addHelpOption();
     cli_parser.addVersionOption();
-    cli_parser.addPositionalArgument("FILE", "the ELF file to open");
+    cli_parser.addPositionalArgument("FILE", "the ELF files to open", "[FILE...]");
+    QCommandLineOption statistics_option("parse-statistics",
+                                         "print what parsing each FILE costs in time and memory and exit");
+    cli_parser.addOption(statistics_option);
+#if defined(EDHELIND_TRACING)
+    QCommandLineOption trace_option("trace", "write a Chrome trace of the session to FILE", "FILE");
+    cli_parser.addOption(trace_option);
+#endif
     cli_parser.process(app);
 
-    MainWindow main_window(cli_parser.positionalArguments().isEmpty() ? ""
-                           : cli_parser.positionalArguments().first());
+#if defined(EDHELIND_TRACING)
+    if (cli_parser.isSet(trace_option))
+    {
+        trace_start(cli_parser.value(trace_option).toStdString());
+    }
+#endif
+
+    if (cli_parser.isSet(statistics_option))
+    {
+        int status = 0;
+        for (QString const& file_name: cli_parser.positionalArguments())
+        {
+            try
+            {
+                ElfFile elf_file(file_name.toStdString());
+                std::cout << file_name.toStdString() << ":\n" << elf_file.statistics() << elf_file.memory();
+            }
+            catch (std::exception const& ex)
+            {
+                std::cerr << file_name.toStdString() << ": " << ex.what() << "\n";
+                status = 1;
+            }
+        }
+        trace_stop();
+        return status;
+    }
+
+    MainWindow main_window(cli_parser.positionalArguments());
     main_window.show();
-    return app.exec();
+    int status = app.exec();
+    trace_stop();
+    return status;
 }
@@ -21,19 +21,27 @@
  */
 #include "edhelind_config.h"
 
+#include "edhelind/detailview.h"
+#include "edhelind/hexview.h"
+#include "edhelind/searchresultmodel.h"
+#include "edhelind/symboltablemodel.h"
 #include "libedhel/elffile.h"
 #include "libedhel/section.h"
 #include "libedhel/section_note.h"
+#include "libedhel/section_symtab.h"
 #include "libedhel/segment.h"
 #include "libedhel/segment_interp.h"
 #include "libedhel/segment_note.h"
+#include "libedhel/trace.h"
 #include "mainwindow.h"
-#include <sstream>
 #include "ui_mainwindow.h"
 
+#include <algorithm>
+#include <limits>
 #include <QApplication>
 #include <QCloseEvent>
 #include <QFileDialog>
+#include <QHeaderView>
 #include <QMessageBox>
 #include <QModelIndex>
 #include <QStandardItem>
@@ -41,19 +49,50 @@
 
 
 MainWindow::
-MainWindow(QString const& file_name, QWidget *parent)
+MainWindow(QStringList const& file_names, QWidget *parent)
 : QMainWindow{parent}
 , ui_{std::make_unique<Ui::MainWindow>()}
+, elf_cache_{8, std::numeric_limits<std::size_t>::max(), ParseOptions{0}}
 , tree_model_(new QStandardItemModel(this))
+, sections_item_(nullptr)
+, symbol_model_(new SymbolTableModel(this))
+, search_model_(new SearchResultModel(this))
 {
     ui_->setupUi(this);
-    this->set_current_file(file_name);
+
+    // Rows are a fixed height so the view never has to measure all of them.
+    ui_->symbol_view_->verticalHeader()->setSectionResizeMode(QHeaderView::Fixed);
+    ui_->symbol_view_->horizontalHeader()->setSortIndicator(-1, Qt::AscendingOrder);
+    ui_->symbol_view_->setModel(symbol_model_);
+    ui_->symbol_view_->setSortingEnabled(true);
+    ui_->detail_tabs_->setTabEnabled(ui_->detail_tabs_->indexOf(ui_->symbols_tab_), false);
+    connect(ui_->symbol_filter_, SIGNAL(textChanged(QString const&)),
+            symbol_model_, SLOT(set_filter(QString const&)));
+    connect(ui_->hex_goto_, SIGNAL(returnPressed()),
+            this, SLOT(goto_hex_location()));
+    ui_->search_results_->setModel(search_model_);
+    connect(ui_->search_text_, SIGNAL(textChanged(QString const&)),
+            search_model_, SLOT(search(QString const&)));
+    connect(search_model_, SIGNAL(search_finished(int)),
+            this, SLOT(search_finished(int)));
+    connect(symbol_model_, SIGNAL(failed(QString const&)),
+            this, SLOT(background_failed(QString const&)));
+    connect(search_model_, SIGNAL(failed(QString const&)),
+            this, SLOT(background_failed(QString const&)));
+    connect(ui_->search_results_, SIGNAL(activated(QModelIndex const&)),
+            this, SLOT(show_search_hit(QModelIndex const&)));
+
     tree_model_->setHorizontalHeaderLabels(QStringList{tr("Field"),
                                                        tr("Value"),
                                                        tr("Description")});
-
+    ui_->tree_view_->setModel(tree_model_);
     connect(ui_->tree_view_->selectionModel(), SIGNAL(currentChanged(QModelIndex const&, QModelIndex const&)),
             this, SLOT(on_current_changed(QModelIndex const&, QModelIndex const&)));
+
+    for (QString const& file_name: file_names)
+    {
+        this->open_file(file_name);
+    }
 }
 
 
@@ -66,7 +105,29 @@ MainWindow::
 void MainWindow::
 on_action_open_triggered()
 {
-    this->set_current_file(QFileDialog::getOpenFileName(this));
+    for (QString const& file_name: QFileDialog::getOpenFileNames(this))
+    {
+        this->open_file(file_name);
+    }
+}
+
+
+void MainWindow::
+on_action_close_triggered()
+{
+    auto it = std::find_if(open_files_.begin(), open_files_.end(), [this](OpenFile const& open_file) {
+        return open_file.elf_file_ == elf_file_;
+    });
+    if (it == open_files_.end())
+    {
+        return;
+    }
+
+    // Let go of everything looking into the file before letting go of the file.
+    this->set_current_file(nullptr);
+    QStandardItem* root_item = it->root_item_;
+    open_files_.erase(it);
+    tree_model_->removeRow(root_item->row());
 }
 
 
@@ -90,32 +151,183 @@ on_action_exit_triggered()
 void MainWindow::
 on_current_changed(QModelIndex const& current, QModelIndex const&)
 {
+    QModelIndex top = current;
+    while (top.parent().isValid())
+    {
+        top = top.parent();
+    }
+    QStandardItem* root_item = tree_model_->itemFromIndex(top.sibling(top.row(), 0));
+    auto it = std::find_if(open_files_.begin(), open_files_.end(), [root_item](OpenFile const& open_file) {
+        return open_file.root_item_ == root_item;
+    });
+    this->set_current_file(it == open_files_.end() ? nullptr : &*it);
+
     QVariant v = tree_model_->data(current, Qt::UserRole+1);
-    if (v.isValid() != true)
+    Detailable const* displayable = nullptr;
+    if (v.isValid() == true)
+    {
+        displayable = static_cast<Detailable const*>(v.value<void*>());
+    }
+    ui_->detail_view_->set_detailable(displayable);
+    this->show_symbols(dynamic_cast<Section_SYMTAB const*>(displayable));
+    this->show_in_hex_view(displayable);
+}
+
+
+void MainWindow::
+goto_hex_location()
+{
+    if (elf_file_ == nullptr)
+    {
+        return;
+    }
+
+    bool ok = false;
+    std::uint64_t location = ui_->hex_goto_->text().trimmed().toULongLong(&ok, 0);
+    if (!ok)
+    {
+        ui_->status_bar_->showMessage(tr("'%1' is not a number").arg(ui_->hex_goto_->text()), 5000);
+        return;
+    }
+
+    if (ui_->hex_goto_mode_->currentIndex() == 1)
     {
-        ui_->text_view_->clear();
+        auto offset = elf_file_->segment_table().vaddr_to_offset(location);
+        if (!offset)
+        {
+            ui_->status_bar_->showMessage(tr("Address 0x%1 is not loaded from the file")
+                                            .arg(location, 0, 16), 5000);
+            return;
+        }
+        location = *offset;
     }
-    else
+
+    if (location >= elf_file_->size())
     {
-        Detailable const* displayable = static_cast<Detailable const*>(v.value<void*>());
-        std::ostringstream ostr ;
-        ostr << *displayable;
-        ui_->text_view_->setPlainText(QString::fromStdString(ostr.str()));
+        ui_->status_bar_->showMessage(tr("Offset 0x%1 is past the end of the file")
+                                        .arg(location, 0, 16), 5000);
+        return;
     }
+    ui_->hex_view_->set_highlight(location, 1);
+    ui_->hex_view_->scroll_to(location);
+    ui_->detail_tabs_->setCurrentWidget(ui_->hex_tab_);
 }
 
 
+/*!
+ * Take the user to whatever the search hit at @p index was found in.
+ */
 void MainWindow::
-set_current_file(QString const& file_name)
+show_search_hit(QModelIndex const& index)
+{
+    if (!index.isValid() || sections_item_ == nullptr)
+    {
+        return;
+    }
+
+    SearchHit const& hit = search_model_->hit(index.row());
+    QStandardItem* section_item = sections_item_->child(static_cast<int>(hit.section_));
+    if (section_item != nullptr)
+    {
+        ui_->tree_view_->setCurrentIndex(tree_model_->indexFromItem(section_item));
+    }
+
+    switch (hit.kind_)
+    {
+    case SearchHit::Kind::SectionName:
+        ui_->detail_tabs_->setCurrentWidget(ui_->details_tab_);
+        break;
+    case SearchHit::Kind::SymbolName:
+        ui_->symbol_filter_->setText(QString::fromStdString(hit.text_));
+        ui_->detail_tabs_->setCurrentWidget(ui_->symbols_tab_);
+        break;
+    case SearchHit::Kind::String:
+    {
+        std::uint64_t offset = elf_file_->section(hit.section_).offset() + hit.index_;
+        ui_->hex_view_->set_highlight(offset, hit.text_.size() + 1);
+        ui_->hex_view_->scroll_to(offset);
+        ui_->detail_tabs_->setCurrentWidget(ui_->hex_tab_);
+        break;
+    }
+    }
+}
+
+
+void MainWindow::
+search_finished(int hits)
+{
+    ui_->status_bar_->showMessage(tr("%n match(es)", nullptr, hits), 5000);
+}
+
+
+void MainWindow::
+background_failed(QString const& what)
+{
+    ui_->status_bar_->showMessage(tr("Error: %1").arg(what), 5000);
+}
+
+
+void MainWindow::
+show_symbols(Section_SYMTAB const* symtab)
+{
+    int symbols_tab = ui_->detail_tabs_->indexOf(ui_->symbols_tab_);
+    ui_->detail_tabs_->setTabEnabled(symbols_tab, symtab != nullptr);
+    symbol_model_->set_symbol_table(symtab);
+    if (symtab != nullptr)
+    {
+        ui_->symbol_view_->resizeColumnsToContents();
+    }
+}
+
+
+/*!
+ * Highlight the bytes of the file that @p detailable was read from, if any.
+ */
+void MainWindow::
+show_in_hex_view(Detailable const* detailable)
+{
+    std::uint64_t offset = 0;
+    std::uint64_t size = 0;
+    if (auto const* section = dynamic_cast<Section const*>(detailable))
+    {
+        offset = section->offset();
+        size = section->type() == SType::SHT_NOBITS ? 0 : section->size();
+    }
+    else if (auto const* segment = dynamic_cast<Segment const*>(detailable))
+    {
+        offset = segment->offset();
+        size = segment->filesz();
+    }
+    else if (auto const* elf_header = dynamic_cast<ElfHeader const*>(detailable))
+    {
+        size = elf_header->ehsize();
+    }
+
+    ui_->hex_view_->set_highlight(offset, size);
+    if (size != 0)
+    {
+        ui_->hex_view_->scroll_to(offset);
+    }
+}
+
+
+/*!
+ * Open @p file_name alongside the files already open and select it.
+ *
+ * The file is parsed only if the session has not parsed it already; opening a
+ * file that is already open just selects it.
+ */
+void MainWindow::
+open_file(QString const& file_name)
 {
-    tree_model_->clear();
     if (file_name.isEmpty()) {
         return;
     }
 
+    std::shared_ptr<ElfFile const> elf_file;
     try
     {
-        elf_file_ = std::make_unique<ElfFile>(file_name.toStdString());
+        elf_file = elf_cache_.open(file_name.toStdString());
     } catch (std::exception &ex) {
         QMessageBox::critical(this,
                               tr("Error opening %1").arg(file_name),
@@ -123,25 +335,75 @@ set_current_file(QString const& file_name)
         return;
     }
 
-    QStandardItem* root = tree_model_->invisibleRootItem();
-    QList<QStandardItem*> file_row{this->prepare_row(file_name, "")};
+    auto it = std::find_if(open_files_.begin(), open_files_.end(), [&elf_file](OpenFile const& open_file) {
+        return open_file.elf_file_ == elf_file;
+    });
+    if (it == open_files_.end())
+    {
+        EDHEL_TRACE_ZONE("populate file tree", file_name.toStdString());
+        QList<QStandardItem*> file_row{this->prepare_row(file_name, "")};
+        QStandardItem* sections_item = this->display_sections(*elf_file);
+        file_row.first()->appendRow(this->display_elf_header(*elf_file));
+        file_row.first()->appendRow(sections_item);
+        file_row.first()->appendRow(this->display_segments(*elf_file));
+        QStandardItem* statistics = new QStandardItem(tr("Parse statistics"));
+        statistics->setData(QVariant::fromValue((void*)&elf_file->statistics()), Qt::UserRole+1);
+        file_row.first()->appendRow(statistics);
+        QStandardItem* memory = new QStandardItem(tr("Memory"));
+        memory->setData(QVariant::fromValue((void*)&elf_file->memory()), Qt::UserRole+1);
+        file_row.first()->appendRow(memory);
+        tree_model_->invisibleRootItem()->appendRow(file_row);
+        it = open_files_.insert(open_files_.end(), OpenFile{file_name, elf_file, file_row.first(), sections_item});
 
-    root->appendRow(file_row);
-    file_row.first()->appendRow(this->display_elf_header());
-    file_row.first()->appendRow(this->display_sections());
-    file_row.first()->appendRow(this->display_segments());
-    ui_->tree_view_->setModel(tree_model_);
-    ui_->tree_view_->expandAll();
-    ui_->tree_view_->resizeColumnToContents(0);
-    ui_->tree_view_->resizeColumnToContents(1);
-    ui_->tree_view_->expandToDepth(1);
+        QModelIndex root_index = tree_model_->indexFromItem(it->root_item_);
+        ui_->tree_view_->expand(root_index);
+        for (int row = 0; row < it->root_item_->rowCount(); ++row)
+        {
+            ui_->tree_view_->expand(tree_model_->index(row, 0, root_index));
+        }
+        ui_->tree_view_->resizeColumnToContents(0);
+        ui_->tree_view_->resizeColumnToContents(1);
+    }
+    ui_->tree_view_->setCurrentIndex(tree_model_->indexFromItem(it->root_item_));
+}
+
+
+/*!
+ * Point the hex view and search at @p open_file, or at nothing if it is null.
+ */
+void MainWindow::
+set_current_file(OpenFile const* open_file)
+{
+    std::shared_ptr<ElfFile const> elf_file = open_file ? open_file->elf_file_ : nullptr;
+    if (elf_file == elf_file_)
+    {
+        return;
+    }
+
+    ui_->detail_view_->set_detailable(nullptr);
+    this->show_symbols(nullptr);
+    search_model_->set_elf_file(nullptr);
+    ui_->hex_view_->clear();
+
+    elf_file_ = elf_file;
+    sections_item_ = open_file ? open_file->sections_item_ : nullptr;
+    this->setWindowTitle(open_file ? QString("%1 - %2").arg(open_file->file_name_).arg(EDHELIND_PROJECT_NAME)
+                                   : QString(EDHELIND_PROJECT_NAME));
+    if (elf_file_ == nullptr)
+    {
+        return;
+    }
+
+    ui_->hex_view_->set_image(elf_file_->view(0, elf_file_->size()));
+    search_model_->set_elf_file(elf_file_.get());
+    search_model_->search(ui_->search_text_->text());
 }
 
 
 QStandardItem* MainWindow::
-display_elf_header() const
+display_elf_header(ElfFile const& elf_file) const
 {
-    ElfHeader const& elf_header = elf_file_->elf_header();
+    ElfHeader const& elf_header = elf_file.elf_header();
     QStandardItem* header = new QStandardItem("ELF Header");
     header->appendRow(prepare_row("eh_type:", QString::fromStdString(elf_header.type_string())));
     header->appendRow(prepare_row("e_entry:", QString("0x%1").arg(elf_header.entry(), 8, 16, QChar('0'))));
@@ -160,10 +422,10 @@ display_elf_header() const
 
 
 QStandardItem* MainWindow::
-display_sections() const
+display_sections(ElfFile const& elf_file) const
 {
     QStandardItem* sections = new QStandardItem("Sections");
-    elf_file_->section_table().iterate_sections([&](Section const& section){
+    elf_file.section_table().iterate_sections([&](Section const& section){
             QStandardItem* sec = new QStandardItem(QString::fromStdString(section.name_string()));
             sec->appendRow(this->prepare_row("sh_type:", QString::fromStdString(section.type_string())));
             sec->appendRow(this->prepare_row("sh_flags:", QString::fromStdString(section.flags_string())));
@@ -198,10 +460,10 @@ display_sections() const
 
 
 QStandardItem* MainWindow::
-display_segments() const
+display_segments(ElfFile const& elf_file) const
 {
     QStandardItem* segments = new QStandardItem("Segments");
-    elf_file_->segment_table().iterate_segments([&](Segment const& segment){
+    elf_file.segment_table().iterate_segments([&](Segment const& segment){
             QStandardItem* seg = new QStandardItem(QString::fromStdString(segment.type_string()));
             seg->appendRow(this->prepare_row("p_flags:", QString::fromStdString(segment.flags_string())));
             seg->appendRow(this->prepare_row("p_offset:", QString("0x%1").arg(segment.offset(), 8, 16, QChar('0'))));
@@ -22,17 +22,23 @@
 #ifndef EDHELIND_MAINWINDOW_H
 #define EDHELIND_MAINWINDOW_H
 
+#include "libedhel/elffilecache.h"
 #include <memory>
 #include <QMainWindow>
+#include <vector>
 
 
 namespace Ui {
     class MainWindow;
 }
 
+class Detailable;
 class ElfFile;
+class Section_SYMTAB;
 class QStandardItem;
 class QStandardItemModel;
+class SearchResultModel;
+class SymbolTableModel;
 
 class MainWindow
 : public QMainWindow
@@ -40,13 +46,16 @@ class MainWindow
     Q_OBJECT
 
 public:
-    explicit MainWindow(QString const& file_name, QWidget *parent = 0);
+    explicit MainWindow(QStringList const& file_names, QWidget *parent = 0);
     ~MainWindow();
 
 private slots:
     void
     on_action_open_triggered();
 
+    void
+    on_action_close_triggered();
+
     void
     on_action_about_triggered();
 
@@ -56,26 +65,61 @@ private slots:
     void
     on_current_changed(const QModelIndex &current, const QModelIndex &previous);
 
+    void
+    goto_hex_location();
+
+    void
+    show_search_hit(QModelIndex const& index);
+
+    void
+    search_finished(int hits);
+
+    void
+    background_failed(QString const& what);
+
 private:
+    /** A file open in this window */
+    struct OpenFile
+    {
+        QString                        file_name_;
+        std::shared_ptr<ElfFile const> elf_file_;
+        QStandardItem*                 root_item_;
+        QStandardItem*                 sections_item_;
+    };
+
+    void
+    open_file(QString const& file_name);
+
+    void
+    set_current_file(OpenFile const* open_file);
+
+    void
+    show_symbols(Section_SYMTAB const* symtab);
+
     void
-    set_current_file(QString const& file_name);
+    show_in_hex_view(Detailable const* detailable);
 
     QStandardItem*
-    display_elf_header() const;
+    display_elf_header(ElfFile const& elf_file) const;
 
     QStandardItem*
-    display_sections() const;
+    display_sections(ElfFile const& elf_file) const;
 
     QStandardItem*
-    display_segments() const;
+    display_segments(ElfFile const& elf_file) const;
 
     QList<QStandardItem*>
     prepare_row(QString const& label, QString const& value) const;
 
 private:
     std::unique_ptr<Ui::MainWindow> ui_;
-    std::unique_ptr<ElfFile>        elf_file_;
+    ElfFileCache                    elf_cache_;
+    std::vector<OpenFile>           open_files_;
+    std::shared_ptr<ElfFile const>  elf_file_;
     QStandardItemModel*             tree_model_;
+    QStandardItem*                  sections_item_;
+    SymbolTableModel*               symbol_model_;
+    SearchResultModel*              search_model_;
 };
 
 #endif /* EDHELIND_MAINWINDOW_H */
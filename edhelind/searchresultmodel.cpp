@@ -0,0 +1,188 @@
+/**
+ * List model holding the results of searching an ELF file
+ */
+/*
+ * Copyright 2020 Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ *
+ * This file is part of Edhelind.
+ *
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Edhelind is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Edhelind.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "edhelind/searchresultmodel.h"
+
+#include "libedhel/elffile.h"
+#include "libedhel/section.h"
+#include <string>
+
+
+namespace
+{
+    /** Hits are handed to the GUI in batches of this many */
+    constexpr std::size_t batch_size = 256;
+
+    /** Stop looking after this many hits: nobody is going to read them all */
+    constexpr std::size_t max_hits = 100000;
+} // anonymous
+
+
+SearchResultModel::
+SearchResultModel(QObject* parent)
+: QAbstractListModel{parent}
+, elf_file_{nullptr}
+, request_{0}
+, pending_request_{0}
+, pending_done_{false}
+, worker_{[this](std::string const& what) { emit failed(QString::fromStdString(what)); }}
+{
+}
+
+
+SearchResultModel::
+~SearchResultModel()
+{
+    worker_.cancel();
+}
+
+
+void SearchResultModel::
+set_elf_file(ElfFile const* elf_file)
+{
+    worker_.cancel();
+    ++request_;
+
+    beginResetModel();
+    elf_file_ = elf_file;
+    hits_.clear();
+    endResetModel();
+}
+
+
+SearchHit const& SearchResultModel::
+hit(int row) const
+{
+    return hits_.at(row);
+}
+
+
+int SearchResultModel::
+rowCount(QModelIndex const& parent) const
+{
+    return parent.isValid() ? 0 : static_cast<int>(hits_.size());
+}
+
+
+QVariant SearchResultModel::
+data(QModelIndex const& index, int role) const
+{
+    if (!index.isValid() || role != Qt::DisplayRole || index.row() >= static_cast<int>(hits_.size()))
+    {
+        return QVariant();
+    }
+
+    SearchHit const& hit = hits_[index.row()];
+    QString where = QString::fromStdString(elf_file_->section(hit.section_).name_string());
+    switch (hit.kind_)
+    {
+    case SearchHit::Kind::SectionName:
+        return tr("section   %1").arg(QString::fromStdString(hit.text_));
+    case SearchHit::Kind::SymbolName:
+        return tr("symbol    %1  (%2 #%3)").arg(QString::fromStdString(hit.text_)).arg(where).arg(hit.index_);
+    case SearchHit::Kind::String:
+        return tr("string    %1  (%2+0x%3)").arg(QString::fromStdString(hit.text_)).arg(where).arg(hit.index_, 0, 16);
+    }
+    return QVariant();
+}
+
+
+void SearchResultModel::
+search(QString const& text)
+{
+    ++request_;
+    beginResetModel();
+    hits_.clear();
+    endResetModel();
+
+    std::string needle = text.toStdString();
+    if (elf_file_ == nullptr || needle.empty())
+    {
+        worker_.cancel();
+        return;
+    }
+
+    ElfFile const* elf_file = elf_file_;
+    std::uint64_t request = request_;
+    worker_.post([=](BackgroundWorker::IsCancelled const& is_cancelled) {
+        std::vector<SearchHit> batch;
+        std::size_t found = 0;
+
+        auto flush = [&](bool done) {
+            {
+                std::lock_guard<std::mutex> lock(pending_mutex_);
+                if (pending_request_ != request)
+                {
+                    pending_.clear();
+                    pending_request_ = request;
+                }
+                pending_.insert(pending_.end(), batch.begin(), batch.end());
+                pending_done_ = done;
+            }
+            batch.clear();
+            QMetaObject::invokeMethod(this, "take_hits", Qt::QueuedConnection);
+        };
+
+        search_elf_file(*elf_file, needle, [&](SearchHit const& hit) {
+            batch.push_back(hit);
+            if (batch.size() == batch_size)
+            {
+                flush(false);
+            }
+            return ++found < max_hits;
+        }, is_cancelled);
+
+        if (!is_cancelled())
+        {
+            flush(true);
+        }
+    });
+}
+
+
+void SearchResultModel::
+take_hits()
+{
+    std::vector<SearchHit> hits;
+    bool done = false;
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex_);
+        if (pending_request_ != request_)
+        {
+            return;
+        }
+        hits.swap(pending_);
+        done = pending_done_;
+        pending_done_ = false;
+    }
+
+    if (!hits.empty())
+    {
+        int first = static_cast<int>(hits_.size());
+        beginInsertRows(QModelIndex(), first, first + static_cast<int>(hits.size()) - 1);
+        hits_.insert(hits_.end(), std::make_move_iterator(hits.begin()), std::make_move_iterator(hits.end()));
+        endInsertRows();
+    }
+    if (done)
+    {
+        emit search_finished(static_cast<int>(hits_.size()));
+    }
+}
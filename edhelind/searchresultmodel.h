@@ -0,0 +1,96 @@
+/**
+ * List model holding the results of searching an ELF file
+ */
+/*
+ * Copyright 2020 Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ *
+ * This file is part of Edhelind.
+ *
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Edhelind is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Edhelind.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef EDHELIND_SEARCHRESULTMODEL_H
+#define EDHELIND_SEARCHRESULTMODEL_H
+
+#include "edhelind/backgroundworker.h"
+#include <cstdint>
+#include "libedhel/search.h"
+#include <mutex>
+#include <QAbstractListModel>
+#include <vector>
+
+
+class ElfFile;
+
+/**
+ * Search-as-you-type results for an ElfFile.
+ *
+ * Each new search cancels the one before it.  The search itself runs on a
+ * background worker and its hits are streamed into the model in batches as
+ * they are found, so the first results show up long before a search of a
+ * large file finishes.
+ */
+class SearchResultModel
+: public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    explicit SearchResultModel(QObject* parent = nullptr);
+    ~SearchResultModel();
+
+    /** Search @p elf_file from now on, or nothing if it is null. */
+    void
+    set_elf_file(ElfFile const* elf_file);
+
+    /** The hit shown in @p row */
+    SearchHit const&
+    hit(int row) const;
+
+    int
+    rowCount(QModelIndex const& parent = QModelIndex()) const override;
+
+    QVariant
+    data(QModelIndex const& index, int role = Qt::DisplayRole) const override;
+
+public slots:
+    /** Start searching for @p text, abandoning any search in progress. */
+    void
+    search(QString const& text);
+
+signals:
+    /** Emitted when a search has run to completion with @p hits results. */
+    void
+    search_finished(int hits);
+
+    /** Emitted when a search was abandoned because of @p what. */
+    void
+    failed(QString const& what);
+
+private slots:
+    void
+    take_hits();
+
+private:
+    ElfFile const*         elf_file_;
+    std::vector<SearchHit> hits_;
+    std::uint64_t          request_;
+
+    std::mutex             pending_mutex_;
+    std::uint64_t          pending_request_;
+    std::vector<SearchHit> pending_;
+    bool                   pending_done_;
+    BackgroundWorker       worker_;
+};
+
+#endif /* EDHELIND_SEARCHRESULTMODEL_H */
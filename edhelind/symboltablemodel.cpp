@@ -0,0 +1,409 @@
+/**
+ * Table model presenting the symbols of a symbol table section
+ */
+/*
+ * Copyright 2020 Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ *
+ * This file is part of Edhelind.
+ *
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Edhelind is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Edhelind.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#include "edhelind/symboltablemodel.h"
+
+#include <algorithm>
+#include <cctype>
+#include <exception>
+#include <functional>
+#include "libedhel/parallel_sort.h"
+#include "libedhel/section_strtab.h"
+#include "libedhel/section_symtab.h"
+#include "libedhel/symbol.h"
+#include "libedhel/trace.h"
+#include <numeric>
+#include <string_view>
+#include <utility>
+
+
+namespace
+{
+    /** How often (in rows) long-running loops check for cancellation */
+    constexpr std::size_t cancel_check_interval = 4096;
+
+    /** Case-insensitive match of a pre-lowercased @p needle in @p haystack */
+    bool
+    contains_nocase(std::string_view haystack, std::string const& needle)
+    {
+        auto it = std::search(haystack.begin(), haystack.end(), needle.begin(), needle.end(),
+                              [](char lhs, char rhs) {
+                                  return std::tolower(static_cast<unsigned char>(lhs)) == rhs;
+                              });
+        return it != haystack.end();
+    }
+
+    /** The numeric sort key of @p symbol in @p column */
+    std::uint64_t
+    numeric_key(Symbol const& symbol, int column)
+    {
+        switch (column)
+        {
+        case SymbolTableModel::Value:      return symbol.value();
+        case SymbolTableModel::Size:       return symbol.size();
+        case SymbolTableModel::Bind:       return symbol.bind();
+        case SymbolTableModel::Type:       return symbol.type();
+        case SymbolTableModel::Visibility: return symbol.other() & STO_EXPORT;
+        case SymbolTableModel::Shndx:      return symbol.shndx();
+        default:                           return 0;
+        }
+    }
+
+    /**
+     * Sort @p rows by the key @p key_of extracts from each symbol.
+     *
+     * The keys are pulled out once up front so the (parallel) sort itself only
+     * shuffles small (key, index) pairs around.  Ties are broken by symbol
+     * index so the order is deterministic.
+     */
+    template<typename KeyOf>
+    bool
+    sort_rows(std::vector<std::uint32_t>& rows, Qt::SortOrder order, KeyOf key_of,
+              BackgroundWorker::IsCancelled const& is_cancelled)
+    {
+        using Key = decltype(key_of(std::uint32_t{}));
+        std::vector<std::pair<Key, std::uint32_t>> keyed;
+        keyed.reserve(rows.size());
+        for (std::size_t i = 0; i < rows.size(); ++i)
+        {
+            if (i % cancel_check_interval == 0 && is_cancelled())
+            {
+                return false;
+            }
+            keyed.emplace_back(key_of(rows[i]), rows[i]);
+        }
+
+        if (order == Qt::AscendingOrder)
+        {
+            parallel_sort(keyed.begin(), keyed.end(), [](auto const& lhs, auto const& rhs) {
+                return lhs.first < rhs.first || (lhs.first == rhs.first && lhs.second < rhs.second);
+            });
+        }
+        else
+        {
+            parallel_sort(keyed.begin(), keyed.end(), [](auto const& lhs, auto const& rhs) {
+                return rhs.first < lhs.first || (lhs.first == rhs.first && lhs.second < rhs.second);
+            });
+        }
+        if (is_cancelled())
+        {
+            return false;
+        }
+
+        std::transform(keyed.begin(), keyed.end(), rows.begin(), [](auto const& k) { return k.second; });
+        return true;
+    }
+} // anonymous
+
+
+SymbolTableModel::
+SymbolTableModel(QObject* parent)
+: QAbstractTableModel{parent}
+, symtab_{nullptr}
+, strtab_{nullptr}
+, applied_{"", -1, Qt::AscendingOrder}
+, requested_{"", -1, Qt::AscendingOrder}
+, request_{0}
+, result_{0, {"", -1, Qt::AscendingOrder}, nullptr, ""}
+, worker_{[this](std::string const& what) { emit failed(QString::fromStdString(what)); }}
+{
+}
+
+
+SymbolTableModel::
+~SymbolTableModel()
+{
+    worker_.cancel();
+}
+
+
+void SymbolTableModel::
+set_symbol_table(Section_SYMTAB const* symtab)
+{
+    if (symtab == symtab_)
+    {
+        return;
+    }
+
+    // Make sure no job is still chewing on the old table before letting go.
+    worker_.cancel();
+    ++request_;
+
+    beginResetModel();
+    symtab_ = symtab;
+    strtab_ = symtab_ ? symtab_->find_string_table() : nullptr;
+    rows_ = nullptr;
+    applied_ = Shape{"", -1, Qt::AscendingOrder};
+    if (strtab_ != nullptr)
+    {
+        auto rows = std::make_shared<std::vector<std::uint32_t>>(symtab_->symbol_count());
+        std::iota(rows->begin(), rows->end(), 0);
+        rows_ = std::move(rows);
+    }
+    endResetModel();
+
+    if (symtab_ != nullptr && strtab_ == nullptr)
+    {
+        emit failed(tr("the symbol table links to section %1, which is not a string table")
+                    .arg(symtab_->link()));
+        return;
+    }
+    this->launch();
+}
+
+
+void SymbolTableModel::
+set_filter(QString const& text)
+{
+    requested_.filter_ = text.toLower().toStdString();
+    this->launch();
+}
+
+
+int SymbolTableModel::
+rowCount(QModelIndex const& parent) const
+{
+    if (parent.isValid() || rows_ == nullptr)
+    {
+        return 0;
+    }
+    return static_cast<int>(rows_->size());
+}
+
+
+int SymbolTableModel::
+columnCount(QModelIndex const& parent) const
+{
+    return parent.isValid() ? 0 : ColumnCount;
+}
+
+
+QVariant SymbolTableModel::
+data(QModelIndex const& index, int role) const
+{
+    if (!index.isValid() || rows_ == nullptr || index.row() >= static_cast<int>(rows_->size()))
+    {
+        return QVariant();
+    }
+
+    if (role == Qt::TextAlignmentRole)
+    {
+        if (index.column() == Value || index.column() == Size)
+        {
+            return QVariant(Qt::AlignRight | Qt::AlignVCenter);
+        }
+        return QVariant(Qt::AlignLeft | Qt::AlignVCenter);
+    }
+
+    if (role != Qt::DisplayRole)
+    {
+        return QVariant();
+    }
+
+    Symbol const& symbol = symtab_->symbol((*rows_)[index.row()]);
+    switch (index.column())
+    {
+    case Value:
+        return QString("0x%1").arg(symbol.value(), 8, 16, QChar('0'));
+    case Size:
+        return QString("%1").arg(symbol.size());
+    case Bind:
+        return QString::fromStdString(symbol.bind_string());
+    case Type:
+        return QString::fromStdString(symbol.type_string());
+    case Visibility:
+        return QString::fromStdString(symbol.other_string());
+    case Shndx:
+        return QString::fromStdString(symbol.shndx_string());
+    case Name:
+    {
+        std::string_view name = strtab_->string_ref(symbol.name());
+        return QString::fromUtf8(name.data(), static_cast<int>(name.size()));
+    }
+    default:
+        return QVariant();
+    }
+}
+
+
+QVariant SymbolTableModel::
+headerData(int section, Qt::Orientation orientation, int role) const
+{
+    if (orientation != Qt::Horizontal || role != Qt::DisplayRole)
+    {
+        return QAbstractTableModel::headerData(section, orientation, role);
+    }
+
+    switch (section)
+    {
+    case Value:      return tr("Value");
+    case Size:       return tr("Size");
+    case Bind:       return tr("Bind");
+    case Type:       return tr("Type");
+    case Visibility: return tr("Vis");
+    case Shndx:      return tr("Index");
+    case Name:       return tr("Name");
+    default:         return QVariant();
+    }
+}
+
+
+void SymbolTableModel::
+sort(int column, Qt::SortOrder order)
+{
+    requested_.sort_column_ = column;
+    requested_.sort_order_ = order;
+    this->launch();
+}
+
+
+/*!
+ * Start a background job to bring the rows in line with the requested shape.
+ *
+ * If the requested filter contains the applied one the new matches must be a
+ * subset of the rows already showing, which are also already in the right
+ * order unless the sort has changed too, so only those need to be examined.
+ */
+void SymbolTableModel::
+launch()
+{
+    ++request_;
+    if (symtab_ == nullptr || strtab_ == nullptr)
+    {
+        return;
+    }
+
+    bool narrowing = requested_.filter_.find(applied_.filter_) != std::string::npos;
+    bool need_filter = !narrowing || requested_.filter_ != applied_.filter_;
+    bool need_sort = narrowing ? (requested_.sort_column_ != applied_.sort_column_
+                                  || requested_.sort_order_ != applied_.sort_order_)
+                               : requested_.sort_column_ >= 0;
+    if (!need_filter && !need_sort)
+    {
+        return;
+    }
+
+    Rows base = narrowing ? rows_ : nullptr;
+    Section_SYMTAB const* symtab = symtab_;
+    Section_STRTAB const* strtab = strtab_;
+    std::uint64_t request = request_;
+    Shape shape = requested_;
+
+    worker_.post([=](BackgroundWorker::IsCancelled const& is_cancelled) {
+        EDHEL_TRACE_ZONE("filter and sort symbols");
+        auto name_of = [&](std::uint32_t i) { return strtab->string_ref(symtab->symbol(i).name()); };
+        Result result{request, shape, nullptr, ""};
+        try
+        {
+            std::vector<std::uint32_t> rows;
+            if (base != nullptr)
+            {
+                rows = *base;
+            }
+            else
+            {
+                rows.resize(symtab->symbol_count());
+                std::iota(rows.begin(), rows.end(), 0);
+            }
+
+            if (need_filter && !shape.filter_.empty())
+            {
+                std::size_t kept = 0;
+                for (std::size_t i = 0; i < rows.size(); ++i)
+                {
+                    if (i % cancel_check_interval == 0 && is_cancelled())
+                    {
+                        return;
+                    }
+                    if (contains_nocase(name_of(rows[i]), shape.filter_))
+                    {
+                        rows[kept++] = rows[i];
+                    }
+                }
+                rows.resize(kept);
+            }
+
+            if (need_sort)
+            {
+                bool sorted = true;
+                if (shape.sort_column_ == Name)
+                {
+                    sorted = sort_rows(rows, shape.sort_order_, name_of, is_cancelled);
+                }
+                else if (shape.sort_column_ >= 0)
+                {
+                    int column = shape.sort_column_;
+                    sorted = sort_rows(rows, shape.sort_order_,
+                                       [&](std::uint32_t i) { return numeric_key(symtab->symbol(i), column); },
+                                       is_cancelled);
+                }
+                else
+                {
+                    parallel_sort(rows.begin(), rows.end(), std::less<std::uint32_t>());
+                }
+                if (!sorted)
+                {
+                    return;
+                }
+            }
+
+            result.rows_ = std::make_shared<std::vector<std::uint32_t>>(std::move(rows));
+        }
+        catch (std::exception const& ex)
+        {
+            // A malformed file can still trip up a symbol lookup: show nothing
+            // rather than half an answer.
+            result.error_ = ex.what();
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(result_mutex_);
+            result_ = std::move(result);
+        }
+        QMetaObject::invokeMethod(this, "apply_result", Qt::QueuedConnection);
+    });
+}
+
+
+void SymbolTableModel::
+apply_result()
+{
+    Result result;
+    {
+        std::lock_guard<std::mutex> lock(result_mutex_);
+        result = std::move(result_);
+        result_.rows_ = nullptr;
+        result_.error_.clear();
+    }
+    if (result.request_ != request_ || (result.rows_ == nullptr && result.error_.empty()))
+    {
+        return;
+    }
+
+    beginResetModel();
+    rows_ = result.rows_;
+    applied_ = rows_ ? result.shape_ : Shape{"", -1, Qt::AscendingOrder};
+    endResetModel();
+    if (!result.error_.empty())
+    {
+        emit failed(QString::fromStdString(result.error_));
+    }
+}
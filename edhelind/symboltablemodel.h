@@ -0,0 +1,140 @@
+/**
+ * Table model presenting the symbols of a symbol table section
+ */
+/*
+ * Copyright 2020 Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ *
+ * This file is part of Edhelind.
+ *
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * Edhelind is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with Edhelind.  If not, see <https://www.gnu.org/licenses/>.
+ */
+#ifndef EDHELIND_SYMBOLTABLEMODEL_H
+#define EDHELIND_SYMBOLTABLEMODEL_H
+
+#include "edhelind/backgroundworker.h"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <QAbstractTableModel>
+#include <string>
+#include <vector>
+
+
+class Section_STRTAB;
+class Section_SYMTAB;
+
+/**
+ * A sortable, filterable view of a Section_SYMTAB.
+ *
+ * The model only ever holds a permutation of symbol indexes: cells are
+ * formatted on demand when the view asks for them, so only visible rows are
+ * ever rendered.  Sorting and filtering run on a background worker against
+ * that permutation and the result is swapped in when it is ready.  A filter
+ * that extends the previous one only re-examines the rows that already
+ * matched.
+ *
+ * The names come from the symbol table's linked string table, which is found
+ * up front; if the link doesn't lead to one (the file may be malformed) the
+ * model stays empty and says why through failed().
+ */
+class SymbolTableModel
+: public QAbstractTableModel
+{
+    Q_OBJECT
+
+public:
+    enum Column {
+        Value,
+        Size,
+        Bind,
+        Type,
+        Visibility,
+        Shndx,
+        Name,
+        ColumnCount
+    };
+
+public:
+    explicit SymbolTableModel(QObject* parent = nullptr);
+    ~SymbolTableModel();
+
+    /** Present the symbols of @p symtab, or nothing if it is null. */
+    void
+    set_symbol_table(Section_SYMTAB const* symtab);
+
+    int
+    rowCount(QModelIndex const& parent = QModelIndex()) const override;
+
+    int
+    columnCount(QModelIndex const& parent = QModelIndex()) const override;
+
+    QVariant
+    data(QModelIndex const& index, int role = Qt::DisplayRole) const override;
+
+    QVariant
+    headerData(int section, Qt::Orientation orientation, int role = Qt::DisplayRole) const override;
+
+    void
+    sort(int column, Qt::SortOrder order = Qt::AscendingOrder) override;
+
+public slots:
+    /** Only show symbols whose name contains @p text (case-insensitive). */
+    void
+    set_filter(QString const& text);
+
+signals:
+    /** Emitted when filtering or sorting the symbols failed because of @p what. */
+    void
+    failed(QString const& what);
+
+private slots:
+    void
+    apply_result();
+
+private:
+    using Rows = std::shared_ptr<std::vector<std::uint32_t> const>;
+
+    /** What a set of rows has been filtered and sorted by. */
+    struct Shape
+    {
+        std::string   filter_;
+        int           sort_column_;
+        Qt::SortOrder sort_order_;
+    };
+
+    struct Result
+    {
+        std::uint64_t request_;
+        Shape         shape_;
+        Rows          rows_;
+        std::string   error_;   /**< why there are no rows, if the job failed */
+    };
+
+    void
+    launch();
+
+private:
+    Section_SYMTAB const* symtab_;
+    Section_STRTAB const* strtab_;
+    Rows                  rows_;
+    Shape                 applied_;
+    Shape                 requested_;
+    std::uint64_t         request_;
+
+    std::mutex            result_mutex_;
+    Result                result_;
+    BackgroundWorker      worker_;
+};
+
+#endif /* EDHELIND_SYMBOLTABLEMODEL_H */
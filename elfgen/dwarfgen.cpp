@@ -0,0 +1,1242 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "elfgen/dwarfgen.h"
+
+#include <algorithm>
+#include "elfgen/elfgen.h"
+#include <iterator>
+#include "libedhel/dwarf.h"
+#include <map>
+#include <utility>
+
+
+namespace
+{
+    /**
+     * Appends target-order integers and the DWARF variable-length encodings
+     * to a byte buffer, for contents whose size isn't known up front.
+     */
+    class Appender
+    {
+    public:
+        Appender(std::vector<std::byte>& bytes, bool big_endian)
+        : bytes_{bytes}
+        , big_endian_{big_endian}
+        { }
+
+        std::size_t
+        size() const
+        {
+            return bytes_.size();
+        }
+
+        void
+        put(std::uint64_t value, std::size_t size)
+        {
+            bytes_.resize(bytes_.size() + size);
+            patch(bytes_.size() - size, value, size);
+        }
+
+        /** Overwrite @p size bytes at @p offset, to fill in a length */
+        void
+        patch(std::size_t offset, std::uint64_t value, std::size_t size)
+        {
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                std::size_t shift = 8 * (big_endian_ ? size - 1 - i : i);
+                bytes_[offset + i] = static_cast<std::byte>(value >> shift);
+            }
+        }
+
+        /**
+         * Start a unit or contribution with a zero initial length, returning
+         * where to patch in the real one with end_unit().
+         */
+        std::size_t
+        begin_unit(bool dwarf64)
+        {
+            if (dwarf64)
+            {
+                put32(0xffffffff);
+            }
+            std::size_t const length_at = size();
+            put(0, dwarf64 ? 8 : 4);
+            return length_at;
+        }
+
+        void
+        end_unit(std::size_t length_at, bool dwarf64)
+        {
+            std::size_t const offset_size = dwarf64 ? 8 : 4;
+            patch(length_at, size() - length_at - offset_size, offset_size);
+        }
+
+        void
+        put8(std::uint8_t value)   { put(value, 1); }
+
+        void
+        put16(std::uint16_t value) { put(value, 2); }
+
+        void
+        put32(std::uint32_t value) { put(value, 4); }
+
+        void
+        put_bytes(std::vector<std::byte> const& bytes)
+        {
+            bytes_.insert(bytes_.end(), bytes.begin(), bytes.end());
+        }
+
+        void
+        uleb128(std::uint64_t value)
+        {
+            do
+            {
+                std::uint8_t byte = value & 0x7f;
+                value >>= 7;
+                put8(value ? byte | 0x80 : byte);
+            } while (value);
+        }
+
+        void
+        sleb128(std::int64_t value)
+        {
+            bool more = true;
+            while (more)
+            {
+                std::uint8_t byte = value & 0x7f;
+                value >>= 7;
+                more = !((value == 0 && (byte & 0x40) == 0) || (value == -1 && (byte & 0x40) != 0));
+                put8(more ? byte | 0x80 : byte);
+            }
+        }
+
+        /** A NUL-terminated string */
+        void
+        put_cstring(std::string const& s)
+        {
+            for (char c: s)
+            {
+                put8(static_cast<std::uint8_t>(c));
+            }
+            put8(0);
+        }
+
+    private:
+        std::vector<std::byte>& bytes_;
+        bool                    big_endian_;
+    };
+
+    // Line number program parameters: those of GCC and the DWARF examples.
+    constexpr std::int8_t line_base = -5;
+    constexpr std::uint8_t line_range = 14;
+    constexpr std::uint8_t opcode_base = 13;
+    constexpr std::uint8_t standard_opcode_lengths[opcode_base - 1] = { 0, 1, 1, 1, 1, 0, 0, 0, 1, 0, 0, 1 };
+    constexpr std::uint64_t line_code_offset = 0x1000000;   /* where the code the programs describe starts */
+    constexpr std::uint64_t line_unit_gap = 64;             /* and how far apart the units are */
+    char const* const line_files[] = { "a.h", "b.h", "c.h" };
+    constexpr std::uint32_t line_file_directories[] = { 1, 1, 0 };
+
+    /**
+     * How far row @p row of a program is from its start.  Most rows are two
+     * or four bytes apart, but every sixteenth is too far for a special
+     * opcode.
+     */
+    std::uint64_t
+    line_row_offset(std::uint32_t row)
+    {
+        std::uint32_t r = row % 16;
+        return std::uint64_t(row / 16) * 346 + (r + 1) / 2 * 4 + r / 2 * 2;
+    }
+
+    /** Add @p s to the string section image @p strings, returning its offset */
+    std::uint64_t
+    add_string(std::vector<std::byte>& strings, std::string const& s)
+    {
+        std::uint64_t offset = strings.size();
+        for (char c: s)
+        {
+            strings.push_back(static_cast<std::byte>(c));
+        }
+        strings.push_back(std::byte{0});
+        return offset;
+    }
+
+    /** Append the line number program of @p unit to @p line and, for DWARF 5, @p line_str */
+    void
+    generate_line_program(ElfSpec const& spec, std::uint32_t unit, std::vector<std::byte>& line,
+                          std::vector<std::byte>& line_str, std::uint64_t include_offset)
+    {
+        Appender a(line, spec.big_endian_);
+        std::uint16_t const version = spec.dwarf_version_;
+        std::size_t const offset_size = spec.dwarf64_ ? 8 : 4;
+        std::uint8_t const address_size = spec.is_64bit_ ? 8 : 4;
+
+        std::size_t const unit_length_at = a.begin_unit(spec.dwarf64_);
+        a.put16(version);
+        if (version >= 5)
+        {
+            a.put8(address_size);
+            a.put8(0);                  // segment_selector_size
+        }
+        std::size_t const header_length_at = a.size();
+        a.put(0, offset_size);
+        a.put8(1);                      // minimum_instruction_length
+        if (version >= 4)
+        {
+            a.put8(1);                  // maximum_operations_per_instruction
+        }
+        a.put8(1);                      // default_is_stmt
+        a.put8(static_cast<std::uint8_t>(line_base));
+        a.put8(line_range);
+        a.put8(opcode_base);
+        for (std::uint8_t length: standard_opcode_lengths)
+        {
+            a.put8(length);
+        }
+
+        if (version >= 5)
+        {
+            a.put8(1);
+            a.uleb128(DW_LNCT_path);
+            a.uleb128(DW_FORM_line_strp);
+            a.uleb128(2);
+            a.put(add_string(line_str, "/src/unit_" + std::to_string(unit)), offset_size);
+            a.put(include_offset, offset_size);
+
+            a.put8(3);
+            a.uleb128(DW_LNCT_path);
+            a.uleb128(DW_FORM_string);
+            a.uleb128(DW_LNCT_directory_index);
+            a.uleb128(DW_FORM_udata);
+            a.uleb128(DW_LNCT_MD5);
+            a.uleb128(DW_FORM_data16);
+            a.uleb128(1 + std::size(line_files));
+            for (std::size_t f = 0; f <= std::size(line_files); ++f)
+            {
+                a.put_cstring(f == 0 ? "unit_" + std::to_string(unit) + ".c" : line_files[f - 1]);
+                a.uleb128(f == 0 ? 0 : line_file_directories[f - 1]);
+                for (int i = 0; i < 16; ++i)
+                {
+                    a.put8(static_cast<std::uint8_t>(unit + f + i));
+                }
+            }
+        }
+        else
+        {
+            a.put_cstring("include");
+            a.put8(0);
+            for (std::size_t f = 0; f < std::size(line_files); ++f)
+            {
+                a.put_cstring(line_files[f]);
+                a.uleb128(line_file_directories[f]);
+                a.uleb128(0);           // modification time
+                a.uleb128(0);           // length
+            }
+            a.put8(0);
+        }
+        a.patch(header_length_at, a.size() - header_length_at - offset_size, offset_size);
+
+        // The second half of the rows first, so the sequences are out of order.
+        std::uint32_t const rows = spec.line_rows_per_unit_;
+        std::uint32_t const half = rows / 2;
+        std::pair<std::uint32_t, std::uint32_t> const sequences[] = { {half, rows}, {0, half} };
+        for (auto const& [first, last]: sequences)
+        {
+            if (first == last)
+            {
+                continue;
+            }
+            GeneratedLine state{0, 1, 1, 0};
+            for (std::uint32_t r = first; r < last; ++r)
+            {
+                GeneratedLine row = generated_line(spec, unit, r);
+                if (row.file_ != state.file_)
+                {
+                    a.put8(DW_LNS_set_file);
+                    a.uleb128(row.file_);
+                }
+                if (row.column_ != state.column_)
+                {
+                    a.put8(DW_LNS_set_column);
+                    a.uleb128(row.column_);
+                }
+                if (r % 11 == 3)
+                {
+                    a.put8(0);
+                    a.uleb128(2);
+                    a.put8(DW_LNE_set_discriminator);
+                    a.uleb128(1);
+                }
+
+                std::uint64_t address_advance = row.address_ - state.address_;
+                if (r == first)
+                {
+                    a.put8(0);
+                    a.uleb128(1 + address_size);
+                    a.put8(DW_LNE_set_address);
+                    a.put(row.address_, address_size);
+                    address_advance = 0;
+                }
+                std::int64_t line_advance = std::int64_t(row.line_) - std::int64_t(state.line_);
+                if (line_advance < line_base || line_advance >= line_base + line_range)
+                {
+                    a.put8(DW_LNS_advance_line);
+                    a.sleb128(line_advance);
+                    line_advance = 0;
+                }
+                std::uint64_t opcode = (line_advance - line_base) + line_range * address_advance + opcode_base;
+                if (opcode > 255)
+                {
+                    if (r % 32 == 31)
+                    {
+                        a.put8(DW_LNS_fixed_advance_pc);
+                        a.put16(static_cast<std::uint16_t>(address_advance));
+                    }
+                    else
+                    {
+                        a.put8(DW_LNS_advance_pc);
+                        a.uleb128(address_advance);
+                    }
+                    opcode = (line_advance - line_base) + opcode_base;
+                }
+                a.put8(static_cast<std::uint8_t>(opcode));
+                state = row;
+            }
+            a.put8(DW_LNS_advance_pc);
+            a.uleb128(generated_line(spec, unit, last).address_ - state.address_);
+            a.put8(0);
+            a.uleb128(1);
+            a.put8(DW_LNE_end_sequence);
+        }
+        a.end_unit(unit_length_at, spec.dwarf64_);
+    }
+
+    std::uint64_t
+    align_up(std::uint64_t value, std::uint64_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+
+    /** Every third function is in two ranges */
+    bool
+    is_ranged(std::uint32_t function)
+    {
+        return function % 3 == 2;
+    }
+
+    /** Of the rest, odd ones are member functions defined outside their class */
+    bool
+    is_member(std::uint32_t function)
+    {
+        return !is_ranged(function) && function % 2 == 1;
+    }
+
+    /** @p name as it appears in a mangled name */
+    std::string
+    length_prefixed(std::string const& name)
+    {
+        return std::to_string(name.size()) + name;
+    }
+
+    /** A name of a DIE, for the name indexes */
+    struct IndexedName
+    {
+        std::string   name_;
+        std::string   qualified_name_;  /**< as .gdb_index has it, or empty if it leaves the name out */
+        std::uint32_t unit_;
+        std::uint64_t die_;             /**< offset in its unit */
+        dw_tag_t      tag_;
+    };
+
+    /** The images of the DWARF sections being generated */
+    struct DwarfImages
+    {
+        std::vector<std::byte> abbrev_;
+        std::vector<std::byte> info_;
+        std::vector<std::byte> aranges_;
+        std::vector<std::byte> line_;
+        std::vector<std::byte> str_;
+        std::vector<std::byte> line_str_;
+        std::vector<std::byte> str_offsets_;
+        std::vector<std::byte> addr_;
+        std::vector<std::byte> ranges_;
+        std::vector<std::byte> rnglists_;
+        std::vector<std::byte> names_;
+        std::vector<std::byte> gdb_index_;
+
+        std::vector<IndexedName> indexed_names_;    /**< in unit order */
+    };
+
+    /** The abbreviation codes of the generated DIEs */
+    enum AbbrevCode : std::uint32_t
+    {
+        abbrev_compile_unit = 1,
+        abbrev_ranged_compile_unit,
+        abbrev_base_type,
+        abbrev_structure_type,
+        abbrev_declaration,
+        abbrev_abstract_instance,
+        abbrev_function,
+        abbrev_definition,
+        abbrev_ranged_function,
+        abbrev_parameter,
+        abbrev_lexical_block,
+        abbrev_inlined_with_children,
+        abbrev_inlined,
+        abbrev_variable,
+    };
+
+    /**
+     * The forms the generated DIEs use, which follow what compilers use for
+     * each DWARF version: DWARF 5 units go through the string offset, address
+     * and range list tables.
+     */
+    struct Forms
+    {
+        explicit Forms(ElfSpec const& spec)
+        : string_{spec.dwarf_version_ >= 5 ? DW_FORM_strx : DW_FORM_strp}
+        , address_{spec.dwarf_version_ >= 5 ? DW_FORM_addrx : DW_FORM_addr}
+        , high_pc_{spec.dwarf_version_ >= 4 ? DW_FORM_data4 : DW_FORM_addr}
+        , section_offset_{spec.dwarf_version_ >= 4 ? DW_FORM_sec_offset
+                                                   : spec.dwarf64_ ? DW_FORM_data8 : DW_FORM_data4}
+        , ranges_{spec.dwarf_version_ >= 5 ? DW_FORM_rnglistx : section_offset_}
+        , location_{spec.dwarf_version_ >= 4 ? DW_FORM_exprloc : DW_FORM_block1}
+        , flag_{spec.dwarf_version_ >= 4 ? DW_FORM_flag_present : DW_FORM_flag}
+        , const_value_{spec.dwarf_version_ >= 5 ? DW_FORM_implicit_const : DW_FORM_sdata}
+        , linkage_name_{spec.dwarf_version_ >= 4 ? DW_AT_linkage_name : DW_AT_MIPS_linkage_name}
+        { }
+
+        dw_form_t string_;
+        dw_form_t address_;
+        dw_form_t high_pc_;
+        dw_form_t section_offset_;
+        dw_form_t ranges_;
+        dw_form_t location_;
+        dw_form_t flag_;
+        dw_form_t const_value_;
+        dw_at_t   linkage_name_;
+    };
+
+    constexpr std::int64_t local_value = -7;    /* the constant value of every "local" variable */
+
+    struct AttributeSpec
+    {
+        dw_at_t      name_;
+        dw_form_t    form_;
+        std::int64_t implicit_const_ = 0;
+    };
+
+    struct Abbreviation
+    {
+        std::uint32_t              code_;
+        dw_tag_t                   tag_;
+        bool                       has_children_;
+        std::vector<AttributeSpec> attributes_;
+    };
+
+    /** Write the abbreviation table all the units share to @p abbrev */
+    void
+    generate_abbreviations(ElfSpec const& spec, Forms const& forms, std::vector<std::byte>& abbrev)
+    {
+        std::vector<AttributeSpec> unit_attributes = {
+            {DW_AT_name, forms.string_},
+            {DW_AT_comp_dir, forms.string_},
+            {DW_AT_low_pc, forms.address_},
+            {DW_AT_high_pc, forms.high_pc_},
+            {DW_AT_stmt_list, forms.section_offset_},
+        };
+        if (spec.dwarf_version_ >= 5)
+        {
+            // After the attributes that need them, as GCC puts them.
+            unit_attributes.push_back({DW_AT_str_offsets_base, DW_FORM_sec_offset});
+            unit_attributes.push_back({DW_AT_addr_base, DW_FORM_sec_offset});
+            unit_attributes.push_back({DW_AT_rnglists_base, DW_FORM_sec_offset});
+        }
+        std::vector<AttributeSpec> ranged_unit_attributes = unit_attributes;
+        ranged_unit_attributes[3] = {DW_AT_ranges, forms.section_offset_};
+        AttributeSpec const name{DW_AT_name, forms.string_};
+        AttributeSpec const linkage_name{forms.linkage_name_, forms.string_};
+        AttributeSpec const low_pc{DW_AT_low_pc, forms.address_};
+        AttributeSpec const high_pc{DW_AT_high_pc, forms.high_pc_};
+        std::vector<Abbreviation> abbreviations = {
+            {abbrev_compile_unit, DW_TAG_compile_unit, true, unit_attributes},
+            {abbrev_ranged_compile_unit, DW_TAG_compile_unit, true, ranged_unit_attributes},
+            {abbrev_base_type, DW_TAG_base_type, false,
+                {name, {DW_AT_encoding, DW_FORM_data1}, {DW_AT_byte_size, DW_FORM_data1}}},
+            {abbrev_structure_type, DW_TAG_structure_type, true,
+                {name, {DW_AT_byte_size, DW_FORM_data1}}},
+            {abbrev_declaration, DW_TAG_subprogram, false,
+                {name, linkage_name, {DW_AT_external, forms.flag_}, {DW_AT_declaration, forms.flag_}}},
+            {abbrev_abstract_instance, DW_TAG_subprogram, false,
+                {name, linkage_name, {DW_AT_inline, DW_FORM_data1}}},
+            {abbrev_function, DW_TAG_subprogram, true,
+                {name, linkage_name, {DW_AT_external, forms.flag_}, low_pc, high_pc}},
+            {abbrev_definition, DW_TAG_subprogram, true,
+                {{DW_AT_specification, DW_FORM_ref_addr}, low_pc, high_pc}},
+            {abbrev_ranged_function, DW_TAG_subprogram, true,
+                {name, linkage_name, {DW_AT_ranges, forms.ranges_}}},
+            {abbrev_parameter, DW_TAG_formal_parameter, false,
+                {name, {DW_AT_type, DW_FORM_ref4}, {DW_AT_location, forms.location_}}},
+            {abbrev_lexical_block, DW_TAG_lexical_block, true,
+                {low_pc, high_pc}},
+            {abbrev_inlined_with_children, DW_TAG_inlined_subroutine, true,
+                {{DW_AT_abstract_origin, DW_FORM_ref4}, low_pc, high_pc, {DW_AT_call_file, DW_FORM_data1},
+                 {DW_AT_call_line, DW_FORM_udata}, {DW_AT_call_column, DW_FORM_data1}}},
+            {abbrev_inlined, DW_TAG_inlined_subroutine, false,
+                {{DW_AT_abstract_origin, DW_FORM_ref4}, low_pc, high_pc, {DW_AT_call_file, DW_FORM_data1},
+                 {DW_AT_call_line, DW_FORM_data2}, {DW_AT_call_column, DW_FORM_data1}}},
+            {abbrev_variable, DW_TAG_variable, false,
+                {name, {DW_AT_type, DW_FORM_ref_udata}, {DW_AT_const_value, forms.const_value_, local_value}}},
+        };
+        if (spec.dwarf_version_ == 3)
+        {
+            // Out of code order, so readers can't just index by code.
+            std::reverse(abbreviations.begin(), abbreviations.end());
+        }
+
+        Appender a(abbrev, spec.big_endian_);
+        for (Abbreviation const& abbreviation: abbreviations)
+        {
+            a.uleb128(abbreviation.code_);
+            a.uleb128(abbreviation.tag_);
+            a.put8(abbreviation.has_children_ ? 1 : 0);
+            for (AttributeSpec const& attribute: abbreviation.attributes_)
+            {
+                a.uleb128(attribute.name_);
+                a.uleb128(attribute.form_);
+                if (attribute.form_ == DW_FORM_implicit_const)
+                {
+                    a.sleb128(attribute.implicit_const_);
+                }
+            }
+            a.put8(0);
+            a.put8(0);
+        }
+        a.put8(0);
+    }
+
+    /**
+     * Append the .debug_info unit @p unit, whose line number program is at
+     * @p stmt_list, to @p images, along with what it refers to in the other
+     * sections.  The DIEs must follow the abbreviations of
+     * generate_abbreviations().
+     */
+    void
+    generate_unit(ElfSpec const& spec, Forms const& forms, std::uint32_t unit, std::uint64_t stmt_list,
+                  DwarfImages& images)
+    {
+        Appender a(images.info_, spec.big_endian_);
+        std::uint16_t const version = spec.dwarf_version_;
+        std::size_t const offset_size = spec.dwarf64_ ? 8 : 4;
+        std::uint8_t const address_size = spec.is_64bit_ ? 8 : 4;
+        std::string const u = std::to_string(unit);
+
+        // A DWARF 5 unit refers to its strings, addresses and range lists by
+        // index, through its own contributions to .debug_str_offsets,
+        // .debug_addr and .debug_rnglists, which follow those of the units
+        // before it.
+        std::vector<std::uint64_t> string_offsets;
+        std::vector<std::uint64_t> addresses;
+        std::vector<std::uint64_t> list_offsets;
+        std::vector<std::byte> lists;
+        Appender l(lists, spec.big_endian_);
+
+        auto put_string = [&](std::string const& s) {
+            std::uint64_t offset = add_string(images.str_, s);
+            if (forms.string_ == DW_FORM_strx)
+            {
+                a.uleb128(string_offsets.size());
+                string_offsets.push_back(offset);
+            }
+            else
+            {
+                a.put(offset, offset_size);
+            }
+        };
+        auto add_address = [&addresses](std::uint64_t address) {
+            addresses.push_back(address);
+            return addresses.size() - 1;
+        };
+        auto put_address = [&](std::uint64_t address) {
+            if (forms.address_ == DW_FORM_addrx)
+            {
+                a.uleb128(add_address(address));
+            }
+            else
+            {
+                a.put(address, address_size);
+            }
+        };
+        auto put_pcs = [&](std::uint64_t low, std::uint64_t high) {
+            put_address(low);
+            a.put(forms.high_pc_ == DW_FORM_data4 ? high - low : high, forms.high_pc_ == DW_FORM_data4 ? 4 : address_size);
+        };
+        auto put_flag = [&]() {
+            if (forms.flag_ == DW_FORM_flag)
+            {
+                a.put8(1);
+            }
+        };
+        auto put_ranges = [&](GeneratedFunction const& function) {
+            if (version >= 5)
+            {
+                a.uleb128(list_offsets.size());
+                list_offsets.push_back(lists.size());
+                l.put8(DW_RLE_base_addressx);
+                l.uleb128(add_address(function.low_pc_));
+                l.put8(DW_RLE_offset_pair);
+                l.uleb128(0);
+                l.uleb128(function.gap_low_ - function.low_pc_);
+                l.put8(DW_RLE_start_length);
+                l.put(function.gap_high_, address_size);
+                l.uleb128(function.high_pc_ - function.gap_high_);
+                l.put8(DW_RLE_end_of_list);
+            }
+            else
+            {
+                Appender r(images.ranges_, spec.big_endian_);
+                a.put(r.size(), offset_size);
+                r.put(~std::uint64_t(0), address_size);     // base address selection
+                r.put(function.low_pc_, address_size);
+                r.put(0, address_size);
+                r.put(function.gap_low_ - function.low_pc_, address_size);
+                r.put(function.gap_high_ - function.low_pc_, address_size);
+                r.put(function.high_pc_ - function.low_pc_, address_size);
+                r.put(0, address_size);
+                r.put(0, address_size);
+            }
+        };
+
+        std::size_t const unit_offset = a.size();
+        std::size_t const unit_length_at = a.begin_unit(spec.dwarf64_);
+        a.put16(version);
+        if (version >= 5)
+        {
+            a.put8(DW_UT_compile);
+            a.put8(address_size);
+            a.put(0, offset_size);      // debug_abbrev_offset
+        }
+        else
+        {
+            a.put(0, offset_size);
+            a.put8(address_size);
+        }
+
+        // Where the functions are, which odd units' DIEs give as their ranges.
+        std::uint32_t const function_count = spec.functions_per_unit_;
+        std::vector<std::pair<std::uint64_t, std::uint64_t>> code;
+        for (std::uint32_t f = 0; f < function_count; ++f)
+        {
+            GeneratedFunction function = generated_function(spec, unit, f);
+            if (is_ranged(f))
+            {
+                code.emplace_back(function.low_pc_, function.gap_low_);
+                code.emplace_back(function.gap_high_, function.high_pc_);
+            }
+            else
+            {
+                code.emplace_back(function.low_pc_, function.high_pc_);
+            }
+        }
+
+        bool const ranged_unit = unit % 2 == 1;
+        a.uleb128(ranged_unit ? abbrev_ranged_compile_unit : abbrev_compile_unit);
+        put_string("unit_" + u + ".c");
+        put_string("/src/unit_" + u);
+        std::size_t unit_ranges_at = 0;
+        if (ranged_unit)
+        {
+            put_address(0);             // the base of the range list entries
+            unit_ranges_at = a.size();
+            a.put(0, offset_size);      // DW_AT_ranges, filled in once the lists are laid out
+        }
+        else
+        {
+            put_pcs(generated_line(spec, unit, 0).address_, generated_line(spec, unit, spec.line_rows_per_unit_).address_);
+        }
+        a.put(stmt_list, offset_size);
+        if (version >= 5)
+        {
+            // Each base is just past its contribution's header.
+            a.put(images.str_offsets_.size() + (spec.dwarf64_ ? 16 : 8), offset_size);
+            a.put(images.addr_.size() + (spec.dwarf64_ ? 16 : 8), offset_size);
+            a.put(images.rnglists_.size() + (spec.dwarf64_ ? 20 : 12), offset_size);
+        }
+
+        auto index_name = [&](std::string const& name, std::string const& qualified_name, dw_tag_t tag) {
+            images.indexed_names_.push_back(IndexedName{name, qualified_name, unit, a.size() - unit_offset, tag});
+        };
+
+        auto index_inlined = [&](std::string const& name) {
+            index_name(name, name, DW_TAG_inlined_subroutine);
+            index_name("_Z" + length_prefixed(name) + "v", std::string(), DW_TAG_inlined_subroutine);
+        };
+
+        std::uint64_t const int_type = a.size() - unit_offset;
+        index_name("int", "int", DW_TAG_base_type);
+        a.uleb128(abbrev_base_type);
+        put_string("int");
+        a.put8(0x05);                   // DW_ATE_signed
+        a.put8(4);
+
+        std::vector<std::uint64_t> declarations(function_count);
+        index_name("Class_" + u, "Class_" + u, DW_TAG_structure_type);
+        a.uleb128(abbrev_structure_type);
+        put_string("Class_" + u);
+        a.put8(1);
+        for (std::uint32_t f = 0; f < function_count; ++f)
+        {
+            if (is_member(f))
+            {
+                GeneratedFunction function = generated_function(spec, unit, f);
+                declarations[f] = a.size();
+                a.uleb128(abbrev_declaration);
+                put_string(function.name_);
+                put_string(function.linkage_name_);
+                put_flag();
+                put_flag();
+            }
+        }
+        a.put8(0);
+
+        auto put_abstract_instance = [&](std::string const& name) {
+            std::uint64_t offset = a.size() - unit_offset;
+            a.uleb128(abbrev_abstract_instance);
+            put_string(name);
+            put_string("_Z" + length_prefixed(name) + "v");
+            a.put8(3);                  // DW_INL_declared_inlined
+            return offset;
+        };
+        std::uint64_t const helper = put_abstract_instance("inline_helper_" + u);
+        std::uint64_t const leaf = put_abstract_instance("inline_leaf_" + u);
+
+        for (std::uint32_t f = 0; f < function_count; ++f)
+        {
+            GeneratedFunction const function = generated_function(spec, unit, f);
+            index_name(function.name_, is_member(f) ? "Class_" + u + "::" + function.name_ : function.name_,
+                       DW_TAG_subprogram);
+            index_name(function.linkage_name_, std::string(), DW_TAG_subprogram);
+            if (is_ranged(f))
+            {
+                a.uleb128(abbrev_ranged_function);
+                put_string(function.name_);
+                put_string(function.linkage_name_);
+                put_ranges(function);
+            }
+            else if (is_member(f))
+            {
+                a.uleb128(abbrev_definition);
+                a.put(declarations[f], version >= 3 ? offset_size : address_size);
+                put_pcs(function.low_pc_, function.high_pc_);
+            }
+            else
+            {
+                a.uleb128(abbrev_function);
+                put_string(function.name_);
+                put_string(function.linkage_name_);
+                put_flag();
+                put_pcs(function.low_pc_, function.high_pc_);
+            }
+
+            a.uleb128(abbrev_parameter);
+            put_string("arg");
+            a.put32(static_cast<std::uint32_t>(int_type));
+            if (forms.location_ == DW_FORM_exprloc)
+            {
+                a.uleb128(2);
+            }
+            else
+            {
+                a.put8(2);
+            }
+            a.put8(0x91);               // DW_OP_fbreg -20
+            a.sleb128(-20);
+
+            a.uleb128(abbrev_lexical_block);
+            put_pcs(function.low_pc_ + 8, function.low_pc_ + 56);
+            index_inlined(function.inline_name_);
+            a.uleb128(abbrev_inlined_with_children);
+            a.put32(static_cast<std::uint32_t>(helper));
+            put_pcs(function.inline_low_, function.inline_high_);
+            a.put8(2);
+            a.uleb128(function.inline_call_line_);
+            a.put8(5);
+            index_inlined(function.leaf_name_);
+            a.uleb128(abbrev_inlined);
+            a.put32(static_cast<std::uint32_t>(leaf));
+            put_pcs(function.leaf_low_, function.leaf_high_);
+            a.put8(3);
+            a.put16(static_cast<std::uint16_t>(function.leaf_call_line_));
+            a.put8(7);
+            a.put8(0);                  // the end of the helper's children
+            a.put8(0);                  // and of the block's
+
+            a.uleb128(abbrev_variable);
+            put_string("local");
+            a.uleb128(int_type);
+            if (forms.const_value_ == DW_FORM_sdata)
+            {
+                a.sleb128(local_value);
+            }
+            a.put8(0);
+        }
+        a.put8(0);
+        a.end_unit(unit_length_at, spec.dwarf64_);
+
+        if (ranged_unit)
+        {
+            if (version >= 5)
+            {
+                // Referred to by offset, not index, like GCC does for units.
+                std::uint64_t const header_size = (spec.dwarf64_ ? 20 : 12) + list_offsets.size() * offset_size;
+                a.patch(unit_ranges_at, images.rnglists_.size() + header_size + lists.size(), offset_size);
+                for (auto const& [low, high]: code)
+                {
+                    l.put8(DW_RLE_startx_length);
+                    l.uleb128(add_address(low));
+                    l.uleb128(high - low);
+                }
+                l.put8(DW_RLE_end_of_list);
+            }
+            else
+            {
+                Appender r(images.ranges_, spec.big_endian_);
+                a.patch(unit_ranges_at, r.size(), offset_size);
+                for (auto const& [low, high]: code)
+                {
+                    r.put(low, address_size);
+                    r.put(high, address_size);
+                }
+                r.put(0, address_size);
+                r.put(0, address_size);
+            }
+        }
+
+        if (spec.dwarf_aranges_)
+        {
+            Appender r(images.aranges_, spec.big_endian_);
+            std::size_t const set_offset = r.size();
+            std::size_t const length_at = r.begin_unit(spec.dwarf64_);
+            r.put16(2);
+            r.put(unit_offset, offset_size);
+            r.put8(address_size);
+            r.put8(0);                  // segment_selector_size
+            while ((r.size() - set_offset) % (2 * address_size) != 0)
+            {
+                r.put8(0);
+            }
+            for (auto const& [low, high]: code)
+            {
+                r.put(low, address_size);
+                r.put(high - low, address_size);
+            }
+            r.put(0, address_size);
+            r.put(0, address_size);
+            r.end_unit(length_at, spec.dwarf64_);
+        }
+
+        if (version >= 5)
+        {
+            Appender s(images.str_offsets_, spec.big_endian_);
+            std::size_t length_at = s.begin_unit(spec.dwarf64_);
+            s.put16(version);
+            s.put16(0);                 // padding
+            for (std::uint64_t offset: string_offsets)
+            {
+                s.put(offset, offset_size);
+            }
+            s.end_unit(length_at, spec.dwarf64_);
+
+            Appender d(images.addr_, spec.big_endian_);
+            length_at = d.begin_unit(spec.dwarf64_);
+            d.put16(version);
+            d.put8(address_size);
+            d.put8(0);                  // segment_selector_size
+            for (std::uint64_t address: addresses)
+            {
+                d.put(address, address_size);
+            }
+            d.end_unit(length_at, spec.dwarf64_);
+
+            Appender r(images.rnglists_, spec.big_endian_);
+            length_at = r.begin_unit(spec.dwarf64_);
+            r.put16(version);
+            r.put8(address_size);
+            r.put8(0);
+            r.put32(static_cast<std::uint32_t>(list_offsets.size()));
+            for (std::uint64_t offset: list_offsets)
+            {
+                r.put(offset + list_offsets.size() * offset_size, offset_size);
+            }
+            r.put_bytes(lists);
+            r.end_unit(length_at, spec.dwarf64_);
+        }
+    }
+
+    std::uint32_t
+    fold_case(char c)
+    {
+        std::uint32_t u = static_cast<unsigned char>(c);
+        return u >= 'A' && u <= 'Z' ? u - 'A' + 'a' : u;
+    }
+
+    /** The hash of names in .debug_names, of the case-folded name as LLVM has it */
+    std::uint32_t
+    names_hash(std::string const& name)
+    {
+        std::uint32_t hash = 5381;
+        for (char c: name)
+        {
+            hash = hash * 33 + fold_case(c);
+        }
+        return hash;
+    }
+
+    /** How many buckets LLVM gives the hash table of @p count names */
+    std::uint32_t
+    names_bucket_count(std::uint32_t count)
+    {
+        return count > 1024 ? count / 4 : count > 16 ? count / 2 : std::max<std::uint32_t>(count, 1);
+    }
+
+    constexpr std::uint32_t units_per_name_index = 8;
+
+    /**
+     * Write .debug_names to @p images, indexing the first @c dwarf_names_
+     * units in name indexes of up to eight of them, as a linker leaves one
+     * index for each object.  An index of a single unit leaves
+     * DW_IDX_compile_unit out of its entries, as compilers do.
+     */
+    void
+    generate_debug_names(ElfSpec const& spec, std::vector<std::uint64_t> const& unit_offsets, DwarfImages& images)
+    {
+        Appender a(images.names_, spec.big_endian_);
+        std::size_t const offset_size = spec.dwarf64_ ? 8 : 4;
+        std::uint32_t const unit_count = std::min<std::uint32_t>(spec.dwarf_names_, spec.dwarf_unit_count_);
+        dw_tag_t const tags[] = { DW_TAG_subprogram, DW_TAG_inlined_subroutine, DW_TAG_base_type, DW_TAG_structure_type };
+
+        auto name = images.indexed_names_.cbegin();
+        for (std::uint32_t first = 0; first < unit_count; first += units_per_name_index)
+        {
+            std::uint32_t const last = std::min(first + units_per_name_index, unit_count);
+            bool const several = last - first > 1;
+
+            // Each name with its DIEs, in unit order, and the table of them
+            // ordered by bucket.
+            std::map<std::string, std::vector<IndexedName const*>> dies;
+            for (; name != images.indexed_names_.cend() && name->unit_ < last; ++name)
+            {
+                dies[name->name_].push_back(&*name);
+            }
+            std::vector<std::pair<std::uint32_t, std::string const*>> names;
+            for (auto const& [s, entries]: dies)
+            {
+                names.emplace_back(names_hash(s), &s);
+            }
+            std::uint32_t const name_count = static_cast<std::uint32_t>(names.size());
+            std::uint32_t const bucket_count = names_bucket_count(name_count);
+            std::stable_sort(names.begin(), names.end(), [bucket_count](auto const& lhs, auto const& rhs) {
+                return lhs.first % bucket_count < rhs.first % bucket_count;
+            });
+
+            std::vector<std::byte> abbrevs;
+            Appender b(abbrevs, spec.big_endian_);
+            for (std::size_t t = 0; t < std::size(tags); ++t)
+            {
+                b.uleb128(t + 1);
+                b.uleb128(tags[t]);
+                if (several)
+                {
+                    b.uleb128(DW_IDX_compile_unit);
+                    b.uleb128(DW_FORM_udata);
+                }
+                b.uleb128(DW_IDX_die_offset);
+                b.uleb128(DW_FORM_ref4);
+                b.uleb128(0);
+                b.uleb128(0);
+            }
+            b.uleb128(0);
+
+            std::vector<std::byte> entries;
+            Appender e(entries, spec.big_endian_);
+            std::vector<std::uint64_t> entry_offsets;
+            for (auto const& [hash, s]: names)
+            {
+                entry_offsets.push_back(entries.size());
+                for (IndexedName const* die: dies[*s])
+                {
+                    e.uleb128(std::find(std::begin(tags), std::end(tags), die->tag_) - std::begin(tags) + 1);
+                    if (several)
+                    {
+                        e.uleb128(die->unit_ - first);
+                    }
+                    e.put32(static_cast<std::uint32_t>(die->die_));
+                }
+                e.put8(0);
+            }
+
+            std::size_t const length_at = a.begin_unit(spec.dwarf64_);
+            a.put16(5);
+            a.put16(0);                 // padding
+            a.put32(last - first);
+            a.put32(0);                 // local_type_unit_count
+            a.put32(0);                 // foreign_type_unit_count
+            a.put32(bucket_count);
+            a.put32(name_count);
+            a.put32(static_cast<std::uint32_t>(abbrevs.size()));
+            a.put32(0);                 // augmentation_string_size
+            for (std::uint32_t u = first; u < last; ++u)
+            {
+                a.put(unit_offsets[u], offset_size);
+            }
+            std::uint32_t next = 0;
+            for (std::uint32_t bucket = 0; bucket < bucket_count; ++bucket)
+            {
+                bool const used = next < name_count && names[next].first % bucket_count == bucket;
+                a.put32(used ? next + 1 : 0);
+                while (next < name_count && names[next].first % bucket_count == bucket)
+                {
+                    ++next;
+                }
+            }
+            for (auto const& [hash, s]: names)
+            {
+                a.put32(hash);
+            }
+            for (auto const& [hash, s]: names)
+            {
+                a.put(add_string(images.str_, *s), offset_size);
+            }
+            for (std::uint64_t offset: entry_offsets)
+            {
+                a.put(offset, offset_size);
+            }
+            a.put_bytes(abbrevs);
+            a.put_bytes(entries);
+            a.end_unit(length_at, spec.dwarf64_);
+        }
+    }
+
+    /** The hash of names in .gdb_index, which ignores ASCII case */
+    std::uint32_t
+    gdb_index_hash(std::string const& name)
+    {
+        std::uint32_t hash = 0;
+        for (char c: name)
+        {
+            hash = hash * 67 + fold_case(c) - 113;
+        }
+        return hash;
+    }
+
+    /**
+     * Write a version 7 .gdb_index of every unit to @p images.  Only its
+     * unit list and symbol table are filled in: there are no type units, and
+     * the address area is left empty.
+     */
+    void
+    generate_gdb_index(std::vector<std::uint64_t> const& unit_offsets, DwarfImages& images)
+    {
+        // The unit list entry of each name: its unit, kind (1 for a type, 3
+        // for a function) and whether it's static, as base types are.  A
+        // subroutine inlined all over a unit is listed once.
+        std::map<std::string, std::vector<std::uint32_t>> units;
+        for (IndexedName const& name: images.indexed_names_)
+        {
+            if (!name.qualified_name_.empty())
+            {
+                bool const function = name.tag_ == DW_TAG_subprogram || name.tag_ == DW_TAG_inlined_subroutine;
+                std::uint32_t const is_static = name.tag_ == DW_TAG_base_type;
+                std::uint32_t const entry = name.unit_ | (function ? 3u : 1u) << 28 | is_static << 31;
+                std::vector<std::uint32_t>& entries = units[name.qualified_name_];
+                if (entries.empty() || entries.back() != entry)
+                {
+                    entries.push_back(entry);
+                }
+            }
+        }
+
+        // The constant pool has the unit lists, then the names.
+        std::vector<std::byte> pool;
+        Appender p(pool, false);
+        std::vector<std::pair<std::string const*, std::uint32_t>> lists;
+        for (auto const& [name, entries]: units)
+        {
+            lists.emplace_back(&name, static_cast<std::uint32_t>(pool.size()));
+            p.put32(static_cast<std::uint32_t>(entries.size()));
+            for (std::uint32_t entry: entries)
+            {
+                p.put32(entry);
+            }
+        }
+
+        // An open addressing hash table at most three quarters full.
+        std::uint32_t slot_count = 1;
+        while (slot_count * 3 < lists.size() * 4)
+        {
+            slot_count *= 2;
+        }
+        std::vector<std::pair<std::uint32_t, std::uint32_t>> slots(slot_count);
+        std::uint32_t const mask = slot_count - 1;
+        for (auto const& [name, list]: lists)
+        {
+            std::uint32_t const hash = gdb_index_hash(*name);
+            std::uint32_t const step = ((hash * 17) & mask) | 1;
+            std::uint32_t slot = hash & mask;
+            while (slots[slot].first != 0 || slots[slot].second != 0)
+            {
+                slot = (slot + step) & mask;
+            }
+            slots[slot] = {static_cast<std::uint32_t>(pool.size()), list};
+            p.put_cstring(*name);
+        }
+
+        Appender a(images.gdb_index_, false);
+        std::uint32_t const unit_list = 6 * 4;
+        std::uint32_t const symbols = unit_list + static_cast<std::uint32_t>(unit_offsets.size()) * 16;
+        a.put32(7);
+        a.put32(unit_list);
+        a.put32(symbols);               // the type unit list
+        a.put32(symbols);               // the address area
+        a.put32(symbols);
+        a.put32(symbols + slot_count * 8);
+        for (std::size_t u = 0; u < unit_offsets.size(); ++u)
+        {
+            std::uint64_t const end = u + 1 < unit_offsets.size() ? unit_offsets[u + 1] : images.info_.size();
+            a.put(unit_offsets[u], 8);
+            a.put(end - unit_offsets[u], 8);
+        }
+        for (auto const& [name, list]: slots)
+        {
+            a.put32(name);
+            a.put32(list);
+        }
+        a.put_bytes(pool);
+    }
+} // anonymous namespace
+
+
+GeneratedLine
+generated_line(ElfSpec const& spec, std::uint32_t unit, std::uint32_t row)
+{
+    std::uint64_t const unit_size = align_up(line_row_offset(spec.line_rows_per_unit_) + line_unit_gap, 16);
+    return GeneratedLine{
+        load_address(spec) + line_code_offset + unit * unit_size + line_row_offset(row),
+        1 + (row / 5) % 3,
+        1 + row + 40 * ((row / 10) % 3),
+        static_cast<std::uint16_t>((row / 4) % 90)
+    };
+}
+
+
+GeneratedFunction
+generated_function(ElfSpec const& spec, std::uint32_t unit, std::uint32_t function)
+{
+    std::uint64_t const unit_low = generated_line(spec, unit, 0).address_;
+    std::uint64_t const unit_high = generated_line(spec, unit, spec.line_rows_per_unit_).address_;
+    std::uint64_t const size = (unit_high - unit_low) / spec.functions_per_unit_ & ~std::uint64_t(15);
+    std::string const u = std::to_string(unit);
+
+    GeneratedFunction generated;
+    generated.low_pc_ = unit_low + function * size;
+    generated.high_pc_ = generated.low_pc_ + size;
+    generated.gap_low_ = is_ranged(function) ? generated.high_pc_ - 32 : 0;
+    generated.gap_high_ = is_ranged(function) ? generated.high_pc_ - 16 : 0;
+    if (is_member(function))
+    {
+        generated.name_ = "method_" + std::to_string(function);
+        generated.linkage_name_ = "_ZN" + length_prefixed("Class_" + u) + length_prefixed(generated.name_) + "Ev";
+    }
+    else
+    {
+        generated.name_ = "function_" + u + "_" + std::to_string(function);
+        generated.linkage_name_ = "_Z" + length_prefixed(generated.name_) + "v";
+    }
+    generated.inline_name_ = "inline_helper_" + u;
+    generated.inline_low_ = generated.low_pc_ + 16;
+    generated.inline_high_ = generated.low_pc_ + 48;
+    generated.inline_call_line_ = 100 + function;
+    generated.leaf_name_ = "inline_leaf_" + u;
+    generated.leaf_low_ = generated.low_pc_ + 24;
+    generated.leaf_high_ = generated.low_pc_ + 32;
+    generated.leaf_call_line_ = 200 + function;
+    return generated;
+}
+
+
+std::vector<DebugSection>
+generate_dwarf(ElfSpec const& spec)
+{
+    std::vector<DebugSection> sections;
+    if (spec.dwarf_unit_count_ == 0)
+    {
+        return sections;
+    }
+
+    DwarfImages images;
+    Forms const forms(spec);
+    std::uint64_t const include_offset = spec.dwarf_version_ >= 5 ? add_string(images.line_str_, "include") : 0;
+    if (spec.functions_per_unit_)
+    {
+        generate_abbreviations(spec, forms, images.abbrev_);
+    }
+    std::vector<std::uint64_t> unit_offsets;
+    for (std::uint32_t u = 0; u < spec.dwarf_unit_count_; ++u)
+    {
+        std::uint64_t const stmt_list = images.line_.size();
+        generate_line_program(spec, u, images.line_, images.line_str_, include_offset);
+        if (spec.functions_per_unit_)
+        {
+            unit_offsets.push_back(images.info_.size());
+            generate_unit(spec, forms, u, stmt_list, images);
+        }
+    }
+    if (spec.functions_per_unit_ && spec.dwarf_names_)
+    {
+        generate_debug_names(spec, unit_offsets, images);
+    }
+    if (spec.functions_per_unit_ && spec.gdb_index_)
+    {
+        generate_gdb_index(unit_offsets, images);
+    }
+
+    std::pair<char const*, std::vector<std::byte>*> const order[] = {
+        {".debug_abbrev", &images.abbrev_},
+        {".debug_info", &images.info_},
+        {".debug_aranges", &images.aranges_},
+        {".debug_line", &images.line_},
+        {".debug_str", &images.str_},
+        {".debug_line_str", &images.line_str_},
+        {".debug_str_offsets", &images.str_offsets_},
+        {".debug_addr", &images.addr_},
+        {".debug_ranges", &images.ranges_},
+        {".debug_rnglists", &images.rnglists_},
+        {".debug_names", &images.names_},
+        {".gdb_index", &images.gdb_index_},
+    };
+    for (auto const& [name, contents]: order)
+    {
+        if (!contents->empty())
+        {
+            bool const strings = contents == &images.str_ || contents == &images.line_str_;
+            sections.push_back(DebugSection{name, std::move(*contents), strings});
+        }
+    }
+    return sections;
+}
@@ -0,0 +1,51 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef EDHELIND_ELFGEN_DWARFGEN_H
+#define EDHELIND_ELFGEN_DWARFGEN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+struct ElfSpec;
+
+
+/** The address the generated file is loaded at */
+std::uint64_t
+load_address(ElfSpec const& spec);
+
+
+/** A generated debug section */
+struct DebugSection
+{
+    std::string            name_;
+    std::vector<std::byte> contents_;
+    bool                   strings_;    /**< a string table, so SHF_MERGE | SHF_STRINGS */
+};
+
+
+/**
+ * Generate the DWARF sections of the file described by @p spec, in the order
+ * they go in the file.
+ */
+std::vector<DebugSection>
+generate_dwarf(ElfSpec const& spec);
+
+#endif /* EDHELIND_ELFGEN_DWARFGEN_H */
@@ -0,0 +1,591 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "elfgen/elfgen.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstring>
+#include "elfgen/dwarfgen.h"
+#include "libedhel/elf.h"
+#include "libedhel/symbol.h"
+#include <iterator>
+#include <sstream>
+#include <stdexcept>
+
+
+namespace
+{
+    constexpr std::uint64_t base_address64 = 0x400000;
+    constexpr std::uint32_t base_address32 = 0x08048000;
+    constexpr std::uint32_t r_type_abs = 1;  /* R_X86_64_64, R_386_32, R_PPC_ADDR32... */
+
+    /** Words symbol names are made from, so names vary in length and content */
+    char const* const name_words[] = {
+        "init", "buffer", "parse", "node", "table", "get", "set", "read",
+        "write", "list", "map", "string", "handle", "event", "queue", "alloc",
+    };
+
+    /**
+     * A small deterministic pseudo-random number generator (xorshift64*).
+     */
+    class Random
+    {
+    public:
+        explicit Random(std::uint64_t seed)
+        : state_{seed ^ 0x9e3779b97f4a7c15ULL}
+        {
+            if (state_ == 0)
+            {
+                state_ = 1;
+            }
+        }
+
+        std::uint64_t
+        next()
+        {
+            state_ ^= state_ >> 12;
+            state_ ^= state_ << 25;
+            state_ ^= state_ >> 27;
+            return state_ * 0x2545f4914f6cdd1dULL;
+        }
+
+        /** A number in [0, @p n) */
+        std::uint32_t
+        below(std::uint32_t n)
+        {
+            return n == 0 ? 0 : static_cast<std::uint32_t>(next() % n);
+        }
+
+    private:
+        std::uint64_t state_;
+    };
+
+    /**
+     * Writes target-order integers into a byte buffer.
+     */
+    class Writer
+    {
+    public:
+        Writer(std::vector<std::byte>& bytes, bool big_endian)
+        : bytes_{bytes}
+        , big_endian_{big_endian}
+        { }
+
+        void
+        put(std::size_t offset, std::uint64_t value, std::size_t size)
+        {
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                std::size_t shift = 8 * (big_endian_ ? size - 1 - i : i);
+                bytes_[offset + i] = static_cast<std::byte>(value >> shift);
+            }
+        }
+
+        void
+        put8(std::size_t offset, std::uint8_t value)   { put(offset, value, 1); }
+
+        void
+        put16(std::size_t offset, std::uint16_t value) { put(offset, value, 2); }
+
+        void
+        put32(std::size_t offset, std::uint32_t value) { put(offset, value, 4); }
+
+        void
+        put64(std::size_t offset, std::uint64_t value) { put(offset, value, 8); }
+
+        void
+        put_string(std::size_t offset, std::string const& s)
+        {
+            std::memcpy(bytes_.data() + offset, s.data(), s.size());
+        }
+
+    private:
+        std::vector<std::byte>& bytes_;
+        bool                    big_endian_;
+    };
+
+    /** A section header as it will be written out */
+    struct SectionHeader
+    {
+        std::uint32_t name_ = 0;
+        SType         type_ = SType::SHT_NULL;
+        std::uint64_t flags_ = 0;
+        std::uint64_t addr_ = 0;
+        std::uint64_t offset_ = 0;
+        std::uint64_t size_ = 0;
+        std::uint32_t link_ = 0;
+        std::uint32_t info_ = 0;
+        std::uint64_t addralign_ = 0;
+        std::uint64_t entsize_ = 0;
+    };
+
+    /** Collects NUL-terminated strings into a string table image */
+    class StringTable
+    {
+    public:
+        StringTable()
+        : table_(1, '\0')
+        { }
+
+        std::uint32_t
+        add(std::string const& s)
+        {
+            auto offset = static_cast<std::uint32_t>(table_.size());
+            table_ += s;
+            table_ += '\0';
+            return offset;
+        }
+
+        std::string const&
+        table() const
+        {
+            return table_;
+        }
+
+    private:
+        std::string table_;
+    };
+
+    std::uint64_t
+    align_up(std::uint64_t value, std::uint64_t alignment)
+    {
+        return (value + alignment - 1) / alignment * alignment;
+    }
+} // anonymous namespace
+
+
+std::uint64_t
+load_address(ElfSpec const& spec)
+{
+    return spec.is_64bit_ ? base_address64 : base_address32;
+}
+
+
+std::vector<std::byte>
+generate_elf(ElfSpec const& spec)
+{
+    Random random(spec.seed_);
+    bool const is64 = spec.is_64bit_;
+    std::uint64_t const base_address = load_address(spec);
+    std::size_t const ehsize = is64 ? sizeof(Elf64_Ehdr) : sizeof(Elf32_Ehdr);
+    std::size_t const phentsize = is64 ? sizeof(Elf64_Phdr) : sizeof(Elf32_Phdr);
+    std::size_t const shentsize = is64 ? sizeof(Elf64_Shdr) : sizeof(Elf32_Shdr);
+    std::size_t const symentsize = is64 ? sizeof(Elf64::Sym) : sizeof(Elf32::Sym);
+    std::size_t const relaentsize = is64 ? 24 : 12;
+    std::uint64_t const word_align = is64 ? 8 : 4;
+
+    // Decide which sections there are and where they are in the table.
+    std::uint32_t next_index = 1;
+    std::uint32_t const first_progbits = next_index;
+    next_index += spec.section_count_;
+    std::uint32_t const note_index = spec.note_count_ ? next_index++ : 0;
+    std::uint32_t const symtab_index = spec.symbol_count_ ? next_index++ : 0;
+    std::uint32_t const max_symbol_shndx = spec.section_count_ == 0 ? 0
+                                         : first_progbits + std::min(spec.section_count_, spec.symbol_count_) - 1;
+    bool const symbols_use_xindex = spec.extended_numbering_ || max_symbol_shndx >= SHN_LORESERVE;
+    std::uint32_t const shndx_index = (spec.symbol_count_ && symbols_use_xindex) ? next_index++ : 0;
+    std::uint32_t const strtab_index = (spec.symbol_count_ || spec.string_table_size_) ? next_index++ : 0;
+    std::uint32_t const rela_index = spec.relocation_count_ ? next_index++ : 0;
+    std::vector<DebugSection> const debug_sections = generate_dwarf(spec);
+    std::uint32_t const first_debug = next_index;
+    next_index += static_cast<std::uint32_t>(debug_sections.size());
+    std::uint32_t const shstrtab_index = next_index++;
+    std::uint32_t const section_count = next_index;
+    bool const extended = spec.extended_numbering_ || section_count >= SHN_LORESERVE;
+
+    std::vector<SectionHeader> sections(section_count);
+    StringTable shstrtab;
+    StringTable strtab;
+
+    // Lay out the file: headers first, then each section's contents, then the
+    // section header table.
+    std::uint32_t const phnum = note_index ? 2 : 1;
+    std::uint64_t offset = ehsize + phnum * phentsize;
+    auto place = [&](std::uint32_t index, std::string const& name, SType type, std::uint64_t size,
+                     std::uint64_t alignment, std::uint64_t entsize) {
+        SectionHeader& section = sections[index];
+        offset = align_up(offset, alignment);
+        section.name_ = shstrtab.add(name);
+        section.type_ = type;
+        section.offset_ = offset;
+        section.size_ = size;
+        section.addralign_ = alignment;
+        section.entsize_ = entsize;
+        offset += size;
+        return &section;
+    };
+
+    for (std::uint32_t i = 0; i < spec.section_count_; ++i)
+    {
+        SectionHeader* section = place(first_progbits + i, ".text." + std::to_string(i), SType::SHT_PROGBITS,
+                                       spec.section_size_, 16, 0);
+        section->flags_ = Elf::SHF_ALLOC | Elf::SHF_EXECINSTR;
+        section->addr_ = base_address + section->offset_;
+    }
+
+    struct NoteShape
+    {
+        std::string   name_;
+        std::uint32_t type_;
+        std::uint32_t descsz_;
+    };
+    std::vector<NoteShape> notes;
+    std::uint64_t note_size = 0;
+    for (std::uint32_t i = 0; i < spec.note_count_; ++i)
+    {
+        NoteShape note{ i % 2 ? "edhel" : "GNU", 1 + i % 4, 4 * (1 + i % 4) };
+        note_size += 12 + align_up(note.name_.size() + 1, 4) + note.descsz_;
+        notes.push_back(note);
+    }
+    if (note_index)
+    {
+        SectionHeader* section = place(note_index, ".note", SType::SHT_NOTE, note_size, 4, 0);
+        section->flags_ = Elf::SHF_ALLOC;
+        section->addr_ = base_address + section->offset_;
+    }
+
+    // Symbols: the first quarter are local objects, the rest global functions.
+    struct SymbolShape
+    {
+        std::uint32_t name_;
+        std::uint64_t value_;
+        std::uint64_t size_;
+        std::uint8_t  info_;
+        std::uint32_t shndx_;
+    };
+    std::vector<SymbolShape> symbols;
+    std::uint32_t const local_count = 1 + spec.symbol_count_ / 4;
+    symbols.reserve(spec.symbol_count_ + 1);
+    symbols.push_back(SymbolShape{0, 0, 0, 0, SHN_UNDEF});
+    for (std::uint32_t i = 0; i < spec.symbol_count_; ++i)
+    {
+        std::string name = std::string(name_words[random.below(std::size(name_words))]) + "_"
+                         + name_words[random.below(std::size(name_words))] + "_" + std::to_string(i);
+        bool is_local = symbols.size() < local_count;
+        SymbolShape symbol;
+        symbol.name_ = strtab.add(name);
+        symbol.info_ = static_cast<std::uint8_t>(((is_local ? STB_LOCAL : STB_GLOBAL) << 4)
+                                                 | (is_local ? STT_OBJECT : STT_FUNC));
+        if (spec.section_count_)
+        {
+            symbol.shndx_ = first_progbits + i % spec.section_count_;
+            symbol.value_ = sections[symbol.shndx_].addr_ + random.below(spec.section_size_);
+        }
+        else
+        {
+            symbol.shndx_ = SHN_ABS;
+            symbol.value_ = random.next() & 0xffff;
+        }
+        symbol.size_ = 1 + random.below(64);
+        symbols.push_back(symbol);
+    }
+    for (std::uint32_t i = 0; strtab.table().size() < spec.string_table_size_; ++i)
+    {
+        strtab.add("padding_" + std::string(name_words[random.below(std::size(name_words))]) + "_" + std::to_string(i));
+    }
+
+    if (symtab_index)
+    {
+        SectionHeader* section = place(symtab_index, ".symtab", SType::SHT_SYMTAB,
+                                       symbols.size() * symentsize, word_align, symentsize);
+        section->link_ = strtab_index;
+        section->info_ = local_count;
+    }
+    if (shndx_index)
+    {
+        SectionHeader* section = place(shndx_index, ".symtab_shndx", SType::SHT_SYMTAB_SHNDX,
+                                       symbols.size() * 4, 4, 4);
+        section->link_ = symtab_index;
+    }
+    if (strtab_index)
+    {
+        place(strtab_index, ".strtab", SType::SHT_STRTAB, strtab.table().size(), 1, 0);
+    }
+    if (rela_index)
+    {
+        SectionHeader* section = place(rela_index, ".rela.text", SType::SHT_RELA,
+                                       spec.relocation_count_ * relaentsize, word_align, relaentsize);
+        section->link_ = symtab_index;
+        section->info_ = spec.section_count_ ? first_progbits : 0;
+    }
+    for (std::size_t i = 0; i < debug_sections.size(); ++i)
+    {
+        DebugSection const& debug = debug_sections[i];
+        SectionHeader* section = place(first_debug + static_cast<std::uint32_t>(i), debug.name_, SType::SHT_PROGBITS,
+                                       debug.contents_.size(), 1, debug.strings_ ? 1 : 0);
+        if (debug.strings_)
+        {
+            section->flags_ = Elf::SHF_MERGE | Elf::SHF_STRINGS;
+        }
+    }
+    // The section name table has to hold its own name before it can be sized.
+    std::uint32_t shstrtab_name = shstrtab.add(".shstrtab");
+    sections[shstrtab_index] = SectionHeader{shstrtab_name, SType::SHT_STRTAB, 0, 0, offset,
+                                             shstrtab.table().size(), 0, 0, 1, 0};
+    offset += shstrtab.table().size();
+
+    std::uint64_t const shoff = align_up(offset, word_align);
+    std::uint64_t const file_size = shoff + section_count * shentsize;
+    if (extended)
+    {
+        sections[0].size_ = section_count;
+        sections[0].link_ = shstrtab_index;
+    }
+
+    // Now write it all out.
+    std::vector<std::byte> bytes(file_size);
+    Writer w(bytes, spec.big_endian_);
+
+    // ELF header
+    std::memcpy(bytes.data(), elf_magic, sizeof(elf_magic));
+    w.put8(offsetof(Elf64_Ehdr, ei_class), static_cast<std::uint8_t>(is64 ? EhiClass::ELFCLASS64 : EhiClass::ELFCLASS32));
+    w.put8(offsetof(Elf64_Ehdr, ei_data), static_cast<std::uint8_t>(spec.big_endian_ ? EhiData::ELFDATA2MSB : EhiData::ELFDATA2LSB));
+    w.put8(offsetof(Elf64_Ehdr, ei_version), static_cast<std::uint8_t>(EhiVersion::EV_CURRENT));
+    EhMachine machine = spec.big_endian_ ? (is64 ? EhMachine::EM_PPC64 : EhMachine::EM_PPC)
+                                         : (is64 ? EhMachine::EM_X86_64 : EhMachine::EM_386);
+    std::uint64_t entry = spec.section_count_ ? sections[first_progbits].addr_ : base_address;
+    std::uint16_t e_shnum = extended ? 0 : static_cast<std::uint16_t>(section_count);
+    std::uint16_t e_shstrndx = extended ? SHN_XINDEX : static_cast<std::uint16_t>(shstrtab_index);
+    if (is64)
+    {
+        w.put16(offsetof(Elf64_Ehdr, e_type), static_cast<std::uint16_t>(EhType::ET_EXEC));
+        w.put16(offsetof(Elf64_Ehdr, e_machine), static_cast<std::uint16_t>(machine));
+        w.put32(offsetof(Elf64_Ehdr, e_version), 1);
+        w.put64(offsetof(Elf64_Ehdr, e_entry), entry);
+        w.put64(offsetof(Elf64_Ehdr, e_phoff), ehsize);
+        w.put64(offsetof(Elf64_Ehdr, e_shoff), shoff);
+        w.put16(offsetof(Elf64_Ehdr, e_ehsize), static_cast<std::uint16_t>(ehsize));
+        w.put16(offsetof(Elf64_Ehdr, e_phentsize), static_cast<std::uint16_t>(phentsize));
+        w.put16(offsetof(Elf64_Ehdr, e_phnum), static_cast<std::uint16_t>(phnum));
+        w.put16(offsetof(Elf64_Ehdr, e_shentsize), static_cast<std::uint16_t>(shentsize));
+        w.put16(offsetof(Elf64_Ehdr, e_shnum), e_shnum);
+        w.put16(offsetof(Elf64_Ehdr, e_shstrndx), e_shstrndx);
+    }
+    else
+    {
+        w.put16(offsetof(Elf32_Ehdr, e_type), static_cast<std::uint16_t>(EhType::ET_EXEC));
+        w.put16(offsetof(Elf32_Ehdr, e_machine), static_cast<std::uint16_t>(machine));
+        w.put32(offsetof(Elf32_Ehdr, e_version), 1);
+        w.put32(offsetof(Elf32_Ehdr, e_entry), static_cast<std::uint32_t>(entry));
+        w.put32(offsetof(Elf32_Ehdr, e_phoff), static_cast<std::uint32_t>(ehsize));
+        w.put32(offsetof(Elf32_Ehdr, e_shoff), static_cast<std::uint32_t>(shoff));
+        w.put16(offsetof(Elf32_Ehdr, e_ehsize), static_cast<std::uint16_t>(ehsize));
+        w.put16(offsetof(Elf32_Ehdr, e_phentsize), static_cast<std::uint16_t>(phentsize));
+        w.put16(offsetof(Elf32_Ehdr, e_phnum), static_cast<std::uint16_t>(phnum));
+        w.put16(offsetof(Elf32_Ehdr, e_shentsize), static_cast<std::uint16_t>(shentsize));
+        w.put16(offsetof(Elf32_Ehdr, e_shnum), e_shnum);
+        w.put16(offsetof(Elf32_Ehdr, e_shstrndx), e_shstrndx);
+    }
+
+    // Program headers
+    auto put_phdr = [&](std::size_t index, PType type, PFlags flags, std::uint64_t p_offset,
+                        std::uint64_t size, std::uint64_t align) {
+        std::size_t at = ehsize + index * phentsize;
+        std::uint64_t vaddr = base_address + p_offset;
+        if (is64)
+        {
+            w.put32(at + offsetof(Elf64_Phdr, p_type), static_cast<std::uint32_t>(type));
+            w.put32(at + offsetof(Elf64_Phdr, p_flags), flags);
+            w.put64(at + offsetof(Elf64_Phdr, p_offset), p_offset);
+            w.put64(at + offsetof(Elf64_Phdr, p_vaddr), vaddr);
+            w.put64(at + offsetof(Elf64_Phdr, p_paddr), vaddr);
+            w.put64(at + offsetof(Elf64_Phdr, p_filesz), size);
+            w.put64(at + offsetof(Elf64_Phdr, p_memsz), size);
+            w.put64(at + offsetof(Elf64_Phdr, p_align), align);
+        }
+        else
+        {
+            w.put32(at + offsetof(Elf32_Phdr, p_type), static_cast<std::uint32_t>(type));
+            w.put32(at + offsetof(Elf32_Phdr, p_offset), static_cast<std::uint32_t>(p_offset));
+            w.put32(at + offsetof(Elf32_Phdr, p_vaddr), static_cast<std::uint32_t>(vaddr));
+            w.put32(at + offsetof(Elf32_Phdr, p_paddr), static_cast<std::uint32_t>(vaddr));
+            w.put32(at + offsetof(Elf32_Phdr, p_filesz), static_cast<std::uint32_t>(size));
+            w.put32(at + offsetof(Elf32_Phdr, p_memsz), static_cast<std::uint32_t>(size));
+            w.put32(at + offsetof(Elf32_Phdr, p_flags), flags);
+            w.put32(at + offsetof(Elf32_Phdr, p_align), static_cast<std::uint32_t>(align));
+        }
+    };
+    put_phdr(0, PType::PT_LOAD, FP_R | FP_X, 0, file_size, 0x1000);
+    if (note_index)
+    {
+        put_phdr(1, PType::PT_NOTE, FP_R, sections[note_index].offset_, sections[note_index].size_, 4);
+    }
+
+    // Section contents
+    for (std::uint32_t i = 0; i < spec.section_count_; ++i)
+    {
+        SectionHeader const& section = sections[first_progbits + i];
+        for (std::uint64_t b = 0; b < section.size_; b += 8)
+        {
+            std::uint64_t value = random.next();
+            std::memcpy(bytes.data() + section.offset_ + b, &value, std::min<std::uint64_t>(8, section.size_ - b));
+        }
+    }
+
+    if (note_index)
+    {
+        std::uint64_t at = sections[note_index].offset_;
+        for (auto const& note: notes)
+        {
+            w.put32(at, static_cast<std::uint32_t>(note.name_.size() + 1));
+            w.put32(at + 4, note.descsz_);
+            w.put32(at + 8, note.type_);
+            w.put_string(at + 12, note.name_);
+            at += 12 + align_up(note.name_.size() + 1, 4);
+            for (std::uint32_t d = 0; d < note.descsz_; d += 4)
+            {
+                w.put32(at + d, static_cast<std::uint32_t>(random.next()));
+            }
+            at += note.descsz_;
+        }
+    }
+
+    if (symtab_index)
+    {
+        std::uint64_t at = sections[symtab_index].offset_;
+        for (std::size_t i = 0; i < symbols.size(); ++i, at += symentsize)
+        {
+            SymbolShape const& symbol = symbols[i];
+            bool use_xindex = i != 0 && symbol.shndx_ != SHN_ABS
+                           && (spec.extended_numbering_ || symbol.shndx_ >= SHN_LORESERVE);
+            std::uint16_t st_shndx = use_xindex ? SHN_XINDEX : static_cast<std::uint16_t>(symbol.shndx_);
+            if (is64)
+            {
+                w.put32(at + offsetof(Elf64::Sym, st_name), symbol.name_);
+                w.put8(at + offsetof(Elf64::Sym, st_info), symbol.info_);
+                w.put16(at + offsetof(Elf64::Sym, st_shndx), st_shndx);
+                w.put64(at + offsetof(Elf64::Sym, st_value), symbol.value_);
+                w.put64(at + offsetof(Elf64::Sym, st_size), symbol.size_);
+            }
+            else
+            {
+                w.put32(at + offsetof(Elf32::Sym, st_name), symbol.name_);
+                w.put32(at + offsetof(Elf32::Sym, st_value), static_cast<std::uint32_t>(symbol.value_));
+                w.put32(at + offsetof(Elf32::Sym, st_size), static_cast<std::uint32_t>(symbol.size_));
+                w.put8(at + offsetof(Elf32::Sym, st_info), symbol.info_);
+                w.put16(at + offsetof(Elf32::Sym, st_shndx), st_shndx);
+            }
+            if (shndx_index && use_xindex)
+            {
+                w.put32(sections[shndx_index].offset_ + 4 * i, symbol.shndx_);
+            }
+        }
+    }
+
+    if (strtab_index)
+    {
+        w.put_string(sections[strtab_index].offset_, strtab.table());
+    }
+
+    if (rela_index)
+    {
+        std::uint64_t at = sections[rela_index].offset_;
+        std::uint64_t target = spec.section_count_ ? sections[first_progbits].addr_ : base_address;
+        for (std::uint32_t i = 0; i < spec.relocation_count_; ++i, at += relaentsize)
+        {
+            std::uint32_t sym = spec.symbol_count_ ? 1 + i % spec.symbol_count_ : 0;
+            std::uint64_t r_offset = target + (spec.section_size_ ? (8 * i) % spec.section_size_ : 0);
+            std::int64_t addend = static_cast<std::int64_t>(random.below(256)) - 128;
+            if (is64)
+            {
+                w.put64(at, r_offset);
+                w.put64(at + 8, (std::uint64_t(sym) << 32) | r_type_abs);
+                w.put64(at + 16, static_cast<std::uint64_t>(addend));
+            }
+            else
+            {
+                w.put32(at, static_cast<std::uint32_t>(r_offset));
+                w.put32(at + 4, (sym << 8) | r_type_abs);
+                w.put32(at + 8, static_cast<std::uint32_t>(addend));
+            }
+        }
+    }
+
+    for (std::size_t i = 0; i < debug_sections.size(); ++i)
+    {
+        std::vector<std::byte> const& contents = debug_sections[i].contents_;
+        std::memcpy(bytes.data() + sections[first_debug + i].offset_, contents.data(), contents.size());
+    }
+
+    w.put_string(sections[shstrtab_index].offset_, shstrtab.table());
+
+    // Section header table
+    for (std::uint32_t i = 0; i < section_count; ++i)
+    {
+        SectionHeader const& s = sections[i];
+        std::size_t at = shoff + i * shentsize;
+        if (is64)
+        {
+            w.put32(at + offsetof(Elf64_Shdr, sh_name), s.name_);
+            w.put32(at + offsetof(Elf64_Shdr, sh_type), static_cast<std::uint32_t>(s.type_));
+            w.put64(at + offsetof(Elf64_Shdr, sh_flags), s.flags_);
+            w.put64(at + offsetof(Elf64_Shdr, sh_addr), s.addr_);
+            w.put64(at + offsetof(Elf64_Shdr, sh_offset), s.offset_);
+            w.put64(at + offsetof(Elf64_Shdr, sh_size), s.size_);
+            w.put32(at + offsetof(Elf64_Shdr, sh_link), s.link_);
+            w.put32(at + offsetof(Elf64_Shdr, sh_info), s.info_);
+            w.put64(at + offsetof(Elf64_Shdr, sh_addralign), s.addralign_);
+            w.put64(at + offsetof(Elf64_Shdr, sh_entsize), s.entsize_);
+        }
+        else
+        {
+            w.put32(at + offsetof(Elf32_Shdr, sh_name), s.name_);
+            w.put32(at + offsetof(Elf32_Shdr, sh_type), static_cast<std::uint32_t>(s.type_));
+            w.put32(at + offsetof(Elf32_Shdr, sh_flags), static_cast<std::uint32_t>(s.flags_));
+            w.put32(at + offsetof(Elf32_Shdr, sh_addr), static_cast<std::uint32_t>(s.addr_));
+            w.put32(at + offsetof(Elf32_Shdr, sh_offset), static_cast<std::uint32_t>(s.offset_));
+            w.put32(at + offsetof(Elf32_Shdr, sh_size), static_cast<std::uint32_t>(s.size_));
+            w.put32(at + offsetof(Elf32_Shdr, sh_link), s.link_);
+            w.put32(at + offsetof(Elf32_Shdr, sh_info), s.info_);
+            w.put32(at + offsetof(Elf32_Shdr, sh_addralign), static_cast<std::uint32_t>(s.addralign_));
+            w.put32(at + offsetof(Elf32_Shdr, sh_entsize), static_cast<std::uint32_t>(s.entsize_));
+        }
+    }
+
+    return bytes;
+}
+
+
+void
+write_elf(ElfSpec const& spec, std::string const& file_name)
+{
+    std::vector<std::byte> bytes = generate_elf(spec);
+
+    // Use C fileio because C++ is broken when it comes to binary file I/O
+    FILE* file = std::fopen(file_name.c_str(), "wb");
+    if (file == nullptr)
+    {
+        std::ostringstream ostr;
+        ostr << "error " << errno << " creating '" << file_name << "': " << std::strerror(errno);
+        throw std::runtime_error(ostr.str());
+    }
+
+    std::size_t written = std::fwrite(bytes.data(), sizeof(std::byte), bytes.size(), file);
+    if (written != bytes.size() || std::fclose(file) != 0)
+    {
+        std::ostringstream ostr;
+        ostr << "error " << errno << " writing '" << file_name << "': " << std::strerror(errno);
+        if (written != bytes.size())
+        {
+            std::fclose(file);
+        }
+        throw std::runtime_error(ostr.str());
+    }
+}
@@ -0,0 +1,163 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef EDHELIND_ELFGEN_ELFGEN_H
+#define EDHELIND_ELFGEN_ELFGEN_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+
+/**
+ * The shape of a synthetic ELF file.
+ *
+ * The generated file is a little executable with a single PT_LOAD segment
+ * covering the whole file and the following sections, in order:
+ *
+ *   - the null section
+ *   - @c section_count_ SHT_PROGBITS sections named .text.0, .text.1, ...
+ *   - .note, if @c note_count_ is not zero (also covered by a PT_NOTE)
+ *   - .symtab, if @c symbol_count_ is not zero
+ *   - .symtab_shndx, if any symbol needs an extended section index
+ *   - .strtab, if there are symbols or a minimum string table size
+ *   - .rela.text, if @c relocation_count_ is not zero
+ *   - if @c dwarf_unit_count_ is not zero, the DWARF sections describing
+ *     that many compilation units: .debug_line, and if
+ *     @c functions_per_unit_ is not zero .debug_abbrev, .debug_info,
+ *     .debug_aranges (unless @c dwarf_aranges_ is false), .debug_str and
+ *     (depending on the version) .debug_ranges or .debug_str_offsets,
+ *     .debug_addr, .debug_rnglists and .debug_line_str, then .debug_names
+ *     and .gdb_index if @c dwarf_names_ and @c gdb_index_ ask for them
+ *   - .shstrtab
+ *
+ * Everything is derived from the spec and @c seed_, so the same spec always
+ * produces the same bytes.
+ */
+struct ElfSpec
+{
+    bool          is_64bit_ = true;
+    bool          big_endian_ = false;
+    std::uint32_t section_count_ = 4;         /**< number of SHT_PROGBITS sections */
+    std::uint32_t section_size_ = 64;         /**< size of each SHT_PROGBITS section */
+    std::uint32_t symbol_count_ = 32;         /**< not counting the null symbol */
+    std::uint32_t string_table_size_ = 0;     /**< pad .strtab out to at least this size */
+    std::uint32_t note_count_ = 2;
+    std::uint32_t relocation_count_ = 0;
+    std::uint32_t dwarf_unit_count_ = 0;      /**< number of DWARF compilation units */
+    std::uint32_t line_rows_per_unit_ = 64;   /**< rows of each line number program, not counting end of sequence rows */
+    std::uint32_t functions_per_unit_ = 0;    /**< functions in each unit's .debug_info */
+    bool          dwarf_aranges_ = true;      /**< say where each unit's functions are in .debug_aranges */
+    std::uint16_t dwarf_version_ = 5;         /**< 2 to 5 */
+    bool          dwarf64_ = false;           /**< use the 64-bit DWARF format */
+    std::uint32_t dwarf_names_ = 0;           /**< index the names of this many units, from the first, in .debug_names */
+    bool          gdb_index_ = false;         /**< index the names of every unit in .gdb_index */
+    bool          extended_numbering_ = false; /**< use extended numbering even if not needed */
+    std::uint64_t seed_ = 0;
+};
+
+
+/** A row of a generated line number program */
+struct GeneratedLine
+{
+    std::uint64_t address_;
+    std::uint32_t file_;
+    std::uint32_t line_;
+    std::uint16_t column_;
+};
+
+
+/**
+ * Row @p row of line number program @p unit of the file generated from
+ * @p spec, where @p row may be one past the last row to get the end of the
+ * unit's code.
+ *
+ * Each program covers its own stretch of code, with a gap between units.  It
+ * is made of two sequences, the second half of the rows first, and names
+ * three files (numbered 1 to 3) in a directory "include" and the
+ * compilation directory "/src/unit_N", which only DWARF 5 programs name.
+ */
+GeneratedLine
+generated_line(ElfSpec const& spec, std::uint32_t unit, std::uint32_t row);
+
+
+/** A function described by generated debugging information */
+struct GeneratedFunction
+{
+    std::string   name_;
+    std::string   linkage_name_;
+    std::uint64_t low_pc_;
+    std::uint64_t high_pc_;
+    std::uint64_t gap_low_;         /**< code between low_pc_ and high_pc_ that isn't the function's, if any */
+    std::uint64_t gap_high_;
+    std::string   inline_name_;     /**< the subroutine inlined into it */
+    std::uint64_t inline_low_;
+    std::uint64_t inline_high_;
+    std::uint32_t inline_call_line_;
+    std::string   leaf_name_;       /**< the subroutine inlined into that */
+    std::uint64_t leaf_low_;
+    std::uint64_t leaf_high_;
+    std::uint32_t leaf_call_line_;
+};
+
+
+/**
+ * Function @p function of unit @p unit of the file generated from @p spec.
+ *
+ * The functions of a unit split its code (see generated_line()) evenly
+ * between them, so there should be at least 96 bytes of it for each.  In
+ * each one a subroutine is inlined, called from file 2, and another inlined
+ * into that, called from file 3.  Every third function is in two ranges with
+ * a gap between them; of the rest, odd ones are out-of-line definitions of
+ * member functions declared in a structure, and get their names from the
+ * declaration.
+ *
+ * The unit DIEs of even units cover all of the unit's code with DW_AT_low_pc
+ * and DW_AT_high_pc; those of odd units list just their functions' ranges in
+ * DW_AT_ranges, as .debug_aranges does for every unit.
+ *
+ * The name indexes list each unit's "int" base type, its structure "Class_N",
+ * its functions and every inlined subroutine, by name and by linkage name.
+ * .gdb_index qualifies the names of member functions with the structure's,
+ * as GDB does, and leaves linkage names out.
+ */
+GeneratedFunction
+generated_function(ElfSpec const& spec, std::uint32_t unit, std::uint32_t function);
+
+
+/**
+ * Generate the ELF file described by @p spec.
+ *
+ * Extended section numbering (e_shnum and e_shstrndx in section 0,
+ * SHN_XINDEX symbols and an SHT_SYMTAB_SHNDX section) is used when there are
+ * too many sections for the ELF header, or always if the spec asks for it.
+ */
+std::vector<std::byte>
+generate_elf(ElfSpec const& spec);
+
+
+/**
+ * Generate the ELF file described by @p spec and write it to @p file_name.
+ *
+ * @throws std::runtime_error if the file can not be written
+ */
+void
+write_elf(ElfSpec const& spec, std::string const& file_name);
+
+#endif /* EDHELIND_ELFGEN_ELFGEN_H */
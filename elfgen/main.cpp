@@ -0,0 +1,180 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "elfgen/elfgen.h"
+
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <iostream>
+#include <string>
+
+
+namespace
+{
+    void
+    usage(char const* program)
+    {
+        std::cerr << "usage: " << program << " [options] -o FILE\n"
+                  << "\n"
+                  << "Write a synthetic ELF file to FILE.\n"
+                  << "\n"
+                  << "options:\n"
+                  << "  --class=32|64           ELF class (default 64)\n"
+                  << "  --endian=le|be          byte order (default le)\n"
+                  << "  --sections=N            number of SHT_PROGBITS sections (default 4)\n"
+                  << "  --section-size=N        size of each SHT_PROGBITS section (default 64)\n"
+                  << "  --symbols=N             number of symbols (default 32)\n"
+                  << "  --strtab-size=N         minimum size of .strtab in bytes (default 0)\n"
+                  << "  --notes=N               number of notes (default 2)\n"
+                  << "  --relocations=N         number of relocations (default 0)\n"
+                  << "  --dwarf-units=N         number of DWARF compilation units (default 0)\n"
+                  << "  --line-rows=N           rows of each line number program (default 64)\n"
+                  << "  --functions=N           functions described in each unit's .debug_info (default 0)\n"
+                  << "  --dwarf-version=N       DWARF version of the debugging information (default 5)\n"
+                  << "  --dwarf64               use the 64-bit DWARF format\n"
+                  << "  --no-aranges            leave out .debug_aranges\n"
+                  << "  --debug-names=N         index the names of the first N units in .debug_names (default 0)\n"
+                  << "  --gdb-index             index the names of every unit in .gdb_index\n"
+                  << "  --extended-numbering    use extended section numbering\n"
+                  << "  --seed=N                seed for the generated contents (default 0)\n";
+    }
+
+    /** If @p arg is "--@p option=VALUE" put VALUE in @p value */
+    bool
+    option_value(char const* arg, char const* option, unsigned long long& value)
+    {
+        std::size_t len = std::strlen(option);
+        if (std::strncmp(arg, "--", 2) == 0 && std::strncmp(arg + 2, option, len) == 0 && arg[2 + len] == '=')
+        {
+            value = std::strtoull(arg + 3 + len, nullptr, 0);
+            return true;
+        }
+        return false;
+    }
+} // anonymous namespace
+
+
+int
+main(int argc, char* argv[])
+{
+    ElfSpec spec;
+    std::string output;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        unsigned long long value = 0;
+        if (std::strcmp(argv[i], "--class=32") == 0 || std::strcmp(argv[i], "--class=64") == 0)
+        {
+            spec.is_64bit_ = std::strcmp(argv[i], "--class=64") == 0;
+        }
+        else if (std::strcmp(argv[i], "--endian=le") == 0 || std::strcmp(argv[i], "--endian=be") == 0)
+        {
+            spec.big_endian_ = std::strcmp(argv[i], "--endian=be") == 0;
+        }
+        else if (option_value(argv[i], "sections", value))
+        {
+            spec.section_count_ = static_cast<std::uint32_t>(value);
+        }
+        else if (option_value(argv[i], "section-size", value))
+        {
+            spec.section_size_ = static_cast<std::uint32_t>(value);
+        }
+        else if (option_value(argv[i], "symbols", value))
+        {
+            spec.symbol_count_ = static_cast<std::uint32_t>(value);
+        }
+        else if (option_value(argv[i], "strtab-size", value))
+        {
+            spec.string_table_size_ = static_cast<std::uint32_t>(value);
+        }
+        else if (option_value(argv[i], "notes", value))
+        {
+            spec.note_count_ = static_cast<std::uint32_t>(value);
+        }
+        else if (option_value(argv[i], "relocations", value))
+        {
+            spec.relocation_count_ = static_cast<std::uint32_t>(value);
+        }
+        else if (option_value(argv[i], "dwarf-units", value))
+        {
+            spec.dwarf_unit_count_ = static_cast<std::uint32_t>(value);
+        }
+        else if (option_value(argv[i], "line-rows", value))
+        {
+            spec.line_rows_per_unit_ = static_cast<std::uint32_t>(value);
+        }
+        else if (option_value(argv[i], "functions", value))
+        {
+            spec.functions_per_unit_ = static_cast<std::uint32_t>(value);
+        }
+        else if (option_value(argv[i], "dwarf-version", value))
+        {
+            spec.dwarf_version_ = static_cast<std::uint16_t>(value);
+        }
+        else if (option_value(argv[i], "debug-names", value))
+        {
+            spec.dwarf_names_ = static_cast<std::uint32_t>(value);
+        }
+        else if (option_value(argv[i], "seed", value))
+        {
+            spec.seed_ = value;
+        }
+        else if (std::strcmp(argv[i], "--dwarf64") == 0)
+        {
+            spec.dwarf64_ = true;
+        }
+        else if (std::strcmp(argv[i], "--no-aranges") == 0)
+        {
+            spec.dwarf_aranges_ = false;
+        }
+        else if (std::strcmp(argv[i], "--gdb-index") == 0)
+        {
+            spec.gdb_index_ = true;
+        }
+        else if (std::strcmp(argv[i], "--extended-numbering") == 0)
+        {
+            spec.extended_numbering_ = true;
+        }
+        else if (std::strcmp(argv[i], "-o") == 0 && i + 1 < argc)
+        {
+            output = argv[++i];
+        }
+        else
+        {
+            usage(argv[0]);
+            return std::strcmp(argv[i], "--help") == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+    if (output.empty())
+    {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    try
+    {
+        write_elf(spec, output);
+    }
+    catch (std::exception const& ex)
+    {
+        std::cerr << argv[0] << ": " << ex.what() << "\n";
+        return EXIT_FAILURE;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,195 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "libedhel/elf.h"
+#include "libedhel/scanner.h"
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <string>
+#include <type_traits>
+
+
+namespace
+{
+    void
+    usage(char const* program)
+    {
+        std::cerr << "usage: " << program << " [options] DIRECTORY\n"
+                  << "\n"
+                  << "Find every ELF file under DIRECTORY, parse it, and summarize.\n"
+                  << "\n"
+                  << "options:\n"
+                  << "  --list                  list each ELF file as well as the summary\n";
+    }
+
+    std::string
+    type_name(EhType type)
+    {
+        switch (type)
+        {
+        case EhType::ET_NONE: return "ET_NONE";
+        case EhType::ET_REL:  return "ET_REL";
+        case EhType::ET_EXEC: return "ET_EXEC";
+        case EhType::ET_DYN:  return "ET_DYN";
+        case EhType::ET_CORE: return "ET_CORE";
+        }
+        return "type " + std::to_string(static_cast<std::underlying_type<EhType>::type>(type));
+    }
+
+    std::string
+    machine_name(EhMachine machine)
+    {
+        switch (machine)
+        {
+        case EhMachine::EM_NONE:    return "none";
+        case EhMachine::EM_SPARC:   return "sparc";
+        case EhMachine::EM_386:     return "i386";
+        case EhMachine::EM_MIPS:    return "mips";
+        case EhMachine::EM_PPC:     return "ppc";
+        case EhMachine::EM_PPC64:   return "ppc64";
+        case EhMachine::EM_X86_64:  return "x86_64";
+        case EhMachine::EM_AARCH64: return "aarch64";
+        case EhMachine::EM_RISCV:   return "riscv";
+        default:
+            break;
+        }
+        return "machine " + std::to_string(static_cast<std::underlying_type<EhMachine>::type>(machine));
+    }
+
+    std::string
+    class_name(ScanResult const& result)
+    {
+        return std::string(result.is_64bit_ ? "ELF64" : "ELF32") + (result.is_big_endian_ ? " BE" : " LE");
+    }
+
+    void
+    print_counts(std::string const& title, std::map<std::string, std::size_t> const& counts)
+    {
+        std::cout << title << ":\n";
+        for (auto const& count: counts)
+        {
+            std::cout << "  " << std::left << std::setw(20) << count.first
+                      << std::right << std::setw(10) << count.second << "\n";
+        }
+    }
+} // anonymous namespace
+
+
+int
+main(int argc, char* argv[])
+{
+    bool list = false;
+    std::string root;
+
+    for (int i = 1; i < argc; ++i)
+    {
+        if (std::strcmp(argv[i], "--list") == 0)
+        {
+            list = true;
+        }
+        else if (argv[i][0] != '-' && root.empty())
+        {
+            root = argv[i];
+        }
+        else
+        {
+            usage(argv[0]);
+            return std::strcmp(argv[i], "--help") == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+        }
+    }
+    if (root.empty())
+    {
+        usage(argv[0]);
+        return EXIT_FAILURE;
+    }
+
+    std::vector<ScanResult> results;
+    auto start = std::chrono::steady_clock::now();
+    try
+    {
+        results = scan_tree(root);
+    }
+    catch (std::exception const& ex)
+    {
+        std::cerr << argv[0] << ": " << ex.what() << "\n";
+        return EXIT_FAILURE;
+    }
+    std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    std::size_t not_elf_count = 0;
+    std::size_t unreadable_count = 0;
+    std::size_t failed_count = 0;
+    std::size_t validated_count = 0;
+    std::uint64_t elf_bytes = 0;
+    std::map<std::string, std::size_t> classes;
+    std::map<std::string, std::size_t> types;
+    std::map<std::string, std::size_t> machines;
+    for (auto const& result: results)
+    {
+        switch (result.status_)
+        {
+        case ScanResult::Status::NotElf:
+            ++not_elf_count;
+            break;
+        case ScanResult::Status::Unreadable:
+            ++unreadable_count;
+            std::cerr << result.path_ << ": " << result.error_ << "\n";
+            break;
+        case ScanResult::Status::Failed:
+            ++failed_count;
+            std::cerr << result.path_ << ": " << result.error_ << "\n";
+            break;
+        case ScanResult::Status::Parsed:
+            elf_bytes += result.size_;
+            validated_count += result.validated_ ? 1 : 0;
+            ++classes[class_name(result)];
+            ++types[type_name(result.type_)];
+            ++machines[machine_name(result.machine_)];
+            if (list)
+            {
+                std::cout << std::left << std::setw(9) << class_name(result)
+                          << std::setw(9) << type_name(result.type_)
+                          << std::setw(9) << machine_name(result.machine_) << std::right
+                          << std::setw(6) << result.section_count_ << " sections"
+                          << std::setw(6) << result.segment_count_ << " segments"
+                          << std::setw(9) << result.symbol_count_ << " symbols  "
+                          << result.path_ << "\n";
+            }
+            break;
+        }
+    }
+
+    std::size_t parsed_count = results.size() - not_elf_count - unreadable_count - failed_count;
+    std::cout << "files scanned:        " << results.size() << "\n"
+              << "ELF files parsed:     " << parsed_count << " (" << elf_bytes << " bytes)\n"
+              << "  fully validated:    " << validated_count << "\n"
+              << "ELF files failed:     " << failed_count << "\n"
+              << "not ELF files:        " << not_elf_count << "\n"
+              << "unreadable files:     " << unreadable_count << "\n"
+              << "elapsed:              " << std::fixed << std::setprecision(3) << elapsed.count() << " s\n";
+    print_counts("class", classes);
+    print_counts("type", types);
+    print_counts("machine", machines);
+    return failed_count == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
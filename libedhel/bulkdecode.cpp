@@ -0,0 +1,341 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "libedhel/bulkdecode.h"
+
+#include <algorithm>
+#include "libedhel/byteorder.h"
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+#include <numeric>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+# define EDHEL_BULK_SSSE3 1
+# include <immintrin.h>
+#elif defined(__aarch64__)
+# define EDHEL_BULK_NEON 1
+# include <arm_neon.h>
+#endif
+
+
+namespace
+{
+    /** The widths of the fields of each kind of table entry, in order */
+    template<typename Entry>
+        struct Fields;
+
+    template<> struct Fields<Elf32_Shdr> { static constexpr std::uint8_t widths[] = { 4, 4, 4, 4, 4, 4, 4, 4, 4, 4 }; };
+    template<> struct Fields<Elf64_Shdr> { static constexpr std::uint8_t widths[] = { 4, 4, 8, 8, 8, 8, 4, 4, 8, 8 }; };
+    template<> struct Fields<Elf32_Phdr> { static constexpr std::uint8_t widths[] = { 4, 4, 4, 4, 4, 4, 4, 4 }; };
+    template<> struct Fields<Elf64_Phdr> { static constexpr std::uint8_t widths[] = { 4, 4, 8, 8, 8, 8, 8, 8 }; };
+    template<> struct Fields<Elf32::Sym> { static constexpr std::uint8_t widths[] = { 4, 4, 4, 1, 1, 2 }; };
+    template<> struct Fields<Elf64::Sym> { static constexpr std::uint8_t widths[] = { 4, 1, 1, 2, 8, 8 }; };
+    template<> struct Fields<Elf32_Rel>  { static constexpr std::uint8_t widths[] = { 4, 4 }; };
+    template<> struct Fields<Elf64_Rel>  { static constexpr std::uint8_t widths[] = { 8, 8 }; };
+    template<> struct Fields<Elf32_Rela> { static constexpr std::uint8_t widths[] = { 4, 4, 4 }; };
+    template<> struct Fields<Elf64_Rela> { static constexpr std::uint8_t widths[] = { 8, 8, 8 }; };
+    template<> struct Fields<Elf32_Dyn>  { static constexpr std::uint8_t widths[] = { 4, 4 }; };
+    template<> struct Fields<Elf64_Dyn>  { static constexpr std::uint8_t widths[] = { 8, 8 }; };
+
+    template<typename Entry>
+        constexpr std::size_t
+        fields_size()
+        {
+            std::size_t size = 0;
+            for (auto width: Fields<Entry>::widths)
+            {
+                size += width;
+            }
+            return size;
+        }
+
+    /** Bytes shuffled by one vector instruction */
+    constexpr std::size_t chunk = 16;
+
+    /** Enough chunks for the longest repeating pattern (Elf64_Phdr, 7 chunks) */
+    constexpr std::size_t max_chunks = 7;
+
+    /**
+     * How to swap every field of a run of entries.
+     *
+     * The pattern of fields repeats every lcm(sizeof(Entry), chunk) bytes, so
+     * one permutation of that many bytes covers a table of any length.
+     */
+    struct SwapPlan
+    {
+        std::size_t  period_;
+        std::uint8_t permutation_[max_chunks * chunk];  /**< source of each byte within a period */
+        std::uint8_t masks_[max_chunks * chunk];        /**< the same, relative to each chunk */
+        bool         chunked_;                          /**< no field straddles two chunks */
+    };
+
+    SwapPlan
+    make_plan(std::uint8_t const* widths, std::size_t field_count, std::size_t entry_size)
+    {
+        SwapPlan plan{};
+        plan.period_ = std::lcm(entry_size, chunk);
+        plan.chunked_ = true;
+        for (std::size_t base = 0; base < plan.period_ && plan.chunked_; base += entry_size)
+        {
+            std::size_t offset = base;
+            for (std::size_t f = 0; f < field_count; ++f)
+            {
+                for (std::size_t b = 0; b < widths[f]; ++b)
+                {
+                    plan.permutation_[offset + b] = static_cast<std::uint8_t>(offset + widths[f] - 1 - b);
+                }
+                plan.chunked_ = plan.chunked_ && offset / chunk == (offset + widths[f] - 1) / chunk;
+                offset += widths[f];
+            }
+        }
+        for (std::size_t i = 0; i < plan.period_ && plan.chunked_; ++i)
+        {
+            plan.masks_[i] = static_cast<std::uint8_t>(plan.permutation_[i] - i / chunk * chunk);
+        }
+        return plan;
+    }
+
+    template<typename Entry>
+        SwapPlan const&
+        swap_plan()
+        {
+            static_assert(fields_size<Entry>() == sizeof(Entry), "field widths don't add up to the entry size");
+            static_assert(std::lcm(sizeof(Entry), chunk) <= max_chunks * chunk, "entry pattern too long for a plan");
+            static SwapPlan const plan = make_plan(Fields<Entry>::widths, std::size(Fields<Entry>::widths), sizeof(Entry));
+            return plan;
+        }
+
+    /**
+     * Swap the @p size bytes of whole entries at @p src into @p dst, which may
+     * be the same place, starting at byte @p from of the table.
+     */
+    void
+    swap_scalar(std::uint8_t const* src, std::uint8_t* dst, std::size_t from, std::size_t size,
+                SwapPlan const& plan)
+    {
+        std::uint8_t period[max_chunks * chunk];
+        for (std::size_t base = from - from % plan.period_; base < size; base += plan.period_)
+        {
+            std::size_t first = std::max(base, from);
+            std::size_t last = std::min(base + plan.period_, size);
+            std::memcpy(period + (first - base), src + first, last - first);
+            for (std::size_t i = first; i < last; ++i)
+            {
+                dst[i] = period[plan.permutation_[i - base]];
+            }
+        }
+    }
+
+#if defined(EDHEL_BULK_SSSE3)
+    __attribute__((target("ssse3")))
+    std::size_t
+    swap_ssse3(std::uint8_t const* src, std::uint8_t* dst, std::size_t size, SwapPlan const& plan)
+    {
+        std::size_t const mask_count = plan.period_ / chunk;
+        __m128i masks[max_chunks];
+        for (std::size_t k = 0; k < mask_count; ++k)
+        {
+            masks[k] = _mm_loadu_si128(reinterpret_cast<__m128i const*>(plan.masks_ + k * chunk));
+        }
+
+        std::size_t k = 0;
+        std::size_t offset = 0;
+        for (; offset + chunk <= size; offset += chunk)
+        {
+            __m128i v = _mm_loadu_si128(reinterpret_cast<__m128i const*>(src + offset));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + offset), _mm_shuffle_epi8(v, masks[k]));
+            k = k + 1 == mask_count ? 0 : k + 1;
+        }
+        return offset;
+    }
+
+    bool
+    have_ssse3()
+    {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("ssse3");
+    }
+#endif
+
+#if defined(EDHEL_BULK_NEON)
+    std::size_t
+    swap_neon(std::uint8_t const* src, std::uint8_t* dst, std::size_t size, SwapPlan const& plan)
+    {
+        std::size_t const mask_count = plan.period_ / chunk;
+        uint8x16_t masks[max_chunks];
+        for (std::size_t k = 0; k < mask_count; ++k)
+        {
+            masks[k] = vld1q_u8(plan.masks_ + k * chunk);
+        }
+
+        std::size_t k = 0;
+        std::size_t offset = 0;
+        for (; offset + chunk <= size; offset += chunk)
+        {
+            vst1q_u8(dst + offset, vqtbl1q_u8(vld1q_u8(src + offset), masks[k]));
+            k = k + 1 == mask_count ? 0 : k + 1;
+        }
+        return offset;
+    }
+#endif
+
+    /** Swap the fields of the @p size bytes of whole entries at @p src into @p dst */
+    void
+    swap_fields(std::uint8_t const* src, std::uint8_t* dst, std::size_t size, SwapPlan const& plan)
+    {
+        std::size_t done = 0;
+        if (plan.chunked_)
+        {
+#if defined(EDHEL_BULK_SSSE3)
+            static bool const ssse3 = have_ssse3();
+            if (ssse3)
+            {
+                done = swap_ssse3(src, dst, size, plan);
+            }
+#elif defined(EDHEL_BULK_NEON)
+            done = swap_neon(src, dst, size, plan);
+#endif
+        }
+        swap_scalar(src, dst, done, size, plan);
+    }
+} // anonymous namespace
+
+
+template<typename Entry>
+    void
+    decode_table(std::byte const* table, std::size_t count, std::size_t entsize, bool big_endian,
+                 Entry* entries)
+    {
+        auto const* src = reinterpret_cast<std::uint8_t const*>(table);
+        auto* dst = reinterpret_cast<std::uint8_t*>(entries);
+        std::size_t const size = count * sizeof(Entry);
+
+        // Entries that aren't packed together get packed first, then swapped
+        // where they lie.
+        if (entsize != sizeof(Entry))
+        {
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                std::memcpy(dst + i * sizeof(Entry), src + i * entsize, sizeof(Entry));
+            }
+            src = dst;
+        }
+
+        if (big_endian == host_is_big_endian)
+        {
+            if (src != dst)
+            {
+                std::memcpy(dst, src, size);
+            }
+            return;
+        }
+        swap_fields(src, dst, size, swap_plan<Entry>());
+    }
+
+
+std::vector<Elf64_Shdr>
+decode_section_headers(ElfImageView const& table, std::size_t entsize, bool is_64bit)
+{
+    if (is_64bit)
+    {
+        return decode_table<Elf64_Shdr>(table, entsize);
+    }
+
+    std::vector<Elf32_Shdr> const headers32 = decode_table<Elf32_Shdr>(table, entsize);
+    std::vector<Elf64_Shdr> headers(headers32.size());
+    for (std::size_t i = 0; i < headers32.size(); ++i)
+    {
+        Elf32_Shdr const& h = headers32[i];
+        headers[i] = Elf64_Shdr{h.sh_name, h.sh_type, h.sh_flags, h.sh_addr, h.sh_offset, h.sh_size,
+                                h.sh_link, h.sh_info, h.sh_addralign, h.sh_entsize};
+    }
+    return headers;
+}
+
+
+std::vector<Elf64_Phdr>
+decode_program_headers(ElfImageView const& table, std::size_t entsize, bool is_64bit)
+{
+    if (is_64bit)
+    {
+        return decode_table<Elf64_Phdr>(table, entsize);
+    }
+
+    std::vector<Elf32_Phdr> const headers32 = decode_table<Elf32_Phdr>(table, entsize);
+    std::vector<Elf64_Phdr> headers(headers32.size());
+    for (std::size_t i = 0; i < headers32.size(); ++i)
+    {
+        Elf32_Phdr const& h = headers32[i];
+        headers[i] = Elf64_Phdr{h.p_type, h.p_flags, h.p_offset, h.p_vaddr, h.p_paddr,
+                                h.p_filesz, h.p_memsz, h.p_align};
+    }
+    return headers;
+}
+
+
+void
+decode_symbols(std::byte const* table, std::size_t count, bool big_endian, bool is_64bit,
+               Elf64::Sym* symbols)
+{
+    if (is_64bit)
+    {
+        decode_table(table, count, sizeof(Elf64::Sym), big_endian, symbols);
+        return;
+    }
+
+    constexpr std::size_t block_size = 256;
+    Elf32::Sym block[block_size];
+    for (std::size_t first = 0; first < count; first += block_size)
+    {
+        std::size_t n = std::min(block_size, count - first);
+        decode_table(table + first * sizeof(Elf32::Sym), n, sizeof(Elf32::Sym), big_endian, block);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            Elf32::Sym const& s = block[i];
+            symbols[first + i] = Elf64::Sym{s.st_name, s.st_info, s.st_other, s.st_shndx, s.st_value, s.st_size};
+        }
+    }
+}
+
+
+char const*
+bulk_decode_method()
+{
+#if defined(EDHEL_BULK_SSSE3)
+    return have_ssse3() ? "ssse3" : "scalar";
+#elif defined(EDHEL_BULK_NEON)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
+
+
+template void decode_table(std::byte const*, std::size_t, std::size_t, bool, Elf32_Shdr*);
+template void decode_table(std::byte const*, std::size_t, std::size_t, bool, Elf64_Shdr*);
+template void decode_table(std::byte const*, std::size_t, std::size_t, bool, Elf32_Phdr*);
+template void decode_table(std::byte const*, std::size_t, std::size_t, bool, Elf64_Phdr*);
+template void decode_table(std::byte const*, std::size_t, std::size_t, bool, Elf32::Sym*);
+template void decode_table(std::byte const*, std::size_t, std::size_t, bool, Elf64::Sym*);
+template void decode_table(std::byte const*, std::size_t, std::size_t, bool, Elf32_Rel*);
+template void decode_table(std::byte const*, std::size_t, std::size_t, bool, Elf64_Rel*);
+template void decode_table(std::byte const*, std::size_t, std::size_t, bool, Elf32_Rela*);
+template void decode_table(std::byte const*, std::size_t, std::size_t, bool, Elf64_Rela*);
+template void decode_table(std::byte const*, std::size_t, std::size_t, bool, Elf32_Dyn*);
+template void decode_table(std::byte const*, std::size_t, std::size_t, bool, Elf64_Dyn*);
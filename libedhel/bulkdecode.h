@@ -0,0 +1,116 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef EDHELIND_BULKDECODE_H
+#define EDHELIND_BULKDECODE_H
+
+#include <cstddef>
+#include "libedhel/elf.h"
+#include "libedhel/elfimage.h"
+#include <vector>
+
+
+/**
+ * Decode a table of ELF structures into host byte order a whole table at a
+ * time.
+ *
+ * Reading structures one field at a time through ElfImageView means a byte
+ * swap per field for targets of the other byte order.  These decoders copy
+ * the table and swap every field of many entries at once with vector byte
+ * shuffles where the CPU has them (SSSE3 or NEON), so tables from big-endian
+ * targets decode about as fast as little-endian ones.
+ *
+ * @tparam Entry one of Elf32_Shdr, Elf64_Shdr, Elf32_Phdr, Elf64_Phdr,
+ *               Elf32::Sym, Elf64::Sym, Elf32_Rel, Elf64_Rel, Elf32_Rela,
+ *               Elf64_Rela, Elf32_Dyn or Elf64_Dyn
+ *
+ * @param[in]  table      the first entry of the table
+ * @param[in]  count      the number of entries to decode
+ * @param[in]  entsize    the distance between entries, at least sizeof(Entry)
+ * @param[in]  big_endian whether the table is in big-endian byte order
+ * @param[out] entries    room for @p count entries in host byte order
+ */
+template<typename Entry>
+    void
+    decode_table(std::byte const* table, std::size_t count, std::size_t entsize, bool big_endian,
+                 Entry* entries);
+
+
+/**
+ * Decode all the whole entries of the table @p table, which are @p entsize
+ * bytes apart, into host byte order.
+ */
+template<typename Entry>
+    std::vector<Entry>
+    decode_table(ElfImageView const& table, std::size_t entsize)
+    {
+        std::size_t count = entsize < sizeof(Entry) ? 0 : table.size() / entsize;
+        std::vector<Entry> entries(count);
+        if (count != 0)
+        {
+            decode_table(table.get_bytes(0), count, entsize, table.isBigEndian(), entries.data());
+        }
+        return entries;
+    }
+
+
+/**
+ * Decode the section header table @p table of a 32-bit or (if @p is_64bit) a
+ * 64-bit file.  32-bit headers are widened to the 64-bit layout, so the rest
+ * of the parser only has the one to deal with.
+ */
+std::vector<Elf64_Shdr>
+decode_section_headers(ElfImageView const& table, std::size_t entsize, bool is_64bit);
+
+
+/**
+ * Decode the program header table @p table of a 32-bit or (if @p is_64bit) a
+ * 64-bit file, widening 32-bit headers to the 64-bit layout.
+ */
+std::vector<Elf64_Phdr>
+decode_program_headers(ElfImageView const& table, std::size_t entsize, bool is_64bit);
+
+
+/**
+ * Decode @p count packed symbols at @p table of a 32-bit or (if @p is_64bit) a
+ * 64-bit file into @p symbols, widening 32-bit symbols to the 64-bit layout.
+ */
+void
+decode_symbols(std::byte const* table, std::size_t count, bool big_endian, bool is_64bit,
+               Elf64::Sym* symbols);
+
+
+/** How the bulk decoders swap bytes on this machine: "ssse3", "neon" or "scalar" */
+char const*
+bulk_decode_method();
+
+
+extern template void decode_table(std::byte const*, std::size_t, std::size_t, bool, Elf32_Shdr*);
+extern template void decode_table(std::byte const*, std::size_t, std::size_t, bool, Elf64_Shdr*);
+extern template void decode_table(std::byte const*, std::size_t, std::size_t, bool, Elf32_Phdr*);
+extern template void decode_table(std::byte const*, std::size_t, std::size_t, bool, Elf64_Phdr*);
+extern template void decode_table(std::byte const*, std::size_t, std::size_t, bool, Elf32::Sym*);
+extern template void decode_table(std::byte const*, std::size_t, std::size_t, bool, Elf64::Sym*);
+extern template void decode_table(std::byte const*, std::size_t, std::size_t, bool, Elf32_Rel*);
+extern template void decode_table(std::byte const*, std::size_t, std::size_t, bool, Elf64_Rel*);
+extern template void decode_table(std::byte const*, std::size_t, std::size_t, bool, Elf32_Rela*);
+extern template void decode_table(std::byte const*, std::size_t, std::size_t, bool, Elf64_Rela*);
+extern template void decode_table(std::byte const*, std::size_t, std::size_t, bool, Elf32_Dyn*);
+extern template void decode_table(std::byte const*, std::size_t, std::size_t, bool, Elf64_Dyn*);
+
+#endif /* EDHELIND_BULKDECODE_H */
@@ -0,0 +1,100 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef EDHELIND_BYTEORDER_H
+#define EDHELIND_BYTEORDER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+
+#ifdef _MSC_VER
+# include <stdlib.h>
+#endif
+
+
+/** Whether the host stores integers most significant byte first */
+#if defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__)
+constexpr inline bool host_is_big_endian = __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__;
+#else
+constexpr inline bool host_is_big_endian = false;
+#endif
+
+
+/**
+ * @defgroup byteswap Reverse the bytes of an unsigned integer
+ * @{
+ */
+inline std::uint8_t
+byteswap(std::uint8_t value)
+{
+    return value;
+}
+
+inline std::uint16_t
+byteswap(std::uint16_t value)
+{
+#if defined(__GNUC__)
+    return __builtin_bswap16(value);
+#elif defined(_MSC_VER)
+    return _byteswap_ushort(value);
+#else
+    return static_cast<std::uint16_t>((value >> 8) | (value << 8));
+#endif
+}
+
+inline std::uint32_t
+byteswap(std::uint32_t value)
+{
+#if defined(__GNUC__)
+    return __builtin_bswap32(value);
+#elif defined(_MSC_VER)
+    return _byteswap_ulong(value);
+#else
+    return (std::uint32_t(byteswap(std::uint16_t(value))) << 16) | byteswap(std::uint16_t(value >> 16));
+#endif
+}
+
+inline std::uint64_t
+byteswap(std::uint64_t value)
+{
+#if defined(__GNUC__)
+    return __builtin_bswap64(value);
+#elif defined(_MSC_VER)
+    return _byteswap_uint64(value);
+#else
+    return (std::uint64_t(byteswap(std::uint32_t(value))) << 32) | byteswap(std::uint32_t(value >> 32));
+#endif
+}
+/** @} */
+
+
+/**
+ * Read the unsigned integer at @p bytes, stored in big-endian byte order if
+ * @p big_endian or little-endian otherwise, as a host-order integer.
+ */
+template<typename UInt>
+    inline UInt
+    load_uint(std::byte const* bytes, bool big_endian)
+    {
+        UInt value;
+        std::memcpy(&value, bytes, sizeof(UInt));
+        return big_endian == host_is_big_endian ? value : byteswap(value);
+    }
+
+#endif /* EDHELIND_BYTEORDER_H */
@@ -0,0 +1,84 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "libedhel/detailable.h"
+
+#include <ostream>
+#include <sstream>
+
+
+std::size_t Detailable::
+lineCount() const
+{
+    std::ostringstream ostr;
+    this->printTo(ostr);
+    return countLines(ostr.str());
+}
+
+
+std::ostream& Detailable::
+printLinesTo(std::ostream& ostr, std::size_t first, std::size_t count) const
+{
+    std::ostringstream text;
+    this->printTo(text);
+    return printLinesOf(ostr, text.str(), first, count);
+}
+
+
+std::size_t Detailable::
+countLines(std::string const& text)
+{
+    std::size_t lines = 0;
+    for (char c: text)
+    {
+        if (c == '\n')
+        {
+            ++lines;
+        }
+    }
+    if (!text.empty() && text.back() != '\n')
+    {
+        ++lines;
+    }
+    return lines;
+}
+
+
+std::ostream& Detailable::
+printLinesOf(std::ostream& ostr, std::string const& text, std::size_t first, std::size_t count)
+{
+    std::size_t begin = 0;
+    for (std::size_t line = 0; line < first && begin < text.size(); ++line)
+    {
+        std::size_t end = text.find('\n', begin);
+        begin = (end == std::string::npos) ? text.size() : end + 1;
+    }
+
+    for (std::size_t line = 0; line < count && begin < text.size(); ++line)
+    {
+        std::size_t end = text.find('\n', begin);
+        if (end == std::string::npos)
+        {
+            end = text.size();
+        }
+        ostr.write(text.data() + begin, end - begin);
+        ostr << '\n';
+        begin = end + 1;
+    }
+    return ostr;
+}
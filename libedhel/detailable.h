@@ -19,21 +19,55 @@
 #ifndef EDHELIND_DETAILABLE_H
 #define EDHELIND_DETAILABLE_H
 
+#include <cstddef>
 #include <iosfwd>
+#include <string>
 
 
 /**
  * Mix-in class to make something get its details printed.
+ *
+ * Details can be printed all at once using operator<<, or a few lines at a
+ * time using lineCount() and printLinesTo() so that something displaying a
+ * very large detail (say, a string table with millions of entries) only has to
+ * format the part that is actually on display.  The default implementation of
+ * the line-oriented interface just formats everything and picks out the
+ * requested lines, so anything that can have large details should override
+ * it.
  */
 class Detailable
 {
 public:
+    virtual ~Detailable() = default;
+
     friend std::ostream&
     operator<<(std::ostream& ostr, Detailable const& detailable)
     {
         return detailable.printTo(ostr);
     }
 
+    /** The number of lines printed by operator<< */
+    virtual std::size_t
+    lineCount() const;
+
+    /**
+     * Print @p count lines starting at line @p first.
+     *
+     * Each line printed ends with a newline.  Lines past the end are silently
+     * ignored.
+     */
+    virtual std::ostream&
+    printLinesTo(std::ostream& ostr, std::size_t first, std::size_t count) const;
+
+protected:
+    /** Count the lines in @p text */
+    static std::size_t
+    countLines(std::string const& text);
+
+    /** Print @p count lines of @p text starting at line @p first */
+    static std::ostream&
+    printLinesOf(std::ostream& ostr, std::string const& text, std::size_t first, std::size_t count);
+
 private:
     virtual std::ostream&
     printTo(std::ostream&) const = 0;
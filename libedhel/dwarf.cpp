@@ -0,0 +1,308 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "libedhel/dwarf.h"
+
+#include <cstring>
+#include "libedhel/elf.h"
+#include "libedhel/elffile.h"
+#include "libedhel/elfheader.h"
+#include "libedhel/section.h"
+#include <string>
+#include <utility>
+
+
+DwarfSection
+find_dwarf_section(ElfFile const& elf_file, std::string_view name)
+{
+    DwarfSection found;
+    SectionTable const& sections = elf_file.section_table();
+    for (std::uint32_t i = 1; i < sections.section_count(); ++i)
+    {
+        Section const& section = sections.section(i);
+        if (section.type() == SType::SHT_NOBITS || section.name_string() != name)
+        {
+            continue;
+        }
+        ElfImageView contents = elf_file.view(section.offset(), section.size());
+        found.bytes_ = contents.get_bytes(0);
+        found.size_ = contents.size();
+        found.offset_ = section.offset();
+        found.compressed_ = (section.flags() & Elf::SHF_COMPRESSED) != 0;
+        break;
+    }
+    return found;
+}
+
+
+DwarfSections
+find_dwarf_sections(ElfFile const& elf_file)
+{
+    DwarfSections found;
+    std::pair<std::string_view, DwarfSection*> const wanted[] = {
+        { ".debug_info",        &found.info_ },
+        { ".debug_abbrev",      &found.abbrev_ },
+        { ".debug_str",         &found.str_ },
+        { ".debug_str_offsets", &found.str_offsets_ },
+        { ".debug_line",        &found.line_ },
+        { ".debug_line_str",    &found.line_str_ },
+        { ".debug_addr",        &found.addr_ },
+        { ".debug_ranges",      &found.ranges_ },
+        { ".debug_rnglists",    &found.rnglists_ },
+        { ".debug_aranges",     &found.aranges_ },
+        { ".debug_names",       &found.names_ },
+        { ".gdb_index",         &found.gdb_index_ },
+    };
+    SectionTable const& sections = elf_file.section_table();
+    for (std::uint32_t i = 1; i < sections.section_count(); ++i)
+    {
+        Section const& section = sections.section(i);
+        if (section.type() == SType::SHT_NOBITS)
+        {
+            continue;
+        }
+        std::string name = section.name_string();
+        for (auto const& [wanted_name, wanted_section]: wanted)
+        {
+            if (name == wanted_name && wanted_section->bytes_ == nullptr)
+            {
+                ElfImageView contents = elf_file.view(section.offset(), section.size());
+                wanted_section->bytes_ = contents.get_bytes(0);
+                wanted_section->size_ = contents.size();
+                wanted_section->offset_ = section.offset();
+                wanted_section->compressed_ = (section.flags() & Elf::SHF_COMPRESSED) != 0;
+            }
+        }
+    }
+    found.big_endian_ = !elf_file.elf_header().isLE();
+    found.linked_ = elf_file.elf_header().type() != EhType::ET_REL;
+    found.address_size_ = elf_file.is_64bit() ? 8 : 4;
+    return found;
+}
+
+
+int
+form_size(dw_form_t form, DwarfFormat const& format)
+{
+    switch (form)
+    {
+    case DW_FORM_flag_present:
+    case DW_FORM_implicit_const:
+        return 0;
+    case DW_FORM_data1:
+    case DW_FORM_ref1:
+    case DW_FORM_flag:
+    case DW_FORM_strx1:
+    case DW_FORM_addrx1:
+        return 1;
+    case DW_FORM_data2:
+    case DW_FORM_ref2:
+    case DW_FORM_strx2:
+    case DW_FORM_addrx2:
+        return 2;
+    case DW_FORM_strx3:
+    case DW_FORM_addrx3:
+        return 3;
+    case DW_FORM_data4:
+    case DW_FORM_ref4:
+    case DW_FORM_ref_sup4:
+    case DW_FORM_strx4:
+    case DW_FORM_addrx4:
+        return 4;
+    case DW_FORM_data8:
+    case DW_FORM_ref8:
+    case DW_FORM_ref_sig8:
+    case DW_FORM_ref_sup8:
+        return 8;
+    case DW_FORM_data16:
+        return 16;
+    case DW_FORM_addr:
+        return format.address_size_;
+    case DW_FORM_ref_addr:
+        return format.version_ <= 2 ? format.address_size_ : format.offset_size_;
+    case DW_FORM_strp:
+    case DW_FORM_line_strp:
+    case DW_FORM_sec_offset:
+    case DW_FORM_strp_sup:
+    case DW_FORM_GNU_ref_alt:
+    case DW_FORM_GNU_strp_alt:
+        return format.offset_size_;
+    default:
+        return -1;
+    }
+}
+
+
+std::string_view DwarfReader::
+cstring()
+{
+    auto const* start = reinterpret_cast<char const*>(cursor_);
+    void const* nul = std::memchr(start, '\0', remaining());
+    if (nul == nullptr)
+    {
+        fail();
+        return {};
+    }
+    std::size_t length = static_cast<char const*>(nul) - start;
+    cursor_ += length + 1;
+    return std::string_view(start, length);
+}
+
+
+void DwarfReader::
+skip_form(dw_form_t form, DwarfFormat const& format)
+{
+    if (form == DW_FORM_indirect && !indirect_form(form))
+    {
+        return;
+    }
+
+    int size = form_size(form, format);
+    if (size >= 0)
+    {
+        skip(size);
+        return;
+    }
+    switch (form)
+    {
+    case DW_FORM_sdata:
+    case DW_FORM_udata:
+    case DW_FORM_ref_udata:
+    case DW_FORM_strx:
+    case DW_FORM_addrx:
+    case DW_FORM_loclistx:
+    case DW_FORM_rnglistx:
+    case DW_FORM_GNU_addr_index:
+    case DW_FORM_GNU_str_index:
+        uleb128();
+        break;
+    case DW_FORM_string:
+        cstring();
+        break;
+    case DW_FORM_block1:
+        skip(u8());
+        break;
+    case DW_FORM_block2:
+        skip(u16());
+        break;
+    case DW_FORM_block4:
+        skip(u32());
+        break;
+    case DW_FORM_block:
+    case DW_FORM_exprloc:
+        skip(uleb128());
+        break;
+    default:
+        // There's no knowing how big a value of an unknown form is.
+        fail();
+        break;
+    }
+}
+
+
+bool DwarfReader::
+indirect_form(dw_form_t& form)
+{
+    form = static_cast<dw_form_t>(uleb128());
+    if (form == DW_FORM_indirect)
+    {
+        fail();
+        return false;
+    }
+    return true;
+}
+
+
+std::uint64_t DwarfReader::
+form_value(dw_form_t form, DwarfFormat const& format)
+{
+    if (form == DW_FORM_indirect && !indirect_form(form))
+    {
+        return 0;
+    }
+
+    switch (form)
+    {
+    case DW_FORM_flag_present:
+        return 1;
+    case DW_FORM_data1:
+    case DW_FORM_ref1:
+    case DW_FORM_flag:
+    case DW_FORM_strx1:
+    case DW_FORM_addrx1:
+        return u8();
+    case DW_FORM_data2:
+    case DW_FORM_ref2:
+    case DW_FORM_strx2:
+    case DW_FORM_addrx2:
+        return u16();
+    case DW_FORM_strx3:
+    case DW_FORM_addrx3:
+        return u24();
+    case DW_FORM_data4:
+    case DW_FORM_ref4:
+    case DW_FORM_ref_sup4:
+    case DW_FORM_strx4:
+    case DW_FORM_addrx4:
+        return u32();
+    case DW_FORM_data8:
+    case DW_FORM_ref8:
+    case DW_FORM_ref_sig8:
+    case DW_FORM_ref_sup8:
+        return u64();
+    case DW_FORM_addr:
+        return address(format);
+    case DW_FORM_ref_addr:
+        return format.version_ <= 2 ? address(format) : offset(format);
+    case DW_FORM_strp:
+    case DW_FORM_line_strp:
+    case DW_FORM_sec_offset:
+    case DW_FORM_strp_sup:
+    case DW_FORM_GNU_ref_alt:
+    case DW_FORM_GNU_strp_alt:
+        return offset(format);
+    case DW_FORM_sdata:
+        return static_cast<std::uint64_t>(sleb128());
+    case DW_FORM_udata:
+    case DW_FORM_ref_udata:
+    case DW_FORM_strx:
+    case DW_FORM_addrx:
+    case DW_FORM_loclistx:
+    case DW_FORM_rnglistx:
+    case DW_FORM_GNU_addr_index:
+    case DW_FORM_GNU_str_index:
+        return uleb128();
+    default:
+        skip_form(form, format);
+        return 0;
+    }
+}
+
+
+std::string_view
+dwarf_string(DwarfSection const& strings, std::uint64_t offset)
+{
+    if (!strings || offset >= strings.size_)
+    {
+        return {};
+    }
+    auto const* start = reinterpret_cast<char const*>(strings.bytes_ + offset);
+    std::size_t maxlen = strings.size_ - offset;
+    void const* nul = std::memchr(start, '\0', maxlen);
+    return std::string_view(start, nul ? static_cast<char const*>(nul) - start : maxlen);
+}
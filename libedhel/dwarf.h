@@ -0,0 +1,580 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef EDHELIND_DWARF_H
+#define EDHELIND_DWARF_H
+
+#include <cstddef>
+#include <cstdint>
+#include "libedhel/byteorder.h"
+#include "libedhel/leb128.h"
+#include <string_view>
+
+class ElfFile;
+
+
+/**
+ * @defgroup dw_form Attribute forms
+ * How an attribute value is encoded in .debug_info, and in the entries of a
+ * DWARF 5 line program header.
+ * @{
+ */
+using dw_form_t = std::uint16_t;
+
+constexpr inline dw_form_t DW_FORM_addr           = 0x01;
+constexpr inline dw_form_t DW_FORM_block2         = 0x03;
+constexpr inline dw_form_t DW_FORM_block4         = 0x04;
+constexpr inline dw_form_t DW_FORM_data2          = 0x05;
+constexpr inline dw_form_t DW_FORM_data4          = 0x06;
+constexpr inline dw_form_t DW_FORM_data8          = 0x07;
+constexpr inline dw_form_t DW_FORM_string         = 0x08;
+constexpr inline dw_form_t DW_FORM_block          = 0x09;
+constexpr inline dw_form_t DW_FORM_block1         = 0x0a;
+constexpr inline dw_form_t DW_FORM_data1          = 0x0b;
+constexpr inline dw_form_t DW_FORM_flag           = 0x0c;
+constexpr inline dw_form_t DW_FORM_sdata          = 0x0d;
+constexpr inline dw_form_t DW_FORM_strp           = 0x0e;
+constexpr inline dw_form_t DW_FORM_udata          = 0x0f;
+constexpr inline dw_form_t DW_FORM_ref_addr       = 0x10;
+constexpr inline dw_form_t DW_FORM_ref1           = 0x11;
+constexpr inline dw_form_t DW_FORM_ref2           = 0x12;
+constexpr inline dw_form_t DW_FORM_ref4           = 0x13;
+constexpr inline dw_form_t DW_FORM_ref8           = 0x14;
+constexpr inline dw_form_t DW_FORM_ref_udata      = 0x15;
+constexpr inline dw_form_t DW_FORM_indirect       = 0x16;
+constexpr inline dw_form_t DW_FORM_sec_offset     = 0x17;
+constexpr inline dw_form_t DW_FORM_exprloc        = 0x18;
+constexpr inline dw_form_t DW_FORM_flag_present   = 0x19;
+constexpr inline dw_form_t DW_FORM_strx           = 0x1a;
+constexpr inline dw_form_t DW_FORM_addrx          = 0x1b;
+constexpr inline dw_form_t DW_FORM_ref_sup4       = 0x1c;
+constexpr inline dw_form_t DW_FORM_strp_sup       = 0x1d;
+constexpr inline dw_form_t DW_FORM_data16         = 0x1e;
+constexpr inline dw_form_t DW_FORM_line_strp      = 0x1f;
+constexpr inline dw_form_t DW_FORM_ref_sig8       = 0x20;
+constexpr inline dw_form_t DW_FORM_implicit_const = 0x21;
+constexpr inline dw_form_t DW_FORM_loclistx       = 0x22;
+constexpr inline dw_form_t DW_FORM_rnglistx       = 0x23;
+constexpr inline dw_form_t DW_FORM_ref_sup8       = 0x24;
+constexpr inline dw_form_t DW_FORM_strx1          = 0x25;
+constexpr inline dw_form_t DW_FORM_strx2          = 0x26;
+constexpr inline dw_form_t DW_FORM_strx3          = 0x27;
+constexpr inline dw_form_t DW_FORM_strx4          = 0x28;
+constexpr inline dw_form_t DW_FORM_addrx1         = 0x29;
+constexpr inline dw_form_t DW_FORM_addrx2         = 0x2a;
+constexpr inline dw_form_t DW_FORM_addrx3         = 0x2b;
+constexpr inline dw_form_t DW_FORM_addrx4         = 0x2c;
+constexpr inline dw_form_t DW_FORM_GNU_addr_index = 0x1f01;
+constexpr inline dw_form_t DW_FORM_GNU_str_index  = 0x1f02;
+constexpr inline dw_form_t DW_FORM_GNU_ref_alt    = 0x1f20;
+constexpr inline dw_form_t DW_FORM_GNU_strp_alt   = 0x1f21;
+
+/** @} */
+
+/**
+ * @defgroup dw_tag Debugging information entry tags
+ * The ones libedhel looks for.
+ * @{
+ */
+using dw_tag_t = std::uint16_t;
+
+constexpr inline dw_tag_t DW_TAG_entry_point        = 0x03;
+constexpr inline dw_tag_t DW_TAG_formal_parameter   = 0x05;
+constexpr inline dw_tag_t DW_TAG_lexical_block      = 0x0b;
+constexpr inline dw_tag_t DW_TAG_compile_unit       = 0x11;
+constexpr inline dw_tag_t DW_TAG_structure_type     = 0x13;
+constexpr inline dw_tag_t DW_TAG_inlined_subroutine = 0x1d;
+constexpr inline dw_tag_t DW_TAG_base_type          = 0x24;
+constexpr inline dw_tag_t DW_TAG_subprogram         = 0x2e;
+constexpr inline dw_tag_t DW_TAG_variable           = 0x34;
+constexpr inline dw_tag_t DW_TAG_partial_unit       = 0x3c;
+constexpr inline dw_tag_t DW_TAG_skeleton_unit      = 0x4a;
+
+/** @} */
+
+/**
+ * @defgroup dw_at Attribute names
+ * The ones libedhel looks for.
+ * @{
+ */
+using dw_at_t = std::uint16_t;
+
+constexpr inline dw_at_t DW_AT_sibling           = 0x01;
+constexpr inline dw_at_t DW_AT_location          = 0x02;
+constexpr inline dw_at_t DW_AT_name              = 0x03;
+constexpr inline dw_at_t DW_AT_byte_size         = 0x0b;
+constexpr inline dw_at_t DW_AT_stmt_list         = 0x10;
+constexpr inline dw_at_t DW_AT_low_pc            = 0x11;
+constexpr inline dw_at_t DW_AT_high_pc           = 0x12;
+constexpr inline dw_at_t DW_AT_comp_dir          = 0x1b;
+constexpr inline dw_at_t DW_AT_const_value       = 0x1c;
+constexpr inline dw_at_t DW_AT_inline            = 0x20;
+constexpr inline dw_at_t DW_AT_abstract_origin   = 0x31;
+constexpr inline dw_at_t DW_AT_declaration       = 0x3c;
+constexpr inline dw_at_t DW_AT_encoding          = 0x3e;
+constexpr inline dw_at_t DW_AT_external          = 0x3f;
+constexpr inline dw_at_t DW_AT_specification     = 0x47;
+constexpr inline dw_at_t DW_AT_type              = 0x49;
+constexpr inline dw_at_t DW_AT_ranges            = 0x55;
+constexpr inline dw_at_t DW_AT_call_column       = 0x57;
+constexpr inline dw_at_t DW_AT_call_file         = 0x58;
+constexpr inline dw_at_t DW_AT_call_line         = 0x59;
+constexpr inline dw_at_t DW_AT_linkage_name      = 0x6e;
+constexpr inline dw_at_t DW_AT_str_offsets_base  = 0x72;
+constexpr inline dw_at_t DW_AT_addr_base         = 0x73;
+constexpr inline dw_at_t DW_AT_rnglists_base     = 0x74;
+constexpr inline dw_at_t DW_AT_MIPS_linkage_name = 0x2007;
+constexpr inline dw_at_t DW_AT_GNU_ranges_base   = 0x2132;
+constexpr inline dw_at_t DW_AT_GNU_addr_base     = 0x2133;
+
+/** @} */
+
+/**
+ * @defgroup dw_ut Unit header types (DWARF 5)
+ * @{
+ */
+constexpr inline std::uint8_t DW_UT_compile       = 0x01;
+constexpr inline std::uint8_t DW_UT_type          = 0x02;
+constexpr inline std::uint8_t DW_UT_partial       = 0x03;
+constexpr inline std::uint8_t DW_UT_skeleton      = 0x04;
+constexpr inline std::uint8_t DW_UT_split_compile = 0x05;
+constexpr inline std::uint8_t DW_UT_split_type    = 0x06;
+
+/** @} */
+
+/**
+ * @defgroup dw_rle Range list entry kinds (DWARF 5)
+ * @{
+ */
+constexpr inline std::uint8_t DW_RLE_end_of_list   = 0x00;
+constexpr inline std::uint8_t DW_RLE_base_addressx = 0x01;
+constexpr inline std::uint8_t DW_RLE_startx_endx   = 0x02;
+constexpr inline std::uint8_t DW_RLE_startx_length = 0x03;
+constexpr inline std::uint8_t DW_RLE_offset_pair   = 0x04;
+constexpr inline std::uint8_t DW_RLE_base_address  = 0x05;
+constexpr inline std::uint8_t DW_RLE_start_end     = 0x06;
+constexpr inline std::uint8_t DW_RLE_start_length  = 0x07;
+
+/** @} */
+
+/**
+ * @defgroup dw_idx Name index attributes (DWARF 5 .debug_names)
+ * @{
+ */
+using dw_idx_t = std::uint16_t;
+
+constexpr inline dw_idx_t DW_IDX_compile_unit = 0x1;
+constexpr inline dw_idx_t DW_IDX_type_unit    = 0x2;
+constexpr inline dw_idx_t DW_IDX_die_offset   = 0x3;
+constexpr inline dw_idx_t DW_IDX_parent       = 0x4;
+constexpr inline dw_idx_t DW_IDX_type_hash    = 0x5;
+
+/** @} */
+
+/**
+ * @defgroup dw_lns Line number program standard opcodes
+ * @{
+ */
+constexpr inline std::uint8_t DW_LNS_copy               = 0x01;
+constexpr inline std::uint8_t DW_LNS_advance_pc         = 0x02;
+constexpr inline std::uint8_t DW_LNS_advance_line       = 0x03;
+constexpr inline std::uint8_t DW_LNS_set_file           = 0x04;
+constexpr inline std::uint8_t DW_LNS_set_column         = 0x05;
+constexpr inline std::uint8_t DW_LNS_negate_stmt        = 0x06;
+constexpr inline std::uint8_t DW_LNS_set_basic_block    = 0x07;
+constexpr inline std::uint8_t DW_LNS_const_add_pc       = 0x08;
+constexpr inline std::uint8_t DW_LNS_fixed_advance_pc   = 0x09;
+constexpr inline std::uint8_t DW_LNS_set_prologue_end   = 0x0a;
+constexpr inline std::uint8_t DW_LNS_set_epilogue_begin = 0x0b;
+constexpr inline std::uint8_t DW_LNS_set_isa            = 0x0c;
+
+/** @} */
+
+/**
+ * @defgroup dw_lne Line number program extended opcodes
+ * @{
+ */
+constexpr inline std::uint8_t DW_LNE_end_sequence      = 0x01;
+constexpr inline std::uint8_t DW_LNE_set_address       = 0x02;
+constexpr inline std::uint8_t DW_LNE_define_file       = 0x03;  /**< DWARF 2 to 4 only */
+constexpr inline std::uint8_t DW_LNE_set_discriminator = 0x04;
+
+/** @} */
+
+/**
+ * @defgroup dw_lnct Line number header entry content types (DWARF 5)
+ * @{
+ */
+constexpr inline std::uint16_t DW_LNCT_path            = 0x1;
+constexpr inline std::uint16_t DW_LNCT_directory_index = 0x2;
+constexpr inline std::uint16_t DW_LNCT_timestamp       = 0x3;
+constexpr inline std::uint16_t DW_LNCT_size            = 0x4;
+constexpr inline std::uint16_t DW_LNCT_MD5             = 0x5;
+
+/** @} */
+
+
+/**
+ * The contents of one DWARF section of an ELF file.
+ */
+struct DwarfSection
+{
+    std::byte const* bytes_ = nullptr;
+    std::size_t      size_ = 0;
+    std::uint64_t    offset_ = 0;       /**< file offset, for reporting errors */
+    bool             compressed_ = false;
+
+    /** Whether there is anything to read */
+    explicit operator bool() const
+    { return size_ != 0 && !compressed_; }
+};
+
+
+/**
+ * Find the section called @p name in @p elf_file.
+ *
+ * A missing section, or one with no contents in the file (SHT_NOBITS), comes
+ * back empty.  A compressed section (SHF_COMPRESSED) comes back marked as
+ * such, since it can't be read where it lies.
+ */
+DwarfSection
+find_dwarf_section(ElfFile const& elf_file, std::string_view name);
+
+
+/**
+ * The DWARF sections of an ELF file, and what it takes to read them.
+ */
+struct DwarfSections
+{
+    DwarfSection info_;
+    DwarfSection abbrev_;
+    DwarfSection str_;
+    DwarfSection str_offsets_;
+    DwarfSection line_;
+    DwarfSection line_str_;
+    DwarfSection addr_;
+    DwarfSection ranges_;
+    DwarfSection rnglists_;
+    DwarfSection aranges_;
+    DwarfSection names_;
+    DwarfSection gdb_index_;                /**< GDB's own name index, always little-endian */
+    bool         big_endian_ = false;
+    bool         linked_ = false;           /**< an executable or shared object, not a relocatable object */
+    std::uint8_t address_size_ = 8;         /**< of the ELF class, for units too old to say */
+
+    /**
+     * Whether @p address is a tombstone: where a linker relocates the debug
+     * information of code it threw away.  GNU ld uses 0, lld all ones.  In a
+     * linked file nothing real is at either.
+     */
+    bool
+    discarded(std::uint64_t address) const
+    { return address >= (address_size_ == 8 ? ~std::uint64_t(0) : 0xffffffff) || (linked_ && address == 0); }
+};
+
+
+/**
+ * Find the DWARF sections of @p elf_file, each as find_dwarf_section() would.
+ */
+DwarfSections
+find_dwarf_sections(ElfFile const& elf_file);
+
+
+/**
+ * The encoding of a unit: how big addresses and section offsets are.
+ */
+struct DwarfFormat
+{
+    std::uint16_t version_ = 0;
+    std::uint8_t  address_size_ = 8;
+    std::uint8_t  offset_size_ = 4;     /**< 4 for 32-bit DWARF, 8 for 64-bit DWARF */
+};
+
+
+/**
+ * The size of an attribute value of @p form in the unit's @p format, if it
+ * is the same for every value, or -1 if it has to be read to be known.
+ */
+int
+form_size(dw_form_t form, DwarfFormat const& format);
+
+
+/**
+ * Whether an attribute value of @p form is an address, rather than (for
+ * DW_AT_high_pc) an offset from one.
+ */
+inline bool
+is_address_form(dw_form_t form)
+{
+    switch (form)
+    {
+    case DW_FORM_addr:
+    case DW_FORM_addrx:
+    case DW_FORM_addrx1:
+    case DW_FORM_addrx2:
+    case DW_FORM_addrx3:
+    case DW_FORM_addrx4:
+    case DW_FORM_GNU_addr_index:
+        return true;
+    default:
+        return false;
+    }
+}
+
+
+/** A half-open range of addresses */
+struct AddressRange
+{
+    std::uint64_t low_;
+    std::uint64_t high_;
+};
+
+
+/**
+ * A cursor reading the basic DWARF encodings from a section.
+ *
+ * Reads never go past the end: one that would leaves the reader at the end,
+ * returns zero, and makes ok() false from then on, so a decoder can read a
+ * whole structure and check once at the end whether it was all there.
+ */
+class DwarfReader
+{
+public:
+    DwarfReader() = default;
+
+    DwarfReader(std::byte const* begin, std::size_t size, bool big_endian)
+    : begin_(begin), cursor_(begin), end_(begin + size), big_endian_(big_endian)
+    { }
+
+    DwarfReader(DwarfSection const& section, bool big_endian)
+    : DwarfReader(section.bytes_, section.size_, big_endian)
+    { }
+
+    /** Whether every read so far was within bounds */
+    bool
+    ok() const
+    { return ok_; }
+
+    bool
+    at_end() const
+    { return cursor_ == end_; }
+
+    /** The offset of the cursor from the beginning */
+    std::size_t
+    offset() const
+    { return static_cast<std::size_t>(cursor_ - begin_); }
+
+    std::size_t
+    remaining() const
+    { return static_cast<std::size_t>(end_ - cursor_); }
+
+    /** Where the cursor is */
+    std::byte const*
+    position() const
+    { return cursor_; }
+
+    /** Move the cursor to @p offset from the beginning */
+    void
+    seek(std::size_t offset)
+    {
+        if (offset > static_cast<std::size_t>(end_ - begin_))
+        {
+            fail();
+            return;
+        }
+        cursor_ = begin_ + offset;
+    }
+
+    void
+    skip(std::uint64_t count)
+    {
+        if (count > remaining())
+        {
+            fail();
+            return;
+        }
+        cursor_ += count;
+    }
+
+    /**
+     * A reader over the next @p size bytes, which this reader skips.  If there
+     * aren't that many, both get what there is and this one is marked failed.
+     */
+    DwarfReader
+    split(std::uint64_t size)
+    {
+        std::size_t length = size > remaining() ? remaining() : static_cast<std::size_t>(size);
+        DwarfReader part(cursor_, length, big_endian_);
+        skip(size);
+        return part;
+    }
+
+    std::uint8_t
+    u8()
+    { return read<std::uint8_t>(); }
+
+    std::uint16_t
+    u16()
+    { return read<std::uint16_t>(); }
+
+    std::uint32_t
+    u24()
+    {
+        std::uint32_t b0 = u8(), b1 = u8(), b2 = u8();
+        return big_endian_ ? (b0 << 16 | b1 << 8 | b2) : (b2 << 16 | b1 << 8 | b0);
+    }
+
+    std::uint32_t
+    u32()
+    { return read<std::uint32_t>(); }
+
+    std::uint64_t
+    u64()
+    { return read<std::uint64_t>(); }
+
+    /** An unsigned integer of @p size (1, 2, 4 or 8) bytes */
+    std::uint64_t
+    sized(std::uint8_t size)
+    {
+        switch (size)
+        {
+        case 1: return u8();
+        case 2: return u16();
+        case 4: return u32();
+        case 8: return u64();
+        }
+        skip(size);
+        return 0;
+    }
+
+    /** A section offset in the unit's @p format */
+    std::uint64_t
+    offset(DwarfFormat const& format)
+    { return format.offset_size_ == 8 ? u64() : u32(); }
+
+    /** A target address in the unit's @p format */
+    std::uint64_t
+    address(DwarfFormat const& format)
+    { return sized(format.address_size_); }
+
+    /**
+     * A unit length, which also settles whether the unit is 32-bit or 64-bit
+     * DWARF.
+     */
+    std::uint64_t
+    initial_length(DwarfFormat& format)
+    {
+        std::uint64_t length = u32();
+        format.offset_size_ = 4;
+        if (length == 0xffffffff)
+        {
+            format.offset_size_ = 8;
+            length = u64();
+        }
+        return length;
+    }
+
+    std::uint64_t
+    uleb128()
+    {
+        std::uint64_t value;
+        std::byte const* next = read_uleb128(cursor_, end_, value);
+        if (next == nullptr)
+        {
+            fail();
+            return value;
+        }
+        cursor_ = next;
+        return value;
+    }
+
+    std::int64_t
+    sleb128()
+    {
+        std::int64_t value;
+        std::byte const* next = read_sleb128(cursor_, end_, value);
+        if (next == nullptr)
+        {
+            fail();
+            return value;
+        }
+        cursor_ = next;
+        return value;
+    }
+
+    /** A NUL-terminated string, not including the NUL */
+    std::string_view
+    cstring();
+
+    /** Skip over an attribute value of @p form in the unit's @p format */
+    void
+    skip_form(dw_form_t form, DwarfFormat const& format);
+
+    /** Read an attribute value of a constant, reference or offset @p form */
+    std::uint64_t
+    form_value(dw_form_t form, DwarfFormat const& format);
+
+private:
+    /**
+     * Replace DW_FORM_indirect @p form with the form that follows it.
+     *
+     * A value is only ever indirect once: an indirect form that is itself
+     * indirect fails the read rather than being followed, so a run of them
+     * can't go on for as long as the section does.
+     */
+    bool
+    indirect_form(dw_form_t& form);
+
+    template<typename UInt>
+        UInt
+        read()
+        {
+            if (remaining() < sizeof(UInt))
+            {
+                fail();
+                return 0;
+            }
+            UInt value = load_uint<UInt>(cursor_, big_endian_);
+            cursor_ += sizeof(UInt);
+            return value;
+        }
+
+    void
+    fail()
+    {
+        cursor_ = end_;
+        ok_ = false;
+    }
+
+private:
+    std::byte const* begin_ = nullptr;
+    std::byte const* cursor_ = nullptr;
+    std::byte const* end_ = nullptr;
+    bool             big_endian_ = false;
+    bool             ok_ = true;
+};
+
+
+/**
+ * The NUL-terminated string at @p offset in the string section @p strings
+ * (.debug_str or .debug_line_str), or an empty string if there is none there.
+ */
+std::string_view
+dwarf_string(DwarfSection const& strings, std::uint64_t offset);
+
+#endif /* EDHELIND_DWARF_H */
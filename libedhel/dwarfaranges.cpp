@@ -0,0 +1,235 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "libedhel/dwarfaranges.h"
+
+#include <algorithm>
+#include "libedhel/dwarf.h"
+#include "libedhel/dwarfinfo.h"
+#include "libedhel/elffile.h"
+#include "libedhel/trace.h"
+#include <iterator>
+
+
+namespace
+{
+    /** Whether @p offset is where one of @p units (in order) starts */
+    bool
+    is_unit(std::vector<DwarfUnit> const& units, std::uint64_t offset)
+    {
+        auto it = std::lower_bound(units.begin(), units.end(), offset, [](DwarfUnit const& unit, std::uint64_t o) {
+            return unit.offset_ < o;
+        });
+        return it != units.end() && it->offset_ == offset;
+    }
+
+    /**
+     * Append the ranges of the address range sets in .debug_aranges that are
+     * for one of @p units to @p ranges, and the units they're for to
+     * @p covered.
+     */
+    void
+    read_aranges(DwarfSections const& sections, std::vector<DwarfUnit> const& units,
+                 std::vector<UnitRange>& ranges, std::vector<std::uint64_t>& covered, ParseError& error)
+    {
+        DwarfReader reader(sections.aranges_, sections.big_endian_);
+        while (!reader.at_end())
+        {
+            std::uint64_t const set_offset = reader.offset();
+            DwarfFormat format;
+            DwarfReader set = reader.split(reader.initial_length(format));
+            std::size_t const length_size = reader.offset() - set_offset - set.remaining();
+            if (!reader.ok())
+            {
+                error = ParseError{ParseErrc::DwarfOutOfBounds, sections.aranges_.offset_ + set_offset};
+                break;
+            }
+
+            // Every version of DWARF so far has version 2 sets.
+            format.version_ = set.u16();
+            if (format.version_ != 2)
+            {
+                error = ParseError{ParseErrc::BadDwarfVersion, sections.aranges_.offset_ + set_offset};
+                break;
+            }
+            std::uint64_t const unit = set.offset(format);
+            format.address_size_ = set.u8();
+            std::uint8_t const segment_size = set.u8();
+            std::size_t const tuple_alignment = 2 * format.address_size_;
+            if (!set.ok() || (format.address_size_ != 4 && format.address_size_ != 8))
+            {
+                error = ParseError{ParseErrc::BadDwarf, sections.aranges_.offset_ + set_offset};
+                break;
+            }
+            if (!is_unit(units, unit))
+            {
+                continue;
+            }
+
+            // The tuples are aligned to twice the address size from the start of the set.
+            std::size_t const header_size = length_size + set.offset();
+            set.skip((tuple_alignment - header_size % tuple_alignment) % tuple_alignment);
+            while (set.remaining() >= segment_size + tuple_alignment)
+            {
+                std::uint64_t const segment = set.sized(segment_size);
+                std::uint64_t const address = set.address(format);
+                std::uint64_t const length = set.address(format);
+                if (segment == 0 && address == 0 && length == 0)
+                {
+                    break;
+                }
+                if (length != 0 && !sections.discarded(address))
+                {
+                    ranges.push_back(UnitRange{address, address + length, unit});
+                }
+            }
+            covered.push_back(unit);
+        }
+    }
+
+    /** Append the ranges of @p unit's unit DIE to @p ranges */
+    bool
+    read_unit_ranges(DwarfSections const& sections, DwarfUnit& unit, std::vector<UnitRange>& ranges)
+    {
+        AbbrevTable abbrevs;
+        if (!abbrevs.read(sections, unit.abbrev_offset_, unit.format_) || !read_unit_die(sections, abbrevs, unit))
+        {
+            return false;
+        }
+        if (unit.ranges_form_)
+        {
+            std::vector<AddressRange> unit_ranges;
+            bool ok = read_ranges(sections, unit, unit.ranges_, unit.ranges_form_, unit_ranges);
+            for (AddressRange const& range: unit_ranges)
+            {
+                ranges.push_back(UnitRange{range.low_, range.high_, unit.offset_});
+            }
+            return ok;
+        }
+        if (unit.low_pc_ < unit.high_pc_ && !sections.discarded(unit.low_pc_))
+        {
+            ranges.push_back(UnitRange{unit.low_pc_, unit.high_pc_, unit.offset_});
+        }
+        return true;
+    }
+} // anonymous namespace
+
+
+UnitRangeIndex::
+UnitRangeIndex(ElfFile const& elf_file)
+{
+    EDHEL_TRACE_ZONE("index unit ranges");
+    DwarfSections sections = find_dwarf_sections(elf_file);
+    if (sections.info_.compressed_ || sections.abbrev_.compressed_ || sections.aranges_.compressed_)
+    {
+        error_ = ParseError{ParseErrc::CompressedSection,
+                            sections.aranges_.compressed_ ? sections.aranges_.offset_ : sections.info_.offset_};
+        return;
+    }
+    if (!sections.info_)
+    {
+        return;
+    }
+    std::vector<DwarfUnit> units = read_units(sections, error_);
+
+    std::vector<UnitRange> ranges;
+    std::vector<std::uint64_t> covered;
+    if (sections.aranges_)
+    {
+        read_aranges(sections, units, ranges, covered, error_);
+        std::sort(covered.begin(), covered.end());
+    }
+    for (DwarfUnit& unit: units)
+    {
+        if (std::binary_search(covered.begin(), covered.end(), unit.offset_))
+        {
+            continue;
+        }
+        ++fallback_count_;
+        if (!read_unit_ranges(sections, unit, ranges) && !error_)
+        {
+            error_ = ParseError{ParseErrc::DwarfOutOfBounds, sections.info_.offset_ + unit.offset_};
+        }
+    }
+
+    // Make the ranges disjoint, clipping each to what the ones before it
+    // leave, and merge neighbours.  Where several units claim the same range
+    // (the copies of an inline function that a linker merged, say) the first
+    // unit keeps it.
+    std::sort(ranges.begin(), ranges.end(), [](UnitRange const& lhs, UnitRange const& rhs) {
+        if (lhs.low_ != rhs.low_)
+        {
+            return lhs.low_ < rhs.low_;
+        }
+        return lhs.high_ > rhs.high_ || (lhs.high_ == rhs.high_ && lhs.unit_ < rhs.unit_);
+    });
+    for (UnitRange range: ranges)
+    {
+        if (!ranges_.empty())
+        {
+            UnitRange& last = ranges_.back();
+            if (range.high_ <= last.high_)
+            {
+                continue;
+            }
+            range.low_ = std::max(range.low_, last.high_);
+            if (range.low_ == last.high_ && range.unit_ == last.unit_)
+            {
+                last.high_ = range.high_;
+                continue;
+            }
+        }
+        ranges_.push_back(range);
+    }
+    ranges_.shrink_to_fit();
+}
+
+
+std::vector<UnitRange> const& UnitRangeIndex::
+ranges() const
+{
+    return ranges_;
+}
+
+
+std::size_t UnitRangeIndex::
+fallback_count() const
+{
+    return fallback_count_;
+}
+
+
+ParseError const& UnitRangeIndex::
+error() const
+{
+    return error_;
+}
+
+
+std::uint64_t UnitRangeIndex::
+lookup(std::uint64_t address) const
+{
+    auto after = std::upper_bound(ranges_.begin(), ranges_.end(), address, [](std::uint64_t a, UnitRange const& range) {
+        return a < range.low_;
+    });
+    if (after == ranges_.begin() || address >= std::prev(after)->high_)
+    {
+        return DwarfUnit::None;
+    }
+    return std::prev(after)->unit_;
+}
@@ -0,0 +1,89 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef EDHELIND_DWARFARANGES_H
+#define EDHELIND_DWARFARANGES_H
+
+#include <cstddef>
+#include <cstdint>
+#include "libedhel/parseerror.h"
+#include <vector>
+
+class ElfFile;
+
+
+/** A range of addresses, and the unit of .debug_info with the code there */
+struct UnitRange
+{
+    std::uint64_t low_;
+    std::uint64_t high_;        /**< past the end */
+    std::uint64_t unit_;        /**< offset of the unit header in .debug_info */
+};
+
+
+/**
+ * Which compilation unit has the code at an address, so that looking into an
+ * address means reading the line table and DIEs of just that unit.
+ *
+ * The ranges come from .debug_aranges.  The units it doesn't describe (all
+ * of them, without the section) are covered by the DW_AT_ranges, or
+ * DW_AT_low_pc and DW_AT_high_pc, of their unit DIEs instead, which takes
+ * reading each one's abbreviations.  Either way they end up in one sorted
+ * array of ranges that don't overlap: where units claim the same addresses,
+ * the range that starts first (or is in the first unit) keeps them.  Code a
+ * linker discarded is left out.
+ */
+class UnitRangeIndex
+{
+public:
+    UnitRangeIndex() = default;
+
+    explicit UnitRangeIndex(ElfFile const& elf_file);
+
+    UnitRangeIndex(UnitRangeIndex&&) = default;
+    UnitRangeIndex& operator=(UnitRangeIndex&&) = default;
+
+    /** The ranges, sorted by address, with adjacent ranges of the same unit merged */
+    std::vector<UnitRange> const&
+    ranges() const;
+
+    /** How many units .debug_aranges left out, and had their unit DIEs read instead */
+    std::size_t
+    fallback_count() const;
+
+    /**
+     * The first problem met, if any.  What .debug_aranges has before a bad
+     * set is kept, and the units it doesn't get to are read instead.
+     */
+    ParseError const&
+    error() const;
+
+    /**
+     * The offset in .debug_info of the unit with code at @p address, or
+     * DwarfUnit::None if there's none.
+     */
+    std::uint64_t
+    lookup(std::uint64_t address) const;
+
+private:
+    std::vector<UnitRange> ranges_;
+    std::size_t            fallback_count_ = 0;
+    ParseError             error_;
+};
+
+#endif /* EDHELIND_DWARFARANGES_H */
@@ -0,0 +1,518 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "libedhel/dwarffunctions.h"
+
+#include <algorithm>
+#include <atomic>
+#include "libedhel/elffile.h"
+#include "libedhel/threadpool.h"
+#include "libedhel/trace.h"
+
+
+namespace
+{
+    constexpr std::uint64_t no_origin = ~std::uint64_t(0);
+
+    /**
+     * The names of a subprogram DIE, which the functions that refer to it
+     * may need to borrow, and what it refers to in turn.
+     */
+    struct NameSource
+    {
+        std::uint64_t    offset_;
+        std::string_view name_;
+        std::string_view linkage_name_;
+        std::uint64_t    origin_;
+    };
+
+    /** What indexing one unit finds, with indexes local to the unit */
+    struct UnitFunctions
+    {
+        std::vector<DwarfFunction> functions_;
+        std::vector<std::uint64_t> origins_;    /**< the DIE each function refers to for its names */
+        std::vector<AddressRange>  ranges_;
+        std::vector<NameSource>    names_;      /**< of every subprogram, in DIE order */
+        ParseError                 error_;
+    };
+
+    /** The .debug_info offset a reference attribute value @p value of @p form refers to */
+    std::uint64_t
+    reference(DwarfUnit const& unit, dw_form_t form, std::uint64_t value)
+    {
+        switch (form)
+        {
+        case DW_FORM_ref1:
+        case DW_FORM_ref2:
+        case DW_FORM_ref4:
+        case DW_FORM_ref8:
+        case DW_FORM_ref_udata:
+            return unit.offset_ + value;
+        case DW_FORM_ref_addr:
+            return value;
+        default:
+            // References into a supplementary or alternate file
+            return no_origin;
+        }
+    }
+
+    /** Skip the attribute values of a DIE of @p abbrev */
+    void
+    skip_die(DwarfReader& reader, AbbrevTable const& abbrevs, Abbrev const& abbrev, DwarfFormat const& format)
+    {
+        if (abbrev.fixed_size_ >= 0)
+        {
+            reader.skip(abbrev.fixed_size_);
+            return;
+        }
+        AbbrevAttribute const* attributes = abbrevs.attributes(abbrev);
+        for (std::uint32_t a = 0; a < abbrev.attribute_count_; ++a)
+        {
+            if (attributes[a].size_ >= 0)
+            {
+                reader.skip(attributes[a].size_);
+            }
+            else
+            {
+                reader.skip_form(attributes[a].form_, format);
+            }
+        }
+    }
+
+    /** Find the functions of @p unit, the @p unit_index th unit, reading its unit DIE on the way */
+    void
+    index_unit(DwarfSections const& sections, DwarfUnit& unit, std::uint32_t unit_index, UnitFunctions& found)
+    {
+        AbbrevTable abbrevs;
+        if (!abbrevs.read(sections, unit.abbrev_offset_, unit.format_) || !read_unit_die(sections, abbrevs, unit))
+        {
+            found.error_ = ParseError{ParseErrc::DwarfOutOfBounds, sections.info_.offset_ + unit.offset_};
+            return;
+        }
+
+        DwarfFormat const& format = unit.format_;
+        DwarfReader reader(sections.info_.bytes_ + unit.dies_, unit.end_ - unit.dies_, sections.big_endian_);
+
+        // The DIEs with children that are open, and the function (if any)
+        // each opened and the one its children are inlined into.
+        struct Level
+        {
+            std::uint32_t opened_;
+            std::uint32_t parent_;
+        };
+        std::vector<Level> levels;
+        auto close = [&found](Level const& level) {
+            if (level.opened_ != DwarfFunction::None)
+            {
+                found.functions_[level.opened_].end_ = static_cast<std::uint32_t>(found.functions_.size());
+            }
+        };
+
+        while (!reader.at_end())
+        {
+            std::uint64_t const offset = unit.dies_ + reader.offset();
+            std::uint64_t const code = reader.uleb128();
+            if (code == 0)
+            {
+                if (!levels.empty())
+                {
+                    close(levels.back());
+                    levels.pop_back();
+                }
+                continue;
+            }
+            Abbrev const* abbrev = abbrevs.find(code);
+            if (abbrev == nullptr)
+            {
+                found.error_ = ParseError{ParseErrc::BadDwarf, sections.info_.offset_ + offset};
+                break;
+            }
+            std::uint32_t const parent = levels.empty() ? DwarfFunction::None : levels.back().parent_;
+            if (abbrev->tag_ != DW_TAG_subprogram && abbrev->tag_ != DW_TAG_inlined_subroutine)
+            {
+                skip_die(reader, abbrevs, *abbrev, format);
+                if (abbrev->has_children_)
+                {
+                    levels.push_back(Level{DwarfFunction::None, parent});
+                }
+                continue;
+            }
+
+            bool const inlined = abbrev->tag_ == DW_TAG_inlined_subroutine;
+            DwarfFunction function{};
+            function.offset_ = offset;
+            function.unit_ = unit_index;
+            function.parent_ = inlined ? parent : DwarfFunction::None;
+            std::uint64_t origin = no_origin;
+            dw_form_t low_form = 0, high_form = 0, ranges_form = 0;
+            std::uint64_t low_value = 0, high_value = 0, ranges_value = 0;
+            AbbrevAttribute const* attributes = abbrevs.attributes(*abbrev);
+            for (std::uint32_t a = 0; a < abbrev->attribute_count_; ++a)
+            {
+                AbbrevAttribute const& attribute = attributes[a];
+                switch (attribute.name_)
+                {
+                case DW_AT_name:
+                    function.name_ = read_string_attribute(sections, unit, reader, attribute.form_);
+                    break;
+                case DW_AT_linkage_name:
+                case DW_AT_MIPS_linkage_name:
+                    function.linkage_name_ = read_string_attribute(sections, unit, reader, attribute.form_);
+                    break;
+                case DW_AT_low_pc:
+                    low_form = attribute.form_;
+                    low_value = read_attribute_value(reader, attribute, format);
+                    break;
+                case DW_AT_high_pc:
+                    high_form = attribute.form_;
+                    high_value = read_attribute_value(reader, attribute, format);
+                    break;
+                case DW_AT_ranges:
+                    ranges_form = attribute.form_;
+                    ranges_value = read_attribute_value(reader, attribute, format);
+                    break;
+                case DW_AT_abstract_origin:
+                case DW_AT_specification:
+                    origin = reference(unit, attribute.form_, read_attribute_value(reader, attribute, format));
+                    break;
+                case DW_AT_call_file:
+                    function.call_file_ = static_cast<std::uint32_t>(read_attribute_value(reader, attribute, format));
+                    break;
+                case DW_AT_call_line:
+                    function.call_line_ = static_cast<std::uint32_t>(read_attribute_value(reader, attribute, format));
+                    break;
+                default:
+                    if (attribute.size_ >= 0)
+                    {
+                        reader.skip(attribute.size_);
+                    }
+                    else
+                    {
+                        reader.skip_form(attribute.form_, format);
+                    }
+                    break;
+                }
+            }
+
+            // Work out where its code is, if it has any.
+            bool has_code = false;
+            if (ranges_form)
+            {
+                std::size_t first = found.ranges_.size();
+                read_ranges(sections, unit, ranges_value, ranges_form, found.ranges_);
+                auto begin = found.ranges_.begin() + first;
+                std::sort(begin, found.ranges_.end(), [](AddressRange const& lhs, AddressRange const& rhs) {
+                    return lhs.low_ < rhs.low_;
+                });
+                std::size_t count = found.ranges_.size() - first;
+                if (count != 0)
+                {
+                    has_code = true;
+                    function.low_pc_ = begin->low_;
+                    function.high_pc_ = std::max_element(begin, found.ranges_.end(), [](auto const& lhs, auto const& rhs) {
+                        return lhs.high_ < rhs.high_;
+                    })->high_;
+                    function.first_range_ = static_cast<std::uint32_t>(first);
+                    function.range_count_ = count > 1 ? static_cast<std::uint32_t>(count) : 0;
+                }
+                if (count == 1)
+                {
+                    found.ranges_.pop_back();
+                }
+            }
+            else if (low_form && high_form)
+            {
+                function.low_pc_ = unit_address(sections, unit, low_form, low_value);
+                function.high_pc_ = is_address_form(high_form) ? unit_address(sections, unit, high_form, high_value)
+                                                                : function.low_pc_ + high_value;
+                has_code = function.low_pc_ < function.high_pc_ && !sections.discarded(function.low_pc_);
+            }
+
+            if (!inlined)
+            {
+                found.names_.push_back(NameSource{offset, function.name_, function.linkage_name_, origin});
+            }
+            std::uint32_t opened = DwarfFunction::None;
+            if (has_code)
+            {
+                opened = static_cast<std::uint32_t>(found.functions_.size());
+                function.inlined_ = inlined;
+                function.end_ = opened + 1;
+                found.functions_.push_back(function);
+                found.origins_.push_back(origin);
+            }
+            if (abbrev->has_children_)
+            {
+                levels.push_back(Level{opened, opened != DwarfFunction::None ? opened : parent});
+            }
+        }
+
+        while (!levels.empty())
+        {
+            close(levels.back());
+            levels.pop_back();
+        }
+        if (!reader.ok() && !found.error_)
+        {
+            found.error_ = ParseError{ParseErrc::DwarfOutOfBounds, sections.info_.offset_ + unit.offset_};
+        }
+    }
+} // anonymous namespace
+
+
+FunctionIndex::
+FunctionIndex(ElfFile const& elf_file, unsigned concurrency)
+{
+    EDHEL_TRACE_ZONE("index functions");
+    DwarfSections sections = find_dwarf_sections(elf_file);
+    if (sections.info_.compressed_ || sections.abbrev_.compressed_)
+    {
+        error_ = ParseError{ParseErrc::CompressedSection, sections.info_.offset_};
+        return;
+    }
+    if (!sections.info_)
+    {
+        return;
+    }
+    units_ = read_units(sections, error_);
+
+    std::vector<UnitFunctions> found(units_.size());
+    concurrency = concurrency ? concurrency : ThreadPool::shared().worker_count() + 1;
+    std::size_t task_count = std::min<std::size_t>(concurrency, units_.size());
+    if (task_count <= 1)
+    {
+        for (std::size_t u = 0; u < units_.size(); ++u)
+        {
+            index_unit(sections, units_[u], static_cast<std::uint32_t>(u), found[u]);
+        }
+    }
+    else
+    {
+        // Units vary a lot in size, so each task takes the next one left.
+        std::atomic<std::size_t> next{0};
+        TaskGroup group;
+        auto work = [&]() {
+            for (std::size_t u = next++; u < units_.size() && !group.is_cancelled(); u = next++)
+            {
+                index_unit(sections, units_[u], static_cast<std::uint32_t>(u), found[u]);
+            }
+        };
+        for (std::size_t t = 0; t < task_count; ++t)
+        {
+            group.run(work);
+        }
+        group.wait();
+    }
+
+    // Put the units' findings together, making their indexes global.
+    std::size_t function_count = 0;
+    std::size_t name_count = 0;
+    for (auto const& unit: found)
+    {
+        function_count += unit.functions_.size();
+        name_count += unit.names_.size();
+    }
+    functions_.reserve(function_count);
+    std::vector<std::uint64_t> origins;
+    origins.reserve(function_count);
+    std::vector<NameSource> names;
+    names.reserve(name_count);
+    for (auto& unit: found)
+    {
+        auto const function_base = static_cast<std::uint32_t>(functions_.size());
+        auto const range_base = static_cast<std::uint32_t>(ranges_.size());
+        for (DwarfFunction function: unit.functions_)
+        {
+            if (function.parent_ != DwarfFunction::None)
+            {
+                function.parent_ += function_base;
+            }
+            function.end_ += function_base;
+            function.first_range_ += range_base;
+            functions_.push_back(function);
+        }
+        origins.insert(origins.end(), unit.origins_.begin(), unit.origins_.end());
+        ranges_.insert(ranges_.end(), unit.ranges_.begin(), unit.ranges_.end());
+        names.insert(names.end(), unit.names_.begin(), unit.names_.end());
+        if (unit.error_ && !error_)
+        {
+            error_ = unit.error_;
+        }
+        unit = UnitFunctions{};
+    }
+
+    // Borrow missing names from the DIEs referred to, which may be in
+    // another unit, and may refer on to another DIE in turn.
+    auto find_name = [&names](std::uint64_t offset) -> NameSource const* {
+        auto it = std::lower_bound(names.begin(), names.end(), offset, [](NameSource const& source, std::uint64_t o) {
+            return source.offset_ < o;
+        });
+        return it != names.end() && it->offset_ == offset ? &*it : nullptr;
+    };
+    for (std::size_t f = 0; f < functions_.size(); ++f)
+    {
+        DwarfFunction& function = functions_[f];
+        std::uint64_t origin = origins[f];
+        for (int hops = 0; hops < 8 && origin != no_origin; ++hops)
+        {
+            if (!function.name_.empty() && !function.linkage_name_.empty())
+            {
+                break;
+            }
+            NameSource const* source = find_name(origin);
+            if (source == nullptr)
+            {
+                break;
+            }
+            if (function.name_.empty())
+            {
+                function.name_ = source->name_;
+            }
+            if (function.linkage_name_.empty())
+            {
+                function.linkage_name_ = source->linkage_name_;
+            }
+            origin = source->origin_;
+        }
+    }
+
+    for (std::uint32_t f = 0; f < functions_.size(); ++f)
+    {
+        DwarfFunction const& function = functions_[f];
+        if (function.inlined_)
+        {
+            continue;
+        }
+        if (function.range_count_ == 0)
+        {
+            outermost_.push_back(Interval{function.low_pc_, function.high_pc_, f});
+        }
+        for (std::uint32_t r = 0; r < function.range_count_; ++r)
+        {
+            AddressRange const& range = ranges_[function.first_range_ + r];
+            outermost_.push_back(Interval{range.low_, range.high_, f});
+        }
+    }
+    std::sort(outermost_.begin(), outermost_.end(), [](Interval const& lhs, Interval const& rhs) {
+        return lhs.low_ < rhs.low_;
+    });
+    reach_.resize(outermost_.size());
+    std::uint64_t reach = 0;
+    for (std::size_t i = 0; i < outermost_.size(); ++i)
+    {
+        reach = std::max(reach, outermost_[i].high_);
+        reach_[i] = reach;
+    }
+}
+
+
+std::vector<DwarfUnit> const& FunctionIndex::
+units() const
+{
+    return units_;
+}
+
+
+std::vector<DwarfFunction> const& FunctionIndex::
+functions() const
+{
+    return functions_;
+}
+
+
+std::vector<AddressRange> const& FunctionIndex::
+ranges() const
+{
+    return ranges_;
+}
+
+
+ParseError const& FunctionIndex::
+error() const
+{
+    return error_;
+}
+
+
+bool FunctionIndex::
+covers(DwarfFunction const& function, std::uint64_t address) const
+{
+    if (address < function.low_pc_ || address >= function.high_pc_)
+    {
+        return false;
+    }
+    if (function.range_count_ == 0)
+    {
+        return true;
+    }
+    auto first = ranges_.begin() + function.first_range_;
+    return std::any_of(first, first + function.range_count_, [address](AddressRange const& range) {
+        return address >= range.low_ && address < range.high_;
+    });
+}
+
+
+std::vector<DwarfFunction const*> FunctionIndex::
+lookup(std::uint64_t address) const
+{
+    std::vector<DwarfFunction const*> chain;
+    auto after = std::upper_bound(outermost_.begin(), outermost_.end(), address,
+                                  [](std::uint64_t a, Interval const& interval) { return a < interval.low_; });
+    std::uint32_t current = DwarfFunction::None;
+    for (std::size_t i = after - outermost_.begin(); i-- > 0 && reach_[i] > address; )
+    {
+        if (address < outermost_[i].high_)
+        {
+            current = outermost_[i].function_;
+            break;
+        }
+    }
+    if (current == DwarfFunction::None)
+    {
+        return chain;
+    }
+
+    // Go down through the subroutines inlined at the address, skipping the
+    // subtrees of those that aren't.
+    for (std::uint32_t f = current + 1; f < functions_[current].end_; )
+    {
+        if (functions_[f].inlined_ && covers(functions_[f], address))
+        {
+            current = f++;
+        }
+        else
+        {
+            f = functions_[f].end_;
+        }
+    }
+    for (std::uint32_t f = current; f != DwarfFunction::None; f = functions_[f].parent_)
+    {
+        chain.push_back(&functions_[f]);
+    }
+    return chain;
+}
+
+
+DwarfFunction const* FunctionIndex::
+find(std::uint64_t offset) const
+{
+    auto it = std::lower_bound(functions_.begin(), functions_.end(), offset, [](DwarfFunction const& function, std::uint64_t o) {
+        return function.offset_ < o;
+    });
+    return it != functions_.end() && it->offset_ == offset ? &*it : nullptr;
+}
@@ -0,0 +1,142 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef EDHELIND_DWARFFUNCTIONS_H
+#define EDHELIND_DWARFFUNCTIONS_H
+
+#include <cstddef>
+#include <cstdint>
+#include "libedhel/dwarf.h"
+#include "libedhel/dwarfinfo.h"
+#include "libedhel/parseerror.h"
+#include <string_view>
+#include <vector>
+
+class ElfFile;
+
+
+/**
+ * A function with code: a subprogram, or a subroutine inlined into one.
+ *
+ * The name of an inlined subroutine or an out-of-line definition is usually
+ * on the DIE it refers to through DW_AT_abstract_origin or
+ * DW_AT_specification, and is taken from there.  Names point into the image
+ * of the ElfFile and are valid for as long as it is.
+ */
+struct DwarfFunction
+{
+    static constexpr std::uint32_t None = ~std::uint32_t(0);
+
+    std::string_view name_;
+    std::string_view linkage_name_;
+    std::uint64_t    offset_;           /**< of its DIE in .debug_info */
+    std::uint64_t    low_pc_;
+    std::uint64_t    high_pc_;          /**< past the end; of the last of its ranges if it has several */
+    std::uint32_t    unit_;             /**< index into FunctionIndex::units() */
+    std::uint32_t    parent_;           /**< the function this one is inlined into, or None for a subprogram */
+    std::uint32_t    end_;              /**< one past the last function within its DIE */
+    std::uint32_t    first_range_;      /**< index into FunctionIndex::ranges() */
+    std::uint32_t    range_count_;      /**< 0 if it's all of [low_pc_, high_pc_) */
+    std::uint32_t    call_file_;        /**< for an inlined subroutine, index into its unit's LineTable::files_ */
+    std::uint32_t    call_line_;
+    bool             inlined_;
+};
+
+
+/**
+ * The functions described by the .debug_info section of an ELF file, indexed
+ * by address so that the chain of inlined subroutines at an address can be
+ * found.
+ *
+ * Building the index reads each unit's DIEs in one pass, without building a
+ * tree of them: only subprograms and inlined subroutines are decoded, and
+ * only the attributes that locate and name them.  Everything else is skipped
+ * using the value sizes worked out from the abbreviations, a whole DIE at a
+ * time where the sizes are all fixed.
+ *
+ * Functions are kept in .debug_info order, which puts those inlined into a
+ * function straight after it.  Code a linker discarded is left out.
+ */
+class FunctionIndex
+{
+public:
+    FunctionIndex() = default;
+
+    /**
+     * Index the functions of @p elf_file, reading units in parallel on up to
+     * @p concurrency threads of the shared ThreadPool (0 for all of them).
+     */
+    explicit FunctionIndex(ElfFile const& elf_file, unsigned concurrency = 1);
+
+    FunctionIndex(FunctionIndex&&) = default;
+    FunctionIndex& operator=(FunctionIndex&&) = default;
+
+    /** The units of .debug_info, in order */
+    std::vector<DwarfUnit> const&
+    units() const;
+
+    std::vector<DwarfFunction> const&
+    functions() const;
+
+    /** The ranges of the functions with more than one */
+    std::vector<AddressRange> const&
+    ranges() const;
+
+    /**
+     * The first problem met, if any.  A unit with a problem keeps the
+     * functions found before it, and units after a bad unit header aren't
+     * read at all.
+     */
+    ParseError const&
+    error() const;
+
+    /** Whether @p function has code at @p address */
+    bool
+    covers(DwarfFunction const& function, std::uint64_t address) const;
+
+    /**
+     * The functions with code at @p address, innermost first: the most
+     * deeply inlined subroutine, then what it was inlined into, out to the
+     * subprogram.  Empty if there's none.
+     */
+    std::vector<DwarfFunction const*>
+    lookup(std::uint64_t address) const;
+
+    /** The function whose DIE is at @p offset in .debug_info, or null */
+    DwarfFunction const*
+    find(std::uint64_t offset) const;
+
+private:
+    /** A range of a subprogram */
+    struct Interval
+    {
+        std::uint64_t low_;
+        std::uint64_t high_;
+        std::uint32_t function_;
+    };
+
+private:
+    std::vector<DwarfUnit>     units_;
+    std::vector<DwarfFunction> functions_;
+    std::vector<AddressRange>  ranges_;
+    std::vector<Interval>      outermost_;  /**< sorted by low_ */
+    std::vector<std::uint64_t> reach_;      /**< the highest high_ of outermost_[0..i] */
+    ParseError                 error_;
+};
+
+#endif /* EDHELIND_DWARFFUNCTIONS_H */
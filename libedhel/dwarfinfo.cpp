@@ -0,0 +1,434 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "libedhel/dwarfinfo.h"
+
+#include <algorithm>
+
+
+namespace
+{
+    /**
+     * The default base of a unit's entries in .debug_str_offsets or
+     * .debug_addr, for units that don't say: just past the header of the
+     * section's contribution.
+     */
+    std::uint64_t
+    default_base(DwarfFormat const& format)
+    {
+        return format.offset_size_ == 8 ? 16 : 8;
+    }
+
+    /** Read a DWARF 5 range list at @p offset in .debug_rnglists */
+    bool
+    read_rnglist(DwarfSections const& sections, DwarfUnit const& unit, std::uint64_t offset,
+                 std::vector<AddressRange>& ranges)
+    {
+        DwarfReader reader(sections.rnglists_, sections.big_endian_);
+        reader.seek(offset);
+        std::uint64_t base = unit.low_pc_;
+        auto add = [&sections, &ranges](std::uint64_t low, std::uint64_t high) {
+            if (low < high && !sections.discarded(low))
+            {
+                ranges.push_back(AddressRange{low, high});
+            }
+        };
+        auto indexed = [&](std::uint64_t index) {
+            return unit_address(sections, unit, DW_FORM_addrx, index);
+        };
+
+        while (reader.ok())
+        {
+            switch (reader.u8())
+            {
+            case DW_RLE_end_of_list:
+                return reader.ok();
+            case DW_RLE_base_addressx:
+                base = indexed(reader.uleb128());
+                break;
+            case DW_RLE_startx_endx:
+            {
+                std::uint64_t low = indexed(reader.uleb128());
+                add(low, indexed(reader.uleb128()));
+                break;
+            }
+            case DW_RLE_startx_length:
+            {
+                std::uint64_t low = indexed(reader.uleb128());
+                add(low, low + reader.uleb128());
+                break;
+            }
+            case DW_RLE_offset_pair:
+            {
+                std::uint64_t low = base + reader.uleb128();
+                add(low, base + reader.uleb128());
+                break;
+            }
+            case DW_RLE_base_address:
+                base = reader.address(unit.format_);
+                break;
+            case DW_RLE_start_end:
+            {
+                std::uint64_t low = reader.address(unit.format_);
+                add(low, reader.address(unit.format_));
+                break;
+            }
+            case DW_RLE_start_length:
+            {
+                std::uint64_t low = reader.address(unit.format_);
+                add(low, low + reader.uleb128());
+                break;
+            }
+            default:
+                return false;
+            }
+        }
+        return false;
+    }
+
+    /** Read a DWARF 2 to 4 range list at @p offset in .debug_ranges */
+    bool
+    read_range_list(DwarfSections const& sections, DwarfUnit const& unit, std::uint64_t offset,
+                    std::vector<AddressRange>& ranges)
+    {
+        DwarfReader reader(sections.ranges_, sections.big_endian_);
+        reader.seek(offset);
+        std::uint8_t const address_size = unit.format_.address_size_;
+        std::uint64_t const base_selector = address_size == 8 ? ~std::uint64_t(0) : 0xffffffff;
+        std::uint64_t base = unit.low_pc_;
+        while (reader.ok())
+        {
+            std::uint64_t begin = reader.sized(address_size);
+            std::uint64_t end = reader.sized(address_size);
+            if (begin == 0 && end == 0)
+            {
+                return reader.ok();
+            }
+            if (begin == base_selector)
+            {
+                base = end;
+            }
+            else if (begin < end && !sections.discarded(base + begin))
+            {
+                ranges.push_back(AddressRange{base + begin, base + end});
+            }
+        }
+        return false;
+    }
+} // anonymous namespace
+
+
+std::vector<DwarfUnit>
+read_units(DwarfSections const& sections, ParseError& error)
+{
+    std::vector<DwarfUnit> units;
+    DwarfReader reader(sections.info_, sections.big_endian_);
+    while (!reader.at_end())
+    {
+        DwarfUnit unit;
+        unit.offset_ = reader.offset();
+        std::uint64_t length = reader.initial_length(unit.format_);
+        DwarfReader header = reader.split(length);
+        unit.end_ = reader.offset();
+        if (!reader.ok())
+        {
+            error = ParseError{ParseErrc::DwarfOutOfBounds, sections.info_.offset_ + unit.offset_};
+            break;
+        }
+
+        unit.format_.version_ = header.u16();
+        if (unit.format_.version_ < 2 || unit.format_.version_ > 5)
+        {
+            error = ParseError{ParseErrc::BadDwarfVersion, sections.info_.offset_ + unit.offset_};
+            break;
+        }
+        if (unit.format_.version_ >= 5)
+        {
+            unit.unit_type_ = header.u8();
+            unit.format_.address_size_ = header.u8();
+            unit.abbrev_offset_ = header.offset(unit.format_);
+            switch (unit.unit_type_)
+            {
+            case DW_UT_skeleton:
+            case DW_UT_split_compile:
+                header.u64();           // dwo_id
+                break;
+            case DW_UT_type:
+            case DW_UT_split_type:
+                header.u64();           // type_signature
+                header.offset(unit.format_);
+                break;
+            }
+        }
+        else
+        {
+            unit.abbrev_offset_ = header.offset(unit.format_);
+            unit.format_.address_size_ = header.u8();
+        }
+        if (!header.ok())
+        {
+            error = ParseError{ParseErrc::DwarfOutOfBounds, sections.info_.offset_ + unit.offset_};
+            break;
+        }
+        unit.dies_ = unit.end_ - header.remaining();
+        if (unit.unit_type_ != DW_UT_type && unit.unit_type_ != DW_UT_split_type)
+        {
+            units.push_back(unit);
+        }
+    }
+    return units;
+}
+
+
+bool AbbrevTable::
+read(DwarfSections const& sections, std::uint64_t offset, DwarfFormat const& format)
+{
+    abbrevs_.clear();
+    attributes_.clear();
+    dense_ = true;
+
+    DwarfReader reader(sections.abbrev_, sections.big_endian_);
+    reader.seek(offset);
+    while (reader.ok())
+    {
+        Abbrev abbrev;
+        abbrev.code_ = reader.uleb128();
+        if (abbrev.code_ == 0)
+        {
+            break;
+        }
+        abbrev.tag_ = static_cast<dw_tag_t>(reader.uleb128());
+        abbrev.has_children_ = reader.u8() != 0;
+        abbrev.first_attribute_ = static_cast<std::uint32_t>(attributes_.size());
+        abbrev.fixed_size_ = 0;
+        while (reader.ok())
+        {
+            AbbrevAttribute attribute;
+            attribute.name_ = static_cast<dw_at_t>(reader.uleb128());
+            attribute.form_ = static_cast<dw_form_t>(reader.uleb128());
+            if (attribute.name_ == 0 && attribute.form_ == 0)
+            {
+                break;
+            }
+            attribute.implicit_const_ = attribute.form_ == DW_FORM_implicit_const ? reader.sleb128() : 0;
+            attribute.size_ = static_cast<std::int16_t>(form_size(attribute.form_, format));
+            if (attribute.size_ < 0 || abbrev.fixed_size_ < 0)
+            {
+                abbrev.fixed_size_ = -1;
+            }
+            else
+            {
+                abbrev.fixed_size_ += attribute.size_;
+            }
+            attributes_.push_back(attribute);
+        }
+        abbrev.attribute_count_ = static_cast<std::uint32_t>(attributes_.size()) - abbrev.first_attribute_;
+        if (abbrev.code_ != abbrevs_.size() + 1)
+        {
+            dense_ = false;
+        }
+        abbrevs_.push_back(abbrev);
+    }
+
+    if (!dense_)
+    {
+        std::sort(abbrevs_.begin(), abbrevs_.end(), [](Abbrev const& lhs, Abbrev const& rhs) {
+            return lhs.code_ < rhs.code_;
+        });
+    }
+    return reader.ok();
+}
+
+
+Abbrev const* AbbrevTable::
+find_sparse(std::uint64_t code) const
+{
+    auto it = std::lower_bound(abbrevs_.begin(), abbrevs_.end(), code, [](Abbrev const& abbrev, std::uint64_t c) {
+        return abbrev.code_ < c;
+    });
+    return it != abbrevs_.end() && it->code_ == code ? &*it : nullptr;
+}
+
+
+bool
+read_unit_die(DwarfSections const& sections, AbbrevTable const& abbrevs, DwarfUnit& unit)
+{
+    DwarfReader reader(sections.info_.bytes_ + unit.dies_, unit.end_ - unit.dies_, sections.big_endian_);
+    Abbrev const* abbrev = abbrevs.find(reader.uleb128());
+    if (abbrev == nullptr || !reader.ok())
+    {
+        return false;
+    }
+    unit.tag_ = abbrev->tag_;
+
+    // The bases can come after the attributes that need them, so hold on to
+    // those until the end.
+    struct Deferred
+    {
+        dw_form_t     form_ = 0;
+        std::uint64_t value_ = 0;
+    };
+    Deferred name, comp_dir, low_pc, high_pc;
+    AbbrevAttribute const* attributes = abbrevs.attributes(*abbrev);
+    for (std::uint32_t a = 0; a < abbrev->attribute_count_; ++a)
+    {
+        AbbrevAttribute const& attribute = attributes[a];
+        auto defer = [&](Deferred& deferred) {
+            deferred.form_ = attribute.form_;
+            deferred.value_ = read_attribute_value(reader, attribute, unit.format_);
+        };
+        switch (attribute.name_)
+        {
+        case DW_AT_name:
+        case DW_AT_comp_dir:
+            if (attribute.form_ == DW_FORM_string)
+            {
+                (attribute.name_ == DW_AT_name ? unit.name_ : unit.comp_dir_) = reader.cstring();
+            }
+            else
+            {
+                defer(attribute.name_ == DW_AT_name ? name : comp_dir);
+            }
+            break;
+        case DW_AT_low_pc:
+            defer(low_pc);
+            break;
+        case DW_AT_high_pc:
+            defer(high_pc);
+            break;
+        case DW_AT_ranges:
+            unit.ranges_form_ = attribute.form_;
+            unit.ranges_ = read_attribute_value(reader, attribute, unit.format_);
+            break;
+        case DW_AT_stmt_list:
+            unit.stmt_list_ = read_attribute_value(reader, attribute, unit.format_);
+            break;
+        case DW_AT_str_offsets_base:
+            unit.str_offsets_base_ = read_attribute_value(reader, attribute, unit.format_);
+            break;
+        case DW_AT_addr_base:
+        case DW_AT_GNU_addr_base:
+            unit.addr_base_ = read_attribute_value(reader, attribute, unit.format_);
+            break;
+        case DW_AT_rnglists_base:
+            unit.rnglists_base_ = read_attribute_value(reader, attribute, unit.format_);
+            break;
+        default:
+            if (attribute.size_ >= 0)
+            {
+                reader.skip(attribute.size_);
+            }
+            else
+            {
+                reader.skip_form(attribute.form_, unit.format_);
+            }
+            break;
+        }
+    }
+    if (!reader.ok())
+    {
+        return false;
+    }
+
+    if (name.form_)
+    {
+        unit.name_ = unit_string(sections, unit, name.form_, name.value_);
+    }
+    if (comp_dir.form_)
+    {
+        unit.comp_dir_ = unit_string(sections, unit, comp_dir.form_, comp_dir.value_);
+    }
+    if (low_pc.form_)
+    {
+        unit.low_pc_ = unit_address(sections, unit, low_pc.form_, low_pc.value_);
+    }
+    if (high_pc.form_)
+    {
+        unit.high_pc_ = is_address_form(high_pc.form_) ? unit_address(sections, unit, high_pc.form_, high_pc.value_)
+                                                       : unit.low_pc_ + high_pc.value_;
+    }
+    return true;
+}
+
+
+std::string_view
+unit_string(DwarfSections const& sections, DwarfUnit const& unit, dw_form_t form, std::uint64_t value)
+{
+    switch (form)
+    {
+    case DW_FORM_strp:
+        return dwarf_string(sections.str_, value);
+    case DW_FORM_line_strp:
+        return dwarf_string(sections.line_str_, value);
+    case DW_FORM_strx:
+    case DW_FORM_strx1:
+    case DW_FORM_strx2:
+    case DW_FORM_strx3:
+    case DW_FORM_strx4:
+    case DW_FORM_GNU_str_index:
+    {
+        std::uint64_t base = unit.str_offsets_base_ ? unit.str_offsets_base_ : default_base(unit.format_);
+        DwarfReader reader(sections.str_offsets_, sections.big_endian_);
+        reader.seek(base + value * unit.format_.offset_size_);
+        std::uint64_t offset = reader.offset(unit.format_);
+        return reader.ok() ? dwarf_string(sections.str_, offset) : std::string_view{};
+    }
+    default:
+        // Strings in a supplementary or alternate file are out of reach.
+        return {};
+    }
+}
+
+
+std::uint64_t
+unit_address(DwarfSections const& sections, DwarfUnit const& unit, dw_form_t form, std::uint64_t value)
+{
+    if (form == DW_FORM_addr)
+    {
+        return value;
+    }
+    std::uint64_t base = unit.addr_base_ ? unit.addr_base_ : default_base(unit.format_);
+    DwarfReader reader(sections.addr_, sections.big_endian_);
+    reader.seek(base + value * unit.format_.address_size_);
+    return reader.address(unit.format_);
+}
+
+
+bool
+read_ranges(DwarfSections const& sections, DwarfUnit const& unit, std::uint64_t value, dw_form_t form,
+            std::vector<AddressRange>& ranges)
+{
+    std::uint64_t offset = value;
+    if (form == DW_FORM_rnglistx)
+    {
+        // Without a base, the offsets follow the header of the unit's contribution.
+        std::uint64_t base = unit.rnglists_base_ ? unit.rnglists_base_ : (unit.format_.offset_size_ == 8 ? 20 : 12);
+        DwarfReader reader(sections.rnglists_, sections.big_endian_);
+        reader.seek(base + value * unit.format_.offset_size_);
+        offset = base + reader.offset(unit.format_);
+        if (!reader.ok())
+        {
+            return false;
+        }
+    }
+    if (unit.format_.version_ >= 5)
+    {
+        return read_rnglist(sections, unit, offset, ranges);
+    }
+    return read_range_list(sections, unit, offset, ranges);
+}
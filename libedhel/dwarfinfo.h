@@ -0,0 +1,202 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef EDHELIND_DWARFINFO_H
+#define EDHELIND_DWARFINFO_H
+
+#include <cstddef>
+#include <cstdint>
+#include "libedhel/dwarf.h"
+#include "libedhel/parseerror.h"
+#include <string_view>
+#include <vector>
+
+
+/**
+ * A unit of .debug_info: where it is, how it's encoded, and the attributes of
+ * its unit DIE that the rest of it depends on.
+ */
+struct DwarfUnit
+{
+    static constexpr std::uint64_t None = ~std::uint64_t(0);
+
+    std::uint64_t    offset_ = 0;           /**< of the unit header in .debug_info */
+    std::uint64_t    end_ = 0;              /**< offset of the next unit */
+    std::uint64_t    dies_ = 0;             /**< offset of the unit DIE */
+    std::uint64_t    abbrev_offset_ = 0;    /**< of its abbreviations in .debug_abbrev */
+    DwarfFormat      format_;
+    std::uint8_t     unit_type_ = DW_UT_compile;
+
+    // From the unit DIE, once read_unit_die() has read it
+    dw_tag_t         tag_ = 0;
+    std::string_view name_;
+    std::string_view comp_dir_;
+    std::uint64_t    low_pc_ = 0;           /**< the base address of its range lists */
+    std::uint64_t    high_pc_ = 0;          /**< 0 if it doesn't say */
+    std::uint64_t    ranges_ = None;        /**< DW_AT_ranges, as the value of ranges_form_ */
+    dw_form_t        ranges_form_ = 0;
+    std::uint64_t    stmt_list_ = None;     /**< offset of its line number program in .debug_line */
+    std::uint64_t    str_offsets_base_ = 0;
+    std::uint64_t    addr_base_ = 0;
+    std::uint64_t    rnglists_base_ = 0;
+};
+
+
+/**
+ * Read the headers of the units in .debug_info.
+ *
+ * Reading stops at the first header that can't be read, or whose version
+ * isn't 2 to 5, putting what went wrong in @p error.  Type units are left
+ * out, since they describe no code.
+ */
+std::vector<DwarfUnit>
+read_units(DwarfSections const& sections, ParseError& error);
+
+
+/** An attribute specification of an abbreviation */
+struct AbbrevAttribute
+{
+    dw_at_t      name_;
+    dw_form_t    form_;
+    std::int16_t size_;             /**< the size of each value, if it's fixed (see form_size()), or -1 */
+    std::int64_t implicit_const_;   /**< the value of a DW_FORM_implicit_const attribute */
+};
+
+
+/** An abbreviation: the shape of the DIEs that use its code */
+struct Abbrev
+{
+    std::uint64_t code_ = 0;
+    dw_tag_t      tag_ = 0;
+    bool          has_children_ = false;
+    std::uint32_t first_attribute_ = 0;
+    std::uint32_t attribute_count_ = 0;
+    std::int32_t  fixed_size_ = -1;  /**< the size of all the attribute values, if they're fixed, or -1 */
+};
+
+
+/**
+ * The abbreviations of a unit, with the sizes of their attribute values
+ * worked out for the unit's format, so that the attributes a reader doesn't
+ * want (and whole DIEs, often) can be skipped without reading them.
+ */
+class AbbrevTable
+{
+public:
+    AbbrevTable() = default;
+
+    /**
+     * Read the abbreviations at @p offset in .debug_abbrev for a unit of
+     * @p format.
+     *
+     * @returns false if they run past the end of the section
+     */
+    bool
+    read(DwarfSections const& sections, std::uint64_t offset, DwarfFormat const& format);
+
+    /** The abbreviation with code @p code, or null if there isn't one */
+    Abbrev const*
+    find(std::uint64_t code) const
+    {
+        if (dense_)
+        {
+            return code - 1 < abbrevs_.size() ? &abbrevs_[code - 1] : nullptr;
+        }
+        return find_sparse(code);
+    }
+
+    /** The attribute specifications of @p abbrev */
+    AbbrevAttribute const*
+    attributes(Abbrev const& abbrev) const
+    { return attributes_.data() + abbrev.first_attribute_; }
+
+private:
+    Abbrev const*
+    find_sparse(std::uint64_t code) const;
+
+private:
+    std::vector<Abbrev>          abbrevs_;      /**< in code order */
+    std::vector<AbbrevAttribute> attributes_;
+    bool                         dense_ = true; /**< whether codes run 1, 2, 3... so a code is an index */
+};
+
+
+/**
+ * Read a value of @p attribute from @p reader; or for a DW_FORM_implicit_const
+ * attribute, whose value is in the abbreviation, don't.
+ */
+inline std::uint64_t
+read_attribute_value(DwarfReader& reader, AbbrevAttribute const& attribute, DwarfFormat const& format)
+{
+    if (attribute.form_ == DW_FORM_implicit_const)
+    {
+        return static_cast<std::uint64_t>(attribute.implicit_const_);
+    }
+    return reader.form_value(attribute.form_, format);
+}
+
+
+/**
+ * Read the unit DIE of @p unit, filling in its attributes.
+ *
+ * @returns false if the DIE can't be read
+ */
+bool
+read_unit_die(DwarfSections const& sections, AbbrevTable const& abbrevs, DwarfUnit& unit);
+
+
+/**
+ * The string an attribute value @p value of @p form refers to: an offset
+ * into .debug_str or .debug_line_str, or an index into the unit's string
+ * offsets.
+ */
+std::string_view
+unit_string(DwarfSections const& sections, DwarfUnit const& unit, dw_form_t form, std::uint64_t value);
+
+
+/**
+ * The address an attribute value @p value of @p form is: the value itself,
+ * or for the indexed forms the address it indexes in .debug_addr.
+ */
+std::uint64_t
+unit_address(DwarfSections const& sections, DwarfUnit const& unit, dw_form_t form, std::uint64_t value);
+
+
+/** Read a string attribute value of @p form from @p reader */
+inline std::string_view
+read_string_attribute(DwarfSections const& sections, DwarfUnit const& unit, DwarfReader& reader, dw_form_t form)
+{
+    if (form == DW_FORM_string)
+    {
+        return reader.cstring();
+    }
+    return unit_string(sections, unit, form, reader.form_value(form, unit.format_));
+}
+
+
+/**
+ * Append the address ranges of the DW_AT_ranges attribute value @p value of
+ * @p form to @p ranges, leaving out empty and discarded ranges.
+ *
+ * @returns false if the range list can't be read
+ */
+bool
+read_ranges(DwarfSections const& sections, DwarfUnit const& unit, std::uint64_t value, dw_form_t form,
+            std::vector<AddressRange>& ranges);
+
+#endif /* EDHELIND_DWARFINFO_H */
@@ -0,0 +1,586 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "libedhel/dwarfline.h"
+
+#include <algorithm>
+#include <atomic>
+#include "libedhel/dwarf.h"
+#include "libedhel/elffile.h"
+#include "libedhel/threadpool.h"
+#include "libedhel/trace.h"
+#include <numeric>
+#include <utility>
+
+
+namespace
+{
+    /** The fields of a line number program header that drive the program */
+    struct LineHeader
+    {
+        DwarfFormat               format_;
+        std::uint8_t              minimum_instruction_length_ = 1;
+        std::uint8_t              maximum_operations_per_instruction_ = 1;
+        bool                      default_is_stmt_ = true;
+        std::int8_t               line_base_ = 0;
+        std::uint8_t              line_range_ = 1;
+        std::uint8_t              opcode_base_ = 1;
+        std::vector<std::uint8_t> standard_opcode_lengths_;
+    };
+
+    /** A string in one of the forms a DWARF 5 header entry can use */
+    std::string_view
+    read_string(DwarfReader& reader, dw_form_t form, DwarfFormat const& format, DwarfSections const& sections)
+    {
+        switch (form)
+        {
+        case DW_FORM_string:
+            return reader.cstring();
+        case DW_FORM_line_strp:
+            return dwarf_string(sections.line_str_, reader.offset(format));
+        case DW_FORM_strp:
+            return dwarf_string(sections.str_, reader.offset(format));
+        default:
+            // Indexed strings need the unit's .debug_str_offsets base, which
+            // only .debug_info knows.
+            reader.skip_form(form, format);
+            return {};
+        }
+    }
+
+    /** Read a DWARF 5 directory or file name table into @p entries */
+    void
+    read_entries(DwarfReader& reader, DwarfFormat const& format, DwarfSections const& sections,
+                 std::vector<LineFile>& entries)
+    {
+        std::uint8_t format_count = reader.u8();
+        std::vector<std::pair<std::uint64_t, dw_form_t>> entry_format(format_count);
+        for (auto& [content_type, form]: entry_format)
+        {
+            content_type = reader.uleb128();
+            form = static_cast<dw_form_t>(reader.uleb128());
+        }
+
+        std::uint64_t count = reader.uleb128();
+        for (std::uint64_t i = 0; i < count && reader.ok(); ++i)
+        {
+            LineFile entry;
+            for (auto const& [content_type, form]: entry_format)
+            {
+                switch (content_type)
+                {
+                case DW_LNCT_path:
+                    entry.name_ = read_string(reader, form, format, sections);
+                    break;
+                case DW_LNCT_directory_index:
+                    entry.directory_ = static_cast<std::uint32_t>(reader.form_value(form, format));
+                    break;
+                default:
+                    reader.skip_form(form, format);
+                    break;
+                }
+            }
+            entries.push_back(entry);
+        }
+    }
+
+    /** Read the header of the program in @p unit, leaving @p unit at the program */
+    bool
+    read_header(DwarfReader& unit, DwarfSections const& sections, LineHeader& header, LineTable& table)
+    {
+        DwarfFormat& format = header.format_;
+        table.version_ = format.version_ = unit.u16();
+        if (table.version_ < 2 || table.version_ > 5)
+        {
+            table.error_.code_ = ParseErrc::BadDwarfVersion;
+            return false;
+        }
+        format.address_size_ = sections.address_size_;
+        if (table.version_ >= 5)
+        {
+            format.address_size_ = unit.u8();
+            unit.u8();      // segment_selector_size
+        }
+
+        DwarfReader reader = unit.split(unit.offset(format));
+        header.minimum_instruction_length_ = reader.u8();
+        if (table.version_ >= 4)
+        {
+            header.maximum_operations_per_instruction_ = std::max<std::uint8_t>(reader.u8(), 1);
+        }
+        header.default_is_stmt_ = reader.u8() != 0;
+        header.line_base_ = static_cast<std::int8_t>(reader.u8());
+        header.line_range_ = reader.u8();
+        header.opcode_base_ = reader.u8();
+        if (header.line_range_ == 0 || header.opcode_base_ == 0)
+        {
+            table.error_.code_ = ParseErrc::BadDwarf;
+            return false;
+        }
+        header.standard_opcode_lengths_.resize(header.opcode_base_);
+        for (std::uint8_t opcode = 1; opcode < header.opcode_base_; ++opcode)
+        {
+            header.standard_opcode_lengths_[opcode] = reader.u8();
+        }
+
+        if (table.version_ >= 5)
+        {
+            std::vector<LineFile> directories;
+            read_entries(reader, format, sections, directories);
+            for (auto const& directory: directories)
+            {
+                table.directories_.push_back(directory.name_);
+            }
+            read_entries(reader, format, sections, table.files_);
+        }
+        else
+        {
+            table.directories_.emplace_back();
+            for (auto directory = reader.cstring(); !directory.empty(); directory = reader.cstring())
+            {
+                table.directories_.push_back(directory);
+            }
+            table.files_.emplace_back();
+            for (auto name = reader.cstring(); !name.empty(); name = reader.cstring())
+            {
+                LineFile file{name, static_cast<std::uint32_t>(reader.uleb128())};
+                reader.uleb128();   // modification time
+                reader.uleb128();   // length
+                table.files_.push_back(file);
+            }
+        }
+
+        if (!reader.ok() || !unit.ok())
+        {
+            table.error_.code_ = ParseErrc::DwarfOutOfBounds;
+            return false;
+        }
+        return true;
+    }
+
+    /** The line number state machine registers */
+    struct LineState
+    {
+        std::uint64_t address_ = 0;
+        std::uint64_t op_index_ = 0;
+        std::uint32_t file_ = 1;
+        std::uint32_t line_ = 1;
+        std::uint64_t column_ = 0;
+        bool          is_stmt_;
+
+        explicit LineState(bool default_is_stmt)
+        : is_stmt_(default_is_stmt)
+        { }
+    };
+
+    /** Run the line number program in @p program, appending its rows to @p table */
+    void
+    run_program(DwarfReader& program, LineHeader const& header, LineTable& table)
+    {
+        LineState state(header.default_is_stmt_);
+        auto emit = [&table, &state](std::uint8_t flags) {
+            table.rows_.push_back(LineRow{
+                state.address_,
+                state.file_,
+                state.line_,
+                static_cast<std::uint16_t>(std::min<std::uint64_t>(state.column_, 0xffff)),
+                static_cast<std::uint8_t>(flags | (state.is_stmt_ ? LineRow::IsStmt : 0))
+            });
+        };
+        auto advance = [&header, &state](std::uint64_t operation_advance) {
+            if (header.maximum_operations_per_instruction_ == 1)
+            {
+                state.address_ += header.minimum_instruction_length_ * operation_advance;
+                return;
+            }
+            std::uint64_t op = state.op_index_ + operation_advance;
+            state.address_ += header.minimum_instruction_length_ * (op / header.maximum_operations_per_instruction_);
+            state.op_index_ = op % header.maximum_operations_per_instruction_;
+        };
+
+        while (!program.at_end())
+        {
+            std::uint8_t opcode = program.u8();
+            if (opcode >= header.opcode_base_)
+            {
+                std::uint8_t adjusted = opcode - header.opcode_base_;
+                advance(adjusted / header.line_range_);
+                state.line_ += header.line_base_ + adjusted % header.line_range_;
+                emit(0);
+                continue;
+            }
+
+            switch (opcode)
+            {
+            case 0:
+            {
+                DwarfReader extended = program.split(program.uleb128());
+                switch (extended.u8())
+                {
+                case DW_LNE_end_sequence:
+                    emit(LineRow::EndSequence);
+                    state = LineState(header.default_is_stmt_);
+                    break;
+                case DW_LNE_set_address:
+                    state.address_ = extended.sized(static_cast<std::uint8_t>(extended.remaining()));
+                    state.op_index_ = 0;
+                    break;
+                case DW_LNE_define_file:
+                {
+                    LineFile file{extended.cstring(), static_cast<std::uint32_t>(extended.uleb128())};
+                    table.files_.push_back(file);
+                    break;
+                }
+                default:
+                    // DW_LNE_set_discriminator and vendor extensions
+                    break;
+                }
+                break;
+            }
+            case DW_LNS_copy:
+                emit(0);
+                break;
+            case DW_LNS_advance_pc:
+                advance(program.uleb128());
+                break;
+            case DW_LNS_advance_line:
+                state.line_ = static_cast<std::uint32_t>(state.line_ + program.sleb128());
+                break;
+            case DW_LNS_set_file:
+                state.file_ = static_cast<std::uint32_t>(program.uleb128());
+                break;
+            case DW_LNS_set_column:
+                state.column_ = program.uleb128();
+                break;
+            case DW_LNS_negate_stmt:
+                state.is_stmt_ = !state.is_stmt_;
+                break;
+            case DW_LNS_set_basic_block:
+            case DW_LNS_set_prologue_end:
+            case DW_LNS_set_epilogue_begin:
+                break;
+            case DW_LNS_const_add_pc:
+                advance((255 - header.opcode_base_) / header.line_range_);
+                break;
+            case DW_LNS_fixed_advance_pc:
+                state.address_ += program.u16();
+                state.op_index_ = 0;
+                break;
+            default:
+                // DW_LNS_set_isa, and any opcodes newer than this decoder
+                for (std::uint8_t i = 0; i < header.standard_opcode_lengths_[opcode]; ++i)
+                {
+                    program.uleb128();
+                }
+                break;
+            }
+        }
+
+        if (!program.ok())
+        {
+            table.error_.code_ = ParseErrc::DwarfOutOfBounds;
+        }
+    }
+
+    /**
+     * Put the sequences of @p table in address order.  Within a sequence
+     * addresses only go up, but compilers and linkers put the sequences of a
+     * unit in any order they like.  Rows after the last complete sequence are
+     * dropped.
+     */
+    void
+    sort_sequences(LineTable& table)
+    {
+        std::vector<std::pair<std::size_t, std::size_t>> sequences;
+        std::size_t first = 0;
+        bool sorted = true;
+        for (std::size_t r = 0; r < table.rows_.size(); ++r)
+        {
+            if (table.rows_[r].flags_ & LineRow::EndSequence)
+            {
+                if (!sequences.empty() && table.rows_[first].address_ < table.rows_[sequences.back().first].address_)
+                {
+                    sorted = false;
+                }
+                sequences.emplace_back(first, r + 1);
+                first = r + 1;
+            }
+        }
+        table.rows_.resize(first);
+        if (sorted)
+        {
+            return;
+        }
+
+        std::stable_sort(sequences.begin(), sequences.end(), [&table](auto const& lhs, auto const& rhs) {
+            return table.rows_[lhs.first].address_ < table.rows_[rhs.first].address_;
+        });
+        std::vector<LineRow> rows;
+        rows.reserve(table.rows_.size());
+        for (auto const& [begin, end]: sequences)
+        {
+            rows.insert(rows.end(), table.rows_.begin() + begin, table.rows_.begin() + end);
+        }
+        table.rows_.swap(rows);
+    }
+
+    /** Decode the line number program at @p offset in .debug_line into @p table */
+    void
+    decode_program(DwarfSections const& sections, std::uint64_t offset, LineTable& table)
+    {
+        table.offset_ = offset;
+        table.error_.offset_ = sections.line_.offset_ + offset;
+
+        DwarfReader reader(sections.line_, sections.big_endian_);
+        reader.seek(offset);
+        DwarfFormat format;
+        DwarfReader unit = reader.split(reader.initial_length(format));
+        if (!reader.ok())
+        {
+            table.error_.code_ = ParseErrc::DwarfOutOfBounds;
+            return;
+        }
+
+        LineHeader header;
+        header.format_ = format;
+        if (read_header(unit, sections, header, table))
+        {
+            run_program(unit, header, table);
+        }
+        sort_sequences(table);
+    }
+} // anonymous namespace
+
+
+std::string LineTable::
+file_path(std::uint32_t file) const
+{
+    if (file >= files_.size())
+    {
+        return {};
+    }
+    std::string path(files_[file].name_);
+    auto is_absolute = [](std::string_view name) {
+        return !name.empty() && (name[0] == '/' || (name.size() > 1 && name[1] == ':'));
+    };
+    if (is_absolute(path))
+    {
+        return path;
+    }
+
+    std::uint32_t directory = files_[file].directory_;
+    if (directory < directories_.size() && !directories_[directory].empty())
+    {
+        path = std::string(directories_[directory]) + "/" + path;
+        if (directory != 0 && !is_absolute(directories_[directory]) && !directories_[0].empty())
+        {
+            path = std::string(directories_[0]) + "/" + path;
+        }
+    }
+    return path;
+}
+
+
+LineTable
+read_line_table(DwarfSections const& sections, std::uint64_t offset)
+{
+    LineTable table;
+    if (sections.line_.compressed_)
+    {
+        table.offset_ = offset;
+        table.error_ = ParseError{ParseErrc::CompressedSection, sections.line_.offset_};
+        return table;
+    }
+    decode_program(sections, offset, table);
+    return table;
+}
+
+
+LineIndex::
+LineIndex(ElfFile const& elf_file, unsigned concurrency)
+{
+    EDHEL_TRACE_ZONE("decode line tables");
+    DwarfSections sections = find_dwarf_sections(elf_file);
+    if (sections.line_.compressed_)
+    {
+        error_ = ParseError{ParseErrc::CompressedSection, sections.line_.offset_};
+        return;
+    }
+    if (!sections.line_)
+    {
+        return;
+    }
+
+    // Find where each unit starts, which only takes reading their lengths.
+    std::vector<std::uint64_t> offsets;
+    DwarfReader reader(sections.line_, sections.big_endian_);
+    while (!reader.at_end())
+    {
+        offsets.push_back(reader.offset());
+        DwarfFormat format;
+        reader.skip(reader.initial_length(format));
+    }
+
+    tables_.resize(offsets.size());
+    concurrency = concurrency ? concurrency : ThreadPool::shared().worker_count() + 1;
+    std::size_t task_count = std::min<std::size_t>(concurrency, offsets.size());
+    if (task_count <= 1)
+    {
+        for (std::size_t t = 0; t < offsets.size(); ++t)
+        {
+            decode_program(sections, offsets[t], tables_[t]);
+        }
+    }
+    else
+    {
+        // Units vary a lot in size, so each task takes the next one left.
+        std::atomic<std::size_t> next{0};
+        TaskGroup group;
+        auto work = [&]() {
+            for (std::size_t t = next++; t < offsets.size() && !group.is_cancelled(); t = next++)
+            {
+                decode_program(sections, offsets[t], tables_[t]);
+            }
+        };
+        for (std::size_t t = 0; t < task_count; ++t)
+        {
+            group.run(work);
+        }
+        group.wait();
+    }
+
+    // Linkers leave the sequences of code they threw away in place, but
+    // relocated to a tombstone.
+    for (std::uint32_t t = 0; t < tables_.size(); ++t)
+    {
+        auto const& rows = tables_[t].rows_;
+        std::uint32_t first = 0;
+        for (std::uint32_t r = 0; r < rows.size(); ++r)
+        {
+            if (rows[r].flags_ & LineRow::EndSequence)
+            {
+                if (rows[r].address_ > rows[first].address_ && !sections.discarded(rows[first].address_))
+                {
+                    sequences_.push_back(Sequence{rows[first].address_, rows[r].address_, t, first, r});
+                }
+                first = r + 1;
+            }
+        }
+    }
+    std::sort(sequences_.begin(), sequences_.end(), [](Sequence const& lhs, Sequence const& rhs) {
+        return lhs.low_ < rhs.low_;
+    });
+    reach_.resize(sequences_.size());
+    std::uint64_t reach = 0;
+    for (std::size_t s = 0; s < sequences_.size(); ++s)
+    {
+        reach = std::max(reach, sequences_[s].high_);
+        reach_[s] = reach;
+    }
+}
+
+
+std::vector<LineTable> const& LineIndex::
+tables() const
+{
+    return tables_;
+}
+
+
+ParseError const& LineIndex::
+error() const
+{
+    return error_;
+}
+
+
+std::size_t LineIndex::
+row_count() const
+{
+    return std::accumulate(tables_.begin(), tables_.end(), std::size_t(0), [](std::size_t sum, LineTable const& table) {
+        return sum + table.rows_.size();
+    });
+}
+
+
+LineLocation LineIndex::
+lookup_from(std::uint64_t address, std::size_t& hint) const
+{
+    // Sorted lookups mostly move a little way on from the last one, so gallop
+    // out from the hint before bisecting.
+    std::size_t low = hint;
+    std::size_t high = sequences_.size();
+    if (hint != 0)
+    {
+        std::size_t step = 1;
+        while (low + step < sequences_.size() && sequences_[low + step].low_ <= address)
+        {
+            low += step;
+            step *= 2;
+        }
+        high = std::min(low + step, sequences_.size());
+    }
+    auto after = std::upper_bound(sequences_.begin() + low, sequences_.begin() + high, address,
+                                  [](std::uint64_t a, Sequence const& sequence) { return a < sequence.low_; });
+    hint = after - sequences_.begin();
+
+    // Sequences can overlap, so the one that covers the address isn't always
+    // the last to start before it; but none can before reach_ drops to it.
+    for (std::size_t s = hint; s-- > 0 && reach_[s] > address; )
+    {
+        Sequence const& sequence = sequences_[s];
+        if (address >= sequence.high_)
+        {
+            continue;
+        }
+        LineTable const& table = tables_[sequence.table_];
+        auto first = table.rows_.begin() + sequence.first_row_;
+        auto last = table.rows_.begin() + sequence.last_row_;
+        auto row = std::upper_bound(first, last, address, [](std::uint64_t a, LineRow const& r) {
+            return a < r.address_;
+        }) - 1;
+        return LineLocation{&table, row->file_, row->line_, row->column_};
+    }
+    return LineLocation{};
+}
+
+
+LineLocation LineIndex::
+lookup(std::uint64_t address) const
+{
+    std::size_t hint = 0;
+    return lookup_from(address, hint);
+}
+
+
+void LineIndex::
+lookup(std::uint64_t const* addresses, std::size_t count, LineLocation* locations) const
+{
+    std::vector<std::pair<std::uint64_t, std::size_t>> order(count);
+    for (std::size_t i = 0; i < count; ++i)
+    {
+        order[i] = {addresses[i], i};
+    }
+    std::sort(order.begin(), order.end());
+
+    std::size_t hint = 0;
+    for (auto const& [address, i]: order)
+    {
+        locations[i] = lookup_from(address, hint);
+    }
+}
@@ -0,0 +1,180 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef EDHELIND_DWARFLINE_H
+#define EDHELIND_DWARFLINE_H
+
+#include <cstddef>
+#include <cstdint>
+#include "libedhel/parseerror.h"
+#include <string>
+#include <string_view>
+#include <vector>
+
+class ElfFile;
+struct DwarfSections;
+
+
+/**
+ * One row of a line number table: the source position of the instructions
+ * from @c address_ up to the address of the next row.
+ */
+struct LineRow
+{
+    static constexpr std::uint8_t IsStmt      = 0x01;  /**< a recommended breakpoint location */
+    static constexpr std::uint8_t EndSequence = 0x02;  /**< the first address past a sequence */
+
+    std::uint64_t address_;
+    std::uint32_t file_;        /**< index into LineTable::files_ */
+    std::uint32_t line_;
+    std::uint16_t column_;      /**< 0 if unknown, and clamped to 65535 */
+    std::uint8_t  flags_;
+};
+
+
+/** A source file named in a line number program header */
+struct LineFile
+{
+    std::string_view name_;
+    std::uint32_t    directory_ = 0;    /**< index into LineTable::directories_ */
+};
+
+
+/**
+ * The decoded line number program of one compilation unit.
+ *
+ * Directories and files are numbered the DWARF 5 way whatever the version of
+ * the program, so that a row's file and a file's directory index them
+ * directly: entry 0 of each is the compilation directory and primary source
+ * file, which earlier versions leave out (and leave empty here).  Names point
+ * into the image of the ElfFile and are valid for as long as it is.
+ */
+struct LineTable
+{
+    std::uint64_t                 offset_ = 0;      /**< of the program in .debug_line */
+    std::uint16_t                 version_ = 0;
+    std::vector<std::string_view> directories_;
+    std::vector<LineFile>         files_;
+    std::vector<LineRow>          rows_;            /**< sequences in address order, each ending in an EndSequence row */
+    ParseError                    error_;           /**< why decoding stopped short, if it did */
+
+    /** The path of file @p file, joined to its directory if it's relative */
+    std::string
+    file_path(std::uint32_t file) const;
+};
+
+
+/** Where an address is in the source */
+struct LineLocation
+{
+    LineTable const* table_ = nullptr;  /**< null if no line table covers the address */
+    std::uint32_t    file_ = 0;         /**< index into table_->files_ */
+    std::uint32_t    line_ = 0;
+    std::uint16_t    column_ = 0;
+
+    /** Whether the address was found at all */
+    explicit operator bool() const
+    { return table_ != nullptr; }
+};
+
+
+/**
+ * Decode just the line number program at @p offset in .debug_line, such as
+ * the DW_AT_stmt_list of a unit, without the rest of the section.  Any
+ * problem is in the table's LineTable::error_.
+ */
+LineTable
+read_line_table(DwarfSections const& sections, std::uint64_t offset);
+
+
+/**
+ * The line number information of an ELF file: every line number program in
+ * its .debug_line section decoded into a table, and the tables indexed by
+ * address.
+ *
+ * Programs of DWARF versions 2 to 5 are understood, including the entry
+ * formats of DWARF 5 headers and names in .debug_line_str.  Compressed debug
+ * sections are not.  The sequences of code a linker discarded stay in their
+ * tables, but are left out of the index.
+ */
+class LineIndex
+{
+public:
+    LineIndex() = default;
+
+    /**
+     * Decode the line number programs of @p elf_file, spread over up to
+     * @p concurrency threads of the shared ThreadPool (0 for all of them).
+     *
+     * A program that can't be decoded keeps the rows decoded before the
+     * problem, and says what the problem was in its LineTable::error_.
+     */
+    explicit LineIndex(ElfFile const& elf_file, unsigned concurrency = 1);
+
+    LineIndex(LineIndex&&) = default;
+    LineIndex& operator=(LineIndex&&) = default;
+
+    /** The line table of each compilation unit, in .debug_line order */
+    std::vector<LineTable> const&
+    tables() const;
+
+    /** Why there are no tables at all, if there's a reason other than there being no .debug_line */
+    ParseError const&
+    error() const;
+
+    /** The total number of rows in all the tables */
+    std::size_t
+    row_count() const;
+
+    /** Find the source position of the instruction at @p address */
+    LineLocation
+    lookup(std::uint64_t address) const;
+
+    /**
+     * Find the source positions of the @p count instructions at @p addresses,
+     * in any order, putting each in the same place in @p locations.
+     *
+     * This sorts the addresses and sweeps through the index once, so it is
+     * much quicker than looking them up one at a time for a big batch.
+     */
+    void
+    lookup(std::uint64_t const* addresses, std::size_t count, LineLocation* locations) const;
+
+private:
+    /** The rows of one sequence of a table */
+    struct Sequence
+    {
+        std::uint64_t low_;
+        std::uint64_t high_;        /**< the address of its EndSequence row */
+        std::uint32_t table_;
+        std::uint32_t first_row_;
+        std::uint32_t last_row_;    /**< the EndSequence row */
+    };
+
+    /** Find the source position of @p address, starting the search at sequence @p hint */
+    LineLocation
+    lookup_from(std::uint64_t address, std::size_t& hint) const;
+
+private:
+    std::vector<LineTable>     tables_;
+    std::vector<Sequence>      sequences_;  /**< sorted by low_ */
+    std::vector<std::uint64_t> reach_;      /**< the highest high_ of sequences_[0..i] */
+    ParseError                 error_;
+};
+
+#endif /* EDHELIND_DWARFLINE_H */
@@ -0,0 +1,585 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "libedhel/dwarfnames.h"
+
+#include <algorithm>
+#include "libedhel/dwarfinfo.h"
+#include "libedhel/elffile.h"
+#include "libedhel/trace.h"
+
+
+namespace
+{
+    std::uint32_t
+    fold_case(char c)
+    {
+        std::uint32_t u = static_cast<unsigned char>(c);
+        return u >= 'A' && u <= 'Z' ? u - 'A' + 'a' : u;
+    }
+
+    /**
+     * The hash of names in .debug_names: Bernstein's, of the case-folded
+     * name so that languages that ignore case can look names up too.  Only
+     * ASCII is folded here, so names that aren't ASCII are looked for
+     * without the hash.
+     */
+    std::uint32_t
+    names_hash(std::string_view name)
+    {
+        std::uint32_t hash = 5381;
+        for (char c: name)
+        {
+            hash = hash * 33 + fold_case(c);
+        }
+        return hash;
+    }
+
+    bool
+    is_ascii(std::string_view name)
+    {
+        return std::all_of(name.begin(), name.end(), [](char c) { return (c & 0x80) == 0; });
+    }
+
+    /** The hash of names in .gdb_index from version 5 on, which ignores ASCII case too */
+    std::uint32_t
+    gdb_index_hash(std::string_view name)
+    {
+        std::uint32_t hash = 0;
+        for (char c: name)
+        {
+            hash = hash * 67 + fold_case(c) - 113;
+        }
+        return hash;
+    }
+
+    /** The kinds of symbol a .gdb_index unit list entry can be (bits 28 to 30) */
+    constexpr std::uint32_t gdb_kind_variable = 2;
+    constexpr std::uint32_t gdb_kind_function = 3;
+
+    bool
+    precedes(NameEntry const& lhs, NameEntry const& rhs)
+    {
+        return lhs.unit_ < rhs.unit_ || (lhs.unit_ == rhs.unit_ && lhs.die_ < rhs.die_);
+    }
+
+    bool
+    same(NameEntry const& lhs, NameEntry const& rhs)
+    {
+        return lhs.unit_ == rhs.unit_ && lhs.die_ == rhs.die_;
+    }
+} // anonymous namespace
+
+
+NameIndex::
+NameIndex(ElfFile const& elf_file, unsigned concurrency)
+: elf_file_(&elf_file)
+, concurrency_(concurrency)
+, sections_(find_dwarf_sections(elf_file))
+{
+    EDHEL_TRACE_ZONE("index names");
+    if (sections_.names_.compressed_ || (sections_.names_ && sections_.str_.compressed_))
+    {
+        error_ = ParseError{ParseErrc::CompressedSection,
+                            sections_.names_.compressed_ ? sections_.names_.offset_ : sections_.str_.offset_};
+    }
+    else if (sections_.names_ && read_debug_names())
+    {
+        source_ = Source::DebugNames;
+    }
+    if (source_ == Source::None && sections_.gdb_index_.compressed_ && !error_)
+    {
+        error_ = ParseError{ParseErrc::CompressedSection, sections_.gdb_index_.offset_};
+    }
+    else if (source_ == Source::None && sections_.gdb_index_ && read_gdb_index())
+    {
+        source_ = Source::GdbIndex;
+    }
+
+    if (sections_.info_.compressed_ || sections_.abbrev_.compressed_)
+    {
+        if (!error_)
+        {
+            error_ = ParseError{ParseErrc::CompressedSection,
+                                sections_.info_.compressed_ ? sections_.info_.offset_ : sections_.abbrev_.offset_};
+        }
+        return;
+    }
+    if (!sections_.info_)
+    {
+        return;
+    }
+    ParseError unit_error;
+    std::vector<DwarfUnit> units = read_units(sections_, unit_error);
+    if (!error_)
+    {
+        error_ = unit_error;
+    }
+    std::vector<std::uint64_t> covered = units_;
+    std::sort(covered.begin(), covered.end());
+    for (DwarfUnit const& unit: units)
+    {
+        if (!std::binary_search(covered.begin(), covered.end(), unit.offset_))
+        {
+            uncovered_.push_back(unit.offset_);
+        }
+    }
+    if (source_ == Source::None && !uncovered_.empty())
+    {
+        source_ = Source::Functions;
+    }
+}
+
+
+bool NameIndex::
+read_debug_names()
+{
+    DwarfSection const& section = sections_.names_;
+    DwarfReader reader(section, sections_.big_endian_);
+    while (!reader.at_end())
+    {
+        std::uint64_t const table_offset = reader.offset();
+        NamesTable table{};
+        std::uint64_t const length = reader.initial_length(table.format_);
+        std::uint64_t const base = reader.offset();
+        DwarfReader header = reader.split(length);
+        if (!reader.ok())
+        {
+            error_ = ParseError{ParseErrc::DwarfOutOfBounds, section.offset_ + table_offset};
+            break;
+        }
+        table.format_.version_ = header.u16();
+        if (table.format_.version_ != 5)
+        {
+            error_ = ParseError{ParseErrc::BadDwarfVersion, section.offset_ + table_offset};
+            break;
+        }
+        header.u16();                   // padding
+        table.unit_count_ = header.u32();
+        table.type_unit_count_ = header.u32();
+        std::uint32_t const foreign_type_unit_count = header.u32();
+        table.bucket_count_ = header.u32();
+        table.name_count_ = header.u32();
+        std::uint32_t const abbrev_size = header.u32();
+        header.skip(header.u32());      // augmentation string
+
+        std::uint64_t const offset_size = table.format_.offset_size_;
+        table.first_unit_ = static_cast<std::uint32_t>(units_.size());
+        for (std::uint32_t i = 0; i < table.unit_count_ && header.ok(); ++i)
+        {
+            units_.push_back(header.offset(table.format_));
+        }
+        table.type_units_ = base + header.offset();
+        header.skip(table.type_unit_count_ * offset_size + foreign_type_unit_count * std::uint64_t(8));
+        table.buckets_ = base + header.offset();
+        header.skip(table.bucket_count_ * std::uint64_t(4));
+        table.hashes_ = base + header.offset();
+        header.skip(table.bucket_count_ != 0 ? table.name_count_ * std::uint64_t(4) : 0);
+        table.string_offsets_ = base + header.offset();
+        header.skip(table.name_count_ * offset_size);
+        table.entry_offsets_ = base + header.offset();
+        header.skip(table.name_count_ * offset_size);
+
+        DwarfReader abbrevs = header.split(abbrev_size);
+        table.first_abbrev_ = static_cast<std::uint32_t>(abbrevs_.size());
+        while (std::uint64_t const code = abbrevs.uleb128())
+        {
+            NamesAbbrev abbrev{code, static_cast<dw_tag_t>(abbrevs.uleb128()),
+                               static_cast<std::uint32_t>(attributes_.size()), 0};
+            for (;;)
+            {
+                auto const index = static_cast<dw_idx_t>(abbrevs.uleb128());
+                auto const form = static_cast<dw_form_t>(abbrevs.uleb128());
+                if ((index == 0 && form == 0) || !abbrevs.ok())
+                {
+                    break;
+                }
+                attributes_.push_back(NamesAttribute{index, form});
+                ++abbrev.attribute_count_;
+            }
+            abbrevs_.push_back(abbrev);
+        }
+        table.abbrev_count_ = static_cast<std::uint32_t>(abbrevs_.size()) - table.first_abbrev_;
+        table.entries_ = base + header.offset();
+        table.end_ = base + length;
+        if (!header.ok() || !abbrevs.ok())
+        {
+            units_.resize(table.first_unit_);
+            abbrevs_.resize(table.first_abbrev_);
+            error_ = ParseError{ParseErrc::DwarfOutOfBounds, section.offset_ + table_offset};
+            break;
+        }
+        tables_.push_back(table);
+    }
+
+    // A linked file has an index for each object, and looking in all of
+    // them would take longer the more there are.  One hash table of the names
+    // in all of them, bucketed by the top bits of their hashes, says which to
+    // look in.  It's laid out in two passes over the hashes, counting then
+    // placing, as sorting them would take longer than the rest put together.
+    if (tables_.size() > 1)
+    {
+        auto hashes = [&](NamesTable const& table) {
+            return DwarfReader(section.bytes_ + table.hashes_,
+                               table.bucket_count_ != 0 ? table.name_count_ * std::size_t(4) : 0,
+                               sections_.big_endian_);
+        };
+        std::uint64_t name_count = 0;
+        for (NamesTable const& table: tables_)
+        {
+            name_count += table.bucket_count_ != 0 ? table.name_count_ : 0;
+        }
+        hash_shift_ = 31;
+        while (hash_shift_ > 0 && (std::uint64_t(1) << (32 - hash_shift_)) < name_count)
+        {
+            --hash_shift_;
+        }
+
+        hash_buckets_.assign((std::size_t(1) << (32 - hash_shift_)) + 1, 0);
+        for (NamesTable const& table: tables_)
+        {
+            for (DwarfReader reader = hashes(table); !reader.at_end(); )
+            {
+                ++hash_buckets_[(reader.u32() >> hash_shift_) + 1];
+            }
+        }
+        for (std::size_t b = 1; b < hash_buckets_.size(); ++b)
+        {
+            hash_buckets_[b] += hash_buckets_[b - 1];
+        }
+        table_hashes_.resize(hash_buckets_.back());
+        std::vector<std::uint32_t> next(hash_buckets_.begin(), hash_buckets_.end() - 1);
+        for (std::uint32_t t = 0; t < tables_.size(); ++t)
+        {
+            for (DwarfReader reader = hashes(tables_[t]); !reader.at_end(); )
+            {
+                std::uint32_t const hash = reader.u32();
+                table_hashes_[next[hash >> hash_shift_]++] = std::uint64_t(hash) << 32 | t;
+            }
+        }
+    }
+    return !tables_.empty();
+}
+
+
+bool NameIndex::
+read_gdb_index()
+{
+    // Versions before 7 are obsolete, and GDB no longer reads them.
+    DwarfSection const& section = sections_.gdb_index_;
+    DwarfReader reader(section, false);
+    std::uint32_t const version = reader.u32();
+    std::uint32_t const units = reader.u32();
+    std::uint32_t const type_units = reader.u32();
+    reader.u32();                       // address area
+    std::uint32_t const symbols = reader.u32();
+    std::uint32_t const pool = reader.u32();
+    if (!reader.ok())
+    {
+        error_ = ParseError{ParseErrc::DwarfOutOfBounds, section.offset_};
+        return false;
+    }
+    if (version < 7 || version > 8)
+    {
+        error_ = ParseError{ParseErrc::BadDwarfVersion, section.offset_};
+        return false;
+    }
+    std::uint32_t const slot_count = (pool - symbols) / 8;
+    if (units > type_units || type_units > symbols || symbols > pool || pool > section.size_
+        || (slot_count & (slot_count - 1)) != 0)
+    {
+        error_ = ParseError{ParseErrc::BadDwarf, section.offset_};
+        return false;
+    }
+
+    reader.seek(units);
+    for (std::uint32_t i = 0; i < (type_units - units) / 16; ++i)
+    {
+        units_.push_back(reader.u64());
+        reader.u64();                   // length
+    }
+    gdb_symbols_ = symbols;
+    gdb_slot_count_ = slot_count;
+    gdb_pool_ = pool;
+    return true;
+}
+
+
+NameIndex::Source NameIndex::
+source() const
+{
+    return source_;
+}
+
+
+std::size_t NameIndex::
+fallback_count() const
+{
+    return uncovered_.size();
+}
+
+
+ParseError const& NameIndex::
+error() const
+{
+    return error_;
+}
+
+
+std::vector<NameEntry> NameIndex::
+lookup(std::string_view name) const
+{
+    std::vector<NameEntry> found;
+    if (source_ == Source::DebugNames && !hash_buckets_.empty() && is_ascii(name))
+    {
+        // Only the tables with a name of the same hash, and those without a
+        // hash table, need looking in.
+        // Each bucket is in table order.
+        std::uint32_t const hash = names_hash(name);
+        std::uint32_t const bucket = hash >> hash_shift_;
+        std::uint32_t last = ~std::uint32_t(0);
+        for (std::uint32_t i = hash_buckets_[bucket]; i < hash_buckets_[bucket + 1]; ++i)
+        {
+            std::uint32_t const t = static_cast<std::uint32_t>(table_hashes_[i]);
+            if ((table_hashes_[i] >> 32) == hash && t != last)
+            {
+                lookup_debug_names(tables_[t], name, found);
+                last = t;
+            }
+        }
+        for (NamesTable const& table: tables_)
+        {
+            if (table.bucket_count_ == 0)
+            {
+                lookup_debug_names(table, name, found);
+            }
+        }
+    }
+    else if (source_ == Source::DebugNames)
+    {
+        for (NamesTable const& table: tables_)
+        {
+            lookup_debug_names(table, name, found);
+        }
+    }
+    else if (source_ == Source::GdbIndex)
+    {
+        lookup_gdb_index(name, found);
+    }
+    if (!uncovered_.empty())
+    {
+        lookup_functions(name, found);
+    }
+
+    // A unit can be listed more than once for a name in .gdb_index, once for
+    // each kind of thing it defines by that name.
+    std::sort(found.begin(), found.end(), precedes);
+    found.erase(std::unique(found.begin(), found.end(), same), found.end());
+    return found;
+}
+
+
+void NameIndex::
+lookup_debug_names(NamesTable const& table, std::string_view name, std::vector<NameEntry>& found) const
+{
+    DwarfReader reader(sections_.names_, sections_.big_endian_);
+    std::uint8_t const offset_size = table.format_.offset_size_;
+    auto u32_at = [&reader](std::uint64_t offset) {
+        reader.seek(offset);
+        return reader.u32();
+    };
+    auto offset_at = [&reader, &table](std::uint64_t offset) {
+        reader.seek(offset);
+        return reader.offset(table.format_);
+    };
+    auto name_at = [&](std::uint32_t i) {
+        return dwarf_string(sections_.str_, offset_at(table.string_offsets_ + i * offset_size));
+    };
+
+    // Names are numbered from 1, and those in a bucket are together.
+    std::uint32_t const hash = names_hash(name);
+    bool const hashed = table.bucket_count_ != 0 && is_ascii(name);
+    std::uint32_t first = 1;
+    std::uint32_t last = table.name_count_;
+    if (hashed)
+    {
+        std::uint32_t const bucket = hash % table.bucket_count_;
+        first = u32_at(table.buckets_ + bucket * std::uint64_t(4));
+        last = first == 0 ? 0 : table.name_count_;
+    }
+    std::uint32_t match = 0;
+    for (std::uint32_t i = first; i != 0 && i <= last && match == 0; ++i)
+    {
+        if (hashed)
+        {
+            std::uint32_t const name_hash = u32_at(table.hashes_ + (i - 1) * std::uint64_t(4));
+            if (name_hash % table.bucket_count_ != hash % table.bucket_count_)
+            {
+                break;
+            }
+            if (name_hash != hash)
+            {
+                continue;
+            }
+        }
+        if (name_at(i - 1) == name)
+        {
+            match = i;
+        }
+    }
+    if (match == 0 || !reader.ok())
+    {
+        return;
+    }
+
+    DwarfReader entries(sections_.names_.bytes_ + table.entries_, table.end_ - table.entries_, sections_.big_endian_);
+    entries.seek(offset_at(table.entry_offsets_ + (match - 1) * offset_size));
+    NamesAbbrev const* const abbrevs = abbrevs_.data() + table.first_abbrev_;
+    while (std::uint64_t const code = entries.uleb128())
+    {
+        NamesAbbrev const* abbrev = std::find_if(abbrevs, abbrevs + table.abbrev_count_, [code](NamesAbbrev const& a) {
+            return a.code_ == code;
+        });
+        if (abbrev == abbrevs + table.abbrev_count_)
+        {
+            return;
+        }
+
+        // Without a unit, the entry is in the only one there is.
+        std::uint64_t unit = 0;
+        std::uint64_t type_unit = DwarfUnit::None;
+        std::uint64_t die = DwarfUnit::None;
+        for (std::uint32_t a = 0; a < abbrev->attribute_count_; ++a)
+        {
+            NamesAttribute const& attribute = attributes_[abbrev->first_attribute_ + a];
+            std::uint64_t const value = entries.form_value(attribute.form_, table.format_);
+            switch (attribute.index_)
+            {
+            case DW_IDX_compile_unit: unit = value; break;
+            case DW_IDX_type_unit:    type_unit = value; break;
+            case DW_IDX_die_offset:   die = value; break;
+            }
+        }
+        if (!entries.ok())
+        {
+            return;
+        }
+
+        if (type_unit != DwarfUnit::None)
+        {
+            // Only local type units are in this file's .debug_info.
+            if (type_unit >= table.type_unit_count_)
+            {
+                continue;
+            }
+            unit = offset_at(table.type_units_ + type_unit * offset_size);
+        }
+        else if (unit < table.unit_count_)
+        {
+            unit = units_[table.first_unit_ + unit];
+        }
+        else
+        {
+            continue;
+        }
+        found.push_back(NameEntry{unit, die == DwarfUnit::None ? die : unit + die, abbrev->tag_});
+    }
+}
+
+
+void NameIndex::
+lookup_gdb_index(std::string_view name, std::vector<NameEntry>& found) const
+{
+    if (gdb_slot_count_ == 0)
+    {
+        return;
+    }
+    DwarfReader reader(sections_.gdb_index_, false);
+    DwarfSection const pool{sections_.gdb_index_.bytes_ + gdb_pool_, sections_.gdb_index_.size_ - gdb_pool_};
+
+    // Open addressing, stepping by an odd amount to visit every slot.
+    std::uint32_t const hash = gdb_index_hash(name);
+    std::uint32_t const mask = gdb_slot_count_ - 1;
+    std::uint32_t const step = ((hash * 17) & mask) | 1;
+    std::uint32_t slot = hash & mask;
+    for (std::uint32_t probes = 0; probes < gdb_slot_count_; ++probes, slot = (slot + step) & mask)
+    {
+        reader.seek(gdb_symbols_ + slot * std::uint64_t(8));
+        std::uint32_t const name_offset = reader.u32();
+        std::uint32_t const units_offset = reader.u32();
+        if (name_offset == 0 && units_offset == 0)
+        {
+            return;
+        }
+        if (dwarf_string(pool, name_offset) != name)
+        {
+            continue;
+        }
+
+        reader.seek(gdb_pool_ + units_offset);
+        std::uint32_t const count = reader.u32();
+        for (std::uint32_t i = 0; i < count && reader.ok(); ++i)
+        {
+            std::uint32_t const value = reader.u32();
+            std::uint32_t const unit = value & 0xffffff;
+            std::uint32_t const kind = (value >> 28) & 7;
+            if (unit < units_.size())
+            {
+                dw_tag_t const tag = kind == gdb_kind_function ? DW_TAG_subprogram
+                                   : kind == gdb_kind_variable ? DW_TAG_variable : 0;
+                found.push_back(NameEntry{units_[unit], DwarfUnit::None, tag});
+            }
+        }
+        return;
+    }
+}
+
+
+void NameIndex::
+lookup_functions(std::string_view name, std::vector<NameEntry>& found) const
+{
+    std::call_once(functions_built_, [this]{
+        functions_ = FunctionIndex(*elf_file_, concurrency_);
+        std::vector<DwarfFunction> const& functions = functions_.functions();
+        for (std::uint32_t i = 0; i < functions.size(); ++i)
+        {
+            DwarfFunction const& function = functions[i];
+            function_names_.emplace_back(function.name_, i);
+            if (!function.linkage_name_.empty() && function.linkage_name_ != function.name_)
+            {
+                function_names_.emplace_back(function.linkage_name_, i);
+            }
+        }
+        std::sort(function_names_.begin(), function_names_.end());
+    });
+
+    auto it = std::lower_bound(function_names_.begin(), function_names_.end(), name,
+                               [](std::pair<std::string_view, std::uint32_t> const& entry, std::string_view key) {
+        return entry.first < key;
+    });
+    for (; it != function_names_.end() && it->first == name; ++it)
+    {
+        DwarfFunction const& function = functions_.functions()[it->second];
+        std::uint64_t const unit = functions_.units()[function.unit_].offset_;
+        if (std::binary_search(uncovered_.begin(), uncovered_.end(), unit))
+        {
+            found.push_back(NameEntry{unit, function.offset_,
+                                      function.inlined_ ? DW_TAG_inlined_subroutine : DW_TAG_subprogram});
+        }
+    }
+}
@@ -0,0 +1,178 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef EDHELIND_DWARFNAMES_H
+#define EDHELIND_DWARFNAMES_H
+
+#include <cstddef>
+#include <cstdint>
+#include "libedhel/dwarf.h"
+#include "libedhel/dwarffunctions.h"
+#include <mutex>
+#include "libedhel/parseerror.h"
+#include <string_view>
+#include <utility>
+#include <vector>
+
+class ElfFile;
+
+
+/** Where a name is defined: a DIE, or just the unit it's in */
+struct NameEntry
+{
+    std::uint64_t unit_;        /**< offset of the unit header in .debug_info */
+    std::uint64_t die_;         /**< offset of the DIE in .debug_info, or DwarfUnit::None if only the unit is known */
+    dw_tag_t      tag_;         /**< of the DIE, or 0 if not known */
+};
+
+
+/**
+ * Which units and DIEs of .debug_info define a name, found through the hash
+ * table of a name index the compiler or linker left in the file instead of
+ * by reading .debug_info.
+ *
+ * The DWARF 5 .debug_names section is used if there is one, and GDB's
+ * .gdb_index if not.  A linked file usually has a .debug_names index for
+ * each object that had one, one after another, and all of them are looked
+ * in.  .debug_names gives the DIE of each definition, .gdb_index only the
+ * unit, and both name types, variables and namespaces as well as functions.
+ * Names in .gdb_index are qualified ("ns::Widget::get"), those in
+ * .debug_names aren't.
+ *
+ * The units of .debug_info the index doesn't cover (all of them, without
+ * one) fall back to a FunctionIndex of the file, which is built the first
+ * time a name is looked up and only knows functions and the subroutines
+ * inlined into them, by DW_AT_name and linkage name, as .debug_names lists
+ * them.  The ElfFile must outlive the NameIndex for that.
+ */
+class NameIndex
+{
+public:
+    /** Where names are looked up */
+    enum class Source: std::uint8_t
+    {
+        None,                   /**< nowhere: there's no debugging information */
+        DebugNames,             /**< .debug_names */
+        GdbIndex,               /**< .gdb_index */
+        Functions,              /**< a FunctionIndex of .debug_info */
+    };
+
+public:
+    NameIndex() = default;
+
+    /**
+     * Find the name index of @p elf_file.  The fallback FunctionIndex, if
+     * needed, reads units on up to @p concurrency threads of the shared
+     * ThreadPool (0 for all of them).
+     */
+    explicit NameIndex(ElfFile const& elf_file, unsigned concurrency = 1);
+
+    Source
+    source() const;
+
+    /** How many units the name index leaves to the FunctionIndex */
+    std::size_t
+    fallback_count() const;
+
+    /**
+     * The first problem met, if any.  A .debug_names section with a bad
+     * index is only used up to it, and falls back to .gdb_index if nothing
+     * before it was good.
+     */
+    ParseError const&
+    error() const;
+
+    /** Everywhere @p name is defined, in .debug_info order */
+    std::vector<NameEntry>
+    lookup(std::string_view name) const;
+
+private:
+    /** One name index of .debug_names */
+    struct NamesTable
+    {
+        DwarfFormat   format_;
+        std::uint32_t first_unit_;          /**< index into units_ of its compilation units */
+        std::uint32_t unit_count_;
+        std::uint32_t type_unit_count_;     /**< local ones, in .debug_info */
+        std::uint32_t bucket_count_;
+        std::uint32_t name_count_;
+        std::uint32_t first_abbrev_;        /**< index into abbrevs_ */
+        std::uint32_t abbrev_count_;
+        std::uint64_t type_units_;          /**< the offsets of the rest, in .debug_names */
+        std::uint64_t buckets_;
+        std::uint64_t hashes_;
+        std::uint64_t string_offsets_;
+        std::uint64_t entry_offsets_;
+        std::uint64_t entries_;
+        std::uint64_t end_;
+    };
+
+    /** An abbreviation for entries of a NamesTable */
+    struct NamesAbbrev
+    {
+        std::uint64_t code_;
+        dw_tag_t      tag_;
+        std::uint32_t first_attribute_;     /**< index into attributes_ */
+        std::uint32_t attribute_count_;
+    };
+
+    struct NamesAttribute
+    {
+        dw_idx_t  index_;
+        dw_form_t form_;
+    };
+
+    bool
+    read_debug_names();
+
+    bool
+    read_gdb_index();
+
+    void
+    lookup_debug_names(NamesTable const& table, std::string_view name, std::vector<NameEntry>& found) const;
+
+    void
+    lookup_gdb_index(std::string_view name, std::vector<NameEntry>& found) const;
+
+    void
+    lookup_functions(std::string_view name, std::vector<NameEntry>& found) const;
+
+private:
+    ElfFile const*              elf_file_ = nullptr;
+    unsigned                    concurrency_ = 1;
+    DwarfSections               sections_;
+    Source                      source_ = Source::None;
+    std::vector<std::uint64_t>  units_;             /**< the compilation units the index covers */
+    std::vector<NamesTable>     tables_;
+    std::vector<NamesAbbrev>    abbrevs_;
+    std::vector<NamesAttribute> attributes_;
+    std::vector<std::uint32_t>  hash_buckets_;      /**< where each bucket of table_hashes_ starts, if there are several tables */
+    std::vector<std::uint64_t>  table_hashes_;      /**< hash << 32 | index into tables_ of each name they hash */
+    unsigned                    hash_shift_ = 0;    /**< of a hash to get its bucket */
+    std::uint64_t               gdb_symbols_ = 0;   /**< where the hash table of .gdb_index is */
+    std::uint32_t               gdb_slot_count_ = 0;
+    std::uint64_t               gdb_pool_ = 0;      /**< where its strings and unit lists are */
+    std::vector<std::uint64_t>  uncovered_;         /**< units of .debug_info it doesn't cover, sorted */
+    ParseError                  error_;
+
+    mutable std::once_flag                                          functions_built_;
+    mutable FunctionIndex                                           functions_;
+    mutable std::vector<std::pair<std::string_view, std::uint32_t>> function_names_;    /**< sorted */
+};
+
+#endif /* EDHELIND_DWARFNAMES_H */
@@ -334,6 +334,62 @@ static_assert(sizeof(Elf64_Phdr) == 56, "invalid 64-bit ELF PHDR size");
 
 /** @} */
 
+/**
+ * @defgroup Relocation entries
+ * @{
+ */
+struct Elf32_Rel
+{
+    std::uint32_t r_offset;
+    std::uint32_t r_info;
+};
+static_assert(sizeof(Elf32_Rel) == 8, "invalid 32-bit ELF REL size");
+
+struct Elf32_Rela
+{
+    std::uint32_t r_offset;
+    std::uint32_t r_info;
+    std::int32_t  r_addend;
+};
+static_assert(sizeof(Elf32_Rela) == 12, "invalid 32-bit ELF RELA size");
+
+struct Elf64_Rel
+{
+    std::uint64_t r_offset;
+    std::uint64_t r_info;
+};
+static_assert(sizeof(Elf64_Rel) == 16, "invalid 64-bit ELF REL size");
+
+struct Elf64_Rela
+{
+    std::uint64_t r_offset;
+    std::uint64_t r_info;
+    std::int64_t  r_addend;
+};
+static_assert(sizeof(Elf64_Rela) == 24, "invalid 64-bit ELF RELA size");
+
+/** @} */
+
+/**
+ * @defgroup Dynamic section entries
+ * @{
+ */
+struct Elf32_Dyn
+{
+    std::int32_t  d_tag;
+    std::uint32_t d_val;        /**< d_val or d_ptr */
+};
+static_assert(sizeof(Elf32_Dyn) == 8, "invalid 32-bit ELF DYN size");
+
+struct Elf64_Dyn
+{
+    std::int64_t  d_tag;
+    std::uint64_t d_val;        /**< d_val or d_ptr */
+};
+static_assert(sizeof(Elf64_Dyn) == 16, "invalid 64-bit ELF DYN size");
+
+/** @} */
+
 /**
  * @defgroup Notes
  * @{
@@ -18,16 +18,147 @@
  */
 #include "libedhel/elffile.h"
 
+#include "libedhel/elfvalidator.h"
+#include <new>
+#include <stdexcept>
+#include "libedhel/threadpool.h"
+
+
+ElfFile::
+ElfFile(std::string const& file_name, ParseOptions const& options)
+: ElfFile(ImageSource{file_name, false, nullptr, 0, nullptr}, options, nullptr)
+{
+}
+
+
+ElfFile::
+ElfFile(std::byte const* bytes, std::size_t size, std::string const& name, ParseOptions const& options)
+: ElfFile(ImageSource{name, true, bytes, size, nullptr}, options, nullptr)
+{
+}
+
+
+ElfFile::
+ElfFile(std::shared_ptr<std::byte const> bytes, std::size_t size, std::string const& name,
+        ParseOptions const& options)
+: ElfFile(ImageSource{name, true, bytes.get(), size, bytes}, options, nullptr)
+{
+}
+
 
 ElfFile::
-ElfFile(std::string const& file_name)
-: file_name_(file_name)
-, elf_image_(file_name_)
-, elf_header_(elf_image_.view(0, 56))
-, set_endianness_(elf_header_, elf_image_)
-, section_table_(*this)
-, segment_table_(*this)
+ElfFile(ImageSource const& source, ParseOptions const& options, ParseError* error)
+: file_name_(source.name_)
+, elf_image_(statistics_.timed(ParseStatistics::Phase::ImageLoad, [this, &source, error]() {
+      if (source.owner_)
+      {
+          return ElfImage(source.owner_, source.size_);
+      }
+      if (source.in_memory_)
+      {
+          return ElfImage(source.bytes_, source.size_);
+      }
+      if (error)
+      {
+          return ElfImage(file_name_, *error, &memory_);
+      }
+      return ElfImage(file_name_, &memory_);
+  }))
+, elf_header_(statistics_.timed(ParseStatistics::Phase::Header, [this, error]() {
+      if (failed(error))
+      {
+          return ElfHeader();
+      }
+      // Validating also settles the byte order of the image.
+      ElfValidation validation = validate_elf(elf_image_);
+      if (validation.error_)
+      {
+          if (!error)
+          {
+              throw std::runtime_error(file_name_ + ": " + validation.error_.message());
+          }
+          *error = validation.error_;
+          return ElfHeader();
+      }
+      return ElfHeader(elf_image_.view(0, 56));
+  }))
+, section_table_(statistics_.timed(ParseStatistics::Phase::SectionTable, [this, error, &options]() {
+      if (failed(error))
+      {
+          return SectionTable();
+      }
+      unsigned concurrency = options.concurrency_ ? options.concurrency_ : ThreadPool::shared().worker_count() + 1;
+      return SectionTable(*this, concurrency);
+  }))
+, segment_table_(statistics_.timed(ParseStatistics::Phase::SegmentTable, [this, error]() {
+      if (failed(error))
+      {
+          return SegmentTable();
+      }
+      return SegmentTable(*this);
+  }))
+{
+    if (!failed(error))
+    {
+        statistics_.add(ParseStatistics::Counter::BytesTouched, elf_header_.ehsize());
+    }
+    statistics_.add(ParseStatistics::Counter::ObjectsAllocated, 1);
+    statistics_.finish();
+}
+
+
+ParseResult ElfFile::
+parse(std::string const& file_name, ParseOptions const& options)
+{
+    return parse(ImageSource{file_name, false, nullptr, 0, nullptr}, options);
+}
+
+
+ParseResult ElfFile::
+parse(std::byte const* bytes, std::size_t size, std::string const& name, ParseOptions const& options)
+{
+    return parse(ImageSource{name, true, bytes, size, nullptr}, options);
+}
+
+
+ParseResult ElfFile::
+parse(std::shared_ptr<std::byte const> bytes, std::size_t size, std::string const& name,
+      ParseOptions const& options)
+{
+    return parse(ImageSource{name, true, bytes.get(), size, bytes}, options);
+}
+
+
+ParseResult ElfFile::
+parse(ImageSource const& source, ParseOptions const& options)
+{
+    // The checks record what they find in result.error_, but a file can be
+    // broken in ways they don't look for, and the parser throws on those.
+    ParseResult result;
+    try
+    {
+        result.elf_file_.reset(new ElfFile(source, options, &result.error_));
+    }
+    catch (std::bad_alloc const&)
+    {
+        result.error_ = ParseError{ParseErrc::OutOfMemory};
+    }
+    catch (...)
+    {
+        result.error_ = ParseError{ParseErrc::Malformed};
+    }
+    if (result.error_)
+    {
+        result.elf_file_.reset();
+    }
+    return result;
+}
+
+
+bool ElfFile::
+failed(ParseError const* error) const
 {
+    return error && *error;
 }
 
 
@@ -38,6 +169,20 @@ is_64bit() const
 }
 
 
+bool ElfFile::
+validated() const
+{
+    return elf_image_.validated();
+}
+
+
+std::size_t ElfFile::
+size() const
+{
+    return elf_image_.size();
+}
+
+
 ElfHeader const& ElfFile::
 elf_header() const
 {
@@ -71,3 +216,31 @@ view(std::size_t offset, std::size_t size) const
 {
     return elf_image_.view(offset, size);
 }
+
+
+ParseStatistics const& ElfFile::
+statistics() const
+{
+    return statistics_;
+}
+
+
+ParseStatistics& ElfFile::
+statistics_recorder() const
+{
+    return statistics_;
+}
+
+
+MemoryAccount const& ElfFile::
+memory() const
+{
+    return memory_;
+}
+
+
+MemoryAccount& ElfFile::
+memory_recorder() const
+{
+    return memory_;
+}
@@ -21,11 +21,43 @@
 
 #include "libedhel/elfheader.h"
 #include "libedhel/elfimage.h"
+#include "libedhel/memoryaccount.h"
+#include "libedhel/parseerror.h"
+#include "libedhel/parsestatistics.h"
 #include "libedhel/sectiontable.h"
 #include "libedhel/segmenttable.h"
+#include <cstddef>
+#include <memory>
 #include <string>
 
 
+/**
+ * How an ElfFile goes about parsing.
+ */
+struct ParseOptions
+{
+    /**
+     * How many threads may decode section contents: 1 decodes them one after
+     * the other on the calling thread, anything more uses the shared
+     * ThreadPool, and 0 uses all of it.
+     */
+    unsigned concurrency_ = 1;
+};
+
+
+class ElfFile;
+
+
+/**
+ * What came of parsing an ELF file: either the file or why there isn't one.
+ */
+struct ParseResult
+{
+    std::unique_ptr<ElfFile> elf_file_;
+    ParseError               error_;
+};
+
+
 /*!
  * Wrap an ELF file and present its innards.
  */
@@ -33,8 +65,59 @@ class ElfFile
 {
 public:
 
-    /** Construct an ElfFile from a named file. */
-    ElfFile(std::string const& file_name);
+    /**
+     * Construct an ElfFile from a named file.
+     *
+     * @throws std::runtime_error if the file can't be read or parsed
+     */
+    ElfFile(std::string const& file_name, ParseOptions const& options = ParseOptions{});
+
+    /**
+     * Construct an ElfFile from an image already in memory, without copying
+     * it.
+     *
+     * The caller keeps the @p size bytes at @p bytes alive and unchanged for
+     * as long as the ElfFile.  @p name is what to call the image in messages.
+     *
+     * @throws std::runtime_error if the image can't be parsed
+     */
+    ElfFile(std::byte const* bytes, std::size_t size, std::string const& name,
+            ParseOptions const& options = ParseOptions{});
+
+    /**
+     * Construct an ElfFile from an image already in memory, without copying
+     * it, sharing in the ownership of the image.
+     *
+     * An image embedded in a bigger buffer (an archive member, a segment of a
+     * core dump) can be passed using the aliasing constructor of
+     * std::shared_ptr, so that the ElfFile keeps the whole buffer alive.
+     *
+     * @throws std::runtime_error if the image can't be parsed
+     */
+    ElfFile(std::shared_ptr<std::byte const> bytes, std::size_t size, std::string const& name,
+            ParseOptions const& options = ParseOptions{});
+
+    /**
+     * Parse a named file without throwing.
+     *
+     * A file that can't be read or fails validate_elf() is caught before any
+     * of it is parsed, so this is the way to go through lots of files that
+     * may be broken.  Anything that goes wrong after that, including running
+     * out of memory, is caught too and reported as ParseErrc::Malformed or
+     * ParseErrc::OutOfMemory.
+     */
+    static ParseResult
+    parse(std::string const& file_name, ParseOptions const& options = ParseOptions{});
+
+    /** Parse an image already in memory without copying it or throwing */
+    static ParseResult
+    parse(std::byte const* bytes, std::size_t size, std::string const& name,
+          ParseOptions const& options = ParseOptions{});
+
+    /** Parse a shared image already in memory without copying it or throwing */
+    static ParseResult
+    parse(std::shared_ptr<std::byte const> bytes, std::size_t size, std::string const& name,
+          ParseOptions const& options = ParseOptions{});
 
     ElfFile(ElfFile const&) = delete;
 
@@ -45,6 +128,17 @@ public:
     bool
     is_64bit() const;
 
+    /**
+     * Whether the file passed every check of validate_elf(), so that reads
+     * from it skip their bounds checks
+     */
+    bool
+    validated() const;
+
+    /** The size of the file image in bytes */
+    std::size_t
+    size() const;
+
     /** Get the ELF header */
     ElfHeader const&
     elf_header() const;
@@ -62,20 +156,50 @@ public:
     ElfImageView
     view(std::size_t offset, std::size_t size) const;
 
+    /** What parsing this file cost */
+    ParseStatistics const&
+    statistics() const;
+
+    /** Where the parsers record what parsing this file costs */
+    ParseStatistics&
+    statistics_recorder() const;
+
+    /** How much memory this file is holding, and for what */
+    MemoryAccount const&
+    memory() const;
+
+    /** Where the parsers record the memory they allocate for this file */
+    MemoryAccount&
+    memory_recorder() const;
+
 private:
-    /*! Helper class for setting endianness */
-    struct EndianSetter
+    /** Where the image of the file comes from */
+    struct ImageSource
     {
-        EndianSetter(ElfHeader const& elf_header, ElfImage& elf_image)
-        {
-            elf_image.setBigEndian(!elf_header.isLE());
-        }
+        std::string                      name_;
+        bool                             in_memory_ = false; /**< or else read from the file name_ */
+        std::byte const*                 bytes_ = nullptr;
+        std::size_t                      size_ = 0;
+        std::shared_ptr<std::byte const> owner_;             /**< keeps bytes_ alive, if anything does */
     };
 
+    /**
+     * Parse, recording any error in @p error or throwing it if there is
+     * nowhere to record it.
+     */
+    ElfFile(ImageSource const& source, ParseOptions const& options, ParseError* error);
+
+    static ParseResult
+    parse(ImageSource const& source, ParseOptions const& options);
+
+    bool
+    failed(ParseError const* error) const;
+
+    mutable MemoryAccount   memory_;
+    mutable ParseStatistics statistics_;
     std::string   file_name_;
     ElfImage      elf_image_;
     ElfHeader     elf_header_;
-    EndianSetter  set_endianness_;
     SectionTable  section_table_;
     SegmentTable  segment_table_;
 };
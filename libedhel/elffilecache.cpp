@@ -0,0 +1,221 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "libedhel/elffilecache.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <sstream>
+#include <stdexcept>
+#include "libedhel/trace.h"
+#include <vector>
+
+#if defined(_WIN32)
+# include <chrono>
+# include <filesystem>
+#else
+# include <climits>
+# include <cstdlib>
+# include <sys/stat.h>
+#endif
+
+
+ElfFileCache::
+ElfFileCache(std::size_t max_unused, std::size_t memory_budget, ParseOptions const& parse_options)
+: max_unused_{max_unused}
+, memory_budget_{memory_budget}
+, parse_options_{parse_options}
+, clock_{0}
+{
+}
+
+
+ElfFileCache::
+~ElfFileCache() = default;
+
+
+bool ElfFileCache::Identity::
+operator==(Identity const& rhs) const
+{
+    return device_ == rhs.device_
+        && inode_ == rhs.inode_
+        && size_ == rhs.size_
+        && mtime_ns_ == rhs.mtime_ns_;
+}
+
+
+/**
+ * Find out what @p file_name currently is on disk.
+ */
+ElfFileCache::Identity ElfFileCache::
+identify(std::string const& file_name, std::string& canonical_name)
+{
+#if defined(_WIN32)
+    // No inodes to be had here: the canonical path has to stand in for them.
+    namespace fs = std::filesystem;
+    std::error_code ec;
+    fs::path path = fs::canonical(file_name, ec);
+    std::uintmax_t size = ec ? 0 : fs::file_size(path, ec);
+    fs::file_time_type mtime = ec ? fs::file_time_type{} : fs::last_write_time(path, ec);
+    if (ec)
+    {
+        std::ostringstream ostr;
+        ostr << "error " << ec.value() << " examining '" << file_name << "': " << ec.message();
+        throw std::runtime_error(ostr.str());
+    }
+    canonical_name = path.string();
+    return Identity{0, 0, size,
+                    std::chrono::duration_cast<std::chrono::nanoseconds>(mtime.time_since_epoch()).count()};
+#else
+    struct stat st;
+    if (::stat(file_name.c_str(), &st) == -1)
+    {
+        std::ostringstream ostr;
+        ostr << "error " << errno << " examining '" << file_name << "': " << std::strerror(errno);
+        throw std::runtime_error(ostr.str());
+    }
+
+    char resolved[PATH_MAX];
+    canonical_name = ::realpath(file_name.c_str(), resolved) ? resolved : file_name;
+# if defined(__APPLE__)
+    std::int64_t mtime_ns = std::int64_t(st.st_mtimespec.tv_sec) * 1000000000 + st.st_mtimespec.tv_nsec;
+# else
+    std::int64_t mtime_ns = std::int64_t(st.st_mtim.tv_sec) * 1000000000 + st.st_mtim.tv_nsec;
+# endif
+    return Identity{static_cast<std::uint64_t>(st.st_dev),
+                    static_cast<std::uint64_t>(st.st_ino),
+                    static_cast<std::uint64_t>(st.st_size),
+                    mtime_ns};
+#endif
+}
+
+
+std::shared_ptr<ElfFile const> ElfFileCache::
+open(std::string const& file_name)
+{
+    EDHEL_TRACE_ZONE("open file", file_name);
+    std::string canonical_name;
+    Identity identity = identify(file_name, canonical_name);
+
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = entries_.find(canonical_name);
+        if (it != entries_.end() && it->second.identity_ == identity)
+        {
+            it->second.last_used_ = ++clock_;
+            return it->second.elf_file_;
+        }
+    }
+
+    // Parse outside the lock so a big file does not hold up everyone else.  If
+    // two threads race to parse the same file the first one in wins and the
+    // other's work is discarded.
+    auto elf_file = std::make_shared<ElfFile const>(canonical_name, parse_options_);
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    Entry& entry = entries_[canonical_name];
+    if (!(entry.elf_file_ && entry.identity_ == identity))
+    {
+        entry.identity_ = identity;
+        entry.elf_file_ = std::move(elf_file);
+    }
+    entry.last_used_ = ++clock_;
+    std::shared_ptr<ElfFile const> result = entry.elf_file_;
+    this->trim();
+    return result;
+}
+
+
+std::size_t ElfFileCache::
+size() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    return entries_.size();
+}
+
+
+std::size_t ElfFileCache::
+memory_bytes() const
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    std::size_t bytes = 0;
+    for (auto const& entry: entries_)
+    {
+        bytes += entry.second.elf_file_->memory().total_bytes();
+    }
+    return bytes;
+}
+
+
+void ElfFileCache::
+clear_unused()
+{
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto it = entries_.begin(); it != entries_.end(); )
+    {
+        if (it->second.elf_file_.use_count() == 1)
+        {
+            it = entries_.erase(it);
+        }
+        else
+        {
+            ++it;
+        }
+    }
+}
+
+
+/**
+ * Forget the least recently used files nobody else holds until there are no
+ * more than max_unused_ of them and the cache is within its memory budget (or
+ * there are no unused files left to forget).  Must be called with mutex_ held.
+ */
+void ElfFileCache::
+trim()
+{
+    std::vector<std::map<std::string, Entry>::iterator> unused;
+    std::size_t bytes = 0;
+    for (auto it = entries_.begin(); it != entries_.end(); ++it)
+    {
+        bytes += it->second.elf_file_->memory().total_bytes();
+        if (it->second.elf_file_.use_count() == 1)
+        {
+            unused.push_back(it);
+        }
+    }
+    if (unused.size() <= max_unused_ && bytes <= memory_budget_)
+    {
+        return;
+    }
+
+    std::sort(unused.begin(), unused.end(), [](auto const& lhs, auto const& rhs) {
+        return lhs->second.last_used_ < rhs->second.last_used_;
+    });
+    std::size_t remaining = unused.size();
+    for (auto it: unused)
+    {
+        if (remaining <= max_unused_ && bytes <= memory_budget_)
+        {
+            break;
+        }
+        bytes -= it->second.elf_file_->memory().total_bytes();
+        entries_.erase(it);
+        --remaining;
+    }
+}
@@ -0,0 +1,123 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef EDHELIND_ELFFILECACHE_H
+#define EDHELIND_ELFFILECACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include "libedhel/elffile.h"
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <string>
+
+
+
+/**
+ * A cache of parsed ElfFiles shared by everything open in a session.
+ *
+ * Files are keyed by their canonical path and checked against the device,
+ * inode, size and modification time they had when they were parsed, so a file
+ * that is opened again (or by another name) is only re-read and re-parsed if
+ * it has changed on disk.
+ *
+ * Files still in use are always kept.  Up to a fixed number of files no longer
+ * used by anyone are also kept, most recently used first, so closing a file
+ * and opening it again is cheap too.  Unused files are also dropped, least
+ * recently used first, while the cache as a whole holds more memory than its
+ * budget allows.
+ *
+ * All member functions may be called from any thread.
+ */
+class ElfFileCache
+{
+public:
+    /**
+     * Construct a cache keeping at most @p max_unused files nobody is using,
+     * and none of those if the cache holds more than @p memory_budget bytes.
+     * Files are parsed according to @p parse_options.
+     */
+    explicit ElfFileCache(std::size_t max_unused = 8,
+                          std::size_t memory_budget = std::numeric_limits<std::size_t>::max(),
+                          ParseOptions const& parse_options = ParseOptions{});
+
+    ElfFileCache(ElfFileCache const&) = delete;
+
+    ElfFileCache& operator=(ElfFileCache const&) = delete;
+
+    ~ElfFileCache();
+
+    /**
+     * Get the parsed ElfFile for @p file_name, parsing it only if it is not
+     * already in the cache or has changed since it was.
+     *
+     * @throws std::runtime_error if the file can not be read or parsed
+     */
+    std::shared_ptr<ElfFile const>
+    open(std::string const& file_name);
+
+    /** The number of files in the cache, in use or not */
+    std::size_t
+    size() const;
+
+    /** The memory held by all the files in the cache, in bytes */
+    std::size_t
+    memory_bytes() const;
+
+    /** Drop every file nobody is using any more */
+    void
+    clear_unused();
+
+private:
+    /** What a file on disk looked like when it was parsed */
+    struct Identity
+    {
+        std::uint64_t device_;
+        std::uint64_t inode_;
+        std::uint64_t size_;
+        std::int64_t  mtime_ns_;
+
+        bool
+        operator==(Identity const& rhs) const;
+    };
+
+    struct Entry
+    {
+        Identity                       identity_;
+        std::shared_ptr<ElfFile const> elf_file_;
+        std::uint64_t                  last_used_;
+    };
+
+    static Identity
+    identify(std::string const& file_name, std::string& canonical_name);
+
+    void
+    trim();
+
+private:
+    mutable std::mutex           mutex_;
+    std::map<std::string, Entry> entries_;
+    std::size_t                  max_unused_;
+    std::size_t                  memory_budget_;
+    ParseOptions                 parse_options_;
+    std::uint64_t                clock_;
+};
+
+#endif /* EDHELIND_ELFFILECACHE_H */
@@ -31,6 +31,9 @@ class ElfHeader
 : public Detailable
 {
 public:
+    /** An empty header, standing in for one that couldn't be read */
+    ElfHeader() = default;
+
     ElfHeader(ElfImageView const& imageView);
 
     bool
@@ -18,12 +18,14 @@
  */
 #include "libedhel/elfimage.h"
 
+#include <algorithm>
 #include <cerrno>
 #include <cstdio>
 #include <cstring>
 #include <fstream>
 #include <sstream>
 #include <stdexcept>
+#include "libedhel/trace.h"
 
 #ifdef DUDE_LATER_DUDE
 #include "md5.h"
@@ -35,10 +37,12 @@
 
 
 ElfImageView::
-ElfImageView(ElfImage const* elfFile, std::size_t offset, std::size_t size)
-: elf_file_(elfFile)
-, offset_(offset)
+ElfImageView(std::byte const* bytes, std::size_t size, std::size_t extent, bool is_be, bool is_checked)
+: bytes_(bytes)
 , size_(size)
+, extent_(extent)
+, is_be_(is_be)
+, is_checked_(is_checked)
 { }
 
 
@@ -51,87 +55,107 @@ view(std::size_t offset, std::size_t size) const
         ostr << "subview size " << size << " is larger than view size " << size_;
         throw std::runtime_error(ostr.str());
     }
-    return ElfImageView(elf_file_, offset_ + offset, size);
+    return ElfImageView(bytes_ + offset, size, extent_ - offset, is_be_, is_checked_);
 }
 
 
-std::size_t ElfImageView::
-size() const
+void ElfImageView::
+throw_out_of_range(std::size_t offset, std::size_t size) const
 {
-    return size_;
+    std::ostringstream ostr;
+    ostr << "read of " << size << " bytes at offset " << std::showbase << std::hex << offset
+         << " of a view is past the end of the image (" << extent_ << " bytes left)";
+    throw std::out_of_range(ostr.str());
 }
 
 
-std::uint8_t ElfImageView::
-get_uint8(std::size_t offset) const
+std::string ElfImageView::
+get_string(std::size_t offset, std::size_t maxlen) const
 {
-    return elf_file_->get_uint8(offset_ + offset);
+    return std::string(get_string_view(offset, maxlen));
 }
 
 
-std::byte const* ElfImageView::
-get_bytes(std::size_t offset) const
+std::string_view ElfImageView::
+get_string_view(std::size_t offset, std::size_t maxlen) const
 {
-    return elf_file_->get_bytes(offset_ + offset);
+    if (offset >= size_)
+    {
+        return {};
+    }
+    maxlen = std::min(maxlen, size_ - offset);
+    const char* b = reinterpret_cast<char const*>(get_bytes(offset));
+    const void* nul = std::memchr(b, '\0', maxlen);
+    return std::string_view(b, nul ? static_cast<char const*>(nul) - b : maxlen);
 }
 
 
-std::uint16_t ElfImageView::
-get_uint16(std::size_t offset) const
+Leb128Run ElfImageView::
+get_uleb128s(std::size_t offset, std::size_t count, std::uint64_t* values) const
 {
-    return elf_file_->get_uint16(offset_ + offset);
+    if (offset >= size_)
+    {
+        return Leb128Run{0, 0};
+    }
+    return decode_uleb128(get_bytes(offset), size_ - offset, count, values);
 }
 
 
-std::uint32_t ElfImageView::
-get_uint32(std::size_t offset) const
+Leb128Run ElfImageView::
+get_sleb128s(std::size_t offset, std::size_t count, std::int64_t* values) const
 {
-    return elf_file_->get_uint32(offset_ + offset);
+    if (offset >= size_)
+    {
+        return Leb128Run{0, 0};
+    }
+    return decode_sleb128(get_bytes(offset), size_ - offset, count, values);
 }
 
 
-std::uint64_t ElfImageView::
-get_uint64(std::size_t offset) const
+ElfImage::
+ElfImage(std::string const& filename, MemoryAccount* account)
+: data_(Bytes::allocator_type(account, MemoryAccount::Category::Image))
+, is_be_(false)
 {
-    return elf_file_->get_uint64(offset_ + offset);
+    ParseError error;
+    load(filename, error);
+    if (error)
+    {
+        std::ostringstream ostr;
+        ostr << "error " << error.errno_ << " reading '" << filename << "': " << std::strerror(error.errno_);
+        throw std::runtime_error(ostr.str());
+    }
 }
 
 
-std::string ElfImageView::
-get_string(std::size_t offset, std::size_t maxlen) const
+ElfImage::
+ElfImage(std::string const& filename, ParseError& error, MemoryAccount* account)
+: data_(Bytes::allocator_type(account, MemoryAccount::Category::Image))
+, is_be_(false)
 {
-    return elf_file_->get_string(offset_ + offset, maxlen);
+    load(filename, error);
 }
 
 
-ElfImage::
-ElfImage(std::string const& filename)
-: is_be_(false)
+void ElfImage::
+load(std::string const& filename, ParseError& error)
 {
+    EDHEL_TRACE_ZONE("load image", filename);
+
     // Use C fileio because C++ is broken when it comes to binary file I/O
     FILE* file = std::fopen(filename.c_str(), "rb");
     if (file == nullptr)
     {
-        std::ostringstream ostr;
-        ostr << "error " << errno << " opening '" << filename << "': " << std::strerror(errno);
-        throw std::runtime_error(ostr.str());
-    }
-
-    if (std::fseek(file, 0, SEEK_END) == -1)
-    {
-        std::ostringstream ostr;
-        ostr << "error " << errno << " positioning '" << filename << "': " << std::strerror(errno);
-        fclose(file);
-        throw std::runtime_error(ostr.str());
+        error = ParseError{ParseErrc::Unreadable, 0, errno};
+        return;
     }
 
-    long fileSize = std::ftell(file);
-    if (fileSize == -1)
+    long fileSize = -1;
+    if (std::fseek(file, 0, SEEK_END) == -1 || (fileSize = std::ftell(file)) == -1)
     {
-        std::ostringstream ostr;
-        ostr << "error " << errno << " determining size of '" << filename << "': " << std::strerror(errno);
+        error = ParseError{ParseErrc::Unreadable, 0, errno};
         fclose(file);
-        throw std::runtime_error(ostr.str());
+        return;
     }
 
     std::rewind(file);
@@ -139,19 +163,41 @@ ElfImage(std::string const& filename)
     std::size_t bytesRead = std::fread(data_.data(), sizeof(std::byte), fileSize, file);
     if (bytesRead != static_cast<std::size_t>(fileSize))
     {
-        std::ostringstream ostr;
-        ostr << "error " << errno << " reading '" << filename << "': " << std::strerror(errno);
-        fclose(file);
-        throw std::runtime_error(ostr.str());
+        error = ParseError{ParseErrc::Unreadable, bytesRead, errno};
+        data_.clear();
     }
+    bytes_ = data_.data();
+    size_ = data_.size();
 
     fclose(file);
 }
 
 
 ElfImage::
-ElfImage(ByteSequence const& byte_sequence)
-: data_{byte_sequence}
+ElfImage(ByteSequence const& byte_sequence, MemoryAccount* account)
+: data_(byte_sequence.begin(), byte_sequence.end(),
+        Bytes::allocator_type(account, MemoryAccount::Category::Image))
+, bytes_(data_.data())
+, size_(data_.size())
+, is_be_{false}
+{
+}
+
+
+ElfImage::
+ElfImage(std::byte const* bytes, std::size_t size)
+: bytes_(bytes)
+, size_(size)
+, is_be_{false}
+{
+}
+
+
+ElfImage::
+ElfImage(std::shared_ptr<std::byte const> bytes, std::size_t size)
+: owner_(std::move(bytes))
+, bytes_(owner_.get())
+, size_(size)
 , is_be_{false}
 {
 }
@@ -164,10 +210,51 @@ setBigEndian(bool isBigEndian)
 }
 
 
+bool ElfImage::
+isBigEndian() const
+{
+    return is_be_;
+}
+
+
 std::size_t ElfImage::
 size() const
 {
-    return data_.size();
+    return size_;
+}
+
+
+bool ElfImage::
+validated() const
+{
+    return is_validated_;
+}
+
+
+void ElfImage::
+set_validated(bool is_validated)
+{
+    is_validated_ = is_validated;
+}
+
+
+inline void ElfImage::
+check_range(std::size_t offset, std::size_t size) const
+{
+    if (!is_validated_ && (offset > size_ || size > size_ - offset))
+    {
+        throw_out_of_range(offset, size);
+    }
+}
+
+
+void ElfImage::
+throw_out_of_range(std::size_t offset, std::size_t size) const
+{
+    std::ostringstream ostr;
+    ostr << "read of " << size << " bytes at offset " << std::showbase << std::hex << offset
+         << " is past the end of the image (size " << size_ << ")";
+    throw std::out_of_range(ostr.str());
 }
 
 
@@ -176,7 +263,7 @@ std::string ElfImage::
 md5() const
 {
     MD5 md5hash;
-    return md5hash(data_.data(), data_.size());
+    return md5hash(bytes_, size_);
 }
 
 
@@ -184,7 +271,7 @@ std::string ElfImage::
 sha1() const
 {
     SHA1 sha1hash;
-    return sha1hash(data_.data(), data_.size());
+    return sha1hash(bytes_, size_);
 }
 
 
@@ -192,7 +279,7 @@ std::string ElfImage::
 sha256() const
 {
     SHA256 sha256hash;
-    return sha256hash(data_.data(), data_.size());
+    return sha256hash(bytes_, size_);
 }
 #endif
 
@@ -200,95 +287,65 @@ sha256() const
 ElfImageView ElfImage::
 view(std::size_t offset, std::size_t size) const
 {
-    if (offset > data_.size())
+    if (offset > size_)
     {
         std::ostringstream ostr;
         ostr << "offset " << std::hex << offset
-             << " is larger than filesize " << std::hex << data_.size();
+             << " is larger than filesize " << std::hex << size_;
         throw std::runtime_error(ostr.str());
     }
-    std::size_t bytesLeft = data_.size() - offset;
-        return ElfImageView(this, offset, (size < bytesLeft ? size : bytesLeft));
+    std::size_t bytesLeft = size_ - offset;
+    return ElfImageView(bytes_ + offset, (size < bytesLeft ? size : bytesLeft), bytesLeft,
+                        is_be_, !is_validated_);
 }
 
 
 std::byte const* ElfImage::
 get_bytes(std::size_t offset) const
 {
-    return &data_[offset];
+    check_range(offset, 0);
+    return bytes_ + offset;
 }
 
 
 std::uint8_t ElfImage::
 get_uint8(std::size_t offset) const
 {
-    return std::to_integer<std::uint8_t>(data_[offset]);
+    check_range(offset, 1);
+    return std::to_integer<std::uint8_t>(bytes_[offset]);
 }
 
 
 std::uint16_t ElfImage::
 get_uint16(std::size_t offset) const
 {
-    if (is_be_)
-    {
-        return (std::to_integer<std::uint16_t>(data_[offset+0]) << 8)
-             | (std::to_integer<std::uint16_t>(data_[offset+1]) << 0);
-    }
-    return (std::to_integer<std::uint16_t>(data_[offset+0]) << 0)
-         | (std::to_integer<std::uint16_t>(data_[offset+1]) << 8);
+    check_range(offset, 2);
+    return load_uint<std::uint16_t>(bytes_ + offset, is_be_);
 }
 
 
 std::uint32_t ElfImage::
-get_uint32(std::size_t offset) const 
+get_uint32(std::size_t offset) const
 {
-    if (is_be_)
-    {
-        return (std::to_integer<std::uint32_t>(data_[offset+0])<<24)
-             | (std::to_integer<std::uint32_t>(data_[offset+1])<<16)
-             | (std::to_integer<std::uint32_t>(data_[offset+2])<<8)
-             | (std::to_integer<std::uint32_t>(data_[offset+3])<<0);
-    }
-    return (std::to_integer<std::uint32_t>(data_[offset+0])<<0)
-         | (std::to_integer<std::uint32_t>(data_[offset+1])<<8)
-         | (std::to_integer<std::uint32_t>(data_[offset+2])<<16)
-         | (std::to_integer<std::uint32_t>(data_[offset+3])<<24);
+    check_range(offset, 4);
+    return load_uint<std::uint32_t>(bytes_ + offset, is_be_);
 }
 
 
 std::uint64_t ElfImage::
 get_uint64(std::size_t offset) const
 {
-    if (is_be_)
-    {
-        return (std::to_integer<std::uint64_t>(data_[offset+0])<<56)
-             | (std::to_integer<std::uint64_t>(data_[offset+1])<<48)
-             | (std::to_integer<std::uint64_t>(data_[offset+2])<<40)
-             | (std::to_integer<std::uint64_t>(data_[offset+3])<<32)
-             | (std::to_integer<std::uint64_t>(data_[offset+4])<<24)
-             | (std::to_integer<std::uint64_t>(data_[offset+5])<<16)
-             | (std::to_integer<std::uint64_t>(data_[offset+6])<<8)
-             | (std::to_integer<std::uint64_t>(data_[offset+7])<<0);
-    }
-    return (std::to_integer<std::uint64_t>(data_[offset+0])<<0)
-         | (std::to_integer<std::uint64_t>(data_[offset+1])<<8)
-         | (std::to_integer<std::uint64_t>(data_[offset+2])<<16)
-         | (std::to_integer<std::uint64_t>(data_[offset+3])<<24)
-         | (std::to_integer<std::uint64_t>(data_[offset+4])<<32)
-         | (std::to_integer<std::uint64_t>(data_[offset+5])<<40)
-         | (std::to_integer<std::uint64_t>(data_[offset+6])<<48)
-         | (std::to_integer<std::uint64_t>(data_[offset+7])<<56);
+    check_range(offset, 8);
+    return load_uint<std::uint64_t>(bytes_ + offset, is_be_);
 }
 
 
 std::string ElfImage::
 get_string(std::size_t offset, std::size_t maxlen) const
 {
-    const char* b = reinterpret_cast<char const*>(&data_[offset]);
-    std::size_t i = 0;
-    while (i < maxlen && b[i] != '\0')
-    {
-        ++i;
-    }
-    return std::string(b, i);
+    check_range(offset, 0);
+    maxlen = std::min(maxlen, size_ - offset);
+    const char* b = reinterpret_cast<char const*>(bytes_ + offset);
+    const void* nul = std::memchr(b, '\0', maxlen);
+    return std::string(b, nul ? static_cast<char const*>(nul) - b : maxlen);
 }
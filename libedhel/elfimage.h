@@ -25,7 +25,13 @@
 #include <cstddef>
 #include <cstdint>
 #include <iosfwd>
+#include "libedhel/byteorder.h"
+#include "libedhel/leb128.h"
+#include "libedhel/memoryaccount.h"
+#include "libedhel/parseerror.h"
+#include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
 
 
@@ -35,11 +41,16 @@ class ElfImage;
 /*!
  * A proxy object to access a subsection of the ELF file.
  *
- * An ElfImageView is effective a view proxy into an actial ElfImage object
- * starting at an offset from the beginning.  The ElfImageView knows all about
- * the target wordsize (32 or 64 bits) and the target endianness.  All of the
- * extractor functions (getXXX()) read from a relative offset from the beginning
- * of the view.
+ * An ElfImageView points straight at the bytes of the subsection of an
+ * ElfImage and carries the target endianness and whether the image has been
+ * validated along with it, so the extractor functions (getXXX()) are a load
+ * and maybe a byte swap with no call back into the image.  All of them read
+ * from a relative offset from the beginning of the view.
+ *
+ * A view takes the byte order and validation state of its image when it is
+ * made, so views should be made after validate_elf() has settled both.  Like
+ * the image, a view of an image that hasn't been validated checks its reads
+ * against the end of the image.
  *
  * This is a fairly flyweight object.
  */
@@ -60,6 +71,10 @@ public:
     std::size_t
     size() const;
 
+    /*! Whether the target is big-endian */
+    bool
+    isBigEndian() const;
+
     /*! Get the raw bytes at @p offset */
     std::byte const*
     get_bytes(std::size_t offset) const;
@@ -84,25 +99,173 @@ public:
     std::string
     get_string(std::size_t offset, std::size_t maxlen) const;
 
+    /*!
+     * Get the (zero-terminated) string at @p offset without copying it.
+     *
+     * The returned string_view is bounded by the end of this view and is valid
+     * for as long as the underlying ElfImage.
+     */
+    std::string_view
+    get_string_view(std::size_t offset, std::size_t maxlen) const;
+
+    /*!
+     * Read the ULEB128 at @p offset, setting @p length to the number of bytes
+     * it takes.  Throws if it runs past the end of the view.
+     */
+    std::uint64_t
+    get_uleb128(std::size_t offset, std::size_t& length) const;
+
+    /*!
+     * Read the SLEB128 at @p offset, setting @p length to the number of bytes
+     * it takes.  Throws if it runs past the end of the view.
+     */
+    std::int64_t
+    get_sleb128(std::size_t offset, std::size_t& length) const;
+
+    /*!
+     * Decode up to @p count consecutive ULEB128 values starting at @p offset
+     * into @p values, stopping short at one that runs past the end of the view.
+     */
+    Leb128Run
+    get_uleb128s(std::size_t offset, std::size_t count, std::uint64_t* values) const;
+
+    /*! Decode up to @p count consecutive SLEB128 values, like get_uleb128s() */
+    Leb128Run
+    get_sleb128s(std::size_t offset, std::size_t count, std::int64_t* values) const;
+
 private:
     friend class ElfImage;
 
     /*!
-     * Constructs a proxy into @p elfFile at offset @p offset.
-     * @param[in] elfFile The ElfImage to create a view on
-     * @param[in] offset  The number of bytes from the start of @p elfFile where
-     *                    this view starts
-     * @param[in] size    The size of the view
+     * Constructs a proxy onto the bytes of an image.
+     * @param[in] bytes       The first byte of the view
+     * @param[in] size        The size of the view
+     * @param[in] extent      The number of bytes from @p bytes to the end of the image
+     * @param[in] is_be       Whether the image is big-endian
+     * @param[in] is_checked  Whether reads are checked against the end of the image
      */
-    ElfImageView(ElfImage const* elfFile, std::size_t offset, std::size_t size);
+    ElfImageView(std::byte const* bytes, std::size_t size, std::size_t extent, bool is_be, bool is_checked);
+
+    /*! Read the @p UInt at @p offset */
+    template<typename UInt>
+        UInt
+        load(std::size_t offset) const;
+
+    /*! Throw if @p size bytes at @p offset run past the end of an unvalidated image */
+    void
+    check_range(std::size_t offset, std::size_t size) const;
+
+    [[noreturn]] void
+    throw_out_of_range(std::size_t offset, std::size_t size) const;
 
 private:
-    ElfImage const* elf_file_;
-    std::size_t     offset_;
-    std::size_t     size_;
+    std::byte const* bytes_ = nullptr;
+    std::size_t      size_ = 0;
+    std::size_t      extent_ = 0;
+    bool             is_be_ = false;
+    bool             is_checked_ = true;
 };
 
 
+inline std::size_t ElfImageView::
+size() const
+{
+    return size_;
+}
+
+
+inline bool ElfImageView::
+isBigEndian() const
+{
+    return is_be_;
+}
+
+
+inline void ElfImageView::
+check_range(std::size_t offset, std::size_t size) const
+{
+    if (is_checked_ && (offset > extent_ || size > extent_ - offset))
+    {
+        throw_out_of_range(offset, size);
+    }
+}
+
+
+template<typename UInt>
+    inline UInt ElfImageView::
+    load(std::size_t offset) const
+    {
+        check_range(offset, sizeof(UInt));
+        return load_uint<UInt>(bytes_ + offset, is_be_);
+    }
+
+
+inline std::byte const* ElfImageView::
+get_bytes(std::size_t offset) const
+{
+    check_range(offset, 0);
+    return bytes_ + offset;
+}
+
+
+inline std::uint8_t ElfImageView::
+get_uint8(std::size_t offset) const
+{
+    return load<std::uint8_t>(offset);
+}
+
+
+inline std::uint16_t ElfImageView::
+get_uint16(std::size_t offset) const
+{
+    return load<std::uint16_t>(offset);
+}
+
+
+inline std::uint32_t ElfImageView::
+get_uint32(std::size_t offset) const
+{
+    return load<std::uint32_t>(offset);
+}
+
+
+inline std::uint64_t ElfImageView::
+get_uint64(std::size_t offset) const
+{
+    return load<std::uint64_t>(offset);
+}
+
+
+inline std::uint64_t ElfImageView::
+get_uleb128(std::size_t offset, std::size_t& length) const
+{
+    std::byte const* bytes = get_bytes(offset);
+    std::uint64_t value;
+    std::byte const* next = offset < size_ ? read_uleb128(bytes, bytes_ + size_, value) : nullptr;
+    if (next == nullptr)
+    {
+        throw_out_of_range(offset, offset < size_ ? size_ - offset + 1 : 1);
+    }
+    length = static_cast<std::size_t>(next - bytes);
+    return value;
+}
+
+
+inline std::int64_t ElfImageView::
+get_sleb128(std::size_t offset, std::size_t& length) const
+{
+    std::byte const* bytes = get_bytes(offset);
+    std::int64_t value;
+    std::byte const* next = offset < size_ ? read_sleb128(bytes, bytes_ + size_, value) : nullptr;
+    if (next == nullptr)
+    {
+        throw_out_of_range(offset, offset < size_ ? size_ - offset + 1 : 1);
+    }
+    length = static_cast<std::size_t>(next - bytes);
+    return value;
+}
+
+
 /*!
  * Wrap the actual ELF file image in a RAII object.
  *
@@ -110,8 +273,8 @@ private:
  * accessors to read from the image in host format.
  *
  * The target ELF file can be memory mapped or buffered (according to what's
- * available on the host platform) and access to it metered out through proxy
- * objects.
+ * available on the host platform), or already in memory somewhere else and
+ * used where it lies, and access to it metered out through proxy objects.
  */
 class ElfImage
 {
@@ -119,11 +282,36 @@ public:
     using ByteSequence = std::vector<std::byte>;
 
 public:
-    /*! Constructs an ElfImage from a named file */
-    ElfImage(std::string const& filename);
+    /*!
+     * Constructs an ElfImage from a named file, recording the memory it takes
+     * in @p account if there is one
+     */
+    ElfImage(std::string const& filename, MemoryAccount* account = nullptr);
+
+    /*!
+     * Constructs an ElfImage from a named file without throwing: if the file
+     * can't be read the image is empty and @p error says why.
+     */
+    ElfImage(std::string const& filename, ParseError& error, MemoryAccount* account = nullptr);
 
-    /*! Constructs an ElfImage from an istream object */
-    ElfImage(ByteSequence const& byte_seq);
+    /*! Constructs an ElfImage from a copy of a sequence of bytes */
+    ElfImage(ByteSequence const& byte_seq, MemoryAccount* account = nullptr);
+
+    /*!
+     * Constructs an ElfImage on the @p size bytes at @p bytes without copying
+     * them.  The caller keeps the bytes alive for as long as the image.
+     */
+    ElfImage(std::byte const* bytes, std::size_t size);
+
+    /*!
+     * Constructs an ElfImage on the @p size bytes at @p bytes without copying
+     * them, sharing in their ownership.
+     *
+     * An image embedded in a bigger buffer can be shared with the aliasing
+     * constructor of std::shared_ptr, which points at the embedded image but
+     * keeps the whole buffer alive.
+     */
+    ElfImage(std::shared_ptr<std::byte const> bytes, std::size_t size);
 
     ElfImage(ElfImage const&) = delete;
 
@@ -134,6 +322,23 @@ public:
     void
     setBigEndian(bool isBigEndian);
 
+    bool
+    isBigEndian() const;
+
+    /*!
+     * Whether the image has been through validate_elf() and can be trusted.
+     *
+     * Reads from an image that hasn't been validated are bounds-checked and
+     * throw std::out_of_range if they would go past its end; reads from a
+     * validated image are not checked, and it is up to the caller to stay
+     * within the structures the validator checked.
+     */
+    bool
+    validated() const;
+
+    void
+    set_validated(bool is_validated);
+
     std::size_t
     size() const;
 
@@ -175,8 +380,24 @@ public:
     get_string(std::size_t offset, std::size_t maxlen) const;
 
 private:
-    ByteSequence data_;
-    bool         is_be_;
+    using Bytes = std::vector<std::byte, CountingAllocator<std::byte>>;
+
+    void
+    load(std::string const& filename, ParseError& error);
+
+    /*! Throw if @p size bytes at @p offset are not all in an unvalidated image */
+    void
+    check_range(std::size_t offset, std::size_t size) const;
+
+    [[noreturn]] void
+    throw_out_of_range(std::size_t offset, std::size_t size) const;
+
+    Bytes                            data_;     /**< the image, if it's ours */
+    std::shared_ptr<std::byte const> owner_;    /**< the image, if it's shared */
+    std::byte const*                 bytes_ = nullptr;
+    std::size_t                      size_ = 0;
+    bool                             is_be_;
+    bool                             is_validated_ = false;
 };
 
 #endif /* EDHELIND_ELFIMAGE_H */
@@ -0,0 +1,232 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "libedhel/elfprobe.h"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#if defined(_WIN32)
+# include <cstdio>
+#else
+# include <cerrno>
+# include <fcntl.h>
+# include <unistd.h>
+#endif
+
+
+namespace
+{
+    /** How much of the start of a file a probe reads */
+    constexpr std::size_t probe_size = 4096;
+
+    /** Read an unsigned integer of type T in the target byte order */
+    template<typename T>
+        T
+        read_uint(std::byte const* bytes, bool big_endian)
+        {
+            T value = 0;
+            for (std::size_t i = 0; i < sizeof(T); ++i)
+            {
+                std::size_t shift = 8 * (big_endian ? sizeof(T) - 1 - i : i);
+                value = static_cast<T>(value | static_cast<T>(std::to_integer<T>(bytes[i]) << shift));
+            }
+            return value;
+        }
+
+    /**
+     * Decode up to ElfProbe::max_segments program headers from @p phdrs, which
+     * holds @p size bytes of the program header table.
+     */
+    void
+    decode_segments(ElfProbe& probe, std::byte const* phdrs, std::size_t size)
+    {
+        std::size_t entry_size = probe.is_64bit_ ? sizeof(Elf64_Phdr) : sizeof(Elf32_Phdr);
+        if (probe.phentsize_ < entry_size)
+        {
+            return;
+        }
+
+        bool be = probe.is_big_endian_;
+        std::size_t count = std::min<std::size_t>({probe.phnum_, ElfProbe::max_segments, size / probe.phentsize_});
+        for (std::size_t i = 0; i < count; ++i)
+        {
+            std::byte const* phdr = phdrs + i * probe.phentsize_;
+            ElfProbeSegment& segment = probe.segments_[i];
+            if (probe.is_64bit_)
+            {
+                segment.type_ = static_cast<PType>(read_uint<std::uint32_t>(phdr + offsetof(Elf64_Phdr, p_type), be));
+                segment.flags_ = read_uint<std::uint32_t>(phdr + offsetof(Elf64_Phdr, p_flags), be);
+                segment.offset_ = read_uint<std::uint64_t>(phdr + offsetof(Elf64_Phdr, p_offset), be);
+                segment.vaddr_ = read_uint<std::uint64_t>(phdr + offsetof(Elf64_Phdr, p_vaddr), be);
+                segment.filesz_ = read_uint<std::uint64_t>(phdr + offsetof(Elf64_Phdr, p_filesz), be);
+                segment.memsz_ = read_uint<std::uint64_t>(phdr + offsetof(Elf64_Phdr, p_memsz), be);
+            }
+            else
+            {
+                segment.type_ = static_cast<PType>(read_uint<std::uint32_t>(phdr + offsetof(Elf32_Phdr, p_type), be));
+                segment.flags_ = read_uint<std::uint32_t>(phdr + offsetof(Elf32_Phdr, p_flags), be);
+                segment.offset_ = read_uint<std::uint32_t>(phdr + offsetof(Elf32_Phdr, p_offset), be);
+                segment.vaddr_ = read_uint<std::uint32_t>(phdr + offsetof(Elf32_Phdr, p_vaddr), be);
+                segment.filesz_ = read_uint<std::uint32_t>(phdr + offsetof(Elf32_Phdr, p_filesz), be);
+                segment.memsz_ = read_uint<std::uint32_t>(phdr + offsetof(Elf32_Phdr, p_memsz), be);
+            }
+        }
+        probe.segment_count_ = static_cast<std::uint16_t>(count);
+    }
+
+    /** The number of bytes of program headers a probe wants */
+    std::size_t
+    segments_size(ElfProbe const& probe)
+    {
+        return std::min<std::size_t>(probe.phnum_, ElfProbe::max_segments) * probe.phentsize_;
+    }
+
+    /**
+     * Read up to @p size bytes at @p offset of @p file_name into @p buffer.
+     * @returns the number of bytes read, or -1 on error
+     */
+    long long
+    read_at(std::string const& file_name, std::uint64_t offset, std::byte* buffer, std::size_t size)
+    {
+#if defined(_WIN32)
+        std::FILE* file = std::fopen(file_name.c_str(), "rb");
+        if (file == nullptr)
+        {
+            return -1;
+        }
+        long long bytes_read = -1;
+        if (_fseeki64(file, static_cast<long long>(offset), SEEK_SET) == 0)
+        {
+            bytes_read = static_cast<long long>(std::fread(buffer, 1, size, file));
+        }
+        std::fclose(file);
+        return bytes_read;
+#else
+        int fd = ::open(file_name.c_str(), O_RDONLY | O_CLOEXEC);
+        if (fd == -1)
+        {
+            return -1;
+        }
+        ssize_t bytes_read;
+        do
+        {
+            bytes_read = ::pread(fd, buffer, size, static_cast<off_t>(offset));
+        } while (bytes_read == -1 && errno == EINTR);
+        ::close(fd);
+        return bytes_read;
+#endif
+    }
+} // anonymous namespace
+
+
+ElfProbe
+probe_elf(std::byte const* bytes, std::size_t size, bool with_segments)
+{
+    ElfProbe probe{};
+    probe.status_ = ElfProbe::Status::NotElf;
+    if (size < offsetof(Elf32_Ehdr, ei_version)
+     || std::memcmp(bytes, elf_magic, sizeof(elf_magic)) != 0)
+    {
+        return probe;
+    }
+
+    auto e_class = static_cast<EhiClass>(bytes[offsetof(Elf32_Ehdr, ei_class)]);
+    auto e_data = static_cast<EhiData>(bytes[offsetof(Elf32_Ehdr, ei_data)]);
+    if ((e_class != EhiClass::ELFCLASS32 && e_class != EhiClass::ELFCLASS64)
+     || (e_data != EhiData::ELFDATA2LSB && e_data != EhiData::ELFDATA2MSB))
+    {
+        return probe;
+    }
+
+    probe.is_64bit_ = e_class == EhiClass::ELFCLASS64;
+    probe.is_big_endian_ = e_data == EhiData::ELFDATA2MSB;
+    if (size < (probe.is_64bit_ ? sizeof(Elf64_Ehdr) : sizeof(Elf32_Ehdr)))
+    {
+        probe.status_ = ElfProbe::Status::Truncated;
+        return probe;
+    }
+
+    // The fields up to e_version are the same in both classes.
+    bool be = probe.is_big_endian_;
+    probe.status_ = ElfProbe::Status::Elf;
+    probe.osabi_ = static_cast<EhiOsAbi>(bytes[offsetof(Elf32_Ehdr, ei_osabi)]);
+    probe.type_ = static_cast<EhType>(read_uint<std::uint16_t>(bytes + offsetof(Elf32_Ehdr, e_type), be));
+    probe.machine_ = static_cast<EhMachine>(read_uint<std::uint16_t>(bytes + offsetof(Elf32_Ehdr, e_machine), be));
+    if (probe.is_64bit_)
+    {
+        probe.entry_ = read_uint<std::uint64_t>(bytes + offsetof(Elf64_Ehdr, e_entry), be);
+        probe.phoff_ = read_uint<std::uint64_t>(bytes + offsetof(Elf64_Ehdr, e_phoff), be);
+        probe.shoff_ = read_uint<std::uint64_t>(bytes + offsetof(Elf64_Ehdr, e_shoff), be);
+        probe.flags_ = read_uint<std::uint32_t>(bytes + offsetof(Elf64_Ehdr, e_flags), be);
+        probe.phentsize_ = read_uint<std::uint16_t>(bytes + offsetof(Elf64_Ehdr, e_phentsize), be);
+        probe.phnum_ = read_uint<std::uint16_t>(bytes + offsetof(Elf64_Ehdr, e_phnum), be);
+        probe.shentsize_ = read_uint<std::uint16_t>(bytes + offsetof(Elf64_Ehdr, e_shentsize), be);
+        probe.shnum_ = read_uint<std::uint16_t>(bytes + offsetof(Elf64_Ehdr, e_shnum), be);
+        probe.shstrndx_ = read_uint<std::uint16_t>(bytes + offsetof(Elf64_Ehdr, e_shstrndx), be);
+    }
+    else
+    {
+        probe.entry_ = read_uint<std::uint32_t>(bytes + offsetof(Elf32_Ehdr, e_entry), be);
+        probe.phoff_ = read_uint<std::uint32_t>(bytes + offsetof(Elf32_Ehdr, e_phoff), be);
+        probe.shoff_ = read_uint<std::uint32_t>(bytes + offsetof(Elf32_Ehdr, e_shoff), be);
+        probe.flags_ = read_uint<std::uint32_t>(bytes + offsetof(Elf32_Ehdr, e_flags), be);
+        probe.phentsize_ = read_uint<std::uint16_t>(bytes + offsetof(Elf32_Ehdr, e_phentsize), be);
+        probe.phnum_ = read_uint<std::uint16_t>(bytes + offsetof(Elf32_Ehdr, e_phnum), be);
+        probe.shentsize_ = read_uint<std::uint16_t>(bytes + offsetof(Elf32_Ehdr, e_shentsize), be);
+        probe.shnum_ = read_uint<std::uint16_t>(bytes + offsetof(Elf32_Ehdr, e_shnum), be);
+        probe.shstrndx_ = read_uint<std::uint16_t>(bytes + offsetof(Elf32_Ehdr, e_shstrndx), be);
+    }
+
+    if (with_segments && probe.phoff_ < size && segments_size(probe) <= size - probe.phoff_)
+    {
+        decode_segments(probe, bytes + probe.phoff_, size - probe.phoff_);
+    }
+    return probe;
+}
+
+
+ElfProbe
+probe_elf(std::string const& file_name, bool with_segments)
+{
+    std::byte page[probe_size];
+    long long bytes_read = read_at(file_name, 0, page, sizeof(page));
+    if (bytes_read < 0)
+    {
+        ElfProbe probe{};
+        probe.status_ = ElfProbe::Status::Unreadable;
+        return probe;
+    }
+
+    ElfProbe probe = probe_elf(page, static_cast<std::size_t>(bytes_read), with_segments);
+    if (with_segments
+     && probe.status_ == ElfProbe::Status::Elf
+     && probe.segment_count_ == 0
+     && probe.phnum_ != 0)
+    {
+        // The program headers run past the first page.
+        std::vector<std::byte> phdrs(segments_size(probe));
+        bytes_read = read_at(file_name, probe.phoff_, phdrs.data(), phdrs.size());
+        if (bytes_read > 0)
+        {
+            decode_segments(probe, phdrs.data(), static_cast<std::size_t>(bytes_read));
+        }
+    }
+    return probe;
+}
@@ -0,0 +1,108 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef EDHELIND_ELFPROBE_H
+#define EDHELIND_ELFPROBE_H
+
+#include <cstddef>
+#include <cstdint>
+#include "libedhel/elf.h"
+#include <string>
+
+
+/**
+ * The bits of one program header an ElfProbe keeps.
+ */
+struct ElfProbeSegment
+{
+    PType         type_;
+    PFlags        flags_;
+    std::uint64_t offset_;
+    std::uint64_t vaddr_;
+    std::uint64_t filesz_;
+    std::uint64_t memsz_;
+};
+
+
+/**
+ * A summary of an ELF file taken from its ELF header, and optionally its
+ * program headers, without reading the rest of the file.
+ *
+ * This is plain data: it holds no resources and can be copied around freely.
+ */
+struct ElfProbe
+{
+    enum class Status: std::uint8_t
+    {
+        Elf,        /**< an ELF header was read; the fields below are valid */
+        NotElf,     /**< the file does not start with an ELF identification */
+        Truncated,  /**< an ELF identification, but the header is cut short */
+        Unreadable, /**< the file could not be opened or read */
+    };
+
+    /** The most program headers an ElfProbe will keep */
+    static constexpr std::size_t max_segments = 24;
+
+    Status          status_;
+    bool            is_64bit_;
+    bool            is_big_endian_;
+    EhiOsAbi        osabi_;
+    EhType          type_;
+    EhMachine       machine_;
+    std::uint32_t   flags_;
+    std::uint64_t   entry_;
+    std::uint64_t   phoff_;
+    std::uint64_t   shoff_;
+    std::uint16_t   phentsize_;
+    std::uint16_t   phnum_;
+    std::uint16_t   shentsize_;
+    std::uint16_t   shnum_;
+    std::uint16_t   shstrndx_;
+
+    /**
+     * How many of the program headers were read into @c segments_: zero unless
+     * they were asked for, and never more than @c max_segments.
+     */
+    std::uint16_t   segment_count_;
+    ElfProbeSegment segments_[max_segments];
+};
+
+
+/**
+ * Probe the file @p file_name for its ELF header.
+ *
+ * Only the first page of the file is read, with a single read.  When
+ * @p with_segments is set the program headers are decoded too; they are almost
+ * always within the first page, and if not they take one more read.
+ *
+ * Nothing is thrown: problems are reported in ElfProbe::status_.
+ */
+ElfProbe
+probe_elf(std::string const& file_name, bool with_segments = false);
+
+
+/**
+ * Probe an in-memory copy of the start of an ELF file.
+ *
+ * The program headers are decoded if @p with_segments is set and they lie
+ * entirely within the @p size bytes at @p bytes.
+ */
+ElfProbe
+probe_elf(std::byte const* bytes, std::size_t size, bool with_segments = false);
+
+#endif /* EDHELIND_ELFPROBE_H */
@@ -0,0 +1,490 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "libedhel/elfvalidator.h"
+
+#include <cstddef>
+#include <cstring>
+#include "libedhel/elf.h"
+#include "libedhel/elfheader.h"
+#include "libedhel/elfimage.h"
+#include "libedhel/symbol.h"
+#include <vector>
+
+
+namespace
+{
+    /** Whether @p size bytes at @p offset lie within @p limit bytes */
+    inline bool
+    fits(std::uint64_t offset, std::uint64_t size, std::uint64_t limit)
+    {
+        return offset <= limit && size <= limit - offset;
+    }
+
+    /** Move a value up to the nearest multiple of 4 */
+    inline std::uint64_t
+    align4(std::uint64_t val)
+    {
+        return (val + 3) &~ std::uint64_t(3);
+    }
+
+    /** The fields of a section header the validator cares about */
+    struct SectionFields
+    {
+        std::uint64_t shdr_;        /**< file offset of the section header */
+        std::uint32_t name_;
+        SType         type_;
+        std::uint64_t offset_;
+        std::uint64_t size_;
+        std::uint32_t link_;
+        std::uint64_t entsize_;
+    };
+
+    /**
+     * One pass over the structure of an ELF image, recording the first fatal
+     * problem and the first problem that makes it untrustworthy.
+     */
+    class Validator
+    {
+    public:
+        explicit Validator(ElfImage& image)
+        : image_(image)
+        , file_size_(image.size())
+        { }
+
+        ElfValidation
+        run();
+
+    private:
+        /** Record a fatal problem; returns false to stop the pass */
+        bool
+        fail(ParseErrc code, std::uint64_t offset)
+        {
+            result_.error_ = ParseError{code, offset};
+            return false;
+        }
+
+        /** Record the first problem that makes the image untrustworthy */
+        void
+        distrust(ParseErrc code, std::uint64_t offset)
+        {
+            if (!result_.untrusted_)
+            {
+                result_.untrusted_ = ParseError{code, offset};
+            }
+        }
+
+        bool
+        check_header();
+
+        bool
+        read_section_headers(ElfHeader const& elf_header);
+
+        bool
+        check_sections();
+
+        void
+        check_symbols(SectionFields const& symtab);
+
+        void
+        check_section_names();
+
+        bool
+        check_segments(ElfHeader const& elf_header);
+
+        bool
+        check_notes(std::uint64_t offset, std::uint64_t size);
+
+        SectionFields
+        section_fields(std::uint64_t shdr) const;
+
+        std::uint64_t
+        symbol_size() const
+        { return is64_ ? sizeof(Elf64::Sym) : sizeof(Elf32::Sym); }
+
+    private:
+        ElfImage&                  image_;
+        std::uint64_t const        file_size_;
+        bool                       is64_ = false;
+        std::uint32_t              shstrndx_ = 0;
+        std::vector<SectionFields> sections_;
+        ElfValidation              result_;
+    };
+
+
+    ElfValidation Validator::
+    run()
+    {
+        if (check_header())
+        {
+            ElfHeader elf_header(image_.view(0, is64_ ? sizeof(Elf64_Ehdr) : sizeof(Elf32_Ehdr)));
+            if (read_section_headers(elf_header) && check_sections())
+            {
+                check_section_names();
+                check_segments(elf_header);
+            }
+        }
+        if (result_.error_ && !result_.untrusted_)
+        {
+            result_.untrusted_ = result_.error_;
+        }
+        image_.set_validated(!result_.untrusted_);
+        return result_;
+    }
+
+
+    /** The identification, and that there's room for the rest of the header */
+    bool Validator::
+    check_header()
+    {
+        if (file_size_ < sizeof(Elf32_Ehdr))
+        {
+            return fail(ParseErrc::TooSmall, 0);
+        }
+        if (std::memcmp(image_.get_bytes(offsetof(Elf32_Ehdr, ei_magic)), elf_magic, sizeof(elf_magic)) != 0)
+        {
+            return fail(ParseErrc::BadMagic, 0);
+        }
+
+        auto e_class = static_cast<EhiClass>(image_.get_uint8(offsetof(Elf32_Ehdr, ei_class)));
+        if (e_class != EhiClass::ELFCLASS32 && e_class != EhiClass::ELFCLASS64)
+        {
+            return fail(ParseErrc::BadClass, offsetof(Elf32_Ehdr, ei_class));
+        }
+        auto e_data = static_cast<EhiData>(image_.get_uint8(offsetof(Elf32_Ehdr, ei_data)));
+        if (e_data != EhiData::ELFDATA2LSB && e_data != EhiData::ELFDATA2MSB)
+        {
+            return fail(ParseErrc::BadEncoding, offsetof(Elf32_Ehdr, ei_data));
+        }
+
+        is64_ = e_class == EhiClass::ELFCLASS64;
+        if (is64_ && file_size_ < sizeof(Elf64_Ehdr))
+        {
+            return fail(ParseErrc::TooSmall, 0);
+        }
+        image_.setBigEndian(e_data == EhiData::ELFDATA2MSB);
+        return true;
+    }
+
+
+    SectionFields Validator::
+    section_fields(std::uint64_t shdr) const
+    {
+        if (is64_)
+        {
+            return SectionFields{
+                shdr,
+                image_.get_uint32(shdr + offsetof(Elf64_Shdr, sh_name)),
+                static_cast<SType>(image_.get_uint32(shdr + offsetof(Elf64_Shdr, sh_type))),
+                image_.get_uint64(shdr + offsetof(Elf64_Shdr, sh_offset)),
+                image_.get_uint64(shdr + offsetof(Elf64_Shdr, sh_size)),
+                image_.get_uint32(shdr + offsetof(Elf64_Shdr, sh_link)),
+                image_.get_uint64(shdr + offsetof(Elf64_Shdr, sh_entsize))
+            };
+        }
+        return SectionFields{
+            shdr,
+            image_.get_uint32(shdr + offsetof(Elf32_Shdr, sh_name)),
+            static_cast<SType>(image_.get_uint32(shdr + offsetof(Elf32_Shdr, sh_type))),
+            image_.get_uint32(shdr + offsetof(Elf32_Shdr, sh_offset)),
+            image_.get_uint32(shdr + offsetof(Elf32_Shdr, sh_size)),
+            image_.get_uint32(shdr + offsetof(Elf32_Shdr, sh_link)),
+            image_.get_uint32(shdr + offsetof(Elf32_Shdr, sh_entsize))
+        };
+    }
+
+
+    /** The section header table, allowing for extended section numbering */
+    bool Validator::
+    read_section_headers(ElfHeader const& elf_header)
+    {
+        std::uint64_t const shoff = elf_header.shoff();
+        std::uint64_t const shentsize = elf_header.shentsize();
+        std::uint64_t shnum = elf_header.shnum();
+        shstrndx_ = elf_header.shstrndx();
+        if (shoff == 0 && shnum == 0)
+        {
+            return true;
+        }
+
+        if (shentsize < (is64_ ? sizeof(Elf64_Shdr) : sizeof(Elf32_Shdr)))
+        {
+            return fail(ParseErrc::BadSectionHeaderSize, shoff);
+        }
+        if (!fits(shoff, shentsize, file_size_))
+        {
+            return fail(ParseErrc::SectionHeadersOutOfBounds, shoff);
+        }
+        if (shnum == 0 || shstrndx_ == SHN_XINDEX)
+        {
+            SectionFields section0 = section_fields(shoff);
+            if (shnum == 0)
+            {
+                shnum = section0.size_;
+            }
+            if (shstrndx_ == SHN_XINDEX)
+            {
+                shstrndx_ = section0.link_;
+            }
+        }
+        if (shnum > file_size_ / shentsize || !fits(shoff, shnum * shentsize, file_size_))
+        {
+            return fail(ParseErrc::SectionHeadersOutOfBounds, shoff);
+        }
+
+        sections_.reserve(shnum);
+        for (std::uint64_t i = 0; i < shnum; ++i)
+        {
+            sections_.push_back(section_fields(shoff + i * shentsize));
+        }
+        return true;
+    }
+
+
+    /** Section contents and entry sizes */
+    bool Validator::
+    check_sections()
+    {
+        for (auto const& section: sections_)
+        {
+            bool in_file = fits(section.offset_, section.size_, file_size_);
+            switch (section.type_)
+            {
+            case SType::SHT_NULL:
+            case SType::SHT_NOBITS:
+                break;
+
+            case SType::SHT_SYMTAB:
+            case SType::SHT_DYNSYM:
+                // Symbols are read whole, even the last one if the size is ragged.
+                if (!in_file
+                 || !fits(section.offset_, (section.size_ + symbol_size() - 1) / symbol_size() * symbol_size(), file_size_))
+                {
+                    return fail(ParseErrc::SectionOutOfBounds, section.shdr_);
+                }
+                if (section.entsize_ != symbol_size() || section.size_ % symbol_size() != 0)
+                {
+                    distrust(ParseErrc::BadEntrySize, section.shdr_);
+                }
+                check_symbols(section);
+                break;
+
+            case SType::SHT_STRTAB:
+                if (!in_file)
+                {
+                    return fail(ParseErrc::SectionOutOfBounds, section.shdr_);
+                }
+                if (section.size_ != 0 && image_.get_uint8(section.offset_ + section.size_ - 1) != 0)
+                {
+                    distrust(ParseErrc::UnterminatedString, section.shdr_);
+                }
+                break;
+
+            case SType::SHT_NOTE:
+                if (!in_file)
+                {
+                    return fail(ParseErrc::SectionOutOfBounds, section.shdr_);
+                }
+                if (!check_notes(section.offset_, section.size_))
+                {
+                    return false;
+                }
+                break;
+
+            case SType::SHT_REL:
+            case SType::SHT_RELA:
+            case SType::SHT_DYNAMIC:
+            case SType::SHT_SYMTAB_SHNDX: {
+                std::uint64_t word = is64_ ? 8 : 4;
+                std::uint64_t entsize = section.type_ == SType::SHT_SYMTAB_SHNDX ? 4
+                                      : section.type_ == SType::SHT_RELA ? 3 * word
+                                      : 2 * word;
+                if (section.entsize_ != entsize || section.size_ % entsize != 0)
+                {
+                    distrust(ParseErrc::BadEntrySize, section.shdr_);
+                }
+                if (!in_file)
+                {
+                    distrust(ParseErrc::SectionOutOfBounds, section.shdr_);
+                }
+                break;
+            }
+
+            default:
+                if (!in_file)
+                {
+                    distrust(ParseErrc::SectionOutOfBounds, section.shdr_);
+                }
+                break;
+            }
+        }
+        return true;
+    }
+
+
+    /** A symbol table's string table, and the names of its symbols */
+    void Validator::
+    check_symbols(SectionFields const& symtab)
+    {
+        if (symtab.link_ >= sections_.size() || sections_[symtab.link_].type_ != SType::SHT_STRTAB)
+        {
+            distrust(ParseErrc::BadSectionIndex, symtab.shdr_);
+            return;
+        }
+        std::uint64_t strtab_size = sections_[symtab.link_].size_;
+        for (std::uint64_t offset = 0; offset + symbol_size() <= symtab.size_; offset += symbol_size())
+        {
+            // st_name comes first in both classes.
+            if (image_.get_uint32(symtab.offset_ + offset) >= strtab_size)
+            {
+                distrust(ParseErrc::NameOutOfBounds, symtab.offset_ + offset);
+                return;
+            }
+        }
+    }
+
+
+    /** The section name string table and the names in it */
+    void Validator::
+    check_section_names()
+    {
+        if (sections_.empty() || shstrndx_ == 0)
+        {
+            return;
+        }
+        if (shstrndx_ >= sections_.size() || sections_[shstrndx_].type_ != SType::SHT_STRTAB)
+        {
+            distrust(ParseErrc::BadSectionIndex, 0);
+            return;
+        }
+        std::uint64_t shstrtab_size = sections_[shstrndx_].size_;
+        for (auto const& section: sections_)
+        {
+            if (section.name_ >= shstrtab_size && section.type_ != SType::SHT_NULL)
+            {
+                distrust(ParseErrc::NameOutOfBounds, section.shdr_);
+                return;
+            }
+        }
+    }
+
+
+    /** The program header table and the segment contents */
+    bool Validator::
+    check_segments(ElfHeader const& elf_header)
+    {
+        std::uint64_t const phoff = elf_header.phoff();
+        std::uint64_t const phentsize = elf_header.phentsize();
+        std::uint64_t const phnum = elf_header.phnum();
+        if (phnum == 0)
+        {
+            // Nothing reads the table then, but a wild e_phoff is still wrong.
+            if (!fits(phoff, 0, file_size_))
+            {
+                distrust(ParseErrc::ProgramHeadersOutOfBounds, phoff);
+            }
+            return true;
+        }
+        if (phentsize < (is64_ ? sizeof(Elf64_Phdr) : sizeof(Elf32_Phdr)))
+        {
+            return fail(ParseErrc::BadProgramHeaderSize, phoff);
+        }
+        if (!fits(phoff, phnum * phentsize, file_size_))
+        {
+            return fail(ParseErrc::ProgramHeadersOutOfBounds, phoff);
+        }
+
+        for (std::uint64_t i = 0; i < phnum; ++i)
+        {
+            std::uint64_t phdr = phoff + i * phentsize;
+            auto type = static_cast<PType>(image_.get_uint32(phdr + offsetof(Elf32_Phdr, p_type)));
+            std::uint64_t offset = is64_ ? image_.get_uint64(phdr + offsetof(Elf64_Phdr, p_offset))
+                                         : image_.get_uint32(phdr + offsetof(Elf32_Phdr, p_offset));
+            std::uint64_t filesz = is64_ ? image_.get_uint64(phdr + offsetof(Elf64_Phdr, p_filesz))
+                                         : image_.get_uint32(phdr + offsetof(Elf32_Phdr, p_filesz));
+            bool in_file = fits(offset, filesz, file_size_);
+            switch (type)
+            {
+            case PType::PT_INTERP:
+                if (!in_file)
+                {
+                    return fail(ParseErrc::SegmentOutOfBounds, phdr);
+                }
+                if (filesz == 0 || image_.get_uint8(offset + filesz - 1) != 0)
+                {
+                    distrust(ParseErrc::UnterminatedString, phdr);
+                }
+                break;
+
+            case PType::PT_NOTE:
+                if (!in_file)
+                {
+                    return fail(ParseErrc::SegmentOutOfBounds, phdr);
+                }
+                if (!check_notes(offset, filesz))
+                {
+                    return false;
+                }
+                break;
+
+            default:
+                if (!in_file)
+                {
+                    distrust(ParseErrc::SegmentOutOfBounds, phdr);
+                }
+                break;
+            }
+        }
+        return true;
+    }
+
+
+    /**
+     * The notes in the @p size bytes at @p offset, walked the same way as
+     * NoteTable walks them.
+     */
+    bool Validator::
+    check_notes(std::uint64_t offset, std::uint64_t size)
+    {
+        std::uint64_t parsed_size = 0;
+        while (parsed_size < size)
+        {
+            std::uint64_t note = offset + parsed_size;
+            if (!fits(parsed_size, offsetof(ElfNote, name), size))
+            {
+                return fail(ParseErrc::NoteOutOfBounds, note);
+            }
+            std::uint64_t namesz = image_.get_uint32(note + offsetof(ElfNote, namesz));
+            std::uint64_t descsz = image_.get_uint32(note + offsetof(ElfNote, descsz));
+            if (!fits(parsed_size, offsetof(ElfNote, name) + align4(namesz) + descsz, size))
+            {
+                return fail(ParseErrc::NoteOutOfBounds, note);
+            }
+            parsed_size += offsetof(ElfNote, name) + align4(namesz) + align4(descsz);
+        }
+        return true;
+    }
+} // anonymous namespace
+
+
+ElfValidation
+validate_elf(ElfImage& image)
+{
+    image.set_validated(false);
+    return Validator(image).run();
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef EDHELIND_ELFVALIDATOR_H
+#define EDHELIND_ELFVALIDATOR_H
+
+#include "libedhel/parseerror.h"
+
+class ElfImage;
+
+
+/**
+ * What validating an ELF image found.
+ */
+struct ElfValidation
+{
+    /** The first problem that stops the file from being parsed at all */
+    ParseError error_;
+
+    /**
+     * The first problem that stops the file from being trusted: the file can
+     * still be parsed, but reads from it stay bounds-checked
+     */
+    ParseError untrusted_;
+};
+
+
+/**
+ * Validate the structure of an ELF file in one pass over its headers.
+ *
+ * For the file to be parsed at all, the ELF identification and header, the
+ * section and program header tables, and the contents of every section and
+ * segment decoded while parsing (symbol tables, string tables, notes and the
+ * interpreter) must lie within @p image.
+ *
+ * For it to be trusted, in addition every section and segment must lie within
+ * the image, every string table and the interpreter must be NUL-terminated,
+ * symbol, relocation and dynamic sections must have the right entry size,
+ * and section and symbol names and section links must refer to things that
+ * exist.  A trusted image is marked as validated, and reads from it skip their
+ * bounds checks.
+ *
+ * As a side effect the byte order of @p image is set from the ELF
+ * identification.  Nothing is thrown.
+ */
+ElfValidation
+validate_elf(ElfImage& image);
+
+#endif /* EDHELIND_ELFVALIDATOR_H */
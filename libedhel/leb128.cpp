@@ -0,0 +1,519 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "libedhel/leb128.h"
+
+#include <algorithm>
+#include "libedhel/byteorder.h"
+#include <cstdint>
+#include <iterator>
+#include <type_traits>
+#include <vector>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+# define EDHEL_LEB128_SSSE3 1
+# define EDHEL_LEB128_TARGET __attribute__((target("ssse3")))
+# include <immintrin.h>
+#elif defined(__GNUC__) && defined(__aarch64__)
+# define EDHEL_LEB128_NEON 1
+# define EDHEL_LEB128_TARGET
+# include <arm_neon.h>
+#endif
+
+
+namespace
+{
+    inline std::byte const*
+    read_one(std::byte const* bytes, std::byte const* end, std::uint64_t& value)
+    { return read_uleb128(bytes, end, value); }
+
+    inline std::byte const*
+    read_one(std::byte const* bytes, std::byte const* end, std::int64_t& value)
+    { return read_sleb128(bytes, end, value); }
+
+    /** Decode the rest of a run a value at a time */
+    template<typename Value>
+        Leb128Run
+        decode_scalar(std::byte const* bytes, std::size_t size, std::size_t count, Value* values, Leb128Run run)
+        {
+            std::byte const* cursor = bytes + run.size_;
+            std::byte const* end = bytes + size;
+            for (; run.count_ < count; ++run.count_)
+            {
+                std::byte const* next = read_one(cursor, end, values[run.count_]);
+                if (next == nullptr)
+                {
+                    break;
+                }
+                cursor = next;
+            }
+            run.size_ = static_cast<std::size_t>(cursor - bytes);
+            return run;
+        }
+
+#if defined(EDHEL_LEB128_SSSE3) || defined(EDHEL_LEB128_NEON)
+    /** Bytes scanned for the ends of values at a time */
+    constexpr std::size_t chunk = 16;
+
+    /** Bytes of a chunk whose ends pick a shuffle */
+    constexpr unsigned window_bits = 12;
+
+    /**
+     * How to decode the first few values of a chunk with one shuffle: it
+     * moves each value's bytes into a lane of its own, zero-filled, and the
+     * lanes are then squeezed together and widened.
+     */
+    struct ShufflePattern
+    {
+        std::uint8_t shuffle_[chunk];   /**< source byte of each lane byte, or 0x80 for none */
+        std::uint8_t sign_[chunk];      /**< the sign bit of the value in each lane */
+    };
+
+    /** What the ends of values in the window of a chunk say to do */
+    struct ShufflePlan
+    {
+        std::uint16_t pattern_;         /**< index of the ShufflePattern */
+        std::uint8_t  lane_size_;       /**< 2, 4, or 0 for no shuffle */
+        std::uint8_t  size_;            /**< bytes taken up by the values decoded */
+    };
+
+    /**
+     * A plan for every window: six values of up to 2 bytes go in 16-bit lanes,
+     * otherwise four of up to 4 bytes go in 32-bit lanes, and anything else is
+     * gathered a value at a time.
+     */
+    struct ShuffleTable
+    {
+        ShufflePlan                 plans_[1u << window_bits];
+        std::vector<ShufflePattern> patterns_;
+    };
+
+    /** The number of values decoded by a plan with lanes of @p lane_size bytes */
+    constexpr unsigned
+    lane_count(unsigned lane_size)
+    { return lane_size == 2 ? 6 : 4; }
+
+    ShuffleTable
+    make_table()
+    {
+        ShuffleTable table{};
+        for (unsigned ends = 0; ends < (1u << window_bits); ++ends)
+        {
+            std::vector<unsigned> lengths;
+            for (unsigned start = 0, i = 0; i < window_bits; ++i)
+            {
+                if ((ends & (1u << i)) != 0)
+                {
+                    lengths.push_back(i + 1 - start);
+                    start = i + 1;
+                }
+            }
+
+            ShufflePlan& plan = table.plans_[ends];
+            for (unsigned lane_size: { 2u, 4u })
+            {
+                unsigned count = lane_count(lane_size);
+                bool fits = lengths.size() >= count;
+                for (unsigned v = 0; fits && v < count; ++v)
+                {
+                    fits = lengths[v] <= lane_size;
+                }
+                if (!fits)
+                {
+                    continue;
+                }
+
+                // Patterns are shared by windows that differ only past the
+                // values they decode.
+                ShufflePattern pattern;
+                unsigned size = 0;
+                for (unsigned v = 0; v < chunk / lane_size; ++v)
+                {
+                    unsigned length = v < count ? lengths[v] : 0;
+                    std::uint64_t sign = length != 0 ? std::uint64_t(1) << (7 * length - 1) : 0;
+                    for (unsigned b = 0; b < lane_size; ++b)
+                    {
+                        pattern.shuffle_[v * lane_size + b] = static_cast<std::uint8_t>(b < length ? size + b : 0x80);
+                        pattern.sign_[v * lane_size + b] = static_cast<std::uint8_t>(sign >> (8 * b));
+                    }
+                    size += length;
+                }
+
+                std::size_t p = 0;
+                while (p < table.patterns_.size()
+                       && !std::equal(std::begin(pattern.shuffle_), std::end(pattern.shuffle_),
+                                      std::begin(table.patterns_[p].shuffle_)))
+                {
+                    ++p;
+                }
+                if (p == table.patterns_.size())
+                {
+                    table.patterns_.push_back(pattern);
+                }
+                plan = ShufflePlan{static_cast<std::uint16_t>(p), static_cast<std::uint8_t>(lane_size),
+                                   static_cast<std::uint8_t>(size)};
+                break;
+            }
+        }
+        return table;
+    }
+
+    ShuffleTable const&
+    shuffle_table()
+    {
+        static ShuffleTable const table = make_table();
+        return table;
+    }
+
+    /**
+     * The value of the @p length byte (1 to 8) LEB128 in the low bytes of the
+     * little-endian @p word: the 7-bit groups are squeezed together in pairs,
+     * then pairs of pairs, then pairs of those.
+     */
+    inline std::uint64_t
+    gather(std::uint64_t word, unsigned length)
+    {
+        word &= std::uint64_t(0x7f7f7f7f7f7f7f7f) >> (64 - 8 * length);
+        word = ((word & 0x7f007f007f007f00) >> 1) | (word & 0x007f007f007f007f);
+        word = ((word & 0x3fff00003fff0000) >> 2) | (word & 0x00003fff00003fff);
+        word = ((word & 0x0fffffff00000000) >> 4) | (word & 0x000000000fffffff);
+        return word;
+    }
+
+    inline void
+    gather(std::uint64_t word, unsigned length, std::uint64_t& value)
+    { value = gather(word, length); }
+
+    inline void
+    gather(std::uint64_t word, unsigned length, std::int64_t& value)
+    {
+        unsigned shift = 64 - 7 * length;
+        value = static_cast<std::int64_t>(gather(word, length) << shift) >> shift;
+    }
+
+# if defined(EDHEL_LEB128_SSSE3)
+    using Vector = __m128i;
+
+    EDHEL_LEB128_TARGET inline Vector
+    load(void const* bytes)
+    { return _mm_loadu_si128(static_cast<__m128i const*>(bytes)); }
+
+    /** A bit for each of the 16 bytes at @p bytes that ends a value */
+    EDHEL_LEB128_TARGET inline unsigned
+    terminators(std::byte const* bytes)
+    { return ~static_cast<unsigned>(_mm_movemask_epi8(load(bytes))) & 0xffff; }
+
+    /** Store the two 64-bit values in each of @p n 32-bit lanes of @p lanes, zero- or sign-extended */
+    template<typename Value>
+        EDHEL_LEB128_TARGET inline void
+        store_lanes32(Vector lanes, Value* values)
+        {
+            Vector high = std::is_signed<Value>::value ? _mm_srai_epi32(lanes, 31) : _mm_setzero_si128();
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(values), _mm_unpacklo_epi32(lanes, high));
+            _mm_storeu_si128(reinterpret_cast<__m128i*>(values + 2), _mm_unpackhi_epi32(lanes, high));
+        }
+
+    /** Store the eight 16-bit lanes of @p lanes as 64-bit values */
+    template<typename Value>
+        EDHEL_LEB128_TARGET inline void
+        store_lanes16(Vector lanes, Value* values)
+        {
+            if (std::is_signed<Value>::value)
+            {
+                store_lanes32(_mm_srai_epi32(_mm_unpacklo_epi16(lanes, lanes), 16), values);
+                store_lanes32(_mm_srai_epi32(_mm_unpackhi_epi16(lanes, lanes), 16), values + 4);
+            }
+            else
+            {
+                store_lanes32(_mm_unpacklo_epi16(lanes, _mm_setzero_si128()), values);
+                store_lanes32(_mm_unpackhi_epi16(lanes, _mm_setzero_si128()), values + 4);
+            }
+        }
+
+    /** Store the 16 one-byte values at @p bytes */
+    template<typename Value>
+        EDHEL_LEB128_TARGET inline void
+        widen(std::byte const* bytes, Value* values)
+        {
+            Vector v = load(bytes);
+            if (std::is_signed<Value>::value)
+            {
+                // Shifting each 7-bit value to the top of its byte and back
+                // down again sign-extends it.
+                v = _mm_add_epi8(v, v);
+                store_lanes16(_mm_srai_epi16(_mm_unpacklo_epi8(v, v), 9), values);
+                store_lanes16(_mm_srai_epi16(_mm_unpackhi_epi8(v, v), 9), values + 8);
+            }
+            else
+            {
+                store_lanes16(_mm_unpacklo_epi8(v, _mm_setzero_si128()), values);
+                store_lanes16(_mm_unpackhi_epi8(v, _mm_setzero_si128()), values + 8);
+            }
+        }
+
+    /** Decode the values of a chunk in lanes of @p lane_size bytes, storing 8 of them */
+    template<typename Value>
+        EDHEL_LEB128_TARGET inline void
+        shuffle(std::byte const* bytes, ShufflePattern const& pattern, unsigned lane_size, Value* values)
+        {
+            Vector v = _mm_shuffle_epi8(load(bytes), load(pattern.shuffle_));
+            Vector sign = load(pattern.sign_);
+            if (lane_size == 2)
+            {
+                v = _mm_or_si128(_mm_and_si128(v, _mm_set1_epi16(0x007f)),
+                                 _mm_srli_epi16(_mm_and_si128(v, _mm_set1_epi16(0x7f00)), 1));
+                if (std::is_signed<Value>::value)
+                {
+                    v = _mm_sub_epi16(_mm_xor_si128(v, sign), sign);
+                }
+                store_lanes16<Value>(v, values);
+            }
+            else
+            {
+                v = _mm_or_si128(_mm_and_si128(v, _mm_set1_epi32(0x007f007f)),
+                                 _mm_srli_epi32(_mm_and_si128(v, _mm_set1_epi32(0x7f007f00)), 1));
+                v = _mm_or_si128(_mm_and_si128(v, _mm_set1_epi32(0x00003fff)),
+                                 _mm_srli_epi32(_mm_and_si128(v, _mm_set1_epi32(0x3fff0000)), 2));
+                if (std::is_signed<Value>::value)
+                {
+                    v = _mm_sub_epi32(_mm_xor_si128(v, sign), sign);
+                }
+                store_lanes32<Value>(v, values);
+            }
+        }
+
+    bool
+    have_ssse3()
+    {
+        __builtin_cpu_init();
+        return __builtin_cpu_supports("ssse3");
+    }
+# else
+    /** A bit for each of the 16 bytes at @p bytes that ends a value */
+    inline unsigned
+    terminators(std::byte const* bytes)
+    {
+        static std::uint8_t const weights[chunk] = { 1, 2, 4, 8, 16, 32, 64, 128, 1, 2, 4, 8, 16, 32, 64, 128 };
+        uint8x16_t v = vld1q_u8(reinterpret_cast<std::uint8_t const*>(bytes));
+        uint8x16_t bits = vmulq_u8(vshrq_n_u8(vmvnq_u8(v), 7), vld1q_u8(weights));
+        return vaddv_u8(vget_low_u8(bits)) | unsigned(vaddv_u8(vget_high_u8(bits))) << 8;
+    }
+
+    inline void
+    store_lanes32(uint32x4_t lanes, std::uint64_t* values)
+    {
+        vst1q_u64(values, vmovl_u32(vget_low_u32(lanes)));
+        vst1q_u64(values + 2, vmovl_u32(vget_high_u32(lanes)));
+    }
+
+    inline void
+    store_lanes32(uint32x4_t lanes, std::int64_t* values)
+    {
+        int32x4_t s = vreinterpretq_s32_u32(lanes);
+        vst1q_s64(reinterpret_cast<int64_t*>(values), vmovl_s32(vget_low_s32(s)));
+        vst1q_s64(reinterpret_cast<int64_t*>(values + 2), vmovl_s32(vget_high_s32(s)));
+    }
+
+    inline void
+    store_lanes16(uint16x8_t lanes, std::uint64_t* values)
+    {
+        store_lanes32(vmovl_u16(vget_low_u16(lanes)), values);
+        store_lanes32(vmovl_u16(vget_high_u16(lanes)), values + 4);
+    }
+
+    inline void
+    store_lanes16(uint16x8_t lanes, std::int64_t* values)
+    {
+        int16x8_t s = vreinterpretq_s16_u16(lanes);
+        store_lanes32(vreinterpretq_u32_s32(vmovl_s16(vget_low_s16(s))), values);
+        store_lanes32(vreinterpretq_u32_s32(vmovl_s16(vget_high_s16(s))), values + 4);
+    }
+
+    /** Store the 16 one-byte values at @p bytes */
+    template<typename Value>
+        inline void
+        widen(std::byte const* bytes, Value* values)
+        {
+            uint8x16_t v = vld1q_u8(reinterpret_cast<std::uint8_t const*>(bytes));
+            if (std::is_signed<Value>::value)
+            {
+                // Shifting each 7-bit value to the top of its byte and back
+                // down again sign-extends it.
+                int8x16_t s = vshrq_n_s8(vshlq_n_s8(vreinterpretq_s8_u8(v), 1), 1);
+                store_lanes16(vreinterpretq_u16_s16(vmovl_s8(vget_low_s8(s))), values);
+                store_lanes16(vreinterpretq_u16_s16(vmovl_s8(vget_high_s8(s))), values + 8);
+            }
+            else
+            {
+                store_lanes16(vmovl_u8(vget_low_u8(v)), values);
+                store_lanes16(vmovl_u8(vget_high_u8(v)), values + 8);
+            }
+        }
+
+    /** Decode the values of a chunk in lanes of @p lane_size bytes, storing 8 of them */
+    template<typename Value>
+        inline void
+        shuffle(std::byte const* bytes, ShufflePattern const& pattern, unsigned lane_size, Value* values)
+        {
+            uint8x16_t v = vqtbl1q_u8(vld1q_u8(reinterpret_cast<std::uint8_t const*>(bytes)),
+                                      vld1q_u8(pattern.shuffle_));
+            if (lane_size == 2)
+            {
+                uint16x8_t w = vreinterpretq_u16_u8(v);
+                w = vorrq_u16(vandq_u16(w, vdupq_n_u16(0x007f)), vshrq_n_u16(vandq_u16(w, vdupq_n_u16(0x7f00)), 1));
+                if (std::is_signed<Value>::value)
+                {
+                    uint16x8_t sign = vreinterpretq_u16_u8(vld1q_u8(pattern.sign_));
+                    w = vsubq_u16(veorq_u16(w, sign), sign);
+                }
+                store_lanes16(w, values);
+            }
+            else
+            {
+                uint32x4_t w = vreinterpretq_u32_u8(v);
+                w = vorrq_u32(vandq_u32(w, vdupq_n_u32(0x007f007f)),
+                              vshrq_n_u32(vandq_u32(w, vdupq_n_u32(0x7f007f00)), 1));
+                w = vorrq_u32(vandq_u32(w, vdupq_n_u32(0x00003fff)),
+                              vshrq_n_u32(vandq_u32(w, vdupq_n_u32(0x3fff0000)), 2));
+                if (std::is_signed<Value>::value)
+                {
+                    uint32x4_t sign = vreinterpretq_u32_u8(vld1q_u8(pattern.sign_));
+                    w = vsubq_u32(veorq_u32(w, sign), sign);
+                }
+                store_lanes32(w, values);
+            }
+        }
+# endif
+
+    /**
+     * Decode values a chunk at a time from the mask of the bytes that end
+     * them, leaving the last few bytes for decode_scalar().
+     */
+    template<typename Value>
+        EDHEL_LEB128_TARGET Leb128Run
+        decode_masked(std::byte const* bytes, std::size_t size, std::size_t count, Value* values)
+        {
+            ShuffleTable const& table = shuffle_table();
+            Leb128Run run{0, 0};
+
+            // A value starting anywhere in a chunk is gathered from the 8
+            // bytes at its start.
+            while (run.count_ < count && size - run.size_ >= chunk + 8)
+            {
+                std::byte const* chunk_bytes = bytes + run.size_;
+                unsigned mask = terminators(chunk_bytes);
+
+                // The vector stores write up to a chunk's worth of values.
+                if (count - run.count_ >= chunk)
+                {
+                    if (mask == 0xffff)
+                    {
+                        widen(chunk_bytes, values + run.count_);
+                        run.count_ += chunk;
+                        run.size_ += chunk;
+                        continue;
+                    }
+                    ShufflePlan const& plan = table.plans_[mask & ((1u << window_bits) - 1)];
+                    if (plan.lane_size_ != 0)
+                    {
+                        shuffle(chunk_bytes, table.patterns_[plan.pattern_], plan.lane_size_, values + run.count_);
+                        run.count_ += lane_count(plan.lane_size_);
+                        run.size_ += plan.size_;
+                        continue;
+                    }
+                }
+
+                if (mask == 0)
+                {
+                    // More than a chunk of continuation bytes: only padded or
+                    // malformed values are that long.
+                    std::byte const* next = read_one(chunk_bytes, bytes + size, values[run.count_]);
+                    if (next == nullptr)
+                    {
+                        return run;
+                    }
+                    run.count_ += 1;
+                    run.size_ = static_cast<std::size_t>(next - bytes);
+                    continue;
+                }
+
+                unsigned start = 0;
+                for (; mask != 0 && run.count_ < count; mask &= mask - 1)
+                {
+                    unsigned end = static_cast<unsigned>(__builtin_ctz(mask)) + 1;
+                    Value& value = values[run.count_++];
+                    if (end - start <= 8)
+                    {
+                        gather(load_uint<std::uint64_t>(chunk_bytes + start, false), end - start, value);
+                    }
+                    else
+                    {
+                        read_one(chunk_bytes + start, chunk_bytes + end, value);
+                    }
+                    start = end;
+                }
+                run.size_ += start;
+            }
+            return run;
+        }
+#endif
+
+    template<typename Value>
+        Leb128Run
+        decode(std::byte const* bytes, std::size_t size, std::size_t count, Value* values)
+        {
+            Leb128Run run{0, 0};
+#if defined(EDHEL_LEB128_SSSE3)
+            static bool const ssse3 = have_ssse3();
+            if (ssse3)
+            {
+                run = decode_masked(bytes, size, count, values);
+            }
+#elif defined(EDHEL_LEB128_NEON)
+            run = decode_masked(bytes, size, count, values);
+#endif
+            return decode_scalar(bytes, size, count, values, run);
+        }
+} // anonymous namespace
+
+
+Leb128Run
+decode_uleb128(std::byte const* bytes, std::size_t size, std::size_t count, std::uint64_t* values)
+{
+    return decode(bytes, size, count, values);
+}
+
+
+Leb128Run
+decode_sleb128(std::byte const* bytes, std::size_t size, std::size_t count, std::int64_t* values)
+{
+    return decode(bytes, size, count, values);
+}
+
+
+char const*
+leb128_decode_method()
+{
+#if defined(EDHEL_LEB128_SSSE3)
+    return have_ssse3() ? "ssse3" : "scalar";
+#elif defined(EDHEL_LEB128_NEON)
+    return "neon";
+#else
+    return "scalar";
+#endif
+}
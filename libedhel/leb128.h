@@ -0,0 +1,128 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef EDHELIND_LEB128_H
+#define EDHELIND_LEB128_H
+
+#include <cstddef>
+#include <cstdint>
+
+
+/**
+ * @defgroup leb128 LEB128 variable-length integers
+ *
+ * DWARF, packed relocations and most of the other variable-length encodings
+ * in ELF files spell integers as little-endian base 128: seven bits to a byte,
+ * least significant first, with the top bit of every byte but the last set.
+ * Bits beyond the 64th are dropped.
+ * @{
+ */
+
+/**
+ * Read the ULEB128 at @p bytes into @p value.
+ *
+ * @returns the byte after it, or nullptr if it runs into @p end first, in which
+ *          case @p value has the bits that were there
+ */
+inline std::byte const*
+read_uleb128(std::byte const* bytes, std::byte const* end, std::uint64_t& value)
+{
+    value = 0;
+    for (unsigned shift = 0; bytes != end; shift += 7)
+    {
+        std::uint8_t byte = std::to_integer<std::uint8_t>(*bytes++);
+        if (shift < 64)
+        {
+            value |= std::uint64_t(byte & 0x7f) << shift;
+        }
+        if ((byte & 0x80) == 0)
+        {
+            return bytes;
+        }
+    }
+    return nullptr;
+}
+
+
+/**
+ * Read the SLEB128 at @p bytes into @p value.
+ *
+ * @returns the byte after it, or nullptr if it runs into @p end first, in which
+ *          case @p value has the bits that were there
+ */
+inline std::byte const*
+read_sleb128(std::byte const* bytes, std::byte const* end, std::int64_t& value)
+{
+    std::uint64_t bits = 0;
+    for (unsigned shift = 0; bytes != end; )
+    {
+        std::uint8_t byte = std::to_integer<std::uint8_t>(*bytes++);
+        if (shift < 64)
+        {
+            bits |= std::uint64_t(byte & 0x7f) << shift;
+        }
+        shift += 7;
+        if ((byte & 0x80) == 0)
+        {
+            if (shift < 64 && (byte & 0x40) != 0)
+            {
+                bits |= ~std::uint64_t(0) << shift;
+            }
+            value = static_cast<std::int64_t>(bits);
+            return bytes;
+        }
+    }
+    value = static_cast<std::int64_t>(bits);
+    return nullptr;
+}
+
+
+/** How far a bulk LEB128 decode got */
+struct Leb128Run
+{
+    std::size_t count_;     /**< the number of values decoded */
+    std::size_t size_;      /**< the number of bytes they took up */
+};
+
+
+/**
+ * Decode up to @p count consecutive ULEB128 values from the @p size bytes at
+ * @p bytes into @p values.
+ *
+ * Decoding stops short of @p count only at a value that runs past the end of
+ * the bytes.  Where the CPU has SSSE3 or NEON the continuation bits of 16
+ * bytes at a time are gathered into a mask, which picks a byte shuffle that
+ * decodes the next four or six short values at once; longer values are
+ * decoded from the mask without a loop over their bytes.
+ */
+Leb128Run
+decode_uleb128(std::byte const* bytes, std::size_t size, std::size_t count, std::uint64_t* values);
+
+
+/** Decode up to @p count consecutive SLEB128 values, like decode_uleb128() */
+Leb128Run
+decode_sleb128(std::byte const* bytes, std::size_t size, std::size_t count, std::int64_t* values);
+
+
+/** How the bulk LEB128 decoders find values on this machine: "ssse3", "neon" or "scalar" */
+char const*
+leb128_decode_method();
+
+/** @} */
+
+#endif /* EDHELIND_LEB128_H */
@@ -0,0 +1,141 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "libedhel/memoryaccount.h"
+
+#include <functional>
+#include <iomanip>
+#include <iostream>
+
+
+MemoryAccount::
+MemoryAccount()
+: total_{0}
+, peak_{0}
+{
+    for (auto& bytes: bytes_)
+    {
+        bytes = 0;
+    }
+    for (auto& allocations: allocations_)
+    {
+        allocations = 0;
+    }
+}
+
+
+std::size_t MemoryAccount::
+bytes(Category category) const
+{
+    return bytes_[static_cast<std::size_t>(category)].load(std::memory_order_relaxed);
+}
+
+
+std::size_t MemoryAccount::
+total_bytes() const
+{
+    return total_.load(std::memory_order_relaxed);
+}
+
+
+std::size_t MemoryAccount::
+peak_bytes() const
+{
+    return peak_.load(std::memory_order_relaxed);
+}
+
+
+std::size_t MemoryAccount::
+allocations(Category category) const
+{
+    return allocations_[static_cast<std::size_t>(category)].load(std::memory_order_relaxed);
+}
+
+
+char const* MemoryAccount::
+category_name(Category category)
+{
+    switch (category)
+    {
+    case Category::Image:   return "image";
+    case Category::Headers: return "headers";
+    case Category::Symbols: return "symbols";
+    case Category::Notes:   return "notes";
+    case Category::Strings: return "strings";
+    case Category::Caches:  return "caches";
+    case Category::Count_:  break;
+    }
+    return "?";
+}
+
+
+void MemoryAccount::
+allocated(Category category, std::size_t size)
+{
+    bytes_[static_cast<std::size_t>(category)].fetch_add(size, std::memory_order_relaxed);
+    allocations_[static_cast<std::size_t>(category)].fetch_add(1, std::memory_order_relaxed);
+    std::size_t total = total_.fetch_add(size, std::memory_order_relaxed) + size;
+    std::size_t peak = peak_.load(std::memory_order_relaxed);
+    while (total > peak && !peak_.compare_exchange_weak(peak, total, std::memory_order_relaxed))
+    {
+    }
+}
+
+
+void MemoryAccount::
+deallocated(Category category, std::size_t size)
+{
+    bytes_[static_cast<std::size_t>(category)].fetch_sub(size, std::memory_order_relaxed);
+    total_.fetch_sub(size, std::memory_order_relaxed);
+}
+
+
+/**
+ * Short strings live inside the std::string object itself and cost nothing
+ * extra; only storage outside the object is recorded.
+ */
+void MemoryAccount::
+allocated(Category category, std::string const& string)
+{
+    char const* data = string.data();
+    char const* self = reinterpret_cast<char const*>(&string);
+    std::less<char const*> before;
+    if (!before(data, self) && before(data, self + sizeof(string)))
+    {
+        return;
+    }
+    allocated(category, string.capacity() + 1);
+}
+
+
+std::ostream& MemoryAccount::
+printTo(std::ostream& ostr) const
+{
+    ostr << "Memory\n";
+    for (std::size_t i = 0; i < bytes_.size(); ++i)
+    {
+        auto category = static_cast<Category>(i);
+        std::string label = std::string("  ") + category_name(category) + ":";
+        ostr << std::left << std::setw(24) << label
+             << std::right << std::setw(14) << bytes(category) << " bytes"
+             << std::setw(10) << allocations(category) << " allocations\n";
+    }
+    ostr << std::left << std::setw(24) << "  total:" << std::right << std::setw(14) << total_bytes() << " bytes\n";
+    ostr << std::left << std::setw(24) << "  peak:" << std::right << std::setw(14) << peak_bytes() << " bytes\n";
+    return ostr;
+}
@@ -0,0 +1,285 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef EDHELIND_MEMORYACCOUNT_H
+#define EDHELIND_MEMORYACCOUNT_H
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include "libedhel/detailable.h"
+#include <memory>
+#include <new>
+#include <string>
+#include <type_traits>
+#include <utility>
+
+
+/**
+ * How much memory a parsed ElfFile is holding, by what it is holding it for.
+ *
+ * The containers and objects that make up a parsed file allocate through a
+ * CountingAllocator or make_counted() tied to the file's account, so the
+ * numbers are what was actually asked of the heap (container slack included),
+ * not estimates.  Strings, which can't carry an allocator without changing
+ * their type, are recorded once when they are made.
+ *
+ * Recording is thread-safe.
+ */
+class MemoryAccount
+: public Detailable
+{
+public:
+    enum class Category
+    {
+        Image,      /**< the file image itself */
+        Headers,    /**< section and segment headers and their tables */
+        Symbols,    /**< decoded symbols and symbol tables */
+        Notes,      /**< decoded notes */
+        Strings,    /**< strings copied out of the image */
+        Caches,     /**< indexes built lazily after parsing */
+        Count_
+    };
+
+public:
+    MemoryAccount();
+
+    MemoryAccount(MemoryAccount const&) = delete;
+    MemoryAccount& operator=(MemoryAccount const&) = delete;
+
+    /** Bytes currently held for @p category */
+    std::size_t
+    bytes(Category category) const;
+
+    /** Bytes currently held for all categories */
+    std::size_t
+    total_bytes() const;
+
+    /** The most bytes held for all categories at any one time */
+    std::size_t
+    peak_bytes() const;
+
+    /** The number of allocations made for @p category */
+    std::size_t
+    allocations(Category category) const;
+
+    static char const*
+    category_name(Category category);
+
+    /** Record that @p size bytes were allocated for @p category */
+    void
+    allocated(Category category, std::size_t size);
+
+    /** Record that @p size bytes allocated for @p category were released */
+    void
+    deallocated(Category category, std::size_t size);
+
+    /** Record the heap storage held by @p string, if any, for @p category */
+    void
+    allocated(Category category, std::string const& string);
+
+private:
+    std::ostream&
+    printTo(std::ostream& ostr) const override;
+
+private:
+    using Sizes = std::array<std::atomic<std::size_t>, static_cast<std::size_t>(Category::Count_)>;
+
+    Sizes                    bytes_;
+    Sizes                    allocations_;
+    std::atomic<std::size_t> total_;
+    std::atomic<std::size_t> peak_;
+};
+
+
+/**
+ * A standard allocator that records what it allocates in a MemoryAccount.
+ *
+ * A default-constructed CountingAllocator records nothing and behaves like
+ * std::allocator.
+ */
+template<typename T>
+class CountingAllocator
+{
+public:
+    using value_type = T;
+
+    CountingAllocator() noexcept = default;
+
+    CountingAllocator(MemoryAccount* account, MemoryAccount::Category category) noexcept
+    : account_{account}
+    , category_{category}
+    { }
+
+    template<typename U>
+    CountingAllocator(CountingAllocator<U> const& other) noexcept
+    : account_{other.account()}
+    , category_{other.category()}
+    { }
+
+    T*
+    allocate(std::size_t n)
+    {
+        T* p = std::allocator<T>().allocate(n);
+        if (account_)
+        {
+            account_->allocated(category_, n * sizeof(T));
+        }
+        return p;
+    }
+
+    void
+    deallocate(T* p, std::size_t n) noexcept
+    {
+        std::allocator<T>().deallocate(p, n);
+        if (account_)
+        {
+            account_->deallocated(category_, n * sizeof(T));
+        }
+    }
+
+    MemoryAccount*
+    account() const noexcept
+    { return account_; }
+
+    MemoryAccount::Category
+    category() const noexcept
+    { return category_; }
+
+    template<typename U>
+    bool
+    operator==(CountingAllocator<U> const& rhs) const noexcept
+    { return account_ == rhs.account() && category_ == rhs.category(); }
+
+    template<typename U>
+    bool
+    operator!=(CountingAllocator<U> const& rhs) const noexcept
+    { return !(*this == rhs); }
+
+private:
+    MemoryAccount*          account_ = nullptr;
+    MemoryAccount::Category category_ = MemoryAccount::Category::Caches;
+};
+
+
+/**
+ * The objects an owner made with make_counted(), as recorded against one
+ * category of a MemoryAccount.
+ *
+ * A table of CountedPtr<Base> can hold objects of several derived sizes, and
+ * there can be one for every symbol, so rather than have each pointer carry
+ * its account and the size of its object, the owner keeps the total and
+ * releases it all at once when it goes.  The objects must not outlive it.
+ *
+ * Objects can be made for the same owner on several threads at once.
+ */
+class CountedObjects
+{
+public:
+    CountedObjects() noexcept = default;
+
+    CountedObjects(MemoryAccount* account, MemoryAccount::Category category) noexcept
+    : account_{account}
+    , category_{category}
+    { }
+
+    ~CountedObjects()
+    {
+        if (account_)
+        {
+            account_->deallocated(category_, bytes_);
+        }
+    }
+
+    CountedObjects(CountedObjects const&) = delete;
+    CountedObjects& operator=(CountedObjects const&) = delete;
+
+    /** Record that an object of @p size bytes was made */
+    void
+    made(std::size_t size)
+    {
+        if (account_)
+        {
+            account_->allocated(category_, size);
+            bytes_ += size;
+        }
+    }
+
+    /** Bytes held by the objects made so far */
+    std::size_t
+    bytes() const
+    { return bytes_; }
+
+private:
+    MemoryAccount*           account_ = nullptr;
+    MemoryAccount::Category  category_ = MemoryAccount::Category::Caches;
+    std::atomic<std::size_t> bytes_{0};
+};
+
+
+/**
+ * Destroys and releases an object made by make_counted().  It has no state,
+ * so a CountedPtr is no bigger than a plain pointer; what the object took is
+ * given back by its CountedObjects.
+ */
+struct CountedDeleter
+{
+    template<typename T>
+    void
+    operator()(T* p) const
+    {
+        void* storage = p;
+        if constexpr (std::is_polymorphic_v<T>)
+        {
+            storage = dynamic_cast<void*>(p);
+        }
+        p->~T();
+        ::operator delete(storage);
+    }
+};
+
+template<typename T>
+using CountedPtr = std::unique_ptr<T, CountedDeleter>;
+
+static_assert(sizeof(CountedPtr<int>) == sizeof(int*), "a CountedPtr should be a plain pointer");
+
+
+/**
+ * Make a T from @p args, recording its allocation in @p objects.
+ */
+template<typename T, typename... Args>
+CountedPtr<T>
+make_counted(CountedObjects& objects, Args&&... args)
+{
+    void* storage = ::operator new(sizeof(T));
+    T* object = nullptr;
+    try
+    {
+        object = ::new(storage) T(std::forward<Args>(args)...);
+    }
+    catch (...)
+    {
+        ::operator delete(storage);
+        throw;
+    }
+    objects.made(sizeof(T));
+    return CountedPtr<T>(object);
+}
+
+#endif /* EDHELIND_MEMORYACCOUNT_H */
@@ -18,10 +18,12 @@
  */
 #include "libedhel/note.h"
 
+#include <algorithm>
 #include <iomanip>
 #include <iostream>
 #include "libedhel/elf.h"
 #include "libedhel/elfimage.h"
+#include "libedhel/trace.h"
 
 
 namespace
@@ -31,6 +33,12 @@ namespace
     constexpr std::size_t note_type_offset = offsetof(ElfNote, type);
     constexpr std::size_t note_name_offset = offsetof(ElfNote, name);
 
+    /** Lines printed before the hex dump of the descriptor */
+    constexpr std::size_t header_lines = 3;
+
+    /** Bytes of the descriptor shown on each line of the hex dump */
+    constexpr std::size_t bytes_per_line = 16;
+
     /** Move a value up to the nearest multiple of 4 */
     inline std::size_t align4(std::size_t val)
     {
@@ -48,34 +56,78 @@ Note(std::string const& name, std::uint32_t type, ElfImageView const& descriptor
 std::ostream& Note::
 printTo(std::ostream& ostr) const
 {
-    ostr << "name: " << name_ << "\n"
-         << "type: " << type_ << "\n"
-         << "data: ";
-    for (std::size_t i = 0; i < descriptor_.size(); ++i)
+    return printLinesTo(ostr, 0, lineCount());
+}
+
+
+std::size_t Note::
+lineCount() const
+{
+    return header_lines + (descriptor_.size() + bytes_per_line - 1) / bytes_per_line;
+}
+
+
+std::ostream& Note::
+printLinesTo(std::ostream& ostr, std::size_t first, std::size_t count) const
+{
+    std::size_t lines = lineCount();
+    if (first >= lines)
+    {
+        return ostr;
+    }
+
+    std::size_t last = first + std::min(count, lines - first);
+    for (std::size_t line = first; line < last; ++line)
     {
-        ostr << std::setw(2) << std::setfill('0') << std::hex
-             << std::to_integer<int>(*descriptor_.get_bytes(i))
-             << " ";
+        switch (line)
+        {
+        case 0:
+            ostr << "name: " << name_ << "\n";
+            break;
+        case 1:
+            ostr << "type: " << std::dec << type_ << "\n";
+            break;
+        case 2:
+            ostr << "data:\n";
+            break;
+        default: {
+            std::size_t offset = (line - header_lines) * bytes_per_line;
+            std::size_t end = std::min(offset + bytes_per_line, descriptor_.size());
+            ostr << "  " << std::setw(8) << std::setfill('0') << std::hex << offset << ":";
+            for (std::size_t i = offset; i < end; ++i)
+            {
+                ostr << " " << std::setw(2) << std::setfill('0') << std::hex
+                     << std::to_integer<int>(*descriptor_.get_bytes(i));
+            }
+            ostr << "\n";
+            break;
+        }
+        }
     }
-    ostr << "\n";
     return ostr;
 }
 
 
 NoteTable::
-NoteTable(ElfImageView const& image_view)
+NoteTable(ElfImageView const& image_view, MemoryAccount* account)
+: notes_(CountingAllocator<Note>(account, MemoryAccount::Category::Notes))
 {
+    EDHEL_TRACE_ZONE("decode notes");
     std::size_t parsed_size = 0;
     while (parsed_size < image_view.size())
     {
         auto namesz = image_view.get_uint32(parsed_size + note_namesz_offset);
         auto descsz = image_view.get_uint32(parsed_size + note_descsz_offset);
         auto type = image_view.get_uint32(parsed_size + note_type_offset);
-        std::size_t desc_offset = note_name_offset + align4(namesz);
+        std::size_t desc_offset = parsed_size + note_name_offset + align4(namesz);
 
         notes_.emplace_back(image_view.get_string(parsed_size + note_name_offset, std::string::npos),
                             type,
                             image_view.view(desc_offset, descsz));
+        if (account)
+        {
+            account->allocated(MemoryAccount::Category::Strings, notes_.back().name_);
+        }
 
         std::size_t note_size = align4(namesz) + align4(descsz) + 3*sizeof(std::uint32_t);
         parsed_size += note_size;
@@ -83,6 +135,13 @@ NoteTable(ElfImageView const& image_view)
 }
 
 
+std::size_t NoteTable::
+note_count() const
+{
+    return notes_.size();
+}
+
+
 void NoteTable::
 iterate_notes(std::function<void(Note const&)> visit) const
 {
@@ -22,6 +22,7 @@
 #include <functional>
 #include "libedhel/detailable.h"
 #include "libedhel/elfimage.h"
+#include "libedhel/memoryaccount.h"
 #include <string>
 #include <vector>
 
@@ -41,6 +42,13 @@ struct Note
     std::ostream&
     printTo(std::ostream& ostr) const override;
 
+    std::size_t
+    lineCount() const override;
+
+    /** Prints the name and type followed by a hex dump of the descriptor */
+    std::ostream&
+    printLinesTo(std::ostream& ostr, std::size_t first, std::size_t count) const override;
+
     std::string   name_;
     std::uint32_t type_;
     ElfImageView  descriptor_;
@@ -55,13 +63,21 @@ struct Note
 class NoteTable
 {
 public:
-    NoteTable(ElfImageView const& image_view);
+    /**
+     * Decode the notes in @p image_view, recording the memory they take in
+     * @p account if there is one
+     */
+    NoteTable(ElfImageView const& image_view, MemoryAccount* account = nullptr);
+
+    /** The number of notes in the table */
+    std::size_t
+    note_count() const;
 
     void
     iterate_notes(std::function<void(Note const&)>) const;
 
 private:
-    std::vector<Note> notes_;
+    std::vector<Note, CountingAllocator<Note>> notes_;
 };
 
 #endif /* EDHELIND_NOTE_H */
@@ -0,0 +1,85 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef EDHELIND_PARALLEL_SORT_H
+#define EDHELIND_PARALLEL_SORT_H
+
+#include <algorithm>
+#include <cstddef>
+#include <iterator>
+#include "libedhel/threadpool.h"
+#include <vector>
+
+
+/**
+ * Sort the range [@p first, @p last) as up to @p concurrency tasks on the
+ * shared ThreadPool.
+ *
+ * The range is cut into a power-of-two number of chunks which are sorted
+ * independently and then merged pairwise until a single sorted run remains.
+ * Small ranges are just handed off to std::sort.  Like std::sort, the sort is
+ * not stable: callers wanting a deterministic order should break ties in
+ * @p comp.
+ */
+template<typename RandomIt, typename Compare>
+void
+parallel_sort(RandomIt first, RandomIt last, Compare comp,
+              unsigned concurrency = ThreadPool::shared().worker_count() + 1)
+{
+    constexpr std::ptrdiff_t serial_cutoff = 32 * 1024;
+
+    auto const count = std::distance(first, last);
+    if (concurrency < 2 || count < serial_cutoff)
+    {
+        std::sort(first, last, comp);
+        return;
+    }
+
+    std::size_t chunks = 1;
+    while (chunks * 2 <= concurrency && count / static_cast<std::ptrdiff_t>(chunks * 2) >= serial_cutoff / 2)
+    {
+        chunks *= 2;
+    }
+
+    std::vector<RandomIt> bounds;
+    for (std::size_t i = 0; i < chunks; ++i)
+    {
+        bounds.push_back(first + count * static_cast<std::ptrdiff_t>(i) / static_cast<std::ptrdiff_t>(chunks));
+    }
+    bounds.push_back(last);
+
+    TaskGroup group;
+    for (std::size_t i = 0; i < chunks; ++i)
+    {
+        group.run([&, i]{ std::sort(bounds[i], bounds[i+1], comp); });
+    }
+    group.wait();
+
+    for (std::size_t width = 1; width < chunks; width *= 2)
+    {
+        for (std::size_t i = 0; i + width < chunks; i += 2 * width)
+        {
+            group.run([&, i, width]{
+                std::inplace_merge(bounds[i], bounds[i + width], bounds[std::min(i + 2 * width, chunks)], comp);
+            });
+        }
+        group.wait();
+    }
+}
+
+#endif /* EDHELIND_PARALLEL_SORT_H */
@@ -0,0 +1,98 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "libedhel/parseerror.h"
+
+#include <cstring>
+#include <sstream>
+
+
+std::string ParseError::
+message() const
+{
+    std::ostringstream ostr;
+    switch (code_)
+    {
+    case ParseErrc::Ok:
+        return "no error";
+    case ParseErrc::Unreadable:
+        ostr << "error " << errno_ << " reading file: " << std::strerror(errno_);
+        return ostr.str();
+    case ParseErrc::TooSmall:
+        return "The file is too small to be an ELF binary";
+    case ParseErrc::BadMagic:
+        return "The file does not start with ELF magic.";
+    case ParseErrc::BadClass:
+        ostr << "unknown ELF class";
+        break;
+    case ParseErrc::BadEncoding:
+        ostr << "unknown ELF data encoding";
+        break;
+    case ParseErrc::BadSectionHeaderSize:
+        ostr << "section header entry size too small";
+        break;
+    case ParseErrc::SectionHeadersOutOfBounds:
+        ostr << "section header table extends past the end of the file";
+        break;
+    case ParseErrc::BadProgramHeaderSize:
+        ostr << "program header entry size too small";
+        break;
+    case ParseErrc::ProgramHeadersOutOfBounds:
+        ostr << "program header table extends past the end of the file";
+        break;
+    case ParseErrc::SectionOutOfBounds:
+        ostr << "section extends past the end of the file";
+        break;
+    case ParseErrc::SegmentOutOfBounds:
+        ostr << "segment extends past the end of the file";
+        break;
+    case ParseErrc::NoteOutOfBounds:
+        ostr << "note extends past the end of its section or segment";
+        break;
+    case ParseErrc::BadEntrySize:
+        ostr << "section entry size does not match its entries";
+        break;
+    case ParseErrc::BadSectionIndex:
+        ostr << "section index refers to a missing or unsuitable section";
+        break;
+    case ParseErrc::NameOutOfBounds:
+        ostr << "name extends past the end of its string table";
+        break;
+    case ParseErrc::UnterminatedString:
+        ostr << "string table is not NUL-terminated";
+        break;
+    case ParseErrc::BadDwarfVersion:
+        ostr << "unsupported DWARF version";
+        break;
+    case ParseErrc::BadDwarf:
+        ostr << "malformed DWARF data";
+        break;
+    case ParseErrc::DwarfOutOfBounds:
+        ostr << "DWARF data extends past the end of its unit or section";
+        break;
+    case ParseErrc::CompressedSection:
+        ostr << "compressed sections are not supported";
+        break;
+    case ParseErrc::Malformed:
+        return "The file is malformed";
+    case ParseErrc::OutOfMemory:
+        return "Ran out of memory parsing the file";
+    }
+    ostr << " (at offset " << std::showbase << std::hex << offset_ << ")";
+    return ostr.str();
+}
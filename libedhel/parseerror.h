@@ -0,0 +1,78 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef EDHELIND_PARSEERROR_H
+#define EDHELIND_PARSEERROR_H
+
+#include <cstdint>
+#include <string>
+
+
+/**
+ * The ways reading and parsing an ELF file can fail.
+ */
+enum class ParseErrc: std::uint8_t
+{
+    Ok,                         /**< no error */
+    Unreadable,                 /**< the file could not be opened or read */
+    TooSmall,                   /**< too small to hold an ELF header */
+    BadMagic,                   /**< does not start with the ELF magic */
+    BadClass,                   /**< neither 32- nor 64-bit */
+    BadEncoding,                /**< neither little- nor big-endian */
+    BadSectionHeaderSize,       /**< e_shentsize is too small for a section header */
+    SectionHeadersOutOfBounds,  /**< the section header table runs past the end of the file */
+    BadProgramHeaderSize,       /**< e_phentsize is too small for a program header */
+    ProgramHeadersOutOfBounds,  /**< the program header table runs past the end of the file */
+    SectionOutOfBounds,         /**< a section's contents run past the end of the file */
+    SegmentOutOfBounds,         /**< a segment's contents run past the end of the file */
+    NoteOutOfBounds,            /**< a note runs past the end of its section or segment */
+    BadEntrySize,               /**< a table section's entry size is not that of its entries */
+    BadSectionIndex,            /**< a section index refers to a missing or unsuitable section */
+    NameOutOfBounds,            /**< a name's index is past the end of its string table */
+    UnterminatedString,         /**< a string table or the interpreter is not NUL-terminated */
+    BadDwarfVersion,            /**< a DWARF unit has a version this can't read */
+    BadDwarf,                   /**< a DWARF unit's header or contents make no sense */
+    DwarfOutOfBounds,           /**< DWARF data runs past the end of its unit or section */
+    CompressedSection,          /**< a section to be read is compressed */
+    Malformed,                  /**< broken in some way none of the checks above caught */
+    OutOfMemory,                /**< memory ran out while parsing */
+};
+
+
+/**
+ * Why an ELF file could not be parsed, and where.
+ *
+ * This is cheap to make and to copy: the text describing the error is only
+ * put together when message() is called.
+ */
+struct ParseError
+{
+    ParseErrc     code_ = ParseErrc::Ok;
+    std::uint64_t offset_ = 0;      /**< file offset of the offending structure */
+    int           errno_ = 0;       /**< the system error, for ParseErrc::Unreadable */
+
+    /** Whether there is an error at all */
+    explicit operator bool() const
+    { return code_ != ParseErrc::Ok; }
+
+    /** A description of the error for people */
+    std::string
+    message() const;
+};
+
+#endif /* EDHELIND_PARSEERROR_H */
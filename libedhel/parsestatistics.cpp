@@ -0,0 +1,151 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "libedhel/parsestatistics.h"
+
+#include <iomanip>
+#include <iostream>
+#include <sstream>
+
+
+namespace
+{
+    /** Print @p duration in milliseconds */
+    std::string
+    milliseconds(ParseStatistics::Duration duration)
+    {
+        std::ostringstream ostr;
+        ostr << std::fixed << std::setprecision(3) << duration.count() / 1e6 << " ms";
+        return ostr.str();
+    }
+} // anonymous namespace
+
+
+ParseStatistics::
+ParseStatistics()
+: start_{Clock::now()}
+, total_{0}
+{
+    for (auto& duration: durations_)
+    {
+        duration = 0;
+    }
+    for (auto& counter: counters_)
+    {
+        counter = 0;
+    }
+}
+
+
+ParseStatistics::Duration ParseStatistics::
+duration(Phase phase) const
+{
+    return Duration(durations_[static_cast<std::size_t>(phase)].load(std::memory_order_relaxed));
+}
+
+
+ParseStatistics::Duration ParseStatistics::
+total() const
+{
+    return total_;
+}
+
+
+std::uint64_t ParseStatistics::
+count(Counter counter) const
+{
+    return counters_[static_cast<std::size_t>(counter)].load(std::memory_order_relaxed);
+}
+
+
+char const* ParseStatistics::
+phase_name(Phase phase)
+{
+    switch (phase)
+    {
+    case Phase::ImageLoad:    return "image load";
+    case Phase::Header:       return "header";
+    case Phase::SectionTable: return "section table";
+    case Phase::SegmentTable: return "segment table";
+    case Phase::SymbolDecode: return "symbol decode";
+    case Phase::NoteDecode:   return "note decode";
+    case Phase::Count_:       break;
+    }
+    return "?";
+}
+
+
+char const* ParseStatistics::
+counter_name(Counter counter)
+{
+    switch (counter)
+    {
+    case Counter::BytesTouched:        return "bytes touched";
+    case Counter::ObjectsAllocated:    return "objects allocated";
+    case Counter::StringsMaterialized: return "strings materialized";
+    case Counter::Count_:              break;
+    }
+    return "?";
+}
+
+
+void ParseStatistics::
+add(Phase phase, Duration duration)
+{
+    durations_[static_cast<std::size_t>(phase)].fetch_add(duration.count(), std::memory_order_relaxed);
+}
+
+
+void ParseStatistics::
+add(Counter counter, std::uint64_t amount)
+{
+    counters_[static_cast<std::size_t>(counter)].fetch_add(amount, std::memory_order_relaxed);
+}
+
+
+void ParseStatistics::
+finish()
+{
+    total_ = std::chrono::duration_cast<Duration>(Clock::now() - start_);
+}
+
+
+std::ostream& ParseStatistics::
+printTo(std::ostream& ostr) const
+{
+    ostr << "Parse statistics\n";
+    ostr << std::left << std::setw(24) << "  total:" << std::right << std::setw(14) << milliseconds(total_) << "\n";
+    auto print_phase = [&](Phase phase, char const* indent) {
+        std::string label = std::string(indent) + phase_name(phase) + ":";
+        ostr << std::left << std::setw(24) << label << std::right << std::setw(14) << milliseconds(duration(phase)) << "\n";
+    };
+    print_phase(Phase::ImageLoad, "  ");
+    print_phase(Phase::Header, "  ");
+    print_phase(Phase::SectionTable, "  ");
+    print_phase(Phase::SegmentTable, "  ");
+    ostr << "  of which (CPU time summed across threads, can exceed the phases above):\n";
+    print_phase(Phase::SymbolDecode, "    ");
+    print_phase(Phase::NoteDecode, "    ");
+    for (std::size_t i = 0; i < counters_.size(); ++i)
+    {
+        auto counter = static_cast<Counter>(i);
+        std::string label = std::string("  ") + counter_name(counter) + ":";
+        ostr << std::left << std::setw(24) << label << std::right << std::setw(14) << count(counter) << "\n";
+    }
+    return ostr;
+}
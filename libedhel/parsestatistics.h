@@ -0,0 +1,157 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef EDHELIND_PARSESTATISTICS_H
+#define EDHELIND_PARSESTATISTICS_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include "libedhel/detailable.h"
+
+
+/**
+ * What parsing an ElfFile cost, phase by phase.
+ *
+ * Each ElfFile keeps one of these, filled in by the parsers as they go, so that
+ * a file that is slow to open can be asked why.  Recording is thread-safe.
+ *
+ * Symbol and note decoding happen while the section and segment tables are
+ * being built, so their times are also part of those phases' times.  When the
+ * section table decodes its sections in parallel, though, the symbol and note
+ * decode times are CPU time summed across the decoding threads, and can add up
+ * to more than the section table phase's own wall-clock time.
+ */
+class ParseStatistics
+: public Detailable
+{
+public:
+    using Clock = std::chrono::steady_clock;
+    using Duration = std::chrono::nanoseconds;
+
+    enum class Phase
+    {
+        ImageLoad,      /**< reading the file into memory */
+        Header,         /**< decoding the ELF header */
+        SectionTable,   /**< building the section table */
+        SegmentTable,   /**< building the segment table */
+        SymbolDecode,   /**< decoding symbol tables */
+        NoteDecode,     /**< decoding notes */
+        Count_
+    };
+
+    enum class Counter
+    {
+        BytesTouched,         /**< bytes of the image decoded */
+        ObjectsAllocated,     /**< sections, segments, symbols, notes... */
+        StringsMaterialized,  /**< strings copied out of the image */
+        Count_
+    };
+
+    /**
+     * Times a phase for as long as it lives.
+     */
+    class ScopedTimer
+    {
+    public:
+        ScopedTimer(ParseStatistics& statistics, Phase phase)
+        : statistics_{statistics}
+        , phase_{phase}
+        , start_{Clock::now()}
+        { }
+
+        ScopedTimer(ScopedTimer const&) = delete;
+        ScopedTimer& operator=(ScopedTimer const&) = delete;
+
+        ~ScopedTimer()
+        {
+            statistics_.add(phase_, Clock::now() - start_);
+        }
+
+    private:
+        ParseStatistics&  statistics_;
+        Phase             phase_;
+        Clock::time_point start_;
+    };
+
+public:
+    ParseStatistics();
+
+    ParseStatistics(ParseStatistics const&) = delete;
+    ParseStatistics& operator=(ParseStatistics const&) = delete;
+
+    /** Time spent in @p phase */
+    Duration
+    duration(Phase phase) const;
+
+    /** Wall time from the start of parsing until finish() was called */
+    Duration
+    total() const;
+
+    /** The value of @p counter */
+    std::uint64_t
+    count(Counter counter) const;
+
+    static char const*
+    phase_name(Phase phase);
+
+    static char const*
+    counter_name(Counter counter);
+
+    /** Add @p duration to the time spent in @p phase */
+    void
+    add(Phase phase, Duration duration);
+
+    /** Add @p amount to @p counter */
+    void
+    add(Counter counter, std::uint64_t amount);
+
+    /**
+     * Run @p fn, adding the time it took to @p phase, and return whatever it
+     * returns.  The result is not copied or moved, so this can be used to
+     * initialize members that can't be.
+     */
+    template<typename Fn>
+    auto
+    timed(Phase phase, Fn&& fn) -> decltype(fn())
+    {
+        ScopedTimer timer(*this, phase);
+        return fn();
+    }
+
+    /** Mark the end of parsing */
+    void
+    finish();
+
+private:
+    std::ostream&
+    printTo(std::ostream& ostr) const override;
+
+private:
+    using Durations = std::array<std::atomic<std::int64_t>, static_cast<std::size_t>(Phase::Count_)>;
+    using Counters = std::array<std::atomic<std::uint64_t>, static_cast<std::size_t>(Counter::Count_)>;
+
+    Clock::time_point start_;
+    Duration          total_;
+    Durations         durations_;
+    Counters          counters_;
+};
+
+#endif /* EDHELIND_PARSESTATISTICS_H */
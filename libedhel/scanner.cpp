@@ -0,0 +1,123 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "libedhel/scanner.h"
+
+#include <algorithm>
+#include "libedhel/elffile.h"
+#include "libedhel/elfprobe.h"
+#include "libedhel/section.h"
+#include "libedhel/section_symtab.h"
+#include "libedhel/threadpool.h"
+#include "libedhel/trace.h"
+#include <filesystem>
+#include <stdexcept>
+
+
+namespace
+{
+    namespace fs = std::filesystem;
+
+    /** How many files one scanning task looks at */
+    constexpr std::size_t files_per_task = 64;
+
+    void
+    scan_file(ScanResult& result)
+    {
+        ElfProbe probe = probe_elf(result.path_);
+        if (probe.status_ == ElfProbe::Status::Unreadable)
+        {
+            result.status_ = ScanResult::Status::Unreadable;
+            result.error_ = "could not be read";
+            return;
+        }
+        if (probe.status_ == ElfProbe::Status::NotElf)
+        {
+            return;
+        }
+        result.is_64bit_ = probe.is_64bit_;
+        result.is_big_endian_ = probe.is_big_endian_;
+        result.type_ = probe.type_;
+        result.machine_ = probe.machine_;
+        result.segment_count_ = probe.phnum_;
+
+        EDHEL_TRACE_ZONE("scan file", result.path_);
+        ParseResult parsed = ElfFile::parse(result.path_);
+        if (!parsed.elf_file_)
+        {
+            result.status_ = ScanResult::Status::Failed;
+            result.error_ = parsed.error_.message();
+            return;
+        }
+
+        SectionTable const& section_table = parsed.elf_file_->section_table();
+        result.section_count_ = section_table.section_count();
+        result.validated_ = parsed.elf_file_->validated();
+        section_table.iterate_sections([&result](Section const& section) {
+            if (auto symtab = dynamic_cast<Section_SYMTAB const*>(&section))
+            {
+                result.symbol_count_ += symtab->symbol_count();
+            }
+        });
+        result.status_ = ScanResult::Status::Parsed;
+    }
+} // anonymous namespace
+
+
+std::vector<ScanResult>
+scan_tree(std::string const& root)
+{
+    EDHEL_TRACE_ZONE("scan tree", root);
+    std::error_code ec;
+    fs::recursive_directory_iterator it(root, fs::directory_options::skip_permission_denied, ec);
+    if (ec)
+    {
+        throw std::runtime_error("error reading '" + root + "': " + ec.message());
+    }
+
+    std::vector<ScanResult> results;
+    for (fs::recursive_directory_iterator end; it != end; it.increment(ec))
+    {
+        if (ec)
+        {
+            ec.clear();
+            continue;
+        }
+        if (it->is_regular_file(ec) && !ec)
+        {
+            ScanResult result;
+            result.path_ = it->path().string();
+            result.size_ = it->file_size(ec);
+            results.push_back(std::move(result));
+        }
+    }
+
+    TaskGroup group;
+    for (std::size_t first = 0; first < results.size(); first += files_per_task)
+    {
+        std::size_t last = std::min(first + files_per_task, results.size());
+        group.run([&results, first, last]{
+            for (std::size_t i = first; i < last; ++i)
+            {
+                scan_file(results[i]);
+            }
+        });
+    }
+    group.wait();
+    return results;
+}
@@ -0,0 +1,70 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef EDHELIND_SCANNER_H
+#define EDHELIND_SCANNER_H
+
+#include <cstddef>
+#include <cstdint>
+#include "libedhel/elf.h"
+#include <string>
+#include <vector>
+
+
+/**
+ * What scanning turned up about one file.
+ */
+struct ScanResult
+{
+    enum class Status
+    {
+        NotElf,     /**< the first bytes are not those of an ELF file */
+        Unreadable, /**< the file could not be opened or read */
+        Parsed,     /**< an ELF file, parsed */
+        Failed,     /**< looks like an ELF file, but could not be parsed */
+    };
+
+    std::string   path_;
+    Status        status_ = Status::NotElf;
+    std::uint64_t size_ = 0;
+    bool          is_64bit_ = false;
+    bool          is_big_endian_ = false;
+    EhType        type_ = EhType::ET_NONE;
+    EhMachine     machine_ = EhMachine::EM_NONE;
+    std::uint32_t section_count_ = 0;
+    std::uint32_t segment_count_ = 0;
+    std::uint64_t symbol_count_ = 0;
+    bool          validated_ = false;   /**< passed every check of validate_elf() */
+    std::string   error_;
+};
+
+
+/**
+ * Find and parse every ELF file in the directory tree under @p root.
+ *
+ * Files are triaged with probe_elf(), so only the ones that look like ELF
+ * files are read in full and parsed; those are parsed in parallel on the
+ * shared ThreadPool.  Directories that can't be read are skipped.  Results come
+ * back in the order the files were found.
+ *
+ * @throws std::runtime_error if @p root can't be read
+ */
+std::vector<ScanResult>
+scan_tree(std::string const& root);
+
+#endif /* EDHELIND_SCANNER_H */
@@ -0,0 +1,256 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "libedhel/search.h"
+
+#include <algorithm>
+#include <cstring>
+#include "libedhel/elffile.h"
+#include "libedhel/section.h"
+#include "libedhel/section_strtab.h"
+#include "libedhel/section_symtab.h"
+#include "libedhel/symbol.h"
+#include "libedhel/trace.h"
+#include <map>
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# define EDHEL_HAVE_SSE2 1
+# include <emmintrin.h>
+# ifdef _MSC_VER
+#  include <intrin.h>
+# endif
+#endif
+
+
+namespace
+{
+    /** How many bytes of string table get scanned between cancellation checks */
+    constexpr std::size_t cancel_check_bytes = 1 << 20;
+
+    /** How many symbols get examined between cancellation checks */
+    constexpr std::size_t cancel_check_symbols = 1 << 14;
+
+#ifdef EDHEL_HAVE_SSE2
+    inline unsigned
+    count_trailing_zeros(unsigned mask)
+    {
+# ifdef _MSC_VER
+        unsigned long index;
+        _BitScanForward(&index, mask);
+        return index;
+# else
+        return __builtin_ctz(mask);
+# endif
+    }
+
+    std::size_t
+    find_substring_sse2(std::string_view haystack, std::string_view needle, std::size_t from)
+    {
+        std::size_t const n = needle.size();
+        __m128i const first = _mm_set1_epi8(needle.front());
+        __m128i const last = _mm_set1_epi8(needle.back());
+
+        std::size_t i = from;
+        for (; i + n - 1 + 16 <= haystack.size(); i += 16)
+        {
+            __m128i block_first = _mm_loadu_si128(reinterpret_cast<__m128i const*>(haystack.data() + i));
+            __m128i block_last = _mm_loadu_si128(reinterpret_cast<__m128i const*>(haystack.data() + i + n - 1));
+            unsigned mask = _mm_movemask_epi8(_mm_and_si128(_mm_cmpeq_epi8(block_first, first),
+                                                            _mm_cmpeq_epi8(block_last, last)));
+            while (mask != 0)
+            {
+                unsigned bit = count_trailing_zeros(mask);
+                if (n <= 2 || std::memcmp(haystack.data() + i + bit + 1, needle.data() + 1, n - 2) == 0)
+                {
+                    return i + bit;
+                }
+                mask &= mask - 1;
+            }
+        }
+        return haystack.find(needle, i);
+    }
+#endif
+
+    /** The raw-byte hits in one string table */
+    struct StringTableHits
+    {
+        std::vector<std::uint32_t> positions_;  /**< where the needle was found */
+        std::vector<std::uint32_t> starts_;     /**< start of the string holding each position */
+    };
+
+    /**
+     * Find every occurrence of @p needle in the string table @p strtab.
+     *
+     * The table is scanned a window at a time, checking for cancellation
+     * before each, so a long scan can be stopped whether or not it's finding
+     * anything.  Each window takes the matches that start in it, reading up to
+     * needle.size() - 1 bytes into the next one to see them through.
+     *
+     * @returns false if cancelled
+     */
+    bool
+    scan_string_table(Section_STRTAB const& strtab, std::string_view needle,
+                      StringTableHits& hits, std::function<bool()> const& is_cancelled)
+    {
+        std::string_view table = strtab.table_bytes();
+        for (std::size_t window = 0; window < table.size(); window += cancel_check_bytes)
+        {
+            if (is_cancelled())
+            {
+                return false;
+            }
+
+            std::size_t window_end = std::min(table.size(), window + cancel_check_bytes);
+            std::string_view scanned = table.substr(0, std::min(table.size(), window_end + needle.size() - 1));
+            for (std::size_t pos = find_substring(scanned, needle, window);
+                 pos < window_end;
+                 pos = find_substring(scanned, needle, pos + 1))
+            {
+                std::size_t start = table.rfind('\0', pos);
+                start = (start == std::string_view::npos) ? 0 : start + 1;
+                hits.positions_.push_back(static_cast<std::uint32_t>(pos));
+                hits.starts_.push_back(static_cast<std::uint32_t>(start));
+            }
+        }
+        return !is_cancelled();
+    }
+} // anonymous
+
+
+std::size_t
+find_substring(std::string_view haystack, std::string_view needle, std::size_t from)
+{
+    if (needle.empty() || from > haystack.size() || needle.size() > haystack.size() - from)
+    {
+        return needle.empty() && from <= haystack.size() ? from : std::string_view::npos;
+    }
+#ifdef EDHEL_HAVE_SSE2
+    return find_substring_sse2(haystack, needle, from);
+#else
+    return haystack.find(needle, from);
+#endif
+}
+
+
+bool
+search_elf_file(ElfFile const& elf_file,
+                std::string_view needle,
+                std::function<bool(SearchHit const&)> const& visit,
+                std::function<bool()> const& is_cancelled)
+{
+    EDHEL_TRACE_ZONE("search", std::string(needle));
+    if (needle.empty())
+    {
+        return true;
+    }
+
+    std::vector<Section const*> sections;
+    elf_file.section_table().iterate_sections([&](Section const& section){
+        sections.push_back(&section);
+    });
+
+    // Section names.
+    for (std::uint32_t i = 0; i < sections.size(); ++i)
+    {
+        std::string name = sections[i]->name_string();
+        if (find_substring(name, needle) != std::string_view::npos)
+        {
+            if (!visit(SearchHit{SearchHit::Kind::SectionName, i, i, name}))
+            {
+                return false;
+            }
+        }
+    }
+
+    // Raw scan of every string table.
+    std::map<std::uint32_t, StringTableHits> strtab_hits;
+    for (std::uint32_t i = 0; i < sections.size(); ++i)
+    {
+        if (auto const* strtab = dynamic_cast<Section_STRTAB const*>(sections[i]))
+        {
+            if (!scan_string_table(*strtab, needle, strtab_hits[i], is_cancelled))
+            {
+                return false;
+            }
+        }
+    }
+
+    // Symbol names, matched against the hits in their string table.  The
+    // first hit at or after a name's offset is in that name if and only if
+    // the string holding the hit starts at or before the name.
+    for (std::uint32_t i = 0; i < sections.size(); ++i)
+    {
+        auto const* symtab = dynamic_cast<Section_SYMTAB const*>(sections[i]);
+        if (symtab == nullptr)
+        {
+            continue;
+        }
+        auto hits = strtab_hits.find(symtab->link());
+        if (hits == strtab_hits.end() || hits->second.positions_.empty())
+        {
+            continue;
+        }
+
+        auto const& positions = hits->second.positions_;
+        auto const& starts = hits->second.starts_;
+        Section_STRTAB const& strtab = symtab->string_table();
+        std::vector<std::uint32_t> const names = symtab->symbol_names();
+        for (std::uint32_t s = 0; s < names.size(); ++s)
+        {
+            if (s % cancel_check_symbols == 0 && is_cancelled())
+            {
+                return false;
+            }
+
+            std::uint32_t name = names[s];
+            auto it = std::lower_bound(positions.begin(), positions.end(), name);
+            if (it != positions.end() && starts[it - positions.begin()] <= name)
+            {
+                SearchHit hit{SearchHit::Kind::SymbolName, i, s, std::string(strtab.string_ref(name))};
+                if (!visit(hit))
+                {
+                    return false;
+                }
+            }
+        }
+    }
+
+    // Strings, each reported once no matter how many times it matches.
+    for (auto const& [index, hits]: strtab_hits)
+    {
+        auto const& strtab = static_cast<Section_STRTAB const&>(*sections[index]);
+        std::uint32_t previous_start = 0;
+        bool first = true;
+        for (std::uint32_t start: hits.starts_)
+        {
+            if (!first && start == previous_start)
+            {
+                continue;
+            }
+            first = false;
+            previous_start = start;
+            if (!visit(SearchHit{SearchHit::Kind::String, index, start, std::string(strtab.string_ref(start))}))
+            {
+                return false;
+            }
+        }
+    }
+
+    return !is_cancelled();
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef EDHELIND_SEARCH_H
+#define EDHELIND_SEARCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <string>
+#include <string_view>
+
+
+class ElfFile;
+
+
+/**
+ * Find the first occurrence of @p needle in @p haystack at or after @p from.
+ *
+ * Where SSE2 is available, candidate positions are found 16 bytes at a time by
+ * comparing against both the first and the last byte of the needle and only
+ * those candidates are verified byte-by-byte.  Otherwise this is
+ * std::string_view::find().
+ *
+ * @returns the position of the match or std::string_view::npos
+ */
+std::size_t
+find_substring(std::string_view haystack, std::string_view needle, std::size_t from = 0);
+
+
+/**
+ * A place in an ElfFile where a searched-for string was found.
+ */
+struct SearchHit
+{
+    enum class Kind
+    {
+        SectionName,   /**< the name of section section_ */
+        SymbolName,    /**< the name of symbol index_ in symbol table section_ */
+        String,        /**< the string at offset index_ in string table section_ */
+    };
+
+    Kind          kind_;
+    std::uint32_t section_;
+    std::uint32_t index_;
+    std::string   text_;
+};
+
+
+/**
+ * Search the section names, symbol names and string tables of @p elf_file
+ * for @p needle (case-sensitive), calling @p visit with each hit as it is
+ * found.
+ *
+ * String tables are searched as raw bytes rather than string by string and
+ * symbol names are matched by looking up where their names fall in the
+ * string table hits, so the cost is dominated by the raw byte scan.
+ *
+ * @param[in] elf_file     The file to search
+ * @param[in] needle       The text to look for
+ * @param[in] visit        Called for each hit; return false to stop searching
+ * @param[in] is_cancelled Polled regularly; return true to stop searching
+ *
+ * @returns false if the search was stopped before it completed
+ */
+bool
+search_elf_file(ElfFile const& elf_file,
+                std::string_view needle,
+                std::function<bool(SearchHit const&)> const& visit,
+                std::function<bool()> const& is_cancelled = []{ return false; });
+
+#endif /* EDHELIND_SEARCH_H */
@@ -82,36 +82,13 @@ namespace
         { Elf::SHF_COMPRESSED, "COMPRESSED" },
     };
 
-    constexpr std::size_t shdr32_name_offset      = offsetof(Elf32_Shdr, sh_name);
-    constexpr std::size_t shdr32_type_offset      = offsetof(Elf32_Shdr, sh_type);
-    constexpr std::size_t shdr32_flags_offset     = offsetof(Elf32_Shdr, sh_flags);
-    constexpr std::size_t shdr32_addr_offset      = offsetof(Elf32_Shdr, sh_addr);
-    constexpr std::size_t shdr32_offset_offset    = offsetof(Elf32_Shdr, sh_offset);
-    constexpr std::size_t shdr32_size_offset      = offsetof(Elf32_Shdr, sh_size);
-    constexpr std::size_t shdr32_link_offset      = offsetof(Elf32_Shdr, sh_link);
-    constexpr std::size_t shdr32_info_offset      = offsetof(Elf32_Shdr, sh_info);
-    constexpr std::size_t shdr32_addralign_offset = offsetof(Elf32_Shdr, sh_addralign);
-    constexpr std::size_t shdr32_entsize_offset   = offsetof(Elf32_Shdr, sh_entsize);
-
-    constexpr std::size_t shdr64_name_offset      = offsetof(Elf64_Shdr, sh_name);
-    constexpr std::size_t shdr64_type_offset      = offsetof(Elf64_Shdr, sh_type);
-    constexpr std::size_t shdr64_flags_offset     = offsetof(Elf64_Shdr, sh_flags);
-    constexpr std::size_t shdr64_addr_offset      = offsetof(Elf64_Shdr, sh_addr);
-    constexpr std::size_t shdr64_offset_offset    = offsetof(Elf64_Shdr, sh_offset);
-    constexpr std::size_t shdr64_size_offset      = offsetof(Elf64_Shdr, sh_size);
-    constexpr std::size_t shdr64_link_offset      = offsetof(Elf64_Shdr, sh_link);
-    constexpr std::size_t shdr64_info_offset      = offsetof(Elf64_Shdr, sh_info);
-    constexpr std::size_t shdr64_addralign_offset = offsetof(Elf64_Shdr, sh_addralign);
-    constexpr std::size_t shdr64_entsize_offset   = offsetof(Elf64_Shdr, sh_entsize);
-
 } // anonymous
 
 
 Section::
-Section(ElfFile const& elf_file, ElfImageView const& image_view)
+Section(ElfFile const& elf_file, Elf64_Shdr const& header)
 : elf_file_(&elf_file)
-, image_view_(image_view)
-, is_64bit_(elf_file.is_64bit())
+, header_(header)
 {
 }
 
@@ -119,13 +96,13 @@ Section(ElfFile const& elf_file, ElfImageView const& image_view)
 std::uint32_t Section::
 name() const
 {
-    return image_view_.get_uint32(shdr32_name_offset);
+    return header_.sh_name;
 }
 
 std::string Section::
 name_string() const
 {
-    auto shstrndx = elf_file_->elf_header().shstrndx();
+    auto shstrndx = elf_file_->section_table().shstrndx();
     auto const& strtab = dynamic_cast<Section_STRTAB const&>(elf_file_->section(shstrndx));
     return strtab.string(this->name());
 }
@@ -134,7 +111,7 @@ name_string() const
 SType Section::
 type() const
 {
-    return static_cast<SType>(image_view_.get_uint32(shdr32_type_offset));
+    return header_.sh_type;
 }
 
 
@@ -154,8 +131,7 @@ type_string() const
 std::uint64_t Section::
 flags() const
 {
-    return is_64bit_ ? image_view_.get_uint64(shdr64_flags_offset)
-                     : image_view_.get_uint32(shdr32_flags_offset);
+    return header_.sh_flags;
 }
 
 
@@ -187,65 +163,116 @@ flags_string() const
 std::uint64_t Section::
 addr() const
 {
-    return is_64bit_ ? image_view_.get_uint64(shdr64_addr_offset)
-                     : image_view_.get_uint32(shdr32_addr_offset);
+    return header_.sh_addr;
 }
 
 std::uint64_t Section::
 offset() const
 {
-    return is_64bit_ ? image_view_.get_uint64(shdr64_offset_offset)
-                     : image_view_.get_uint32(shdr32_offset_offset);
+    return header_.sh_offset;
 }
 
 std::uint64_t Section::
 size() const
 {
-    return is_64bit_ ? image_view_.get_uint64(shdr64_size_offset)
-                     : image_view_.get_uint32(shdr32_size_offset);
+    return header_.sh_size;
 }
 
 std::uint32_t Section::
 link() const
 {
-    return is_64bit_ ? image_view_.get_uint32(shdr64_link_offset)
-                     : image_view_.get_uint32(shdr32_link_offset);
+    return header_.sh_link;
 }
 
 std::uint32_t Section::
 info() const
 {
-    return is_64bit_ ? image_view_.get_uint32(shdr64_info_offset)
-                     : image_view_.get_uint32(shdr32_info_offset);
+    return header_.sh_info;
 }
 
 std::uint64_t Section::
 addralign() const
 {
-    return is_64bit_ ? image_view_.get_uint64(shdr32_addralign_offset)
-                     : image_view_.get_uint32(shdr32_addralign_offset);
+    return header_.sh_addralign;
 }
 
 std::uint64_t Section::
 entsize() const
 {
-    return is_64bit_ ? image_view_.get_uint64(shdr64_entsize_offset)
-                     : image_view_.get_uint32(shdr32_entsize_offset);
+    return header_.sh_entsize;
+}
+
+
+ElfFile const& Section::
+elf_file() const
+{
+    return *elf_file_;
 }
 
 
 std::ostream& Section::
 printTo(std::ostream& ostr) const
+{
+    printSummaryTo(ostr);
+    return printDetailTo(ostr);
+}
+
+
+std::size_t Section::
+lineCount() const
+{
+    return 1 + detailLineCount();
+}
+
+
+std::ostream& Section::
+printLinesTo(std::ostream& ostr, std::size_t first, std::size_t count) const
+{
+    if (count == 0)
+    {
+        return ostr;
+    }
+
+    if (first == 0)
+    {
+        printSummaryTo(ostr);
+        return printDetailLinesTo(ostr, 0, count - 1);
+    }
+    return printDetailLinesTo(ostr, first - 1, count);
+}
+
+
+std::ostream& Section::
+printSummaryTo(std::ostream& ostr) const
 {
     ostr << name_string() << '\t' << type_string()
          << '\t' << "offset=" << std::showbase << std::hex << offset()
          << '\t' << "size=" << std::dec << size()
          << '\n';
-    return printDetailTo(ostr);
+    return ostr;
 }
 
+
 std::ostream& Section::
 printDetailTo(std::ostream& ostr) const
 {
     return ostr;
 }
+
+
+std::size_t Section::
+detailLineCount() const
+{
+    std::ostringstream ostr;
+    printDetailTo(ostr);
+    return countLines(ostr.str());
+}
+
+
+std::ostream& Section::
+printDetailLinesTo(std::ostream& ostr, std::size_t first, std::size_t count) const
+{
+    std::ostringstream text;
+    printDetailTo(text);
+    return printLinesOf(ostr, text.str(), first, count);
+}
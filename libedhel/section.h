@@ -27,11 +27,17 @@
 class ElfFile;
 
 
+/**
+ * A section, described by its header.
+ *
+ * The header is decoded into host byte order (and a 32-bit one widened to
+ * the 64-bit layout) when the section table is read, a whole table at a time.
+ */
 class Section
 : public Detailable
 {
 public:
-    Section(ElfFile const& elfFile, ElfImageView const& imageView);
+    Section(ElfFile const& elfFile, Elf64_Shdr const& header);
 
     virtual ~Section() = default;
 
@@ -78,6 +84,17 @@ public:
     std::uint64_t
     entsize() const;
 
+    std::size_t
+    lineCount() const override;
+
+    std::ostream&
+    printLinesTo(std::ostream& ostr, std::size_t first, std::size_t count) const override;
+
+protected:
+    /**! The ElfFile this section belongs to */
+    ElfFile const&
+    elf_file() const;
+
 private:
     Section(Section const&) = delete;
     Section(Section const&&) = delete;
@@ -86,13 +103,24 @@ private:
     virtual std::ostream&
     printTo(std::ostream&) const override;
 
+    /** Print the one-line summary that heads the details of every section */
+    std::ostream&
+    printSummaryTo(std::ostream& ostr) const;
+
     virtual std::ostream&
     printDetailTo(std::ostream& ostr) const;
 
+    /** The number of lines printed by printDetailTo() */
+    virtual std::size_t
+    detailLineCount() const;
+
+    /** Print @p count lines of printDetailTo() output starting at @p first */
+    virtual std::ostream&
+    printDetailLinesTo(std::ostream& ostr, std::size_t first, std::size_t count) const;
+
 private:
     ElfFile const* elf_file_;
-    ElfImageView   image_view_;
-    bool           is_64bit_;
+    Elf64_Shdr     header_;
 };
 
 
@@ -23,10 +23,15 @@
 
 
 Section_NOTE::
-Section_NOTE(ElfFile const& elf_file, ElfImageView const& image_view)
-: Section{elf_file, image_view}
-, note_table_{elf_file.view(this->offset(), this->size())}
+Section_NOTE(ElfFile const& elf_file, Elf64_Shdr const& header)
+: Section{elf_file, header}
+, note_table_{elf_file.statistics_recorder().timed(ParseStatistics::Phase::NoteDecode, [&]() {
+      return NoteTable(elf_file.view(this->offset(), this->size()), &elf_file.memory_recorder());
+  })}
 {
+    elf_file.statistics_recorder().add(ParseStatistics::Counter::BytesTouched, this->size());
+    elf_file.statistics_recorder().add(ParseStatistics::Counter::ObjectsAllocated, note_table_.note_count());
+    elf_file.statistics_recorder().add(ParseStatistics::Counter::StringsMaterialized, note_table_.note_count());
 }
 
 
@@ -40,7 +45,7 @@ iterate_notes(std::function<void(Note const&)> visit) const
 std::ostream& Section_NOTE::
 printDetailTo(std::ostream& ostr) const
 {
-    ostr << "NOTE details";
+    ostr << "NOTE details\n";
     return ostr;
 }
 
@@ -31,7 +31,7 @@ class Section_NOTE
 : public Section
 {
 public:
-    Section_NOTE(ElfFile const& elf_file, ElfImageView const& image_view);
+    Section_NOTE(ElfFile const& elf_file, Elf64_Shdr const& header);
 
     void
     iterate_notes(std::function<void(Note const&)>) const;
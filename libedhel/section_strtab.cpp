@@ -19,14 +19,17 @@
 #include "libedhel/section_strtab.h"
 
 #include "libedhel/elffile.h"
+#include <algorithm>
 #include <iomanip>
 #include <iostream>
+#include "libedhel/trace.h"
 
 
 Section_STRTAB::
-Section_STRTAB(ElfFile const& elf_file, ElfImageView const& image_view)
-: Section(elf_file, image_view)
+Section_STRTAB(ElfFile const& elf_file, Elf64_Shdr const& header)
+: Section(elf_file, header)
 , string_table_(elf_file.view(this->offset(), this->size()))
+, line_index_(LineIndex::allocator_type(&elf_file.memory_recorder(), MemoryAccount::Category::Caches))
 {
 }
 
@@ -38,6 +41,24 @@ string(std::uint32_t index) const
 }
 
 
+std::string_view Section_STRTAB::
+string_ref(std::uint32_t index) const
+{
+    return string_table_.get_string_view(index, std::string::npos);
+}
+
+
+std::string_view Section_STRTAB::
+table_bytes() const
+{
+    if (string_table_.size() == 0)
+    {
+        return {};
+    }
+    return std::string_view(reinterpret_cast<char const*>(string_table_.get_bytes(0)), string_table_.size());
+}
+
+
 void Section_STRTAB::
 iterate_strings(std::function<void(std::uint32_t, std::string)> visit) const
 {
@@ -54,9 +75,47 @@ iterate_strings(std::function<void(std::uint32_t, std::string)> visit) const
 std::ostream& Section_STRTAB::
 printDetailTo(std::ostream& ostr) const
 {
-    this->iterate_strings([&](std::uint32_t offset, std::string value){
-        ostr << "0x" << std::setw(8) << std::setfill('0') << std::hex << offset
-             << ": " << value << "\n";
-    });
+    return printDetailLinesTo(ostr, 0, detailLineCount());
+}
+
+
+std::size_t Section_STRTAB::
+detailLineCount() const
+{
+    return line_index().size();
+}
+
+
+std::ostream& Section_STRTAB::
+printDetailLinesTo(std::ostream& ostr, std::size_t first, std::size_t count) const
+{
+    auto const& index = line_index();
+    if (first >= index.size())
+    {
+        return ostr;
+    }
+
+    std::size_t last = first + std::min(count, index.size() - first);
+    for (std::size_t line = first; line < last; ++line)
+    {
+        ostr << "0x" << std::noshowbase << std::setw(8) << std::setfill('0') << std::hex << index[line]
+             << ": " << string_ref(index[line]) << "\n";
+    }
     return ostr;
 }
+
+
+Section_STRTAB::LineIndex const& Section_STRTAB::
+line_index() const
+{
+    std::call_once(line_index_built_, [this]{
+        EDHEL_TRACE_ZONE("build string table index");
+        std::size_t offset = 0;
+        while (offset < string_table_.size())
+        {
+            line_index_.push_back(static_cast<std::uint32_t>(offset));
+            offset += string_table_.get_string_view(offset, std::string::npos).size() + 1;
+        }
+    });
+    return line_index_;
+}
@@ -20,7 +20,10 @@
 #define EDHELIND_SECTION_STRTAB_H
 
 #include <functional>
+#include <mutex>
 #include "libedhel/section.h"
+#include <string_view>
+#include <vector>
 
 
 /*!
@@ -30,12 +33,20 @@ class Section_STRTAB
 : public Section
 {
 public:
-    Section_STRTAB(ElfFile const& elf_file, ElfImageView const& image_view);
+    Section_STRTAB(ElfFile const& elf_file, Elf64_Shdr const& header);
 
     /** Retrieve the string at @p index */
     std::string
     string(std::uint32_t index) const;
 
+    /** Retrieve the string at @p index without copying it out of the image */
+    std::string_view
+    string_ref(std::uint32_t index) const;
+
+    /** The raw bytes of the whole string table, terminators and all */
+    std::string_view
+    table_bytes() const;
+
     /**
      * Visit each string in the string table
      *
@@ -49,8 +60,22 @@ private:
     std::ostream&
     printDetailTo(std::ostream& ostr) const override;
 
+    std::size_t
+    detailLineCount() const override;
+
+    std::ostream&
+    printDetailLinesTo(std::ostream& ostr, std::size_t first, std::size_t count) const override;
+
+    /** Offsets of the start of each string, built the first time it's needed */
+    using LineIndex = std::vector<std::uint32_t, CountingAllocator<std::uint32_t>>;
+
+    LineIndex const&
+    line_index() const;
+
 private:
-    ElfImageView string_table_;
+    ElfImageView           string_table_;
+    mutable std::once_flag line_index_built_;
+    mutable LineIndex      line_index_;
 };
 
 #endif /* EDHELIND_SECTION_STRTAB_H */
@@ -18,22 +18,58 @@
  */
 #include "libedhel/section_symtab.h"
 
+#include "libedhel/bulkdecode.h"
 #include "libedhel/elffile.h"
+#include "libedhel/section_strtab.h"
+#include <algorithm>
 #include <iomanip>
 #include <iostream>
+#include "libedhel/trace.h"
 
 
 Section_SYMTAB::
-Section_SYMTAB(ElfFile const& elf_file, ElfImageView const& image_view)
-: Section(elf_file, image_view)
+Section_SYMTAB(ElfFile const& elf_file, Elf64_Shdr const& header)
+: Section(elf_file, header)
+, objects_(&elf_file.memory_recorder(), MemoryAccount::Category::Symbols)
+, symbol_table_(Symbols::allocator_type(&elf_file.memory_recorder(), MemoryAccount::Category::Symbols))
 {
-    const std::size_t symbol_size = elf_file.is_64bit() ? sizeof(Elf64::Sym) : sizeof(Elf32::Sym);
-    for (std::size_t offset = 0; offset < this->size(); offset += symbol_size)
+    EDHEL_TRACE_ZONE("decode symbols");
+    ParseStatistics::ScopedTimer timer(elf_file.statistics_recorder(), ParseStatistics::Phase::SymbolDecode);
+    const bool is_64bit = elf_file.is_64bit();
+    const std::size_t symbol_size = is_64bit ? sizeof(Elf64::Sym) : sizeof(Elf32::Sym);
+    ElfImageView table = elf_file.view(this->offset(), this->size());
+    std::size_t count = table.size() / symbol_size;
+    symbol_table_.reserve(count + (table.size() % symbol_size != 0));
+
+    // The table is decoded a block at a time rather than a field at a time.
+    constexpr std::size_t block_size = 256;
+    Elf64::Sym block[block_size];
+    for (std::size_t first = 0; first < count; first += block_size)
     {
-        symbol_table_.emplace_back(make_symbol(elf_file,
-                                               elf_file.view(this->offset() + offset, symbol_size),
-                                               this->link()));
+        std::size_t n = std::min(block_size, count - first);
+        decode_symbols(table.get_bytes(first * symbol_size), n, table.isBigEndian(), is_64bit, block);
+        for (std::size_t i = 0; i < n; ++i)
+        {
+            symbol_table_.emplace_back(make_symbol(objects_, elf_file, block[i], this->link()));
+        }
     }
+
+    // A truncated entry at the end of the table still counts as a symbol.
+    if (count * symbol_size < table.size())
+    {
+        ElfImageView last = elf_file.view(this->offset() + count * symbol_size, symbol_size);
+        decode_symbols(last.get_bytes(0), 1, last.isBigEndian(), is_64bit, block);
+        symbol_table_.emplace_back(make_symbol(objects_, elf_file, block[0], this->link()));
+    }
+    elf_file.statistics_recorder().add(ParseStatistics::Counter::BytesTouched, this->size());
+    elf_file.statistics_recorder().add(ParseStatistics::Counter::ObjectsAllocated, symbol_table_.size());
+}
+
+
+std::size_t Section_SYMTAB::
+symbol_count() const
+{
+    return symbol_table_.size();
 }
 
 
@@ -44,6 +80,37 @@ symbol(std::uint32_t index) const
 }
 
 
+std::vector<std::uint32_t> Section_SYMTAB::
+symbol_names() const
+{
+    std::vector<std::uint32_t> names;
+    names.reserve(symbol_table_.size());
+    for (auto const& symbol: symbol_table_)
+    {
+        names.push_back(symbol->name());
+    }
+    return names;
+}
+
+
+Section_STRTAB const& Section_SYMTAB::
+string_table() const
+{
+    return dynamic_cast<Section_STRTAB const&>(this->elf_file().section(this->link()));
+}
+
+
+Section_STRTAB const* Section_SYMTAB::
+find_string_table() const
+{
+    if (this->link() >= this->elf_file().section_table().section_count())
+    {
+        return nullptr;
+    }
+    return dynamic_cast<Section_STRTAB const*>(&this->elf_file().section(this->link()));
+}
+
+
 void Section_SYMTAB::
 iterate_symbols(std::function<void(Symbol const&)> visit) const
 {
@@ -56,20 +123,51 @@ iterate_symbols(std::function<void(Symbol const&)> visit) const
 
 std::ostream& Section_SYMTAB::
 printDetailTo(std::ostream& ostr) const
+{
+    return printDetailLinesTo(ostr, 0, detailLineCount());
+}
+
+
+/*!
+ * One line of column headings followed by one line per symbol.
+ */
+std::size_t Section_SYMTAB::
+detailLineCount() const
+{
+    return 1 + symbol_table_.size();
+}
+
+
+std::ostream& Section_SYMTAB::
+printDetailLinesTo(std::ostream& ostr, std::size_t first, std::size_t count) const
 {
     using std::setw;
     using std::left;
 
-    ostr << " " << setw(10) << std::left << "Value"
-         << " " << setw(10) << std::left << "Size"
-         << " " << setw(6)  << std::left << "Bind"
-         << " " << setw(7)  << std::left << "Type"
-         << " " << setw(9)  << std::left << "Vis"
-         << " " << setw(6)  << std::left << "Index"
-         << " " << "Name"
-         << "\n";
-    this->iterate_symbols([&](Symbol const& symbol){
-        ostr << symbol << "\n";
-    });
+    std::size_t lines = detailLineCount();
+    if (first >= lines)
+    {
+        return ostr;
+    }
+
+    std::size_t last = first + std::min(count, lines - first);
+    for (std::size_t line = first; line < last; ++line)
+    {
+        if (line == 0)
+        {
+            ostr << " " << setw(10) << std::left << "Value"
+                 << " " << setw(10) << std::left << "Size"
+                 << " " << setw(6)  << std::left << "Bind"
+                 << " " << setw(7)  << std::left << "Type"
+                 << " " << setw(9)  << std::left << "Vis"
+                 << " " << setw(6)  << std::left << "Index"
+                 << " " << "Name"
+                 << "\n";
+        }
+        else
+        {
+            ostr << *symbol_table_[line - 1] << "\n";
+        }
+    }
     return ostr;
 }
@@ -26,6 +26,8 @@
 #include <vector>
 
 
+class Section_STRTAB;
+
 /**
  * An SHT_SYMTAB section
  */
@@ -33,12 +35,31 @@ class Section_SYMTAB
 : public Section
 {
 public:
-    Section_SYMTAB(ElfFile const& elf_file, ElfImageView const& image_view);
+    Section_SYMTAB(ElfFile const& elf_file, Elf64_Shdr const& header);
+
+    /** The number of symbols in the symbol table */
+    std::size_t
+    symbol_count() const;
 
     /** Retrieve the symbol at @p index */
     Symbol const&
     symbol(std::uint32_t index) const;
 
+    /** The name (string table offset) of every symbol, in order */
+    std::vector<std::uint32_t>
+    symbol_names() const;
+
+    /** The string table holding the names of the symbols */
+    Section_STRTAB const&
+    string_table() const;
+
+    /**
+     * The string table holding the names of the symbols, or null if sh_link
+     * doesn't lead to one, as it might not in a file that failed validation.
+     */
+    Section_STRTAB const*
+    find_string_table() const;
+
     /** Visit each symbol in the symbol table */
     void
     iterate_symbols(std::function<void(Symbol const&)> visit) const;
@@ -47,8 +68,17 @@ private:
     std::ostream&
     printDetailTo(std::ostream& ostr) const override;
 
+    std::size_t
+    detailLineCount() const override;
+
+    std::ostream&
+    printDetailLinesTo(std::ostream& ostr, std::size_t first, std::size_t count) const override;
+
 private:
-    std::vector<std::unique_ptr<Symbol>> symbol_table_;
+    using Symbols = std::vector<CountedPtr<Symbol>, CountingAllocator<CountedPtr<Symbol>>>;
+
+    CountedObjects objects_;    /**< what the symbols in symbol_table_ took */
+    Symbols        symbol_table_;
 };
 
 #endif /* EDHELIND_SECTION_SYMTAB_H */
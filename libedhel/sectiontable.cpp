@@ -18,12 +18,17 @@
  */
 #include "libedhel/sectiontable.h"
 
+#include "libedhel/bulkdecode.h"
 #include "libedhel/elffile.h"
 #include "libedhel/section.h"
 #include "libedhel/section_note.h"
 #include "libedhel/section_strtab.h"
 #include "libedhel/section_symtab.h"
+#include <algorithm>
+#include <atomic>
 #include <stdexcept>
+#include "libedhel/threadpool.h"
+#include "libedhel/trace.h"
 
 
 SectionTable::
@@ -33,38 +38,139 @@ SectionTable()
 
 
 SectionTable::
-SectionTable(ElfFile const& elfFile)
-: image_view_(elfFile.view(elfFile.elf_header().shoff(),
-                           elfFile.elf_header().shnum() * elfFile.elf_header().shentsize()))
+SectionTable(ElfFile const& elfFile, unsigned concurrency)
+: objects_(&elfFile.memory_recorder(), MemoryAccount::Category::Headers)
+, sections_(Sections::allocator_type(&elfFile.memory_recorder(), MemoryAccount::Category::Headers))
 {
-    std::size_t shoff = 0;
-    std::size_t shentsize = elfFile.elf_header().shentsize();
-    for (auto i = 0; i < elfFile.elf_header().shnum(); ++i)
+    EDHEL_TRACE_ZONE("build section table");
+    ElfHeader const& elf_header = elfFile.elf_header();
+    std::size_t shentsize = elf_header.shentsize();
+    std::uint32_t shnum = elf_header.shnum();
+    shstrndx_ = elf_header.shstrndx();
+
+    // With extended section numbering the real section count and/or section
+    // name table index don't fit in the ELF header and live in section 0.
+    if (elf_header.shoff() != 0 && (shnum == 0 || shstrndx_ == SHN_XINDEX))
     {
-        auto sectionView = image_view_.view(shoff, shentsize);
-        Section tmpSection(elfFile, sectionView);
-        switch (tmpSection.type())
+        auto section0 = decode_section_headers(elfFile.view(elf_header.shoff(), shentsize),
+                                               shentsize, elfFile.is_64bit());
+        if (section0.empty())
         {
-            case SType::SHT_NOTE:
-                sections_.emplace_back(std::make_unique<Section_NOTE>(elfFile, sectionView));
-                break;
+            throw std::runtime_error("section header entry size is too small");
+        }
+        if (shnum == 0)
+        {
+            shnum = static_cast<std::uint32_t>(section0[0].sh_size);
+        }
+        if (shstrndx_ == SHN_XINDEX)
+        {
+            shstrndx_ = section0[0].sh_link;
+        }
+    }
 
-            case SType::SHT_STRTAB:
-                sections_.emplace_back(std::make_unique<Section_STRTAB>(elfFile, sectionView));
-                break;
+    // The whole header table is decoded in one go, so none of it gets
+    // byte-swapped a field at a time.
+    std::vector<Elf64_Shdr> headers;
+    if (shnum != 0)
+    {
+        ElfImageView table = elfFile.view(elf_header.shoff(), shnum * shentsize);
+        headers = decode_section_headers(table, shentsize, elfFile.is_64bit());
+        if (headers.size() != shnum)
+        {
+            throw std::runtime_error("section header entry size is too small");
+        }
+        elfFile.statistics_recorder().add(ParseStatistics::Counter::BytesTouched, table.size());
+    }
+    sections_.resize(shnum);
+    elfFile.statistics_recorder().add(ParseStatistics::Counter::ObjectsAllocated, shnum);
 
+    // Sections whose contents get decoded up front are set aside to be made
+    // last, possibly in parallel; the rest are little more than their header.
+    std::vector<Decode> decodes;
+    for (std::uint32_t i = 0; i < shnum; ++i)
+    {
+        switch (headers[i].sh_type)
+        {
+            case SType::SHT_NOTE:
             case SType::SHT_DYNSYM:
             case SType::SHT_SYMTAB:
-                sections_.emplace_back(std::make_unique<Section_SYMTAB>(elfFile, sectionView));
+                decodes.push_back(Decode{i, headers[i].sh_size});
                 break;
 
             default:
-                sections_.emplace_back(std::make_unique<Section>(elfFile, sectionView));
+                sections_[i] = make_section(elfFile, headers[i]);
                 break;
         }
-        
-        shoff += shentsize;
     }
+
+    if (concurrency > 1 && decodes.size() > 1)
+    {
+        decode_in_parallel(elfFile, headers, decodes, concurrency);
+    }
+    else
+    {
+        for (auto const& decode: decodes)
+        {
+            sections_[decode.index_] = make_section(elfFile, headers[decode.index_]);
+        }
+    }
+}
+
+
+SectionTable::OwningSectionPtr SectionTable::
+make_section(ElfFile const& elfFile, Elf64_Shdr const& header)
+{
+    EDHEL_TRACE_ZONE("decode section");
+    switch (header.sh_type)
+    {
+        case SType::SHT_NOTE:
+            return make_counted<Section_NOTE>(objects_, elfFile, header);
+
+        case SType::SHT_STRTAB:
+            return make_counted<Section_STRTAB>(objects_, elfFile, header);
+
+        case SType::SHT_DYNSYM:
+        case SType::SHT_SYMTAB:
+            return make_counted<Section_SYMTAB>(objects_, elfFile, header);
+
+        default:
+            return make_counted<Section>(objects_, elfFile, header);
+    }
+}
+
+
+/**
+ * Make the sections in @p decodes as up to @p concurrency tasks on the shared
+ * thread pool.
+ *
+ * Section sizes vary wildly (one symbol table can outweigh everything else put
+ * together) so rather than splitting the work up front, each task takes the
+ * next biggest section left until there are none.  Each section goes in its
+ * own slot, so the result is the same as making them one after the other.
+ */
+void SectionTable::
+decode_in_parallel(ElfFile const& elfFile, std::vector<Elf64_Shdr> const& headers,
+                   std::vector<Decode> decodes, unsigned concurrency)
+{
+    std::stable_sort(decodes.begin(), decodes.end(), [](Decode const& lhs, Decode const& rhs) {
+        return lhs.size_ > rhs.size_;
+    });
+
+    std::atomic<std::size_t> next{0};
+    TaskGroup group;
+    auto work = [&]() {
+        for (std::size_t d = next++; d < decodes.size() && !group.is_cancelled(); d = next++)
+        {
+            sections_[decodes[d].index_] = make_section(elfFile, headers[decodes[d].index_]);
+        }
+    };
+
+    std::size_t task_count = std::min<std::size_t>(concurrency, decodes.size());
+    for (std::size_t t = 0; t < task_count; ++t)
+    {
+        group.run(work);
+    }
+    group.wait();
 }
 
 
@@ -72,7 +178,7 @@ SectionTable(ElfFile const& elfFile)
  * Destroy a @pSectionTable
  *
  * This destructor is explicitly defined in the file so the vector of
- * unique_ptrs will have some place to go to die.
+ * owning pointers will have some place to go to die.
  */
 SectionTable::
 ~SectionTable()
@@ -92,6 +198,20 @@ section(std::uint32_t index) const
 }
 
 
+std::uint32_t SectionTable::
+section_count() const
+{
+    return static_cast<std::uint32_t>(sections_.size());
+}
+
+
+std::uint32_t SectionTable::
+shstrndx() const
+{
+    return shstrndx_;
+}
+
+
 void SectionTable::
 iterate_sections(std::function<void(Section const&)> visit) const
 {
@@ -19,7 +19,9 @@
 #ifndef EDHELIND_SECTIONTABLE_H
 #define EDHELIND_SECTIONTABLE_H
 
+#include "libedhel/elf.h"
 #include "libedhel/elfimage.h"
+#include "libedhel/memoryaccount.h"
 #include <functional>
 #include <memory>
 #include <vector>
@@ -32,7 +34,11 @@ class SectionTable
 {
 public:
     SectionTable();
-    SectionTable(ElfFile const& elfFile);
+    /**
+     * Build the section table of @p elfFile, decoding the contents of its
+     * sections on up to @p concurrency threads of the shared ThreadPool.
+     */
+    SectionTable(ElfFile const& elfFile, unsigned concurrency = 1);
 
     ~SectionTable();
 
@@ -43,14 +49,43 @@ public:
     Section const&
     section(std::uint32_t index) const;
 
+    /*! The number of sections, including the null section at index 0 */
+    std::uint32_t
+    section_count() const;
+
+    /*!
+     * Index of the section holding the section names.
+     *
+     * This is e_shstrndx, unless the file uses extended section numbering and
+     * the real index is in the sh_link of section 0.
+     */
+    std::uint32_t
+    shstrndx() const;
+
     void
     iterate_sections(std::function<void(Section const&)>) const;
 
 private:
-    using OwningSectionPtr = std::unique_ptr<Section>;
+    using OwningSectionPtr = CountedPtr<Section>;
+    using Sections = std::vector<OwningSectionPtr, CountingAllocator<OwningSectionPtr>>;
+
+    /** A section whose contents are decoded as it is made */
+    struct Decode
+    {
+        std::uint32_t index_;
+        std::uint64_t size_;
+    };
+
+    OwningSectionPtr
+    make_section(ElfFile const& elfFile, Elf64_Shdr const& header);
+
+    void
+    decode_in_parallel(ElfFile const& elfFile, std::vector<Elf64_Shdr> const& headers,
+                       std::vector<Decode> decodes, unsigned concurrency);
 
-    ElfImageView                  image_view_;
-    std::vector<OwningSectionPtr> sections_;
+    CountedObjects objects_;    /**< what the sections in sections_ took */
+    Sections       sections_;
+    std::uint32_t  shstrndx_ = 0;
 };
 
 #endif /* EDHELIND_SECTIONTABLE_H */
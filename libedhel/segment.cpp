@@ -53,32 +53,13 @@ namespace {
         { FP_W, "FP_W" },
         { FP_R, "FP_R" },
     };
-
-    constexpr std::size_t phdr32_type_offset   = offsetof(Elf32_Phdr, p_type);
-    constexpr std::size_t phdr32_offset_offset = offsetof(Elf32_Phdr, p_offset);
-    constexpr std::size_t phdr32_vaddr_offset  = offsetof(Elf32_Phdr, p_vaddr);
-    constexpr std::size_t phdr32_paddr_offset  = offsetof(Elf32_Phdr, p_paddr);
-    constexpr std::size_t phdr32_filesz_offset = offsetof(Elf32_Phdr, p_filesz);
-    constexpr std::size_t phdr32_memsz_offset  = offsetof(Elf32_Phdr, p_memsz);
-    constexpr std::size_t phdr32_flags_offset  = offsetof(Elf32_Phdr, p_flags);
-    constexpr std::size_t phdr32_align_offset  = offsetof(Elf32_Phdr, p_align);
-
-    constexpr std::size_t phdr64_type_offset   = offsetof(Elf64_Phdr, p_type);
-    constexpr std::size_t phdr64_offset_offset = offsetof(Elf64_Phdr, p_offset);
-    constexpr std::size_t phdr64_vaddr_offset  = offsetof(Elf64_Phdr, p_vaddr);
-    constexpr std::size_t phdr64_paddr_offset  = offsetof(Elf64_Phdr, p_paddr);
-    constexpr std::size_t phdr64_filesz_offset = offsetof(Elf64_Phdr, p_filesz);
-    constexpr std::size_t phdr64_memsz_offset  = offsetof(Elf64_Phdr, p_memsz);
-    constexpr std::size_t phdr64_flags_offset  = offsetof(Elf64_Phdr, p_flags);
-    constexpr std::size_t phdr64_align_offset  = offsetof(Elf64_Phdr, p_align);
 } // anonymous
 
 
 Segment::
-Segment(ElfFile const& elf_file, ElfImageView const& image_view)
+Segment(ElfFile const& elf_file, Elf64_Phdr const& header)
 : elf_file_(&elf_file)
-, image_view_(image_view)
-, is_64bit_(elf_file_->is_64bit())
+, header_(header)
 {
 }
 
@@ -86,7 +67,7 @@ Segment(ElfFile const& elf_file, ElfImageView const& image_view)
 PType Segment::
 type() const
 {
-    return static_cast<PType>(image_view_.get_uint32(phdr32_type_offset));
+    return header_.p_type;
 }
 
 
@@ -115,8 +96,7 @@ type_string() const
 PFlags Segment::
 flags() const
 {
-    return this->is_64bit_ ? static_cast<PFlags>(image_view_.get_uint32(phdr64_flags_offset))
-                           : static_cast<PFlags>(image_view_.get_uint32(phdr32_flags_offset));
+    return header_.p_flags;
 }
 
 
@@ -151,48 +131,42 @@ flags_string() const
 std::uint64_t Segment::
 offset() const
 {
-    return this->is_64bit_ ? image_view_.get_uint64(phdr64_offset_offset)
-                           : image_view_.get_uint32(phdr32_offset_offset);
+    return header_.p_offset;
 }
 
 
 std::uint64_t Segment::
 vaddr() const
 {
-    return this->is_64bit_ ? image_view_.get_uint64(phdr64_vaddr_offset)
-                           : image_view_.get_uint32(phdr32_vaddr_offset);
+    return header_.p_vaddr;
 }
 
 
 std::uint64_t Segment::
 paddr() const
 {
-    return this->is_64bit_ ? image_view_.get_uint64(phdr64_paddr_offset)
-                           : image_view_.get_uint32(phdr32_paddr_offset);
+    return header_.p_paddr;
 }
 
 
 std::uint64_t Segment::
 filesz() const
 {
-    return this->is_64bit_ ? image_view_.get_uint64(phdr64_filesz_offset)
-                           : image_view_.get_uint32(phdr32_filesz_offset);
+    return header_.p_filesz;
 }
 
 
 std::uint64_t Segment::
 memsz() const
 {
-    return this->is_64bit_ ? image_view_.get_uint64(phdr64_memsz_offset)
-                           : image_view_.get_uint32(phdr32_memsz_offset);
+    return header_.p_memsz;
 }
 
 
 std::uint64_t Segment::
 align() const
 {
-    return this->is_64bit_ ? image_view_.get_uint64(phdr64_align_offset)
-                           : image_view_.get_uint32(phdr32_align_offset);
+    return header_.p_align;
 }
 
 std::ostream& Segment::
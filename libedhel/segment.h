@@ -28,11 +28,17 @@
 class ElfFile;
 
 
+/**
+ * A segment, described by its program header.
+ *
+ * The header is decoded into host byte order (and a 32-bit one widened to
+ * the 64-bit layout) when the program header table is read.
+ */
 class Segment
 : public Detailable
 {
 public:
-    Segment(ElfFile const& elfFile, ElfImageView const& imageView);
+    Segment(ElfFile const& elfFile, Elf64_Phdr const& header);
 
     virtual ~Segment() = default;
 
@@ -81,8 +87,7 @@ private:
 
 private:
     ElfFile const* elf_file_;
-    ElfImageView   image_view_;
-    bool           is_64bit_;
+    Elf64_Phdr     header_;
 };
 
 #endif /* EDHELIND_SEGMENT_H */
@@ -24,10 +24,13 @@
 
 
 Segment_INTERP::
-Segment_INTERP(ElfFile const& elf_file, ElfImageView const& image_view)
-: Segment(elf_file, image_view)
+Segment_INTERP(ElfFile const& elf_file, Elf64_Phdr const& header)
+: Segment(elf_file, header)
 , interp_(elf_file.view(this->offset(), this->filesz()).get_string(0, std::string::npos))
 {
+    elf_file.statistics_recorder().add(ParseStatistics::Counter::BytesTouched, interp_.size() + 1);
+    elf_file.statistics_recorder().add(ParseStatistics::Counter::StringsMaterialized, 1);
+    elf_file.memory_recorder().allocated(MemoryAccount::Category::Strings, interp_);
 }
 
 
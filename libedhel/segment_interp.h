@@ -29,7 +29,7 @@ class Segment_INTERP
 : public Segment
 {
 public:
-    Segment_INTERP(ElfFile const& elf_file, ElfImageView const& image_view);
+    Segment_INTERP(ElfFile const& elf_file, Elf64_Phdr const& header);
 
     /** Retrieve the interpreter string */
     std::string
@@ -31,7 +31,7 @@ class Segment_NOTE
 : public Segment
 {
 public:
-    Segment_NOTE(ElfFile const& elf_file, ElfImageView const& image_view);
+    Segment_NOTE(ElfFile const& elf_file, Elf64_Phdr const& header);
 
     void
     iterate_notes(std::function<void(Note const&)>) const;
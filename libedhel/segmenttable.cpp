@@ -18,11 +18,13 @@
  */
 #include "libedhel/segmenttable.h"
 
+#include "libedhel/bulkdecode.h"
 #include "libedhel/elffile.h"
 #include "libedhel/segment.h"
 #include "libedhel/segment_note.h"
 #include "libedhel/segment_interp.h"
 #include <stdexcept>
+#include "libedhel/trace.h"
 
 
 SegmentTable::
@@ -33,29 +35,39 @@ SegmentTable()
 
 SegmentTable::
 SegmentTable(ElfFile const& elfFile)
-: image_view_(elfFile.view(elfFile.elf_header().phoff(),
-                           elfFile.elf_header().phnum() * elfFile.elf_header().phentsize()))
+: objects_(&elfFile.memory_recorder(), MemoryAccount::Category::Headers)
+, segments_(Segments::allocator_type(&elfFile.memory_recorder(), MemoryAccount::Category::Headers))
 {
-    std::size_t phoff = 0;
-    std::size_t phentsize = elfFile.elf_header().phentsize();
-    for (auto i = 0; i < elfFile.elf_header().phnum(); ++i)
+    EDHEL_TRACE_ZONE("build segment table");
+    // Without segments e_phoff means nothing, and may point anywhere.
+    ElfHeader const& elf_header = elfFile.elf_header();
+    std::vector<Elf64_Phdr> headers;
+    if (elf_header.phnum() != 0)
     {
-        auto segmentView = image_view_.view(phoff, phentsize);
-        Segment tmpSegment(elfFile, segmentView);
-        switch (tmpSegment.type())
+        ElfImageView table = elfFile.view(elf_header.phoff(), elf_header.phnum() * elf_header.phentsize());
+        headers = decode_program_headers(table, elf_header.phentsize(), elfFile.is_64bit());
+        if (headers.size() != elf_header.phnum())
+        {
+            throw std::runtime_error("program header entry size is too small");
+        }
+        elfFile.statistics_recorder().add(ParseStatistics::Counter::BytesTouched, table.size());
+    }
+    elfFile.statistics_recorder().add(ParseStatistics::Counter::ObjectsAllocated, elf_header.phnum());
+
+    for (auto const& header: headers)
+    {
+        switch (header.p_type)
         {
         case PType::PT_INTERP:
-            segments_.emplace_back(std::make_unique<Segment_INTERP>(elfFile, segmentView));
+            segments_.emplace_back(make_counted<Segment_INTERP>(objects_, elfFile, header));
             break;
         case PType::PT_NOTE:
-            segments_.emplace_back(std::make_unique<Segment_NOTE>(elfFile, segmentView));
+            segments_.emplace_back(make_counted<Segment_NOTE>(objects_, elfFile, header));
             break;
         default:
-            segments_.emplace_back(std::make_unique<Segment>(elfFile, segmentView));
+            segments_.emplace_back(make_counted<Segment>(objects_, elfFile, header));
             break;
         }
-        
-        phoff += phentsize;
     }
 }
 
@@ -64,7 +76,7 @@ SegmentTable(ElfFile const& elfFile)
  * Destroy a @pSegmentTable
  *
  * This destructor is explicitly defined in the file so the vector of
- * unique_ptrs will have some place to go to die.
+ * owning pointers will have some place to go to die.
  */
 SegmentTable::
 ~SegmentTable()
@@ -84,6 +96,22 @@ segment(std::uint32_t index) const
 }
 
 
+std::optional<std::uint64_t> SegmentTable::
+vaddr_to_offset(std::uint64_t vaddr) const
+{
+    for (auto const& segment: segments_)
+    {
+        if (segment->type() == PType::PT_LOAD
+         && vaddr >= segment->vaddr()
+         && vaddr - segment->vaddr() < segment->filesz())
+        {
+            return segment->offset() + (vaddr - segment->vaddr());
+        }
+    }
+    return std::nullopt;
+}
+
+
 void SegmentTable::
 iterate_segments(std::function<void(Segment const&)> visit) const
 {
@@ -20,8 +20,10 @@
 #define EDHELIND_SEGMENTTABLE_H
 
 #include "libedhel/elfimage.h"
+#include "libedhel/memoryaccount.h"
 #include <functional>
 #include <memory>
+#include <optional>
 #include <vector>
 
 
@@ -43,15 +45,25 @@ public:
     Segment const&
     segment(std::uint32_t index) const;
 
+    /**
+     * Find the file offset that virtual address @p vaddr is loaded from.
+     *
+     * Only the file-backed part of PT_LOAD segments is considered: addresses
+     * in the zero-filled tail of a segment have no file offset.
+     */
+    std::optional<std::uint64_t>
+    vaddr_to_offset(std::uint64_t vaddr) const;
+
     /** Pretty much the classic dl_iterate_phdr() */
     void
     iterate_segments(std::function<void(Segment const&)>) const;
 
 private:
-    using OwningSegmentPtr = std::unique_ptr<Segment>;
+    using OwningSegmentPtr = CountedPtr<Segment>;
+    using Segments = std::vector<OwningSegmentPtr, CountingAllocator<OwningSegmentPtr>>;
 
-    ElfImageView                  image_view_;
-    std::vector<OwningSegmentPtr> segments_;
+    CountedObjects objects_;    /**< what the segments in segments_ took */
+    Segments       segments_;
 };
 
 #endif /* EDHELIND_SEGMENTTABLE_H */
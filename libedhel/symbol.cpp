@@ -81,106 +81,13 @@ namespace
     };
     const std::string st_other_other{"(OTHER)"};
 
-
-    class Symbol32
-    : public Symbol
-    {
-    public:
-        Symbol32(ElfFile const& elf_file, ElfImageView const& image_view, std::uint32_t strndx)
-        : Symbol(elf_file, image_view, strndx)
-        { }
-
-    private:
-        std::uint32_t
-        get_name() const override
-        {
-            return image_view_.get_uint32(offsetof(Elf32::Sym, st_name));
-        }
-
-        std::uint64_t
-        get_value() const override
-        {
-            return image_view_.get_uint32(offsetof(Elf32::Sym, st_value));
-        }
-
-        std::uint64_t
-        get_size() const override
-        {
-            return image_view_.get_uint32(offsetof(Elf32::Sym, st_size));
-        }
-
-        st_shndx_t
-        get_shndx() const override
-        {
-            return image_view_.get_uint16(offsetof(Elf32::Sym, st_shndx));
-        }
-
-        st_info_t
-        get_info() const override
-        {
-            return image_view_.get_uint8(offsetof(Elf32::Sym, st_info));
-        }
-
-        st_other_t
-        get_other() const override
-        {
-            return image_view_.get_uint8(offsetof(Elf32::Sym, st_other));
-        }
-    };
-
-
-    class Symbol64
-    : public Symbol
-    {
-    public:
-        Symbol64(ElfFile const& elf_file, ElfImageView const& image_view, std::uint32_t strndx)
-        : Symbol(elf_file, image_view, strndx)
-        { }
-
-    private:
-        std::uint32_t
-        get_name() const override
-        {
-            return image_view_.get_uint32(offsetof(Elf64::Sym, st_name));
-        }
-
-        std::uint64_t
-        get_value() const override
-        {
-            return image_view_.get_uint64(offsetof(Elf64::Sym, st_value));
-        }
-
-        std::uint64_t
-        get_size() const override
-        {
-            return image_view_.get_uint64(offsetof(Elf64::Sym, st_size));
-        }
-
-        st_shndx_t
-        get_shndx() const override
-        {
-            return image_view_.get_uint16(offsetof(Elf64::Sym, st_shndx));
-        }
-
-        st_info_t
-        get_info() const override
-        {
-            return image_view_.get_uint8(offsetof(Elf64::Sym, st_info));
-        }
-
-        st_other_t
-        get_other() const override
-        {
-            return image_view_.get_uint8(offsetof(Elf64::Sym, st_other));
-        }
-    };
 } // anonymous
 
 
 Symbol::
-Symbol(ElfFile const& elf_file, ElfImageView const& image_view, std::uint32_t strndx)
+Symbol(ElfFile const& elf_file, Elf64::Sym const& sym, std::uint32_t strndx)
 : elf_file_{&elf_file}
-, image_view_{image_view}
+, sym_{sym}
 , strndx_{strndx}
 {
 }
@@ -189,7 +96,7 @@ Symbol(ElfFile const& elf_file, ElfImageView const& image_view, std::uint32_t st
 std::uint32_t Symbol::
 name() const
 {
-    return this->get_name();
+    return sym_.st_name;
 }
 
 
@@ -209,21 +116,21 @@ name_string() const
 std::uint64_t Symbol::
 value() const
 {
-    return this->get_value();
+    return sym_.st_value;
 }
 
 
 std::uint64_t Symbol::
 size() const
 {
-    return this->get_size();
+    return sym_.st_size;
 }
 
 
 st_shndx_t Symbol::
 shndx() const
 {
-    return this->get_shndx();
+    return sym_.st_shndx;
 }
 
 
@@ -255,7 +162,7 @@ shndx_string() const
 st_info_t Symbol::
 info() const
 {
-    return this->get_info();
+    return sym_.st_info;
 }
 
 
@@ -306,7 +213,7 @@ type_string() const
 st_other_t Symbol::
 other() const
 {
-    return this->get_other();
+    return sym_.st_other;
 }
 
 
@@ -346,12 +253,8 @@ printTo(std::ostream& ostr) const
 }
 
 
-std::unique_ptr<Symbol>
-make_symbol(ElfFile const& elf_file, ElfImageView const& image_view, std::uint32_t strndx)
+CountedPtr<Symbol>
+make_symbol(CountedObjects& objects, ElfFile const& elf_file, Elf64::Sym const& sym, std::uint32_t strndx)
 {
-    using std::make_unique;
-
-    if (elf_file.is_64bit())
-        return make_unique<Symbol64>(elf_file, image_view, strndx);
-    return make_unique<Symbol32>(elf_file, image_view, strndx);
+    return make_counted<Symbol>(objects, elf_file, sym, strndx);
 }
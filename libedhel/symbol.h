@@ -20,8 +20,9 @@
 #define EDHELIND_SYMBOL_H
 
 #include "libedhel/detailable.h"
+#include "libedhel/elf.h"
 #include "libedhel/elffile.h"
-#include "libedhel/elfimage.h"
+#include "libedhel/memoryaccount.h"
 #include <string>
 
 using st_info_t = std::uint8_t;
@@ -97,6 +98,7 @@ constexpr inline st_shndx_t SHN_LOOS      = 0xff20; /**< start of OS-specific va
 constexpr inline st_shndx_t SHN_HIOS      = 0xff3f; /**< start of OS-specific values */
 constexpr inline st_shndx_t SHN_ABS       = 0xfff1; /**< symbol location is absolute*/
 constexpr inline st_shndx_t SHN_COMMON    = 0xfff2; /**< start of a common block */
+constexpr inline st_shndx_t SHN_XINDEX    = 0xffff; /**< the real index is in SHT_SYMTAB_SHNDX */
 constexpr inline st_shndx_t SHN_HIRESERVE = 0xffff; /**< end of reserved index values */
 
 /** @} */
@@ -104,13 +106,15 @@ constexpr inline st_shndx_t SHN_HIRESERVE = 0xffff; /**< end of reserved index v
 /**
  * A single Symbol
  *
- * A Symbol is keyed by (name, type).
+ * A Symbol is keyed by (name, type).  Its table entry is decoded into host
+ * byte order (and a 32-bit one widened to the 64-bit layout) when the symbol
+ * table is read.
  */
 class Symbol
 : public Detailable
 {
 public:
-    Symbol(ElfFile const& elf_file, ElfImageView const& image_view, std::uint32_t strndx);
+    Symbol(ElfFile const& elf_file, Elf64::Sym const& sym, std::uint32_t strndx);
 
     std::uint32_t
     name() const;
@@ -155,36 +159,18 @@ public:
     printTo(std::ostream& ostr) const override;
 
 private:
-    virtual std::uint32_t
-    get_name() const = 0;
-
-    virtual std::uint64_t
-    get_value() const= 0;
-
-    virtual std::uint64_t
-    get_size() const = 0;
-
-    virtual st_shndx_t
-    get_shndx() const = 0;
-
-    virtual st_info_t
-    get_info() const = 0;
-
-    virtual st_other_t
-    get_other() const = 0;
-
-protected:
     ElfFile const* elf_file_;
-    ElfImageView   image_view_;
+    Elf64::Sym     sym_;
     std::uint32_t  strndx_;
 };
 
 
 /**
- * Factory function to create a Symbol from an ElfImageView on an ElfFile
+ * Factory function to create a Symbol from a decoded symbol table entry of an
+ * ElfFile, recording it in @p objects
  */
-std::unique_ptr<Symbol>
-make_symbol(ElfFile const& elf_file, ElfImageView const& image_view, std::uint32_t strndx);
+CountedPtr<Symbol>
+make_symbol(CountedObjects& objects, ElfFile const& elf_file, Elf64::Sym const& sym, std::uint32_t strndx);
 
 #endif /* EDHELIND_SYMBOL_H */
 
@@ -0,0 +1,322 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "libedhel/threadpool.h"
+
+#include <algorithm>
+#include <cstdlib>
+
+
+namespace
+{
+    /** The pool and queue the calling thread works for, if it's a worker */
+    thread_local ThreadPool const* current_pool = nullptr;
+    thread_local std::size_t current_queue = 0;
+
+    unsigned
+    default_worker_count()
+    {
+        if (char const* threads = std::getenv("EDHELIND_THREADS"))
+        {
+            return std::max(1u, static_cast<unsigned>(std::strtoul(threads, nullptr, 10)));
+        }
+        unsigned cores = std::thread::hardware_concurrency();
+        return cores > 2 ? cores - 1 : 1;
+    }
+} // anonymous namespace
+
+
+ThreadPool::
+ThreadPool(unsigned worker_count)
+: queued_{0}
+, next_queue_{0}
+, stop_{false}
+{
+    // A pool without workers still needs somewhere to queue tasks for the
+    // threads waiting on them to run.
+    for (unsigned i = 0; i < std::max(worker_count, 1u); ++i)
+    {
+        queues_.push_back(std::make_unique<Queue>());
+    }
+    for (unsigned i = 0; i < worker_count; ++i)
+    {
+        workers_.emplace_back([this, i]{ this->work(i); });
+    }
+}
+
+
+ThreadPool::
+~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+        stop_ = true;
+    }
+    wake_.notify_all();
+    for (auto& worker: workers_)
+    {
+        worker.join();
+    }
+}
+
+
+unsigned ThreadPool::
+worker_count() const
+{
+    return static_cast<unsigned>(workers_.size());
+}
+
+
+ThreadPool& ThreadPool::
+shared()
+{
+    static ThreadPool the_pool(default_worker_count());
+    return the_pool;
+}
+
+
+void ThreadPool::
+submit(Task task)
+{
+    std::size_t index = current_pool == this
+                      ? current_queue
+                      : next_queue_.fetch_add(1, std::memory_order_relaxed) % queues_.size();
+    {
+        std::lock_guard<std::mutex> lock(queues_[index]->mutex_);
+        queues_[index]->tasks_.push_back(std::move(task));
+    }
+    queued_.fetch_add(1);
+    {
+        // Taking the lock orders this against a worker deciding to sleep.
+        std::lock_guard<std::mutex> lock(sleep_mutex_);
+    }
+    wake_.notify_one();
+}
+
+
+bool ThreadPool::
+run_pending_task()
+{
+    Task task;
+    if (!this->pop(current_pool == this ? current_queue : 0, task))
+    {
+        return false;
+    }
+    task();
+    return true;
+}
+
+
+/**
+ * Take a task from the back of queue @p home, or failing that steal one from
+ * the front of another queue.
+ */
+bool ThreadPool::
+pop(std::size_t home, Task& task)
+{
+    if (queued_.load() == 0)
+    {
+        return false;
+    }
+
+    for (std::size_t i = 0; i < queues_.size(); ++i)
+    {
+        Queue& queue = *queues_[(home + i) % queues_.size()];
+        std::lock_guard<std::mutex> lock(queue.mutex_);
+        if (!queue.tasks_.empty())
+        {
+            if (i == 0)
+            {
+                task = std::move(queue.tasks_.back());
+                queue.tasks_.pop_back();
+            }
+            else
+            {
+                task = std::move(queue.tasks_.front());
+                queue.tasks_.pop_front();
+            }
+            queued_.fetch_sub(1);
+            return true;
+        }
+    }
+    return false;
+}
+
+
+void ThreadPool::
+work(std::size_t index)
+{
+    current_pool = this;
+    current_queue = index;
+    while (true)
+    {
+        Task task;
+        if (this->pop(index, task))
+        {
+            task();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleep_mutex_);
+        wake_.wait(lock, [this]{ return stop_ || queued_.load() > 0; });
+        if (stop_ && queued_.load() == 0)
+        {
+            break;
+        }
+    }
+}
+
+
+/**
+ * The group's tasks that have yet to start, and how the group is getting on.
+ *
+ * Placeholders still sitting in the pool's queues when the group is destroyed
+ * keep this alive, and find nothing left to run.
+ */
+struct TaskGroup::State
+{
+    std::mutex                        mutex_;
+    std::condition_variable           done_;     /**< signalled when pending_ drops to 0 or a task is queued */
+    std::deque<std::function<void()>> queued_;
+    std::size_t                       pending_ = 0;
+    std::exception_ptr                error_;
+    std::atomic<bool>                 cancelled_{false};
+
+    /** Run @p task unless the group is cancelled, then mark it done */
+    void
+    execute(std::function<void()> const& task)
+    {
+        if (!cancelled_.load(std::memory_order_relaxed))
+        {
+            try
+            {
+                task();
+            }
+            catch (...)
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (!error_)
+                {
+                    error_ = std::current_exception();
+                }
+                cancelled_ = true;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (--pending_ == 0)
+        {
+            done_.notify_all();
+        }
+    }
+};
+
+
+TaskGroup::
+TaskGroup(ThreadPool& pool)
+: pool_{pool}
+, state_{std::make_shared<State>()}
+{
+}
+
+
+TaskGroup::
+~TaskGroup()
+{
+    try
+    {
+        this->wait();
+    }
+    catch (...)
+    {
+    }
+}
+
+
+void TaskGroup::
+run(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(state_->mutex_);
+        ++state_->pending_;
+        state_->queued_.push_back(std::move(task));
+    }
+    state_->done_.notify_all();
+
+    // The pool's workers take the oldest task, the one most likely to hold
+    // the others up; the waiter takes the newest, as a worker would its own.
+    pool_.submit([state = state_]() {
+        std::function<void()> task;
+        {
+            std::lock_guard<std::mutex> lock(state->mutex_);
+            if (state->queued_.empty())
+            {
+                return;
+            }
+            task = std::move(state->queued_.front());
+            state->queued_.pop_front();
+        }
+        state->execute(task);
+    });
+}
+
+
+void TaskGroup::
+wait()
+{
+    State& state = *state_;
+    std::unique_lock<std::mutex> lock(state.mutex_);
+    while (state.pending_ != 0)
+    {
+        // Lend a hand rather than just block: the task being waited for may be
+        // sitting in a queue behind others, or this may be a worker itself.
+        if (!state.queued_.empty())
+        {
+            std::function<void()> task = std::move(state.queued_.back());
+            state.queued_.pop_back();
+            lock.unlock();
+            state.execute(task);
+            lock.lock();
+            continue;
+        }
+        state.done_.wait(lock, [&state]{ return state.pending_ == 0 || !state.queued_.empty(); });
+    }
+
+    std::exception_ptr error;
+    std::swap(error, state.error_);
+    state.cancelled_ = false;
+    lock.unlock();
+    if (error)
+    {
+        std::rethrow_exception(error);
+    }
+}
+
+
+void TaskGroup::
+cancel()
+{
+    state_->cancelled_ = true;
+}
+
+
+bool TaskGroup::
+is_cancelled() const
+{
+    return state_->cancelled_.load(std::memory_order_relaxed);
+}
@@ -0,0 +1,168 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef EDHELIND_THREADPOOL_H
+#define EDHELIND_THREADPOOL_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+
+/**
+ * A work-stealing pool of worker threads.
+ *
+ * Each worker has its own deque of tasks.  A task submitted from a worker goes
+ * on the back of that worker's deque and the worker takes its own tasks from
+ * the back, so nested work stays on a warm cache; an idle worker steals from
+ * the front of the others' deques, where the oldest and usually biggest tasks
+ * are.  Tasks submitted from outside the pool are dealt out to the workers in
+ * turn.
+ *
+ * Tasks are normally run as part of a TaskGroup, which can be waited on and
+ * cancelled.  A thread waiting on a group runs that group's queued tasks while
+ * it waits, so tasks may safely wait on groups of their own.
+ */
+class ThreadPool
+{
+public:
+    using Task = std::function<void()>;
+
+public:
+    /** Construct a pool of @p worker_count threads (which may be none) */
+    explicit ThreadPool(unsigned worker_count);
+
+    ThreadPool(ThreadPool const&) = delete;
+    ThreadPool& operator=(ThreadPool const&) = delete;
+
+    /** Finishes all queued tasks and then stops the workers */
+    ~ThreadPool();
+
+    unsigned
+    worker_count() const;
+
+    /**
+     * The pool shared by everything in the process.
+     *
+     * It has one thread fewer than there are cores, since whoever waits on a
+     * task group lends a hand, but always at least one.  Setting the
+     * EDHELIND_THREADS environment variable overrides the number of threads.
+     */
+    static ThreadPool&
+    shared();
+
+    /** Queue @p task to be run by the pool */
+    void
+    submit(Task task);
+
+    /**
+     * Run one queued task on the calling thread, if there is one.
+     * @returns true if a task was run
+     */
+    bool
+    run_pending_task();
+
+private:
+    struct Queue
+    {
+        std::mutex       mutex_;
+        std::deque<Task> tasks_;
+    };
+
+    bool
+    pop(std::size_t home, Task& task);
+
+    void
+    work(std::size_t index);
+
+private:
+    std::vector<std::unique_ptr<Queue>> queues_;
+    std::vector<std::thread>            workers_;
+    std::atomic<std::size_t>            queued_;
+    std::atomic<std::size_t>            next_queue_;
+    std::mutex                          sleep_mutex_;
+    std::condition_variable             wake_;
+    bool                                stop_;
+};
+
+
+/**
+ * A set of tasks run on a ThreadPool that can be waited for or cancelled as a
+ * whole.
+ *
+ * If a task throws, the rest of the group is cancelled and the exception is
+ * rethrown by wait().
+ *
+ * The group keeps its tasks in a queue of its own and hands the pool one
+ * placeholder per task, which runs whichever of them is next.  That way a
+ * thread waiting on the group can run the group's tasks itself but never
+ * anyone else's: waiting on the GUI thread must not mean picking up some other
+ * window's long-running job.
+ */
+class TaskGroup
+{
+public:
+    explicit TaskGroup(ThreadPool& pool = ThreadPool::shared());
+
+    TaskGroup(TaskGroup const&) = delete;
+    TaskGroup& operator=(TaskGroup const&) = delete;
+
+    /** Waits for the tasks still running, discarding any exception */
+    ~TaskGroup();
+
+    /** Run @p task as part of this group */
+    void
+    run(std::function<void()> task);
+
+    /**
+     * Wait for every task in the group to finish, running the group's queued
+     * tasks in the meantime.  Once it returns the group is empty, no longer
+     * cancelled, and ready to be used again.
+     *
+     * @throws whatever the first task to throw threw
+     */
+    void
+    wait();
+
+    /**
+     * Skip the tasks in the group that haven't started yet.  Running tasks
+     * should poll is_cancelled() and give up early.
+     */
+    void
+    cancel();
+
+    /** Whether the group has been cancelled since it was last waited for */
+    bool
+    is_cancelled() const;
+
+private:
+    /** What the group shares with the placeholders it has handed the pool */
+    struct State;
+
+    ThreadPool&            pool_;
+    std::shared_ptr<State> state_;
+};
+
+#endif /* EDHELIND_THREADPOOL_H */
@@ -0,0 +1,231 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "libedhel/trace.h"
+
+#if defined(EDHELIND_TRACING)
+# include <algorithm>
+# include <atomic>
+# include <chrono>
+# include <cstdio>
+# include <memory>
+# include <mutex>
+# include <vector>
+
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    struct Event
+    {
+        char const*  name_;
+        std::string  detail_;
+        std::int64_t start_ns_;
+        std::int64_t duration_ns_;
+    };
+
+    /**
+     * The events recorded by one thread.  Only that thread appends to it, so
+     * the lock is only ever contended while a trace is being written.
+     */
+    struct ThreadEvents
+    {
+        std::mutex         mutex_;
+        std::uint32_t      tid_;
+        std::vector<Event> events_;
+    };
+
+    struct Tracer
+    {
+        std::atomic<bool>                          enabled_{false};
+        std::mutex                                 mutex_;
+        std::string                                file_name_;
+        std::atomic<std::int64_t>                  epoch_ns_{0};
+        std::uint32_t                              next_tid_ = 1;
+        std::vector<std::shared_ptr<ThreadEvents>> threads_;
+    };
+
+    Tracer&
+    tracer()
+    {
+        static Tracer the_tracer;
+        return the_tracer;
+    }
+
+    ThreadEvents&
+    thread_events()
+    {
+        thread_local std::shared_ptr<ThreadEvents> events = [] {
+            auto events = std::make_shared<ThreadEvents>();
+            Tracer& t = tracer();
+            std::lock_guard<std::mutex> lock(t.mutex_);
+            events->tid_ = t.next_tid_++;
+            t.threads_.push_back(events);
+            return events;
+        }();
+        return *events;
+    }
+
+    std::int64_t
+    clock_ns()
+    {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(Clock::now().time_since_epoch()).count();
+    }
+
+    /** Nanoseconds since the trace was started */
+    std::int64_t
+    now_ns()
+    {
+        return clock_ns() - tracer().epoch_ns_.load(std::memory_order_relaxed);
+    }
+
+    void
+    write_json_string(std::FILE* file, char const* s)
+    {
+        std::fputc('"', file);
+        for (; *s; ++s)
+        {
+            unsigned char c = static_cast<unsigned char>(*s);
+            if (c == '"' || c == '\\')
+            {
+                std::fputc('\\', file);
+                std::fputc(c, file);
+            }
+            else if (c < 0x20)
+            {
+                std::fprintf(file, "\\u%04x", c);
+            }
+            else
+            {
+                std::fputc(c, file);
+            }
+        }
+        std::fputc('"', file);
+    }
+} // anonymous namespace
+
+
+bool
+trace_start(std::string const& file_name)
+{
+    Tracer& t = tracer();
+    std::lock_guard<std::mutex> lock(t.mutex_);
+    for (auto const& thread: t.threads_)
+    {
+        std::lock_guard<std::mutex> thread_lock(thread->mutex_);
+        thread->events_.clear();
+    }
+    t.file_name_ = file_name;
+    t.epoch_ns_.store(clock_ns(), std::memory_order_relaxed);
+    t.enabled_.store(true, std::memory_order_release);
+    return true;
+}
+
+
+bool
+trace_stop()
+{
+    Tracer& t = tracer();
+    if (!t.enabled_.exchange(false))
+    {
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lock(t.mutex_);
+    std::FILE* file = std::fopen(t.file_name_.c_str(), "w");
+    if (file == nullptr)
+    {
+        return false;
+    }
+
+    std::fputs("{\"displayTimeUnit\":\"ns\",\"traceEvents\":[", file);
+    char const* separator = "\n";
+    for (auto const& thread: t.threads_)
+    {
+        std::lock_guard<std::mutex> thread_lock(thread->mutex_);
+        for (Event const& event: thread->events_)
+        {
+            std::fputs(separator, file);
+            std::fputs("{\"name\":", file);
+            write_json_string(file, event.name_);
+            std::fprintf(file, ",\"cat\":\"edhelind\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%u",
+                         event.start_ns_ / 1000.0, event.duration_ns_ / 1000.0, thread->tid_);
+            if (!event.detail_.empty())
+            {
+                std::fputs(",\"args\":{\"detail\":", file);
+                write_json_string(file, event.detail_.c_str());
+                std::fputc('}', file);
+            }
+            std::fputc('}', file);
+            separator = ",\n";
+        }
+        thread->events_.clear();
+    }
+    std::fputs("\n]}\n", file);
+
+    // Forget the threads that have gone away since the last trace.
+    t.threads_.erase(std::remove_if(t.threads_.begin(), t.threads_.end(), [](auto const& thread) {
+                         return thread.use_count() == 1;
+                     }),
+                     t.threads_.end());
+    return std::fclose(file) == 0;
+}
+
+
+TraceZone::
+TraceZone(char const* name)
+: name_{nullptr}
+, start_ns_{0}
+{
+    if (tracer().enabled_.load(std::memory_order_relaxed))
+    {
+        name_ = name;
+        start_ns_ = now_ns();
+    }
+}
+
+
+TraceZone::
+~TraceZone()
+{
+    if (name_ && tracer().enabled_.load(std::memory_order_relaxed))
+    {
+        std::int64_t duration_ns = now_ns() - start_ns_;
+        ThreadEvents& events = thread_events();
+        std::lock_guard<std::mutex> lock(events.mutex_);
+        events.events_.push_back(Event{name_, std::move(detail_), start_ns_, duration_ns});
+    }
+}
+
+#else
+
+bool
+trace_start(std::string const&)
+{
+    return false;
+}
+
+
+bool
+trace_stop()
+{
+    return false;
+}
+
+#endif
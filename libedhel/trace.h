@@ -0,0 +1,108 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef EDHELIND_TRACE_H
+#define EDHELIND_TRACE_H
+
+#include "edhelind_config.h"
+#include <cstdint>
+#include <string>
+
+
+/**
+ * Scoped trace zones, written out in the Chrome trace event format so a trace
+ * can be opened in chrome://tracing or Perfetto to see where the time went,
+ * thread by thread.
+ *
+ * Zones are only compiled in when the build is configured with
+ * EDHELIND_TRACING on.  Otherwise EDHEL_TRACE_ZONE() expands to nothing and
+ * trace_start() just reports that tracing is not available.  When compiled in,
+ * a zone costs a single relaxed atomic load until a trace is started, and its
+ * detail argument, if it has one, is not evaluated until then either.
+ */
+
+/**
+ * Start recording a trace to be written to @p file_name.
+ *
+ * @returns false if tracing is not compiled in
+ */
+bool
+trace_start(std::string const& file_name);
+
+/**
+ * Stop recording and write out the trace started by trace_start().
+ *
+ * @returns false if there was no trace or it could not be written
+ */
+bool
+trace_stop();
+
+
+#if defined(EDHELIND_TRACING)
+
+/**
+ * Records the time from its construction to its destruction as a zone named
+ * @p name, which must be a string literal.
+ */
+class TraceZone
+{
+public:
+    explicit TraceZone(char const* name);
+
+    /**
+     * A zone with some detail, such as a file name, to tell it apart.  The
+     * detail is only made, by calling @p make_detail, if a trace is running.
+     */
+    template<typename MakeDetail>
+        TraceZone(char const* name, MakeDetail const& make_detail)
+        : TraceZone(name)
+        {
+            if (name_)
+            {
+                detail_ = make_detail();
+            }
+        }
+
+    TraceZone(TraceZone const&) = delete;
+    TraceZone& operator=(TraceZone const&) = delete;
+
+    ~TraceZone();
+
+private:
+    char const*  name_;
+    std::string  detail_;
+    std::int64_t start_ns_;
+};
+
+# define EDHEL_TRACE_CONCAT_(a, b) a##b
+# define EDHEL_TRACE_CONCAT(a, b) EDHEL_TRACE_CONCAT_(a, b)
+# define EDHEL_TRACE_ZONE_NAME_(name) \
+    TraceZone EDHEL_TRACE_CONCAT(trace_zone_, __LINE__)(name)
+# define EDHEL_TRACE_ZONE_DETAIL_(name, detail) \
+    TraceZone EDHEL_TRACE_CONCAT(trace_zone_, __LINE__)(name, [&]() -> std::string { return detail; })
+# define EDHEL_TRACE_ZONE_PICK_(_1, _2, zone, ...) zone
+# define EDHEL_TRACE_ZONE(...) \
+    EDHEL_TRACE_ZONE_PICK_(__VA_ARGS__, EDHEL_TRACE_ZONE_DETAIL_, EDHEL_TRACE_ZONE_NAME_, )(__VA_ARGS__)
+
+#else
+
+# define EDHEL_TRACE_ZONE(...) static_cast<void>(0)
+
+#endif
+
+#endif /* EDHELIND_TRACE_H */
@@ -0,0 +1,53 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "test/catch.hpp"
+#include "edhelind/backgroundworker.h"
+
+#include <chrono>
+#include <future>
+#include <stdexcept>
+#include <string>
+
+
+TEST_CASE("BackgroundWorker functionality") {
+    SECTION("Verify a job that throws doesn't stop the next one") {
+        std::promise<std::string> failure;
+        BackgroundWorker worker([&failure](std::string const& what) { failure.set_value(what); });
+
+        worker.post([](BackgroundWorker::IsCancelled const&) { throw std::runtime_error("job failed"); });
+        auto failed = failure.get_future();
+        REQUIRE(failed.wait_for(std::chrono::seconds(10)) == std::future_status::ready);
+        CHECK(failed.get() == "job failed");
+
+        std::promise<void> ran;
+        worker.post([&ran](BackgroundWorker::IsCancelled const&) { ran.set_value(); });
+        CHECK(ran.get_future().wait_for(std::chrono::seconds(10)) == std::future_status::ready);
+        CHECK_NOTHROW(worker.cancel());
+    }
+
+    SECTION("Verify a worker without a failure callback survives a throwing job") {
+        BackgroundWorker worker;
+        worker.post([](BackgroundWorker::IsCancelled const&) { throw 42; });
+        CHECK_NOTHROW(worker.cancel());
+
+        std::promise<void> ran;
+        worker.post([&ran](BackgroundWorker::IsCancelled const&) { ran.set_value(); });
+        CHECK(ran.get_future().wait_for(std::chrono::seconds(10)) == std::future_status::ready);
+    }
+}
@@ -0,0 +1,164 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "test/catch.hpp"
+#include "elfgen/elfgen.h"
+#include "libedhel/bulkdecode.h"
+#include "libedhel/elffile.h"
+#include "libedhel/elfheader.h"
+#include "libedhel/section.h"
+#include "libedhel/section_symtab.h"
+#include "libedhel/symbol.h"
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+
+
+namespace
+{
+    template<typename Entry>
+    bool
+    same_entries(std::vector<Entry> const& a, std::vector<Entry> const& b)
+    {
+        return a.size() == b.size() && std::memcmp(a.data(), b.data(), a.size() * sizeof(Entry)) == 0;
+    }
+
+    template<typename Shdr, typename Sym, typename Rela>
+    void
+    check_decoded_tables(std::string const& le_name, std::string const& be_name)
+    {
+        ElfFile le_file(le_name);
+        ElfFile be_file(be_name);
+        ElfHeader const& header = le_file.elf_header();
+
+        auto shdrs = [&header](ElfFile const& elf_file) {
+            return decode_table<Shdr>(elf_file.view(header.shoff(), header.shnum() * header.shentsize()),
+                                      header.shentsize());
+        };
+        auto table = [](ElfFile const& elf_file, SType type, auto entry) {
+            for (std::uint32_t i = 0; i < elf_file.section_table().section_count(); ++i)
+            {
+                Section const& section = elf_file.section(i);
+                if (section.type() == type)
+                {
+                    return decode_table<decltype(entry)>(elf_file.view(section.offset(), section.size()),
+                                                         section.entsize());
+                }
+            }
+            return std::vector<decltype(entry)>{};
+        };
+
+        std::vector<Shdr> le_shdrs = shdrs(le_file);
+        REQUIRE(le_shdrs.size() == header.shnum());
+        CHECK(same_entries(le_shdrs, shdrs(be_file)));
+        for (std::uint32_t i = 0; i < le_shdrs.size(); ++i)
+        {
+            Section const& section = be_file.section(i);
+            CHECK(le_shdrs[i].sh_type == section.type());
+            CHECK(le_shdrs[i].sh_offset == section.offset());
+            CHECK(le_shdrs[i].sh_size == section.size());
+            CHECK(le_shdrs[i].sh_link == section.link());
+            CHECK(le_shdrs[i].sh_entsize == section.entsize());
+        }
+
+        std::vector<Sym> le_symbols = table(le_file, SType::SHT_SYMTAB, Sym{});
+        std::vector<Sym> be_symbols = table(be_file, SType::SHT_SYMTAB, Sym{});
+        REQUIRE(!le_symbols.empty());
+        CHECK(same_entries(le_symbols, be_symbols));
+
+        Section_SYMTAB const* symtab = nullptr;
+        be_file.section_table().iterate_sections([&symtab](Section const& section) {
+            if (symtab == nullptr)
+            {
+                symtab = dynamic_cast<Section_SYMTAB const*>(&section);
+            }
+        });
+        REQUIRE(symtab != nullptr);
+        REQUIRE(symtab->symbol_count() == be_symbols.size());
+        std::vector<std::uint32_t> names = symtab->symbol_names();
+        for (std::uint32_t i = 0; i < be_symbols.size(); ++i)
+        {
+            Symbol const& symbol = symtab->symbol(i);
+            CHECK(be_symbols[i].st_name == symbol.name());
+            CHECK(names[i] == symbol.name());
+            CHECK(be_symbols[i].st_value == symbol.value());
+            CHECK(be_symbols[i].st_size == symbol.size());
+            CHECK(be_symbols[i].st_info == symbol.info());
+            CHECK(be_symbols[i].st_shndx == symbol.shndx());
+        }
+
+        std::vector<Rela> le_relocations = table(le_file, SType::SHT_RELA, Rela{});
+        REQUIRE(!le_relocations.empty());
+        CHECK(same_entries(le_relocations, table(be_file, SType::SHT_RELA, Rela{})));
+    }
+} // anonymous namespace
+
+
+TEST_CASE("bulk table decoding") {
+    std::string le_name = (std::filesystem::temp_directory_path() / "edhelind_bulk_le.elf").string();
+    std::string be_name = (std::filesystem::temp_directory_path() / "edhelind_bulk_be.elf").string();
+
+    for (bool is_64bit: { true, false })
+    {
+        SECTION(std::string("Verify big- and little-endian tables decode the same")
+                + (is_64bit ? " (64-bit)" : " (32-bit)")) {
+            ElfSpec spec;
+            spec.is_64bit_ = is_64bit;
+            spec.section_count_ = 13;
+            spec.symbol_count_ = 101;
+            spec.relocation_count_ = 37;
+            write_elf(spec, le_name);
+            spec.big_endian_ = true;
+            write_elf(spec, be_name);
+
+            if (is_64bit)
+            {
+                check_decoded_tables<Elf64_Shdr, Elf64::Sym, Elf64_Rela>(le_name, be_name);
+            }
+            else
+            {
+                check_decoded_tables<Elf32_Shdr, Elf32::Sym, Elf32_Rela>(le_name, be_name);
+            }
+            std::remove(le_name.c_str());
+            std::remove(be_name.c_str());
+        }
+    }
+
+    SECTION("Verify entries further apart than their size are decoded") {
+        // Big-endian Elf32_Dyn entries padded out to 12 bytes.
+        std::vector<std::byte> table(12 * 5);
+        for (std::size_t i = 0; i < 5; ++i)
+        {
+            std::byte* entry = table.data() + i * 12;
+            entry[3] = std::byte(i + 1);
+            entry[4] = std::byte(0xa0 + i);
+            entry[7] = std::byte(0x0b);
+            entry[8] = std::byte(0xff);
+        }
+
+        Elf32_Dyn dynamic[5];
+        decode_table(table.data(), 5, 12, true, dynamic);
+        for (std::size_t i = 0; i < 5; ++i)
+        {
+            CHECK(dynamic[i].d_tag == std::int32_t(i + 1));
+            CHECK(dynamic[i].d_val == ((0xa0 + i) << 24 | 0x0b));
+        }
+
+        CHECK(decode_table<Elf64_Dyn>(ElfImageView{}, 8).empty());
+    }
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmsoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "test/catch.hpp"
+#include "libedhel/detailable.h"
+#include <ostream>
+#include <sstream>
+
+
+namespace
+{
+    /** A Detailable relying on the default line-oriented implementation */
+    class ThreeLines
+    : public Detailable
+    {
+        std::ostream&
+        printTo(std::ostream& ostr) const override
+        {
+            return ostr << "one\ntwo\nthree";
+        }
+    };
+} // anonymous
+
+
+TEST_CASE("Detailable line paging") {
+    ThreeLines detailable;
+
+    SECTION("Verify the line count includes an unterminated last line") {
+        CHECK(detailable.lineCount() == 3);
+    }
+
+    SECTION("Verify a window of lines is printed") {
+        std::ostringstream ostr;
+        detailable.printLinesTo(ostr, 1, 1);
+        CHECK(ostr.str() == "two\n");
+    }
+
+    SECTION("Verify lines past the end are ignored") {
+        std::ostringstream ostr;
+        detailable.printLinesTo(ostr, 2, 10);
+        CHECK(ostr.str() == "three\n");
+
+        std::ostringstream empty;
+        detailable.printLinesTo(empty, 5, 10);
+        CHECK(empty.str().empty());
+    }
+}
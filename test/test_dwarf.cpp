@@ -0,0 +1,69 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "test/catch.hpp"
+#include "libedhel/dwarf.h"
+#include <cstddef>
+#include <initializer_list>
+#include <vector>
+
+
+namespace
+{
+    std::vector<std::byte>
+    bytes_of(std::initializer_list<unsigned> list)
+    {
+        std::vector<std::byte> bytes;
+        for (unsigned b: list)
+        {
+            bytes.push_back(std::byte(b));
+        }
+        return bytes;
+    }
+} // anonymous namespace
+
+
+TEST_CASE("DWARF attribute values") {
+    DwarfFormat format;
+    format.version_ = 5;
+
+    SECTION("Verify an indirect value is read in the form that follows it") {
+        std::vector<std::byte> bytes = bytes_of({ DW_FORM_data2, 0x34, 0x12, DW_FORM_data1, 0x56, 0x78 });
+        DwarfReader reader(bytes.data(), bytes.size(), false);
+        CHECK(reader.form_value(DW_FORM_indirect, format) == 0x1234);
+        reader.skip_form(DW_FORM_indirect, format);
+        CHECK(reader.u8() == 0x78);
+        CHECK(reader.ok());
+    }
+
+    SECTION("Verify an indirect value that is itself indirect fails the read") {
+        std::vector<std::byte> bytes(4096, std::byte(DW_FORM_indirect));
+        bytes.push_back(std::byte(DW_FORM_data1));
+        bytes.push_back(std::byte(0x12));
+
+        DwarfReader value_reader(bytes.data(), bytes.size(), false);
+        CHECK(value_reader.form_value(DW_FORM_indirect, format) == 0);
+        CHECK_FALSE(value_reader.ok());
+        CHECK(value_reader.at_end());
+
+        DwarfReader skip_reader(bytes.data(), bytes.size(), false);
+        skip_reader.skip_form(DW_FORM_indirect, format);
+        CHECK_FALSE(skip_reader.ok());
+        CHECK(skip_reader.at_end());
+    }
+}
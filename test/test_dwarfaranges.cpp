@@ -0,0 +1,214 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "test/catch.hpp"
+#include "elfgen/elfgen.h"
+#include "libedhel/dwarf.h"
+#include "libedhel/dwarfaranges.h"
+#include "libedhel/dwarfinfo.h"
+#include "libedhel/dwarfline.h"
+#include "libedhel/elffile.h"
+#include "libedhel/section.h"
+#include <algorithm>
+#include <string>
+#include <vector>
+
+
+namespace
+{
+    /** The offsets of the units of @p elf_file */
+    std::vector<std::uint64_t>
+    unit_offsets(ElfFile const& elf_file)
+    {
+        ParseError error;
+        std::vector<std::uint64_t> offsets;
+        for (DwarfUnit const& unit: read_units(find_dwarf_sections(elf_file), error))
+        {
+            offsets.push_back(unit.offset_);
+        }
+        return offsets;
+    }
+
+    /**
+     * Check the code of every generated function is found in its unit.  Where
+     * the unit's ranges come from its low and high pc (even units, without
+     * .debug_aranges), the gaps in functions are part of the unit.
+     */
+    void
+    check_generated_units(ElfSpec const& spec, ElfFile const& elf_file, UnitRangeIndex const& index, bool aranges)
+    {
+        std::vector<std::uint64_t> const units = unit_offsets(elf_file);
+        REQUIRE(units.size() == spec.dwarf_unit_count_);
+        for (std::uint32_t u = 0; u < spec.dwarf_unit_count_; ++u)
+        {
+            bool const whole_unit = !aranges && u % 2 == 0;
+            CHECK(index.lookup(generated_line(spec, u, 0).address_ - 1) == DwarfUnit::None);
+            std::uint64_t const unit_high = generated_line(spec, u, spec.line_rows_per_unit_).address_;
+            CHECK(index.lookup(unit_high - 1) == (whole_unit ? units[u] : DwarfUnit::None));
+            CHECK(index.lookup(unit_high) == DwarfUnit::None);
+
+            for (std::uint32_t f = 0; f < spec.functions_per_unit_; ++f)
+            {
+                GeneratedFunction function = generated_function(spec, u, f);
+                CHECK(index.lookup(function.low_pc_) == units[u]);
+                CHECK(index.lookup(function.leaf_low_) == units[u]);
+                CHECK(index.lookup(function.high_pc_ - 1) == units[u]);
+                if (function.gap_low_ != function.gap_high_)
+                {
+                    CHECK(index.lookup(function.gap_low_) == (whole_unit ? units[u] : DwarfUnit::None));
+                }
+            }
+        }
+    }
+} // anonymous namespace
+
+
+TEST_CASE("unit range index") {
+    for (std::uint16_t version: { 2, 3, 4, 5 })
+    {
+        SECTION("Verify the units of DWARF " + std::to_string(version) + " files are found by address") {
+            for (bool aranges: { true, false })
+            {
+                for (bool big_endian: { false, true })
+                {
+                    for (bool is_64bit: { false, true })
+                    {
+                        ElfSpec spec;
+                        spec.is_64bit_ = is_64bit;
+                        spec.big_endian_ = big_endian;
+                        spec.dwarf_version_ = version;
+                        spec.dwarf64_ = is_64bit && version >= 3;
+                        spec.dwarf_unit_count_ = 4;
+                        spec.line_rows_per_unit_ = 100;
+                        spec.functions_per_unit_ = 7;
+                        spec.dwarf_aranges_ = aranges;
+                        std::vector<std::byte> const bytes = generate_elf(spec);
+                        ElfFile elf_file(bytes.data(), bytes.size(), "units");
+
+                        UnitRangeIndex index(elf_file);
+                        CHECK(!index.error());
+                        CHECK(index.fallback_count() == (aranges ? 0 : spec.dwarf_unit_count_));
+                        check_generated_units(spec, elf_file, index, aranges);
+                    }
+                }
+            }
+        }
+    }
+
+    SECTION("Verify adjacent ranges of a unit are merged") {
+        ElfSpec spec;
+        spec.dwarf_unit_count_ = 3;
+        spec.functions_per_unit_ = 6;
+        std::vector<std::byte> const bytes = generate_elf(spec);
+        ElfFile elf_file(bytes.data(), bytes.size(), "units");
+        UnitRangeIndex index(elf_file);
+
+        // Each unit's functions are back to back, except for the gaps in
+        // functions 2 and 5.
+        CHECK(index.ranges().size() == 3 * 3);
+        for (std::size_t r = 1; r < index.ranges().size(); ++r)
+        {
+            CHECK(index.ranges()[r - 1].high_ < index.ranges()[r].low_);
+        }
+    }
+
+    SECTION("Verify units .debug_aranges leaves out are found from their unit DIEs") {
+        ElfSpec spec;
+        spec.dwarf_unit_count_ = 4;
+        spec.functions_per_unit_ = 3;
+        std::vector<std::byte> bytes = generate_elf(spec);
+
+        // Point the second set at an offset that isn't a unit.
+        ElfFile good_file(bytes.data(), bytes.size(), "units");
+        Section const* aranges_section = nullptr;
+        for (std::uint32_t i = 0; i < good_file.section_table().section_count(); ++i)
+        {
+            if (good_file.section(i).name_string() == ".debug_aranges")
+            {
+                aranges_section = &good_file.section(i);
+            }
+        }
+        REQUIRE(aranges_section != nullptr);
+        std::size_t const first_set_length = static_cast<std::size_t>(bytes[aranges_section->offset()]);
+        std::size_t const second_set = aranges_section->offset() + 4 + first_set_length;
+        bytes[second_set + 6] = std::byte{1};
+        ElfFile elf_file(bytes.data(), bytes.size(), "units");
+
+        UnitRangeIndex index(elf_file);
+        CHECK(!index.error());
+        CHECK(index.fallback_count() == 1);
+        std::vector<std::uint64_t> const units = unit_offsets(elf_file);
+        REQUIRE(units.size() == 4);
+        for (std::uint32_t u = 0; u < 4; ++u)
+        {
+            CHECK(index.lookup(generated_function(spec, u, 0).low_pc_) == units[u]);
+            CHECK(index.lookup(generated_function(spec, u, 2).gap_low_) == DwarfUnit::None);
+        }
+
+        // A set with a version other than 2 stops the reading of the section.
+        bytes[aranges_section->offset() + 4] = std::byte{3};
+        ElfFile bad_file(bytes.data(), bytes.size(), "units");
+        UnitRangeIndex bad(bad_file);
+        CHECK(bad.error().code_ == ParseErrc::BadDwarfVersion);
+        CHECK(bad.error().offset_ == aranges_section->offset());
+        CHECK(bad.fallback_count() == 4);
+        CHECK(bad.lookup(generated_function(spec, 3, 0).low_pc_) == units[3]);
+    }
+
+    SECTION("Verify an address's line can be found from its unit alone") {
+        ElfSpec spec;
+        spec.dwarf_unit_count_ = 5;
+        spec.functions_per_unit_ = 4;
+        std::vector<std::byte> const bytes = generate_elf(spec);
+        ElfFile elf_file(bytes.data(), bytes.size(), "units");
+        UnitRangeIndex index(elf_file);
+        DwarfSections const sections = find_dwarf_sections(elf_file);
+        ParseError error;
+        std::vector<DwarfUnit> units = read_units(sections, error);
+        REQUIRE(units.size() == 5);
+
+        GeneratedLine expected = generated_line(spec, 3, 20);
+        std::uint64_t const offset = index.lookup(expected.address_);
+        REQUIRE(offset == units[3].offset_);
+        DwarfUnit& unit = units[3];
+        AbbrevTable abbrevs;
+        REQUIRE(abbrevs.read(sections, unit.abbrev_offset_, unit.format_));
+        REQUIRE(read_unit_die(sections, abbrevs, unit));
+        REQUIRE(unit.stmt_list_ != DwarfUnit::None);
+
+        LineTable table = read_line_table(sections, unit.stmt_list_);
+        CHECK(!table.error_);
+        auto row = std::find_if(table.rows_.begin(), table.rows_.end(), [&expected](LineRow const& r) {
+            return r.address_ == expected.address_;
+        });
+        REQUIRE(row != table.rows_.end());
+        CHECK(row->line_ == expected.line_);
+        CHECK(table.file_path(0) == "/src/unit_3/unit_3.c");
+    }
+
+    SECTION("Verify files without .debug_info have an empty index") {
+        ElfSpec spec;
+        spec.dwarf_unit_count_ = 2;
+        std::vector<std::byte> const bytes = generate_elf(spec);
+        ElfFile elf_file(bytes.data(), bytes.size(), "lines only");
+        UnitRangeIndex index(elf_file);
+        CHECK(index.ranges().empty());
+        CHECK(!index.error());
+        CHECK(index.lookup(generated_line(spec, 0, 0).address_) == DwarfUnit::None);
+    }
+}
@@ -0,0 +1,185 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "test/catch.hpp"
+#include "elfgen/elfgen.h"
+#include "libedhel/dwarffunctions.h"
+#include "libedhel/elffile.h"
+#include "libedhel/section.h"
+#include <string>
+#include <vector>
+
+
+namespace
+{
+    /** Check every generated function, and what's inlined into it, is found where it was put */
+    void
+    check_generated_functions(ElfSpec const& spec, FunctionIndex const& index)
+    {
+        REQUIRE(index.units().size() == spec.dwarf_unit_count_);
+        CHECK(index.functions().size() == spec.dwarf_unit_count_ * spec.functions_per_unit_ * 3);
+        for (std::uint32_t u = 0; u < spec.dwarf_unit_count_; ++u)
+        {
+            DwarfUnit const& unit = index.units()[u];
+            CHECK(unit.name_ == "unit_" + std::to_string(u) + ".c");
+            CHECK(unit.comp_dir_ == "/src/unit_" + std::to_string(u));
+            CHECK(unit.stmt_list_ != DwarfUnit::None);
+            CHECK(index.lookup(generated_line(spec, u, 0).address_ - 1).empty());
+
+            for (std::uint32_t f = 0; f < spec.functions_per_unit_; ++f)
+            {
+                GeneratedFunction expected = generated_function(spec, u, f);
+                auto chain = index.lookup(expected.low_pc_);
+                REQUIRE(chain.size() == 1);
+                CHECK(chain[0]->name_ == expected.name_);
+                CHECK(chain[0]->linkage_name_ == expected.linkage_name_);
+                CHECK(chain[0]->unit_ == u);
+                CHECK(!chain[0]->inlined_);
+                CHECK(index.find(chain[0]->offset_) == chain[0]);
+                DwarfFunction const* outer = chain[0];
+
+                chain = index.lookup(expected.inline_low_ + 2);
+                REQUIRE(chain.size() == 2);
+                CHECK(chain[0]->name_ == expected.inline_name_);
+                CHECK(chain[0]->inlined_);
+                CHECK(chain[0]->call_file_ == 2);
+                CHECK(chain[0]->call_line_ == expected.inline_call_line_);
+                CHECK(chain[1] == outer);
+
+                chain = index.lookup(expected.leaf_low_);
+                REQUIRE(chain.size() == 3);
+                CHECK(chain[0]->name_ == expected.leaf_name_);
+                CHECK(chain[0]->call_file_ == 3);
+                CHECK(chain[0]->call_line_ == expected.leaf_call_line_);
+                CHECK(chain[1]->name_ == expected.inline_name_);
+                CHECK(chain[2] == outer);
+
+                // Just past the leaf is back in the helper, and past that in the function.
+                CHECK(index.lookup(expected.leaf_high_).size() == 2);
+                CHECK(index.lookup(expected.inline_high_).size() == 1);
+
+                chain = index.lookup(expected.high_pc_ - 1);
+                REQUIRE(chain.size() == 1);
+                CHECK(chain[0] == outer);
+                if (expected.gap_low_ != expected.gap_high_)
+                {
+                    CHECK(outer->range_count_ == 2);
+                    CHECK(!index.covers(*outer, expected.gap_low_));
+                    CHECK(index.lookup(expected.gap_low_).empty());
+                    CHECK(index.lookup(expected.gap_high_ - 1).empty());
+                    CHECK(index.lookup(expected.gap_high_).size() == 1);
+                }
+            }
+        }
+    }
+} // anonymous namespace
+
+
+TEST_CASE("function index") {
+    for (std::uint16_t version: { 2, 3, 4, 5 })
+    {
+        SECTION("Verify the functions of DWARF " + std::to_string(version) + " units are indexed") {
+            for (bool big_endian: { false, true })
+            {
+                for (bool is_64bit: { false, true })
+                {
+                    ElfSpec spec;
+                    spec.is_64bit_ = is_64bit;
+                    spec.big_endian_ = big_endian;
+                    spec.dwarf_version_ = version;
+                    spec.dwarf64_ = is_64bit && version >= 3;
+                    spec.dwarf_unit_count_ = 3;
+                    spec.line_rows_per_unit_ = 100;
+                    spec.functions_per_unit_ = 7;
+                    std::vector<std::byte> const bytes = generate_elf(spec);
+                    ElfFile elf_file(bytes.data(), bytes.size(), "functions");
+
+                    FunctionIndex index(elf_file);
+                    CHECK(!index.error());
+                    check_generated_functions(spec, index);
+                }
+            }
+        }
+    }
+
+    SECTION("Verify parallel indexing matches serial indexing") {
+        ElfSpec spec;
+        spec.dwarf_unit_count_ = 40;
+        spec.functions_per_unit_ = 5;
+        std::vector<std::byte> const bytes = generate_elf(spec);
+        ElfFile elf_file(bytes.data(), bytes.size(), "functions");
+
+        FunctionIndex serial(elf_file, 1);
+        FunctionIndex parallel(elf_file, 0);
+        REQUIRE(parallel.functions().size() == serial.functions().size());
+        for (std::size_t f = 0; f < serial.functions().size(); ++f)
+        {
+            DwarfFunction const& expected = serial.functions()[f];
+            DwarfFunction const& actual = parallel.functions()[f];
+            CHECK(actual.offset_ == expected.offset_);
+            CHECK(actual.name_ == expected.name_);
+            CHECK(actual.parent_ == expected.parent_);
+            CHECK(actual.end_ == expected.end_);
+            CHECK(actual.first_range_ == expected.first_range_);
+        }
+        check_generated_functions(spec, parallel);
+    }
+
+    SECTION("Verify the units before a bad unit header are still indexed") {
+        ElfSpec spec;
+        spec.dwarf_unit_count_ = 2;
+        spec.functions_per_unit_ = 4;
+        std::vector<std::byte> bytes = generate_elf(spec);
+        ElfFile good_file(bytes.data(), bytes.size(), "functions");
+        FunctionIndex good(good_file);
+        REQUIRE(good.units().size() == 2);
+
+        // Claim the second unit is much longer than the section.
+        Section const* info_section = nullptr;
+        for (std::uint32_t i = 0; i < good_file.section_table().section_count(); ++i)
+        {
+            if (good_file.section(i).name_string() == ".debug_info")
+            {
+                info_section = &good_file.section(i);
+            }
+        }
+        REQUIRE(info_section != nullptr);
+        std::size_t const at = info_section->offset() + good.units()[1].offset_;
+        bytes[at + 3] = std::byte{0x7f};
+        ElfFile bad_file(bytes.data(), bytes.size(), "functions");
+        FunctionIndex bad(bad_file);
+        CHECK(bad.error().code_ == ParseErrc::DwarfOutOfBounds);
+        CHECK(bad.error().offset_ == at);
+        REQUIRE(bad.units().size() == 1);
+        CHECK(bad.functions().size() == spec.functions_per_unit_ * 3);
+        CHECK(bad.lookup(generated_function(spec, 0, 0).low_pc_).size() == 1);
+        CHECK(bad.lookup(generated_function(spec, 1, 0).low_pc_).empty());
+    }
+
+    SECTION("Verify files without .debug_info have an empty index") {
+        ElfSpec spec;
+        spec.dwarf_unit_count_ = 2;
+        std::vector<std::byte> const bytes = generate_elf(spec);
+        ElfFile elf_file(bytes.data(), bytes.size(), "lines only");
+        FunctionIndex index(elf_file);
+        CHECK(index.units().empty());
+        CHECK(index.functions().empty());
+        CHECK(!index.error());
+        CHECK(index.lookup(generated_line(spec, 0, 0).address_).empty());
+    }
+}
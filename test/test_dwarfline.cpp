@@ -0,0 +1,210 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "test/catch.hpp"
+#include "elfgen/elfgen.h"
+#include "libedhel/dwarfline.h"
+#include "libedhel/elffile.h"
+#include "libedhel/section.h"
+#include <string>
+#include <vector>
+
+
+namespace
+{
+    /** Check every row of every generated program is found where it was put */
+    void
+    check_generated_lines(ElfSpec const& spec, LineIndex const& index)
+    {
+        REQUIRE(index.tables().size() == spec.dwarf_unit_count_);
+        CHECK(index.row_count() == spec.dwarf_unit_count_ * (spec.line_rows_per_unit_ + 2));
+        for (std::uint32_t u = 0; u < spec.dwarf_unit_count_; ++u)
+        {
+            LineTable const& table = index.tables()[u];
+            CHECK(!table.error_);
+            CHECK(table.version_ == spec.dwarf_version_);
+            for (std::uint32_t r = 0; r < spec.line_rows_per_unit_; ++r)
+            {
+                GeneratedLine expected = generated_line(spec, u, r);
+                LineLocation location = index.lookup(expected.address_);
+                REQUIRE(location);
+                CHECK(location.table_ == &table);
+                CHECK(location.file_ == expected.file_);
+                CHECK(location.line_ == expected.line_);
+                CHECK(location.column_ == expected.column_);
+
+                // In between rows is still the same row.
+                GeneratedLine next = generated_line(spec, u, r + 1);
+                CHECK(index.lookup(next.address_ - 1).line_ == expected.line_);
+            }
+            GeneratedLine end = generated_line(spec, u, spec.line_rows_per_unit_);
+            CHECK(!index.lookup(end.address_));
+            CHECK(!index.lookup(generated_line(spec, u, 0).address_ - 1));
+        }
+    }
+} // anonymous namespace
+
+
+TEST_CASE("line number tables") {
+    for (std::uint16_t version: { 2, 3, 4, 5 })
+    {
+        SECTION("Verify DWARF " + std::to_string(version) + " line number programs are decoded") {
+            for (bool big_endian: { false, true })
+            {
+                for (bool is_64bit: { false, true })
+                {
+                    ElfSpec spec;
+                    spec.is_64bit_ = is_64bit;
+                    spec.big_endian_ = big_endian;
+                    spec.dwarf_version_ = version;
+                    spec.dwarf64_ = is_64bit && version >= 3;
+                    spec.dwarf_unit_count_ = 3;
+                    spec.line_rows_per_unit_ = 100;
+                    std::vector<std::byte> const bytes = generate_elf(spec);
+                    ElfFile elf_file(bytes.data(), bytes.size(), "lines");
+
+                    LineIndex index(elf_file);
+                    CHECK(!index.error());
+                    check_generated_lines(spec, index);
+                }
+            }
+        }
+    }
+
+    SECTION("Verify file names are joined to their directories") {
+        ElfSpec spec;
+        spec.dwarf_unit_count_ = 2;
+        std::vector<std::byte> const bytes = generate_elf(spec);
+        ElfFile elf_file(bytes.data(), bytes.size(), "lines");
+        LineIndex index(elf_file);
+        REQUIRE(index.tables().size() == 2);
+
+        LineTable const& table = index.tables()[1];
+        REQUIRE(table.files_.size() == 4);
+        CHECK(table.files_[1].name_ == "a.h");
+        CHECK(table.file_path(0) == "/src/unit_1/unit_1.c");
+        CHECK(table.file_path(1) == "/src/unit_1/include/a.h");
+        CHECK(table.file_path(3) == "/src/unit_1/c.h");
+        CHECK(table.file_path(4).empty());
+
+        spec.dwarf_version_ = 4;
+        std::vector<std::byte> const v4_bytes = generate_elf(spec);
+        ElfFile v4_file(v4_bytes.data(), v4_bytes.size(), "lines");
+        LineIndex v4_index(v4_file);
+        REQUIRE(v4_index.tables().size() == 2);
+        LineTable const& v4_table = v4_index.tables()[1];
+        REQUIRE(v4_table.files_.size() == 4);
+        CHECK(v4_table.file_path(0).empty());
+        CHECK(v4_table.file_path(1) == "include/a.h");
+        CHECK(v4_table.file_path(3) == "c.h");
+    }
+
+    SECTION("Verify batch lookups match single lookups") {
+        ElfSpec spec;
+        spec.dwarf_unit_count_ = 5;
+        spec.line_rows_per_unit_ = 200;
+        std::vector<std::byte> const bytes = generate_elf(spec);
+        ElfFile elf_file(bytes.data(), bytes.size(), "lines");
+        LineIndex index(elf_file);
+
+        // Every row, the gaps around them, and some repeats, in a jumbled order.
+        std::vector<std::uint64_t> addresses;
+        for (std::uint32_t r = 0; r <= spec.line_rows_per_unit_; ++r)
+        {
+            for (std::uint32_t u = spec.dwarf_unit_count_; u-- > 0; )
+            {
+                std::uint64_t address = generated_line(spec, u, (r * 7) % (spec.line_rows_per_unit_ + 1)).address_;
+                addresses.push_back(address);
+                addresses.push_back(address - 1);
+            }
+        }
+        addresses.push_back(0);
+        addresses.push_back(~std::uint64_t(0));
+
+        std::vector<LineLocation> locations(addresses.size());
+        index.lookup(addresses.data(), addresses.size(), locations.data());
+        for (std::size_t i = 0; i < addresses.size(); ++i)
+        {
+            LineLocation expected = index.lookup(addresses[i]);
+            CHECK(locations[i].table_ == expected.table_);
+            CHECK(locations[i].file_ == expected.file_);
+            CHECK(locations[i].line_ == expected.line_);
+            CHECK(locations[i].column_ == expected.column_);
+        }
+        CHECK(!locations[addresses.size() - 2]);
+        CHECK(!locations[addresses.size() - 1]);
+    }
+
+    SECTION("Verify parallel decoding matches serial decoding") {
+        ElfSpec spec;
+        spec.dwarf_unit_count_ = 40;
+        spec.line_rows_per_unit_ = 50;
+        std::vector<std::byte> const bytes = generate_elf(spec);
+        ElfFile elf_file(bytes.data(), bytes.size(), "lines");
+
+        LineIndex serial(elf_file, 1);
+        LineIndex parallel(elf_file, 0);
+        REQUIRE(parallel.tables().size() == serial.tables().size());
+        CHECK(parallel.row_count() == serial.row_count());
+        for (std::size_t t = 0; t < serial.tables().size(); ++t)
+        {
+            CHECK(parallel.tables()[t].offset_ == serial.tables()[t].offset_);
+            CHECK(parallel.tables()[t].rows_.size() == serial.tables()[t].rows_.size());
+        }
+        check_generated_lines(spec, parallel);
+    }
+
+    SECTION("Verify a unit running past the end of its section is reported") {
+        ElfSpec spec;
+        spec.dwarf_unit_count_ = 1;
+        spec.line_rows_per_unit_ = 100;
+        std::vector<std::byte> bytes = generate_elf(spec);
+        ElfFile good_file(bytes.data(), bytes.size(), "lines");
+        LineIndex good(good_file);
+        REQUIRE(good.tables().size() == 1);
+
+        // Claim the unit is much longer than the section.
+        Section const* line_section = nullptr;
+        for (std::uint32_t i = 0; i < good_file.section_table().section_count(); ++i)
+        {
+            if (good_file.section(i).name_string() == ".debug_line")
+            {
+                line_section = &good_file.section(i);
+            }
+        }
+        REQUIRE(line_section != nullptr);
+        std::size_t const at = line_section->offset();
+        bytes[at + 3] = std::byte{0x7f};
+        ElfFile bad_file(bytes.data(), bytes.size(), "lines");
+        LineIndex bad(bad_file);
+        REQUIRE(bad.tables().size() == 1);
+        CHECK(bad.tables()[0].error_.code_ == ParseErrc::DwarfOutOfBounds);
+        CHECK(bad.tables()[0].error_.offset_ == at);
+        CHECK(bad.tables()[0].rows_.empty());
+    }
+
+    SECTION("Verify files without line numbers have an empty index") {
+        ElfSpec spec;
+        std::vector<std::byte> const bytes = generate_elf(spec);
+        ElfFile elf_file(bytes.data(), bytes.size(), "no lines");
+        LineIndex index(elf_file);
+        CHECK(index.tables().empty());
+        CHECK(!index.error());
+        CHECK(!index.lookup(0x400000));
+    }
+}
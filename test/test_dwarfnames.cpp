@@ -0,0 +1,253 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmsoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "test/catch.hpp"
+#include "elfgen/elfgen.h"
+#include "libedhel/dwarffunctions.h"
+#include "libedhel/dwarfnames.h"
+#include "libedhel/elffile.h"
+#include "libedhel/section.h"
+#include <algorithm>
+#include <string>
+#include <vector>
+
+
+namespace
+{
+    /** The DIE of the out-of-line function called @p name in unit @p unit */
+    DwarfFunction const*
+    find_function(FunctionIndex const& functions, std::uint32_t unit, std::string const& name)
+    {
+        for (DwarfFunction const& function: functions.functions())
+        {
+            if (function.unit_ == unit && !function.inlined_ && function.name_ == name)
+            {
+                return &function;
+            }
+        }
+        return nullptr;
+    }
+
+    /**
+     * Check every generated function and inlined subroutine is found, by
+     * name and by linkage name, at its DIE.
+     */
+    void
+    check_generated_names(ElfSpec const& spec, NameIndex const& index, FunctionIndex const& functions)
+    {
+        for (std::uint32_t u = 0; u < spec.dwarf_unit_count_; ++u)
+        {
+            std::uint64_t const unit = functions.units()[u].offset_;
+            for (std::uint32_t f = 0; f < spec.functions_per_unit_; ++f)
+            {
+                GeneratedFunction const expected = generated_function(spec, u, f);
+                DwarfFunction const* function = find_function(functions, u, expected.name_);
+                REQUIRE(function != nullptr);
+
+                std::vector<NameEntry> found = index.lookup(expected.linkage_name_);
+                REQUIRE(found.size() == 1);
+                CHECK(found[0].unit_ == unit);
+                CHECK(found[0].die_ == function->offset_);
+                CHECK(found[0].tag_ == DW_TAG_subprogram);
+
+                // Member functions have the same name in every unit.
+                found = index.lookup(expected.name_);
+                CHECK(found.size() == (expected.name_.rfind("method_", 0) == 0 ? spec.dwarf_unit_count_ : 1));
+                CHECK(std::count_if(found.begin(), found.end(), [&](NameEntry const& entry) {
+                    return entry.unit_ == unit && entry.die_ == function->offset_;
+                }) == 1);
+            }
+
+            // A subroutine is inlined once into each function.
+            std::vector<NameEntry> found = index.lookup("inline_leaf_" + std::to_string(u));
+            CHECK(found.size() == spec.functions_per_unit_);
+            for (NameEntry const& entry: found)
+            {
+                CHECK(entry.unit_ == unit);
+                CHECK(entry.tag_ == DW_TAG_inlined_subroutine);
+                DwarfFunction const* inlined = functions.find(entry.die_);
+                REQUIRE(inlined != nullptr);
+                CHECK(inlined->name_ == "inline_leaf_" + std::to_string(u));
+            }
+        }
+        CHECK(index.lookup("function_0").empty());
+        CHECK(index.lookup("").empty());
+    }
+
+    std::size_t
+    section_offset(ElfFile const& elf_file, std::string const& name)
+    {
+        for (std::uint32_t i = 0; i < elf_file.section_table().section_count(); ++i)
+        {
+            if (elf_file.section(i).name_string() == name)
+            {
+                return elf_file.section(i).offset();
+            }
+        }
+        return 0;
+    }
+} // anonymous namespace
+
+
+TEST_CASE("name index") {
+    for (std::uint16_t version: { 4, 5 })
+    {
+        SECTION("Verify names are found through .debug_names indexing DWARF " + std::to_string(version) + " units") {
+            for (bool big_endian: { false, true })
+            {
+                for (bool dwarf64: { false, true })
+                {
+                    ElfSpec spec;
+                    spec.big_endian_ = big_endian;
+                    spec.dwarf_version_ = version;
+                    spec.dwarf64_ = dwarf64;
+                    spec.dwarf_unit_count_ = 10;
+                    spec.line_rows_per_unit_ = 100;
+                    spec.functions_per_unit_ = 5;
+                    spec.dwarf_names_ = 10;
+                    std::vector<std::byte> const bytes = generate_elf(spec);
+                    ElfFile elf_file(bytes.data(), bytes.size(), "names");
+
+                    NameIndex index(elf_file);
+                    CHECK(!index.error());
+                    CHECK(index.source() == NameIndex::Source::DebugNames);
+                    CHECK(index.fallback_count() == 0);
+                    FunctionIndex functions(elf_file);
+                    check_generated_names(spec, index, functions);
+
+                    std::vector<NameEntry> found = index.lookup("Class_9");
+                    REQUIRE(found.size() == 1);
+                    CHECK(found[0].unit_ == functions.units()[9].offset_);
+                    CHECK(found[0].tag_ == DW_TAG_structure_type);
+                    CHECK(index.lookup("int").size() == 10);
+                    CHECK(index.lookup("Int").empty());
+                }
+            }
+        }
+    }
+
+    SECTION("Verify units .debug_names leaves out fall back to the function index") {
+        ElfSpec spec;
+        spec.dwarf_unit_count_ = 12;
+        spec.functions_per_unit_ = 4;
+        spec.dwarf_names_ = 5;
+        std::vector<std::byte> const bytes = generate_elf(spec);
+        ElfFile elf_file(bytes.data(), bytes.size(), "names");
+
+        NameIndex index(elf_file);
+        CHECK(!index.error());
+        CHECK(index.source() == NameIndex::Source::DebugNames);
+        CHECK(index.fallback_count() == 7);
+        check_generated_names(spec, index, FunctionIndex(elf_file));
+
+        // The function index only knows functions.
+        CHECK(index.lookup("int").size() == 5);
+        CHECK(index.lookup("Class_4").size() == 1);
+        CHECK(index.lookup("Class_5").empty());
+    }
+
+    SECTION("Verify names are found through .gdb_index") {
+        ElfSpec spec;
+        spec.dwarf_unit_count_ = 6;
+        spec.functions_per_unit_ = 4;
+        spec.gdb_index_ = true;
+        std::vector<std::byte> const bytes = generate_elf(spec);
+        ElfFile elf_file(bytes.data(), bytes.size(), "gdb");
+
+        NameIndex index(elf_file);
+        CHECK(!index.error());
+        CHECK(index.source() == NameIndex::Source::GdbIndex);
+        CHECK(index.fallback_count() == 0);
+        FunctionIndex functions(elf_file);
+
+        for (std::uint32_t u = 0; u < spec.dwarf_unit_count_; ++u)
+        {
+            std::string const unit_name = std::to_string(u);
+            for (std::string const& name: { "function_" + unit_name + "_0", "Class_" + unit_name + "::method_1",
+                                            "inline_helper_" + unit_name })
+            {
+                std::vector<NameEntry> found = index.lookup(name);
+                REQUIRE(found.size() == 1);
+                CHECK(found[0].unit_ == functions.units()[u].offset_);
+                CHECK(found[0].die_ == DwarfUnit::None);
+                CHECK(found[0].tag_ == DW_TAG_subprogram);
+            }
+        }
+
+        // Names are qualified, and linkage names left out.
+        CHECK(index.lookup("method_1").empty());
+        CHECK(index.lookup(generated_function(spec, 0, 0).linkage_name_).empty());
+        std::vector<NameEntry> found = index.lookup("int");
+        CHECK(found.size() == spec.dwarf_unit_count_);
+        CHECK(found.back().unit_ == functions.units().back().offset_);
+        CHECK(found.back().tag_ == 0);
+        CHECK(index.lookup("INT").empty());
+    }
+
+    SECTION("Verify .debug_names is preferred to .gdb_index") {
+        ElfSpec spec;
+        spec.dwarf_unit_count_ = 3;
+        spec.functions_per_unit_ = 4;
+        spec.dwarf_names_ = 3;
+        spec.gdb_index_ = true;
+        std::vector<std::byte> bytes = generate_elf(spec);
+        ElfFile both_file(bytes.data(), bytes.size(), "both");
+        NameIndex both(both_file);
+        CHECK(both.source() == NameIndex::Source::DebugNames);
+        std::vector<NameEntry> found = both.lookup("function_1_0");
+        REQUIRE(found.size() == 1);
+        CHECK(found[0].die_ != DwarfUnit::None);
+
+        // A .debug_names of a version it can't read is passed over.
+        std::size_t const at = section_offset(both_file, ".debug_names");
+        REQUIRE(at != 0);
+        bytes[at + 4] = std::byte{4};
+        ElfFile bad_file(bytes.data(), bytes.size(), "both");
+        NameIndex bad(bad_file);
+        CHECK(bad.error().code_ == ParseErrc::BadDwarfVersion);
+        CHECK(bad.error().offset_ == at);
+        CHECK(bad.source() == NameIndex::Source::GdbIndex);
+        CHECK(bad.lookup("function_1_0").size() == 1);
+    }
+
+    SECTION("Verify files without a name index fall back to the function index") {
+        ElfSpec spec;
+        spec.dwarf_unit_count_ = 4;
+        spec.functions_per_unit_ = 6;
+        std::vector<std::byte> const bytes = generate_elf(spec);
+        ElfFile elf_file(bytes.data(), bytes.size(), "functions");
+
+        NameIndex index(elf_file, 0);
+        CHECK(!index.error());
+        CHECK(index.source() == NameIndex::Source::Functions);
+        CHECK(index.fallback_count() == 4);
+        check_generated_names(spec, index, FunctionIndex(elf_file));
+    }
+
+    SECTION("Verify files without .debug_info have nothing to look up") {
+        ElfSpec spec;
+        spec.dwarf_unit_count_ = 2;
+        std::vector<std::byte> const bytes = generate_elf(spec);
+        ElfFile elf_file(bytes.data(), bytes.size(), "lines only");
+        NameIndex index(elf_file);
+        CHECK(index.source() == NameIndex::Source::None);
+        CHECK(index.fallback_count() == 0);
+        CHECK(!index.error());
+        CHECK(index.lookup("main").empty());
+    }
+}
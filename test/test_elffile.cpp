@@ -18,25 +18,367 @@
  */
 #include "test/catch.hpp"
 
+#include "elfgen/elfgen.h"
 #include "libedhel/elffile.h"
+#include "libedhel/note.h"
+#include "libedhel/section.h"
+#include "libedhel/section_note.h"
+#include "libedhel/section_symtab.h"
+#include "libedhel/segment.h"
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+namespace
+{
+    /** Write @p spec to a temporary file that goes away with this object */
+    struct GeneratedFile
+    {
+        explicit GeneratedFile(ElfSpec const& spec)
+        : name_{(std::filesystem::temp_directory_path() / "edhelind_test.elf").string()}
+        {
+            write_elf(spec, name_);
+        }
+
+        ~GeneratedFile()
+        {
+            std::remove(name_.c_str());
+        }
+
+        std::string name_;
+    };
+
+    /** Write @p bytes to @p file_name */
+    void
+    write_bytes(std::vector<std::byte> const& bytes, std::string const& file_name)
+    {
+        std::FILE* file = std::fopen(file_name.c_str(), "wb");
+        REQUIRE(file != nullptr);
+        CHECK(std::fwrite(bytes.data(), 1, bytes.size(), file) == bytes.size());
+        std::fclose(file);
+    }
+
+    std::size_t
+    count_notes(ElfFile const& elf_file)
+    {
+        std::size_t notes = 0;
+        elf_file.section_table().iterate_sections([&notes](Section const& section) {
+            if (auto note_section = dynamic_cast<Section_NOTE const*>(&section))
+            {
+                note_section->iterate_notes([&notes](Note const&) { ++notes; });
+            }
+        });
+        return notes;
+    }
+
+    /** Everything there is to print about every section of @p elf_file */
+    std::string
+    dump_sections(ElfFile const& elf_file)
+    {
+        std::ostringstream ostr;
+        elf_file.section_table().iterate_sections([&ostr](Section const& section) {
+            ostr << section;
+        });
+        return ostr.str();
+    }
+} // anonymous namespace
 
 
 TEST_CASE("ElfFile functionality") {
-    SECTION("basics") {
-#ifdef DUDE_LATER_DUDE
-        ElfFile elfFile("../test_files/64_intel_ls");
-        EXPECT_TRUE(elfFile.isLE());
-        EXPECT_TRUE(elfFile.is64());
-        EXPECT_EQ(elfFile.elfHeader().version(), 1U);
-        EXPECT_EQ(elfFile.elfHeader().machine(), 62U);
-        EXPECT_EQ(elfFile.elfHeader().entry(), 0x404888UL);
-        EXPECT_EQ(elfFile.elfHeader().phoff(), 64UL);
-        EXPECT_EQ(elfFile.elfHeader().shoff(), 108296UL);
-        EXPECT_EQ(elfFile.elfHeader().phentsize(), 56U);
-        EXPECT_EQ(elfFile.elfHeader().phnum(), 9U);
-        EXPECT_EQ(elfFile.elfHeader().shentsize(), 64U);
-        EXPECT_EQ(elfFile.elfHeader().shnum(), 28U);
-        EXPECT_EQ(elfFile.elfHeader().shstrndx(), 27U);
-#endif
+    SECTION("Verify the generator is deterministic") {
+        ElfSpec spec;
+        spec.symbol_count_ = 100;
+        CHECK(generate_elf(spec) == generate_elf(spec));
+        ElfSpec other = spec;
+        other.seed_ = 1;
+        CHECK(generate_elf(spec) != generate_elf(other));
+    }
+
+    SECTION("Verify 64-bit little-endian basics") {
+        ElfSpec spec;
+        spec.section_count_ = 3;
+        spec.symbol_count_ = 10;
+        spec.note_count_ = 3;
+        spec.relocation_count_ = 4;
+        GeneratedFile file(spec);
+
+        ElfFile elf_file(file.name_);
+        CHECK(elf_file.is_64bit());
+        CHECK(elf_file.elf_header().isLE());
+        CHECK(elf_file.elf_header().phoff() == 64U);
+        CHECK(elf_file.elf_header().phentsize() == 56U);
+        CHECK(elf_file.elf_header().phnum() == 2U);
+        CHECK(elf_file.elf_header().shentsize() == 64U);
+        // null + 3 .text + .note + .symtab + .strtab + .rela.text + .shstrtab
+        CHECK(elf_file.elf_header().shnum() == 9U);
+        CHECK(elf_file.section_table().section_count() == 9U);
+        CHECK(elf_file.section(1).name_string() == ".text.0");
+        CHECK(elf_file.section(8).name_string() == ".shstrtab");
+        CHECK(count_notes(elf_file) == 3U);
+
+        auto const& symtab = dynamic_cast<Section_SYMTAB const&>(elf_file.section(5));
+        CHECK(symtab.symbol_count() == 11U);
+        CHECK(symtab.symbol(1).name_string().find("_0") != std::string::npos);
+        CHECK(symtab.symbol(10).bind() == STB_GLOBAL);
+    }
+
+    SECTION("Verify 32-bit big-endian basics") {
+        ElfSpec spec;
+        spec.is_64bit_ = false;
+        spec.big_endian_ = true;
+        spec.section_count_ = 2;
+        spec.symbol_count_ = 5;
+        spec.note_count_ = 1;
+        GeneratedFile file(spec);
+
+        ElfFile elf_file(file.name_);
+        CHECK_FALSE(elf_file.is_64bit());
+        CHECK_FALSE(elf_file.elf_header().isLE());
+        CHECK(elf_file.elf_header().phoff() == 52U);
+        CHECK(elf_file.elf_header().shentsize() == 40U);
+        CHECK(elf_file.section(2).name_string() == ".text.1");
+        CHECK(count_notes(elf_file) == 1U);
+
+        auto const& symtab = dynamic_cast<Section_SYMTAB const&>(elf_file.section(4));
+        CHECK(symtab.symbol_count() == 6U);
+        CHECK(symtab.symbol(5).shndx() == 1U + 4 % 2);
+    }
+
+    SECTION("Verify parse statistics are recorded") {
+        ElfSpec spec;
+        spec.section_count_ = 3;
+        spec.symbol_count_ = 10;
+        spec.note_count_ = 3;
+        GeneratedFile file(spec);
+
+        ElfFile elf_file(file.name_);
+        ParseStatistics const& statistics = elf_file.statistics();
+        CHECK(statistics.total() >= statistics.duration(ParseStatistics::Phase::SectionTable));
+        CHECK(statistics.duration(ParseStatistics::Phase::SectionTable)
+              >= statistics.duration(ParseStatistics::Phase::SymbolDecode));
+        // the image, 8 sections, 2 segments, 11 symbols and the 3 notes seen
+        // through both the note section and the note segment
+        CHECK(statistics.count(ParseStatistics::Counter::ObjectsAllocated) == 1U + 8U + 2U + 11U + 6U);
+        CHECK(statistics.count(ParseStatistics::Counter::StringsMaterialized) == 6U);
+        CHECK(statistics.count(ParseStatistics::Counter::BytesTouched) > elf_file.section(5).size());
+    }
+
+    SECTION("Verify memory is accounted by category") {
+        ElfSpec spec;
+        spec.section_count_ = 3;
+        spec.symbol_count_ = 10;
+        spec.note_count_ = 3;
+        GeneratedFile file(spec);
+
+        ElfFile elf_file(file.name_);
+        MemoryAccount const& memory = elf_file.memory();
+        CHECK(memory.bytes(MemoryAccount::Category::Image) == elf_file.size());
+        CHECK(memory.bytes(MemoryAccount::Category::Headers) >= 10 * sizeof(Section));
+        CHECK(memory.allocations(MemoryAccount::Category::Symbols) >= 11U);
+        CHECK(memory.bytes(MemoryAccount::Category::Symbols) >= 11 * sizeof(Symbol));
+        CHECK(memory.bytes(MemoryAccount::Category::Notes) >= 6 * sizeof(Note));
+        CHECK(memory.bytes(MemoryAccount::Category::Caches) == 0U);
+
+        // the string table's line index is only built when it's first shown
+        CHECK(elf_file.section(elf_file.section_table().shstrndx()).lineCount() > 0U);
+        CHECK(memory.bytes(MemoryAccount::Category::Caches) > 0U);
+
+        std::size_t sum = 0;
+        for (std::size_t i = 0; i < static_cast<std::size_t>(MemoryAccount::Category::Count_); ++i)
+        {
+            sum += memory.bytes(static_cast<MemoryAccount::Category>(i));
+        }
+        CHECK(memory.total_bytes() == sum);
+        CHECK(memory.peak_bytes() >= memory.total_bytes());
+    }
+
+    SECTION("Verify parallel section decoding matches serial decoding") {
+        ElfSpec spec;
+        spec.section_count_ = 6;
+        spec.symbol_count_ = 500;
+        spec.note_count_ = 5;
+        GeneratedFile file(spec);
+
+        ElfFile serial(file.name_);
+        ElfFile parallel(file.name_, ParseOptions{4});
+        CHECK(parallel.section_table().section_count() == serial.section_table().section_count());
+        CHECK(dump_sections(parallel) == dump_sections(serial));
+        CHECK(parallel.statistics().count(ParseStatistics::Counter::ObjectsAllocated)
+              == serial.statistics().count(ParseStatistics::Counter::ObjectsAllocated));
+        CHECK(parallel.memory().total_bytes() == serial.memory().total_bytes());
+    }
+
+    SECTION("Verify extended section numbering") {
+        ElfSpec spec;
+        spec.extended_numbering_ = true;
+        GeneratedFile file(spec);
+
+        ElfFile elf_file(file.name_);
+        CHECK(elf_file.elf_header().shnum() == 0U);
+        CHECK(elf_file.elf_header().shstrndx() == SHN_XINDEX);
+        // null + 4 .text + .note + .symtab + .symtab_shndx + .strtab + .shstrtab
+        CHECK(elf_file.section_table().section_count() == 10U);
+        CHECK(elf_file.section_table().shstrndx() == 9U);
+        CHECK(elf_file.section(7).name_string() == ".symtab_shndx");
+    }
+
+    SECTION("Verify each note's descriptor follows its own name") {
+        GeneratedFile file(ElfSpec{});
+        ElfFile elf_file(file.name_);
+        std::size_t notes = 0;
+        elf_file.section_table().iterate_sections([&](Section const& section) {
+            if (auto note_section = dynamic_cast<Section_NOTE const*>(&section))
+            {
+                std::byte const* end = elf_file.view(section.offset(), section.size()).get_bytes(0) + section.size();
+                std::byte const* last = nullptr;
+                note_section->iterate_notes([&](Note const& note) {
+                    last = note.descriptor_.get_bytes(0) + note.descriptor_.size();
+                    ++notes;
+                });
+                CHECK(last == end);
+            }
+        });
+        CHECK(notes == ElfSpec{}.note_count_);
+    }
+
+    SECTION("Verify malformed files are reported without throwing") {
+        std::string file_name = (std::filesystem::temp_directory_path() / "edhelind_test_malformed.elf").string();
+        ElfSpec spec;
+        std::vector<std::byte> const good = generate_elf(spec);
+
+        write_bytes(good, file_name);
+        ParseResult result = ElfFile::parse(file_name);
+        CHECK(!result.error_);
+        REQUIRE(result.elf_file_);
+        CHECK(result.elf_file_->section_table().section_count() > 0);
+
+        auto check_malformed = [&](std::vector<std::byte> const& bytes, ParseErrc code) {
+            write_bytes(bytes, file_name);
+            ParseResult result = ElfFile::parse(file_name);
+            CHECK(result.error_.code_ == code);
+            CHECK(!result.elf_file_);
+            CHECK(!result.error_.message().empty());
+            CHECK_THROWS_AS(ElfFile(file_name), std::runtime_error);
+        };
+
+        std::vector<std::byte> bytes = good;
+        bytes.resize(30);
+        check_malformed(bytes, ParseErrc::TooSmall);
+
+        bytes = good;
+        bytes[2] = std::byte{'X'};
+        check_malformed(bytes, ParseErrc::BadMagic);
+
+        bytes = good;
+        bytes[offsetof(Elf64_Ehdr, ei_class)] = std::byte{7};
+        check_malformed(bytes, ParseErrc::BadClass);
+
+        bytes = good;
+        bytes.resize(bytes.size() - 1);
+        check_malformed(bytes, ParseErrc::SectionHeadersOutOfBounds);
+
+        bytes = good;
+        bytes[offsetof(Elf64_Ehdr, e_phentsize)] = std::byte{8};
+        bytes[offsetof(Elf64_Ehdr, e_phentsize) + 1] = std::byte{0};
+        check_malformed(bytes, ParseErrc::BadProgramHeaderSize);
+
+        // Without segments e_phoff can point anywhere, and isn't looked at.
+        bytes = good;
+        bytes[offsetof(Elf64_Ehdr, e_phoff) + 2] = std::byte{0xab};
+        bytes[offsetof(Elf64_Ehdr, e_phnum)] = std::byte{0};
+        bytes[offsetof(Elf64_Ehdr, e_phnum) + 1] = std::byte{0};
+        write_bytes(bytes, file_name);
+        ParseResult no_segments;
+        CHECK_NOTHROW(no_segments = ElfFile::parse(file_name));
+        REQUIRE(no_segments.elf_file_);
+        std::size_t segment_count = 0;
+        no_segments.elf_file_->segment_table().iterate_segments([&segment_count](Segment const&) { ++segment_count; });
+        CHECK(segment_count == 0);
+        CHECK_NOTHROW(ElfFile(file_name));
+
+        // An unterminated string table can be parsed but not trusted.
+        bytes = good;
+        REQUIRE(result.elf_file_->validated());
+        Section const& strtab = result.elf_file_->section(result.elf_file_->section_table().shstrndx());
+        bytes[strtab.offset() + strtab.size() - 1] = std::byte{'x'};
+        write_bytes(bytes, file_name);
+        ParseResult untrusted = ElfFile::parse(file_name);
+        REQUIRE(untrusted.elf_file_);
+        CHECK(!untrusted.elf_file_->validated());
+
+        // A symbol table linked to something other than a string table.
+        for (std::uint32_t link: {1u, 1000u})
+        {
+            bytes = good;
+            ElfFile const& good_file = *result.elf_file_;
+            std::uint32_t symtab_index = 0;
+            for (std::uint32_t i = 0; i < good_file.section_table().section_count(); ++i)
+            {
+                if (good_file.section(i).type() == SType::SHT_SYMTAB)
+                {
+                    symtab_index = i;
+                    REQUIRE(dynamic_cast<Section_SYMTAB const&>(good_file.section(i)).find_string_table() != nullptr);
+                }
+            }
+            REQUIRE(symtab_index != 0);
+            std::size_t sh_link = good_file.elf_header().shoff() + symtab_index * sizeof(Elf64_Shdr)
+                                + offsetof(Elf64_Shdr, sh_link);
+            std::memcpy(&bytes[sh_link], &link, sizeof(link));
+            write_bytes(bytes, file_name);
+            ParseResult bad_link = ElfFile::parse(file_name);
+            REQUIRE(bad_link.elf_file_);
+            CHECK(!bad_link.elf_file_->validated());
+            auto const& symtab = dynamic_cast<Section_SYMTAB const&>(bad_link.elf_file_->section(symtab_index));
+            CHECK(symtab.find_string_table() == nullptr);
+            CHECK_THROWS(symtab.string_table());
+        }
+
+        std::remove(file_name.c_str());
+        ParseResult missing = ElfFile::parse(file_name);
+        CHECK(missing.error_.code_ == ParseErrc::Unreadable);
+        CHECK(missing.error_.errno_ != 0);
+    }
+
+    SECTION("Verify images in memory are parsed where they lie") {
+        ElfSpec spec;
+        spec.big_endian_ = true;
+        GeneratedFile file(spec);
+        ElfFile from_file(file.name_);
+        std::vector<std::byte> const bytes = generate_elf(spec);
+
+        ElfFile borrowed(bytes.data(), bytes.size(), "borrowed");
+        CHECK(borrowed.view(0, 4).get_bytes(0) == bytes.data());
+        CHECK(borrowed.memory().bytes(MemoryAccount::Category::Image) == 0U);
+        CHECK(borrowed.size() == from_file.size());
+        CHECK(borrowed.validated());
+        CHECK(dump_sections(borrowed) == dump_sections(from_file));
+
+        // An image in the middle of a bigger buffer, which the ElfFile keeps alive.
+        std::size_t const prefix = 100;
+        auto buffer = std::make_shared<std::vector<std::byte>>(prefix, std::byte{0xcc});
+        buffer->insert(buffer->end(), bytes.begin(), bytes.end());
+        std::shared_ptr<std::byte const> embedded(buffer, buffer->data() + prefix);
+        std::weak_ptr<std::vector<std::byte>> watch = buffer;
+        buffer.reset();
+        {
+            ParseResult shared = ElfFile::parse(std::move(embedded), bytes.size(), "embedded");
+            REQUIRE(shared.elf_file_);
+            CHECK(!watch.expired());
+            CHECK(shared.elf_file_->memory().bytes(MemoryAccount::Category::Image) == 0U);
+            CHECK(dump_sections(*shared.elf_file_) == dump_sections(from_file));
+        }
+        CHECK(watch.expired());
+
+        ParseResult truncated = ElfFile::parse(bytes.data(), 30, "truncated");
+        CHECK(truncated.error_.code_ == ParseErrc::TooSmall);
+        CHECK(!truncated.elf_file_);
+        CHECK_THROWS_AS(ElfFile(bytes.data(), 30, "truncated"), std::runtime_error);
     }
 }
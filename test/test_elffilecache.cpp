@@ -0,0 +1,123 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmsoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "test/catch.hpp"
+#include "elfgen/elfgen.h"
+#include "libedhel/elffile.h"
+#include "libedhel/elffilecache.h"
+#include <chrono>
+#include <cstdio>
+#include <filesystem>
+#include <stdexcept>
+#include <string>
+
+
+TEST_CASE("ElfFileCache functionality") {
+    SECTION("Verify a missing file is reported") {
+        ElfFileCache cache;
+        CHECK_THROWS_AS(cache.open("/no/such/file"), std::runtime_error);
+        CHECK(cache.size() == 0);
+    }
+
+    SECTION("Verify a file rewritten in place is parsed again") {
+        namespace fs = std::filesystem;
+        std::string file_name = (fs::temp_directory_path() / "edhelind_cache_rewrite_test.elf").string();
+        ElfSpec spec;
+        write_elf(spec, file_name);
+
+        ElfFileCache cache;
+        auto original = cache.open(file_name);
+        CHECK(cache.open(file_name).get() == original.get());
+
+        // A different size...
+        spec.symbol_count_ *= 2;
+        write_elf(spec, file_name);
+        auto bigger = cache.open(file_name);
+        CHECK(bigger.get() != original.get());
+        CHECK(bigger->size() == fs::file_size(file_name));
+        CHECK(bigger->size() > original->size());
+
+        // ...or the same size written later.
+        write_elf(spec, file_name);
+        fs::last_write_time(file_name, fs::last_write_time(file_name) + std::chrono::seconds(5));
+        auto touched = cache.open(file_name);
+        CHECK(touched.get() != bigger.get());
+        CHECK(touched->size() == bigger->size());
+        CHECK(cache.open(file_name).get() == touched.get());
+
+        std::remove(file_name.c_str());
+    }
+
+#ifdef __linux__
+    SECTION("Verify the same file by another name is the same ElfFile") {
+        namespace fs = std::filesystem;
+        fs::path dir = fs::temp_directory_path() / "edhelind_cache_alias_test";
+        fs::remove_all(dir);
+        fs::create_directories(dir / "sub");
+        fs::path file_name = dir / "sub" / "a.elf";
+        write_elf(ElfSpec{}, file_name.string());
+        fs::create_symlink(file_name, dir / "link.elf");
+        fs::create_directory_symlink(dir / "sub", dir / "linked_sub");
+
+        ElfFileCache cache;
+        auto elf_file = cache.open(file_name.string());
+        CHECK(cache.open((dir / "sub" / "." / "a.elf").string()).get() == elf_file.get());
+        CHECK(cache.open((dir / "sub" / ".." / "sub" / "a.elf").string()).get() == elf_file.get());
+        CHECK(cache.open((dir / "link.elf").string()).get() == elf_file.get());
+        CHECK(cache.open((dir / "linked_sub" / "a.elf").string()).get() == elf_file.get());
+        CHECK(cache.size() == 1);
+
+        fs::remove_all(dir);
+    }
+
+    // The test executable itself is the one ELF file sure to be at hand.
+    SECTION("Verify the same file is only parsed once") {
+        ElfFileCache cache;
+        auto first = cache.open("/proc/self/exe");
+        auto second = cache.open("/proc/self/exe");
+        CHECK(first.get() == second.get());
+        CHECK(cache.size() == 1);
+        CHECK(first->size() > 0);
+    }
+
+    SECTION("Verify unused files are dropped when asked") {
+        ElfFileCache cache;
+        auto elf_file = cache.open("/proc/self/exe");
+        cache.clear_unused();
+        CHECK(cache.size() == 1);
+        elf_file.reset();
+        cache.clear_unused();
+        CHECK(cache.size() == 0);
+    }
+
+    SECTION("Verify unused files are dropped to stay within the memory budget") {
+        std::string file_name = (std::filesystem::temp_directory_path() / "edhelind_cache_test.elf").string();
+        write_elf(ElfSpec{}, file_name);
+
+        ElfFileCache cache(8, 0);
+        auto generated = cache.open(file_name);
+        CHECK(cache.memory_bytes() >= generated->size());
+        generated.reset();
+        auto elf_file = cache.open("/proc/self/exe");
+        CHECK(cache.size() == 1);
+        CHECK(cache.memory_bytes() == elf_file->memory().total_bytes());
+
+        std::remove(file_name.c_str());
+    }
+#endif
+}
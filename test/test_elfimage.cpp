@@ -19,6 +19,7 @@
 #include "test/catch.hpp"
 #include "libedhel/elfimage.h"
 #include <sstream>
+#include <stdexcept>
 
 
 TEST_CASE("ElfImage functionality") {
@@ -70,6 +71,27 @@ TEST_CASE("ElfImage functionality") {
     }
 
 
+    SECTION("Verify reads past the end are caught until the image is validated") {
+        ElfImage image(test_image);
+        CHECK(!image.validated());
+        CHECK(image.get_uint32(9) == 0x00747365);
+        CHECK_THROWS_AS(image.get_uint32(10), std::out_of_range);
+        CHECK_THROWS_AS(image.get_uint64(test_image.size()), std::out_of_range);
+        CHECK_THROWS_AS(image.get_uint8(test_image.size()), std::out_of_range);
+
+        image.set_validated(true);
+        CHECK(image.validated());
+        CHECK(image.get_uint32(9) == 0x00747365);
+    }
+
+
+    SECTION("Verify strings stop at the end of their view") {
+        ElfImage image(test_image);
+        CHECK(image.view(8, 3).get_string(0, std::string::npos) == "tes");
+        CHECK(image.get_string(8, std::string::npos) == "test");
+    }
+
+
     SECTION("Verify creating an ElfImage from a non-existent file throws") {
         auto create_empty_image = [](){ ElfImage image{""}; };
         REQUIRE_THROWS_AS(create_empty_image(), std::runtime_error);
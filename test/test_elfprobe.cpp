@@ -0,0 +1,85 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "test/catch.hpp"
+#include "elfgen/elfgen.h"
+#include "libedhel/elffile.h"
+#include "libedhel/elfprobe.h"
+#include "libedhel/segment.h"
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+
+
+TEST_CASE("probe_elf functionality") {
+    std::string file_name = (std::filesystem::temp_directory_path() / "edhelind_probe_test.elf").string();
+
+    SECTION("Verify a missing file is reported") {
+        CHECK(probe_elf("/no/such/file").status_ == ElfProbe::Status::Unreadable);
+    }
+
+    SECTION("Verify other files are told apart from ELF files") {
+        std::ofstream(file_name) << "not an ELF file\n";
+        CHECK(probe_elf(file_name).status_ == ElfProbe::Status::NotElf);
+        std::ofstream(file_name) << "\177ELF\001\002 and no more";
+        CHECK(probe_elf(file_name).status_ == ElfProbe::Status::Truncated);
+        std::remove(file_name.c_str());
+    }
+
+    for (bool is_64bit: { true, false })
+    {
+        for (bool big_endian: { false, true })
+        {
+            SECTION(std::string("Verify the probe matches the parsed file")
+                    + (is_64bit ? " (64" : " (32") + (big_endian ? "-bit BE)" : "-bit LE)")) {
+                ElfSpec spec;
+                spec.is_64bit_ = is_64bit;
+                spec.big_endian_ = big_endian;
+                write_elf(spec, file_name);
+
+                ElfFile elf_file(file_name);
+                ElfHeader const& elf_header = elf_file.elf_header();
+                ElfProbe probe = probe_elf(file_name, true);
+                REQUIRE(probe.status_ == ElfProbe::Status::Elf);
+                CHECK(probe.is_64bit_ == elf_header.is64());
+                CHECK(probe.is_big_endian_ == !elf_header.isLE());
+                CHECK(probe.osabi_ == elf_header.osabi());
+                CHECK(probe.type_ == elf_header.type());
+                CHECK(probe.machine_ == elf_header.machine());
+                CHECK(probe.entry_ == elf_header.entry());
+                CHECK(probe.phoff_ == elf_header.phoff());
+                CHECK(probe.shoff_ == elf_header.shoff());
+                CHECK(probe.phnum_ == elf_header.phnum());
+                CHECK(probe.shnum_ == elf_header.shnum());
+                CHECK(probe.shstrndx_ == elf_header.shstrndx());
+
+                REQUIRE(probe.segment_count_ == elf_header.phnum());
+                for (std::size_t i = 0; i < probe.segment_count_; ++i)
+                {
+                    Segment const& segment = elf_file.segment_table().segment(i);
+                    CHECK(probe.segments_[i].type_ == segment.type());
+                    CHECK(probe.segments_[i].offset_ == segment.offset());
+                    CHECK(probe.segments_[i].filesz_ == segment.filesz());
+                }
+
+                CHECK(probe_elf(file_name).segment_count_ == 0);
+                std::remove(file_name.c_str());
+            }
+        }
+    }
+}
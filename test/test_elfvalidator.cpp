@@ -0,0 +1,240 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmsoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "test/catch.hpp"
+#include "elfgen/elfgen.h"
+#include "libedhel/elf.h"
+#include "libedhel/elfimage.h"
+#include "libedhel/elfvalidator.h"
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+
+namespace
+{
+    /** A generated 64-bit little-endian file to break, and where things are in it */
+    struct GeneratedImage
+    {
+        explicit GeneratedImage(ElfSpec const& spec)
+        : bytes_(generate_elf(spec))
+        { }
+
+        std::uint64_t
+        get(std::uint64_t offset, std::size_t size) const
+        {
+            std::uint64_t value = 0;
+            for (std::size_t i = size; i-- > 0; )
+            {
+                value = value << 8 | std::to_integer<std::uint64_t>(bytes_[offset + i]);
+            }
+            return value;
+        }
+
+        void
+        put(std::uint64_t offset, std::uint64_t value, std::size_t size)
+        {
+            for (std::size_t i = 0; i < size; ++i)
+            {
+                bytes_[offset + i] = static_cast<std::byte>(value >> 8 * i);
+            }
+        }
+
+        /** The file offset of the header of section @p index */
+        std::uint64_t
+        shdr(std::uint64_t index) const
+        {
+            return get(offsetof(Elf64_Ehdr, e_shoff), 8) + index * sizeof(Elf64_Shdr);
+        }
+
+        /** The file offset of the header of the section called @p name */
+        std::uint64_t
+        shdr(char const* name) const
+        {
+            std::uint64_t const shnum = get(offsetof(Elf64_Ehdr, e_shnum), 2);
+            std::uint64_t const shstrndx = get(offsetof(Elf64_Ehdr, e_shstrndx), 2);
+            std::uint64_t const names = get(shdr(shstrndx) + offsetof(Elf64_Shdr, sh_offset), 8);
+            for (std::uint64_t i = 1; i < shnum; ++i)
+            {
+                std::uint64_t const at = names + get(shdr(i) + offsetof(Elf64_Shdr, sh_name), 4);
+                if (std::strcmp(reinterpret_cast<char const*>(&bytes_[at]), name) == 0)
+                {
+                    return shdr(i);
+                }
+            }
+            FAIL("no section " << name);
+            return 0;
+        }
+
+        ElfValidation
+        validate() const
+        {
+            ElfImage image(bytes_.data(), bytes_.size());
+            return validate_elf(image);
+        }
+
+        /** Check the file can be parsed, but not trusted because of @p code at @p offset */
+        void
+        check_untrusted(ParseErrc code, std::uint64_t offset) const
+        {
+            ElfImage image(bytes_.data(), bytes_.size());
+            ElfValidation validation = validate_elf(image);
+            CHECK(!validation.error_);
+            CHECK(validation.untrusted_.code_ == code);
+            CHECK(validation.untrusted_.offset_ == offset);
+            CHECK(!image.validated());
+        }
+
+        /** Check the file can't be parsed at all, because of @p code at @p offset */
+        void
+        check_fatal(ParseErrc code, std::uint64_t offset) const
+        {
+            ElfValidation validation = validate();
+            CHECK(validation.error_.code_ == code);
+            CHECK(validation.error_.offset_ == offset);
+            CHECK(validation.untrusted_.code_ == code);
+        }
+
+        std::vector<std::byte> bytes_;
+    };
+
+    ElfSpec
+    make_spec()
+    {
+        ElfSpec spec;
+        spec.relocation_count_ = 8;
+        return spec;
+    }
+} // anonymous namespace
+
+
+TEST_CASE("ELF validation") {
+    GeneratedImage file(make_spec());
+
+    SECTION("Verify a well-formed file is trusted") {
+        ElfImage image(file.bytes_.data(), file.bytes_.size());
+        ElfValidation validation = validate_elf(image);
+        CHECK(!validation.error_);
+        CHECK(!validation.untrusted_);
+        CHECK(image.validated());
+    }
+
+    SECTION("Verify wrong entry sizes are not trusted") {
+        std::uint64_t const symtab = file.shdr(".symtab");
+        file.put(symtab + offsetof(Elf64_Shdr, sh_entsize), sizeof(Elf64::Sym) - 4, 8);
+        file.check_untrusted(ParseErrc::BadEntrySize, symtab);
+    }
+
+    SECTION("Verify a symbol table whose size isn't a whole number of symbols is not trusted") {
+        std::uint64_t const symtab = file.shdr(".symtab");
+        std::uint64_t const size = file.get(symtab + offsetof(Elf64_Shdr, sh_size), 8);
+        file.put(symtab + offsetof(Elf64_Shdr, sh_size), size - 1, 8);
+        file.check_untrusted(ParseErrc::BadEntrySize, symtab);
+    }
+
+    SECTION("Verify wrong relocation entry sizes are not trusted") {
+        std::uint64_t const rela = file.shdr(".rela.text");
+        file.put(rela + offsetof(Elf64_Shdr, sh_entsize), 16, 8);
+        file.check_untrusted(ParseErrc::BadEntrySize, rela);
+    }
+
+    SECTION("Verify wrong dynamic entry sizes are not trusted") {
+        // Make a code section a dynamic section, with no entry size.
+        std::uint64_t const text = file.shdr(".text.0");
+        file.put(text + offsetof(Elf64_Shdr, sh_type), static_cast<std::uint32_t>(SType::SHT_DYNAMIC), 4);
+        file.check_untrusted(ParseErrc::BadEntrySize, text);
+    }
+
+    SECTION("Verify a symbol name past the end of its string table is not trusted") {
+        std::uint64_t const symtab = file.shdr(".symtab");
+        std::uint64_t const strtab_size = file.get(file.shdr(".strtab") + offsetof(Elf64_Shdr, sh_size), 8);
+        std::uint64_t const symbol = file.get(symtab + offsetof(Elf64_Shdr, sh_offset), 8) + 3 * sizeof(Elf64::Sym);
+        file.put(symbol + offsetof(Elf64::Sym, st_name), strtab_size, 4);
+        file.check_untrusted(ParseErrc::NameOutOfBounds, symbol);
+    }
+
+    SECTION("Verify a symbol table linked to a missing section is not trusted") {
+        std::uint64_t const symtab = file.shdr(".symtab");
+        file.put(symtab + offsetof(Elf64_Shdr, sh_link), 1000, 4);
+        file.check_untrusted(ParseErrc::BadSectionIndex, symtab);
+    }
+
+    SECTION("Verify a symbol table linked to something other than a string table is not trusted") {
+        std::uint64_t const symtab = file.shdr(".symtab");
+        file.put(symtab + offsetof(Elf64_Shdr, sh_link), 1, 4);
+        file.check_untrusted(ParseErrc::BadSectionIndex, symtab);
+    }
+
+    SECTION("Verify a section name table that isn't a string table is not trusted") {
+        file.put(offsetof(Elf64_Ehdr, e_shstrndx), 1, 2);
+        file.check_untrusted(ParseErrc::BadSectionIndex, 0);
+    }
+
+    SECTION("Verify a missing section name table is not trusted") {
+        file.put(offsetof(Elf64_Ehdr, e_shstrndx), 1000, 2);
+        file.check_untrusted(ParseErrc::BadSectionIndex, 0);
+    }
+
+    SECTION("Verify a section name past the end of the name table is not trusted") {
+        std::uint64_t const shstrtab = file.shdr(".shstrtab");
+        std::uint64_t const size = file.get(shstrtab + offsetof(Elf64_Shdr, sh_size), 8);
+        std::uint64_t const text = file.shdr(".text.1");
+        file.put(text + offsetof(Elf64_Shdr, sh_name), size, 4);
+        file.check_untrusted(ParseErrc::NameOutOfBounds, text);
+    }
+
+    SECTION("Verify a section outside the file is not trusted") {
+        std::uint64_t const text = file.shdr(".text.2");
+        file.put(text + offsetof(Elf64_Shdr, sh_offset), file.bytes_.size() - 8, 8);
+        file.check_untrusted(ParseErrc::SectionOutOfBounds, text);
+    }
+
+    SECTION("Verify a relocation section outside the file is not trusted") {
+        std::uint64_t const rela = file.shdr(".rela.text");
+        file.put(rela + offsetof(Elf64_Shdr, sh_offset), file.bytes_.size() + 0x1000, 8);
+        file.check_untrusted(ParseErrc::SectionOutOfBounds, rela);
+    }
+
+    SECTION("Verify a string table outside the file can't be parsed") {
+        std::uint64_t const strtab = file.shdr(".strtab");
+        file.put(strtab + offsetof(Elf64_Shdr, sh_offset), file.bytes_.size(), 8);
+        file.check_fatal(ParseErrc::SectionOutOfBounds, strtab);
+    }
+
+    SECTION("Verify a note overrunning its section can't be parsed") {
+        std::uint64_t const note = file.get(file.shdr(".note") + offsetof(Elf64_Shdr, sh_offset), 8);
+        file.put(note + offsetof(ElfNote, descsz), 0x10000, 4);
+        file.check_fatal(ParseErrc::NoteOutOfBounds, note);
+    }
+
+    SECTION("Verify a wild program header offset with no segments is not trusted") {
+        file.put(offsetof(Elf64_Ehdr, e_phoff), 0xab0000, 8);
+        file.put(offsetof(Elf64_Ehdr, e_phnum), 0, 2);
+        file.check_untrusted(ParseErrc::ProgramHeadersOutOfBounds, 0xab0000);
+    }
+
+    SECTION("Verify an unterminated string table is not trusted") {
+        std::uint64_t const strtab = file.shdr(".strtab");
+        std::uint64_t const end = file.get(strtab + offsetof(Elf64_Shdr, sh_offset), 8)
+                                + file.get(strtab + offsetof(Elf64_Shdr, sh_size), 8);
+        file.put(end - 1, 'x', 1);
+        file.check_untrusted(ParseErrc::UnterminatedString, strtab);
+    }
+}
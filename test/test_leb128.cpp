@@ -0,0 +1,249 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmsoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "test/catch.hpp"
+#include "libedhel/elfimage.h"
+#include "libedhel/leb128.h"
+#include <cstdint>
+#include <random>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+
+namespace
+{
+    void
+    put_uleb128(std::vector<std::byte>& bytes, std::uint64_t value)
+    {
+        do
+        {
+            std::uint8_t byte = value & 0x7f;
+            value >>= 7;
+            bytes.push_back(std::byte(value != 0 ? byte | 0x80 : byte));
+        } while (value != 0);
+    }
+
+    void
+    put_sleb128(std::vector<std::byte>& bytes, std::int64_t value)
+    {
+        for (;;)
+        {
+            std::uint8_t byte = value & 0x7f;
+            value >>= 7;
+            bool done = (value == 0 && (byte & 0x40) == 0) || (value == -1 && (byte & 0x40) != 0);
+            bytes.push_back(std::byte(done ? byte : byte | 0x80));
+            if (done)
+            {
+                return;
+            }
+        }
+    }
+
+    std::vector<std::byte>
+    bytes_of(std::initializer_list<unsigned> list)
+    {
+        std::vector<std::byte> bytes;
+        for (unsigned b: list)
+        {
+            bytes.push_back(std::byte(b));
+        }
+        return bytes;
+    }
+
+    /**
+     * Values of up to @p max_width bits, mostly short ones the way real
+     * streams are
+     */
+    template<typename Value>
+    std::vector<Value>
+    mixed_values(std::size_t count, unsigned max_width, std::uint32_t seed)
+    {
+        std::mt19937_64 random(seed);
+        std::vector<Value> values(count);
+        for (auto& value: values)
+        {
+            std::uint64_t bits = random();
+            unsigned width = random() % 4 == 0 ? random() % (max_width + 1) : random() % 8;
+            bits = width == 64 ? bits : bits & ((std::uint64_t(1) << width) - 1);
+            value = static_cast<Value>(bits);
+            if (std::is_signed<Value>::value && (random() & 1) != 0)
+            {
+                value = static_cast<Value>(0 - bits);
+            }
+        }
+        return values;
+    }
+} // anonymous namespace
+
+
+TEST_CASE("LEB128 decoding") {
+    SECTION("Verify the encodings from the DWARF standard decode") {
+        struct { std::vector<std::byte> bytes_; std::uint64_t value_; } const unsigned_cases[] = {
+            { bytes_of({ 0x02 }), 2 },
+            { bytes_of({ 0x7f }), 127 },
+            { bytes_of({ 0x80, 0x01 }), 128 },
+            { bytes_of({ 0x81, 0x01 }), 129 },
+            { bytes_of({ 0x82, 0x01 }), 130 },
+            { bytes_of({ 0xb9, 0x64 }), 12857 },
+            { bytes_of({ 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0xff, 0x01 }), ~std::uint64_t(0) },
+        };
+        for (auto const& c: unsigned_cases)
+        {
+            std::uint64_t value = 0;
+            CHECK(read_uleb128(c.bytes_.data(), c.bytes_.data() + c.bytes_.size(), value)
+                  == c.bytes_.data() + c.bytes_.size());
+            CHECK(value == c.value_);
+        }
+
+        struct { std::vector<std::byte> bytes_; std::int64_t value_; } const signed_cases[] = {
+            { bytes_of({ 0x02 }), 2 },
+            { bytes_of({ 0x7e }), -2 },
+            { bytes_of({ 0xff, 0x00 }), 127 },
+            { bytes_of({ 0x81, 0x7f }), -127 },
+            { bytes_of({ 0x80, 0x01 }), 128 },
+            { bytes_of({ 0x80, 0x7f }), -128 },
+            { bytes_of({ 0x81, 0x01 }), 129 },
+            { bytes_of({ 0xff, 0x7e }), -129 },
+            { bytes_of({ 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x80, 0x7f }), INT64_MIN },
+        };
+        for (auto const& c: signed_cases)
+        {
+            std::int64_t value = 0;
+            CHECK(read_sleb128(c.bytes_.data(), c.bytes_.data() + c.bytes_.size(), value)
+                  == c.bytes_.data() + c.bytes_.size());
+            CHECK(value == c.value_);
+        }
+    }
+
+    SECTION("Verify bulk decoding matches a value at a time") {
+        // Values of up to 2 and 4 bytes can all be shuffled into lanes.
+        std::pair<std::size_t, unsigned> const runs[] = {
+            { 0, 64 }, { 1, 64 }, { 15, 64 }, { 16, 64 }, { 17, 64 }, { 100, 64 }, { 5000, 64 },
+            { 5000, 14 }, { 5000, 28 },
+        };
+        for (auto [count, max_width]: runs)
+        {
+            std::vector<std::uint64_t> unsigned_values = mixed_values<std::uint64_t>(count, max_width, 17);
+            std::vector<std::int64_t> signed_values = mixed_values<std::int64_t>(count, max_width, 29);
+            std::vector<std::byte> unsigned_bytes;
+            std::vector<std::byte> signed_bytes;
+            for (std::size_t i = 0; i < count; ++i)
+            {
+                put_uleb128(unsigned_bytes, unsigned_values[i]);
+                put_sleb128(signed_bytes, signed_values[i]);
+            }
+
+            std::vector<std::uint64_t> unsigned_decoded(count + 1);
+            Leb128Run run = decode_uleb128(unsigned_bytes.data(), unsigned_bytes.size(), count + 1,
+                                           unsigned_decoded.data());
+            CHECK(run.count_ == count);
+            CHECK(run.size_ == unsigned_bytes.size());
+            unsigned_decoded.resize(count);
+            CHECK(unsigned_decoded == unsigned_values);
+
+            std::vector<std::int64_t> signed_decoded(count + 1);
+            run = decode_sleb128(signed_bytes.data(), signed_bytes.size(), count + 1, signed_decoded.data());
+            CHECK(run.count_ == count);
+            CHECK(run.size_ == signed_bytes.size());
+            signed_decoded.resize(count);
+            CHECK(signed_decoded == signed_values);
+        }
+    }
+
+    SECTION("Verify runs of one-byte values and overlong values decode") {
+        std::vector<std::byte> bytes;
+        std::vector<std::uint64_t> expected;
+        for (unsigned i = 0; i < 40; ++i)
+        {
+            bytes.push_back(std::byte(i));
+            expected.push_back(i);
+        }
+        // Padded out with continuation bytes past a whole chunk, as some
+        // assemblers do, and with bits past the 64th that get dropped.
+        bytes.push_back(std::byte(0x85));
+        for (unsigned i = 0; i < 18; ++i)
+        {
+            bytes.push_back(std::byte(0x80));
+        }
+        bytes.push_back(std::byte(0x00));
+        expected.push_back(5);
+        for (unsigned i = 0; i < 40; ++i)
+        {
+            bytes.push_back(std::byte(0x7f - i));
+            expected.push_back(0x7f - i);
+        }
+
+        std::vector<std::uint64_t> values(expected.size());
+        Leb128Run run = decode_uleb128(bytes.data(), bytes.size(), values.size(), values.data());
+        CHECK(run.count_ == expected.size());
+        CHECK(run.size_ == bytes.size());
+        CHECK(values == expected);
+
+        std::vector<std::int64_t> signed_values(expected.size());
+        run = decode_sleb128(bytes.data(), bytes.size(), signed_values.size(), signed_values.data());
+        CHECK(run.count_ == expected.size());
+        CHECK(signed_values[3] == 3);
+        CHECK(signed_values[41] == -1);
+        CHECK(signed_values[80] == 0x58 - 0x80);
+        CHECK(signed_values[40] == 5);
+    }
+
+    SECTION("Verify decoding stops at a value cut short") {
+        std::vector<std::byte> bytes;
+        for (unsigned i = 0; i < 30; ++i)
+        {
+            put_uleb128(bytes, 300 + i);
+        }
+        bytes.push_back(std::byte(0xff));
+
+        std::vector<std::uint64_t> values(40);
+        Leb128Run run = decode_uleb128(bytes.data(), bytes.size(), values.size(), values.data());
+        CHECK(run.count_ == 30);
+        CHECK(run.size_ == 60);
+        CHECK(values[29] == 329);
+
+        std::uint64_t value = 0;
+        CHECK(read_uleb128(bytes.data() + 60, bytes.data() + bytes.size(), value) == nullptr);
+        CHECK(value == 0x7f);
+    }
+
+    SECTION("Verify ElfImageView reads LEB128 within the view") {
+        ElfImage::ByteSequence bytes = bytes_of({ 0x01, 0xe5, 0x8e, 0x26, 0x7f, 0x80, 0x7f, 0xff });
+        ElfImage image(bytes);
+        ElfImageView view = image.view(0, 7);
+
+        std::size_t length = 0;
+        CHECK(view.get_uleb128(1, length) == 624485);
+        CHECK(length == 3);
+        CHECK(view.get_sleb128(4, length) == -1);
+        CHECK(length == 1);
+        CHECK(view.get_sleb128(5, length) == -128);
+        CHECK(length == 2);
+        CHECK_THROWS_AS(image.view(0, 2).get_uleb128(1, length), std::out_of_range);
+        CHECK_THROWS_AS(view.get_uleb128(7, length), std::out_of_range);
+
+        std::int64_t values[8];
+        Leb128Run run = view.get_sleb128s(0, 8, values);
+        CHECK(run.count_ == 4);
+        CHECK(run.size_ == 7);
+        CHECK(values[1] == 624485);
+        CHECK(values[3] == -128);
+        CHECK(view.get_uleb128s(7, 8, nullptr).count_ == 0);
+    }
+}
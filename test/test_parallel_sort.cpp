@@ -0,0 +1,57 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmsoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "test/catch.hpp"
+#include "libedhel/parallel_sort.h"
+#include <algorithm>
+#include <functional>
+#include <random>
+#include <vector>
+
+
+TEST_CASE("parallel_sort functionality") {
+    std::mt19937 rng(42);
+    std::vector<unsigned> values(200000);
+    std::generate(values.begin(), values.end(), [&]{ return rng() % 1000; });
+
+    SECTION("Verify a large range is sorted the same as std::sort") {
+        auto expected = values;
+        std::sort(expected.begin(), expected.end());
+
+        parallel_sort(values.begin(), values.end(), std::less<unsigned>(), 4);
+        CHECK(values == expected);
+    }
+
+    SECTION("Verify an odd number of threads still sorts") {
+        auto expected = values;
+        std::sort(expected.begin(), expected.end(), std::greater<unsigned>());
+
+        parallel_sort(values.begin(), values.end(), std::greater<unsigned>(), 3);
+        CHECK(values == expected);
+    }
+
+    SECTION("Verify small and empty ranges") {
+        std::vector<unsigned> small{3, 1, 2};
+        parallel_sort(small.begin(), small.end(), std::less<unsigned>(), 8);
+        CHECK(small == std::vector<unsigned>{1, 2, 3});
+
+        std::vector<unsigned> empty;
+        parallel_sort(empty.begin(), empty.end(), std::less<unsigned>(), 8);
+        CHECK(empty.empty());
+    }
+}
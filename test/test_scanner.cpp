@@ -0,0 +1,108 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "test/catch.hpp"
+#include "elfgen/elfgen.h"
+#include "libedhel/elf.h"
+#include "libedhel/scanner.h"
+#include <algorithm>
+#include <cstddef>
+#include <filesystem>
+#include <fstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+
+TEST_CASE("scan_tree functionality") {
+    SECTION("Verify a missing directory is reported") {
+        CHECK_THROWS_AS(scan_tree("/no/such/directory"), std::runtime_error);
+    }
+
+    SECTION("Verify ELF files are found, parsed, and told apart from other files") {
+        namespace fs = std::filesystem;
+        fs::path root = fs::temp_directory_path() / "edhelind_scanner_test";
+        fs::remove_all(root);
+        fs::create_directories(root / "sub");
+
+        ElfSpec spec32be;
+        spec32be.is_64bit_ = false;
+        spec32be.big_endian_ = true;
+        write_elf(ElfSpec{}, (root / "a.elf").string());
+        write_elf(spec32be, (root / "sub" / "b.elf").string());
+        std::ofstream(root / "notes.txt") << "not an ELF file\n";
+        std::ofstream(root / "sub" / "broken.elf") << "\177ELF\002\001 and not much more";
+
+        auto results = scan_tree(root.string());
+        REQUIRE(results.size() == 4);
+        auto find = [&results](fs::path const& path) {
+            return *std::find_if(results.begin(), results.end(), [&path](ScanResult const& result) {
+                return result.path_ == path.string();
+            });
+        };
+
+        ScanResult a = find(root / "a.elf");
+        CHECK(a.status_ == ScanResult::Status::Parsed);
+        CHECK(a.is_64bit_);
+        CHECK(!a.is_big_endian_);
+        CHECK(a.section_count_ > 0);
+        CHECK(a.symbol_count_ >= ElfSpec{}.symbol_count_);
+
+        ScanResult b = find(root / "sub" / "b.elf");
+        CHECK(b.status_ == ScanResult::Status::Parsed);
+        CHECK(!b.is_64bit_);
+        CHECK(b.is_big_endian_);
+
+        CHECK(find(root / "notes.txt").status_ == ScanResult::Status::NotElf);
+        ScanResult broken = find(root / "sub" / "broken.elf");
+        CHECK(broken.status_ == ScanResult::Status::Failed);
+        CHECK(!broken.error_.empty());
+
+        fs::remove_all(root);
+    }
+
+    SECTION("Verify a file the parser chokes on doesn't stop the scan") {
+        namespace fs = std::filesystem;
+        fs::path root = fs::temp_directory_path() / "edhelind_scanner_bad_test";
+        fs::remove_all(root);
+        fs::create_directories(root);
+
+        // e_phoff far past the end, with no segments for it to locate.
+        std::vector<std::byte> bytes = generate_elf(ElfSpec{});
+        bytes[offsetof(Elf64_Ehdr, e_phoff) + 2] = std::byte{0xab};
+        bytes[offsetof(Elf64_Ehdr, e_phnum)] = std::byte{0};
+        bytes[offsetof(Elf64_Ehdr, e_phnum) + 1] = std::byte{0};
+        std::ofstream(root / "bad.elf", std::ios::binary).write(reinterpret_cast<char const*>(bytes.data()),
+                                                                 static_cast<std::streamsize>(bytes.size()));
+        for (int i = 0; i < 3; ++i)
+        {
+            write_elf(ElfSpec{}, (root / ("good" + std::to_string(i) + ".elf")).string());
+        }
+
+        std::vector<ScanResult> results;
+        CHECK_NOTHROW(results = scan_tree(root.string()));
+        REQUIRE(results.size() == 4);
+        for (ScanResult const& result: results)
+        {
+            CHECK(result.status_ == ScanResult::Status::Parsed);
+            CHECK(result.section_count_ > 0);
+        }
+
+        fs::remove_all(root);
+    }
+}
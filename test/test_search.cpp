@@ -0,0 +1,327 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmsoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "test/catch.hpp"
+#include "elfgen/elfgen.h"
+#include "libedhel/elf.h"
+#include "libedhel/elffile.h"
+#include "libedhel/search.h"
+#include "libedhel/section.h"
+#include "libedhel/section_strtab.h"
+#include "libedhel/section_symtab.h"
+#include "libedhel/symbol.h"
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <random>
+#include <set>
+#include <string>
+#include <tuple>
+#include <vector>
+
+
+namespace
+{
+    using Hit = std::tuple<SearchHit::Kind, std::uint32_t, std::uint32_t>;
+
+    /** What search_elf_file() should find, looked for the slow way */
+    std::set<Hit>
+    expected_hits(ElfFile const& elf_file, std::string const& needle)
+    {
+        std::set<Hit> hits;
+        for (std::uint32_t i = 0; i < elf_file.section_table().section_count(); ++i)
+        {
+            Section const& section = elf_file.section(i);
+            if (section.name_string().find(needle) != std::string::npos)
+            {
+                hits.emplace(SearchHit::Kind::SectionName, i, i);
+            }
+            if (auto const* symtab = dynamic_cast<Section_SYMTAB const*>(&section))
+            {
+                for (std::uint32_t s = 0; s < symtab->symbol_count(); ++s)
+                {
+                    if (symtab->symbol(s).name_string().find(needle) != std::string::npos)
+                    {
+                        hits.emplace(SearchHit::Kind::SymbolName, i, s);
+                    }
+                }
+            }
+            if (auto const* strtab = dynamic_cast<Section_STRTAB const*>(&section))
+            {
+                std::string_view table = strtab->table_bytes();
+                for (std::size_t start = 0; start < table.size(); )
+                {
+                    std::size_t end = std::min(table.find('\0', start), table.size());
+                    if (table.substr(start, end - start).find(needle) != std::string_view::npos)
+                    {
+                        hits.emplace(SearchHit::Kind::String, i, static_cast<std::uint32_t>(start));
+                    }
+                    start = end + 1;
+                }
+            }
+        }
+        return hits;
+    }
+
+    /** Everything search_elf_file() reports for @p needle, in order */
+    std::vector<SearchHit>
+    search(ElfFile const& elf_file, std::string const& needle)
+    {
+        std::vector<SearchHit> hits;
+        CHECK(search_elf_file(elf_file, needle, [&hits](SearchHit const& hit) {
+            hits.push_back(hit);
+            return true;
+        }));
+        return hits;
+    }
+
+    std::set<Hit>
+    hit_set(std::vector<SearchHit> const& hits)
+    {
+        std::set<Hit> set;
+        for (auto const& hit: hits)
+        {
+            set.emplace(hit.kind_, hit.section_, hit.index_);
+        }
+        return set;
+    }
+
+    std::size_t
+    count_kind(std::vector<SearchHit> const& hits, SearchHit::Kind kind)
+    {
+        return std::count_if(hits.begin(), hits.end(), [kind](SearchHit const& hit) { return hit.kind_ == kind; });
+    }
+} // anonymous namespace
+
+
+TEST_CASE("find_substring functionality") {
+    SECTION("Verify simple matches") {
+        CHECK(find_substring("hello world", "world") == 6);
+        CHECK(find_substring("hello world", "o") == 4);
+        CHECK(find_substring("hello world", "o", 5) == 7);
+        CHECK(find_substring("hello world", "planet") == std::string_view::npos);
+        CHECK(find_substring("hi", "high") == std::string_view::npos);
+    }
+
+    SECTION("Verify matches across and at the end of 16-byte blocks") {
+        std::string haystack(100, 'a');
+        haystack.replace(14, 4, "abcd");
+        haystack.replace(96, 4, "wxyz");
+        CHECK(find_substring(haystack, "abcd") == 14);
+        CHECK(find_substring(haystack, "wxyz") == 96);
+        CHECK(find_substring(haystack, "z") == 99);
+    }
+
+    SECTION("Verify agreement with std::string_view::find on random data") {
+        std::mt19937 rng(7);
+        std::string haystack(5000, '\0');
+        for (auto& c: haystack)
+        {
+            c = static_cast<char>('a' + rng() % 4);
+        }
+        std::string_view view(haystack);
+        for (std::size_t length = 1; length < 8; ++length)
+        {
+            std::string needle = haystack.substr(rng() % 4000, length);
+            for (std::size_t from = 0; from < 5000; from += 611)
+            {
+                CHECK(find_substring(view, needle, from) == view.find(needle, from));
+            }
+        }
+    }
+}
+
+
+TEST_CASE("search_elf_file functionality") {
+    namespace fs = std::filesystem;
+    std::string file_name = (fs::temp_directory_path() / "edhelind_search_test.elf").string();
+    ElfSpec spec;
+    spec.symbol_count_ = 300;
+    spec.seed_ = 29;
+    write_elf(spec, file_name);
+
+    SECTION("Verify a needle shared by several symbols is found in each of them") {
+        ElfFile elf_file(file_name);
+        auto hits = search(elf_file, "parse");
+        CHECK(hit_set(hits).size() == hits.size());
+        CHECK(hit_set(hits) == expected_hits(elf_file, "parse"));
+        CHECK(count_kind(hits, SearchHit::Kind::SymbolName) > 1);
+        for (auto const& hit: hits)
+        {
+            CHECK(hit.text_.find("parse") != std::string::npos);
+        }
+    }
+
+    SECTION("Verify each string is reported once however often it matches") {
+        ElfFile elf_file(file_name);
+        // every generated symbol name has two of these
+        auto hits = search(elf_file, "_");
+        CHECK(hit_set(hits).size() == hits.size());
+        CHECK(hit_set(hits) == expected_hits(elf_file, "_"));
+        CHECK(count_kind(hits, SearchHit::Kind::SymbolName) == spec.symbol_count_);
+    }
+
+    SECTION("Verify a name sharing the tail of another string is found") {
+        // Point symbol 2's name at the tail of symbol 1's, as a linker merging
+        // string tables would, and look for just that tail.
+        std::uint32_t symtab_index = 0;
+        std::uint64_t symtab_offset = 0;
+        std::uint32_t name_offset = 0;
+        std::string name;
+        {
+            ElfFile elf_file(file_name);
+            for (std::uint32_t i = 0; i < elf_file.section_table().section_count(); ++i)
+            {
+                if (auto const* symtab = dynamic_cast<Section_SYMTAB const*>(&elf_file.section(i)))
+                {
+                    symtab_index = i;
+                    symtab_offset = symtab->offset();
+                    name_offset = symtab->symbol(1).name();
+                    name = symtab->symbol(1).name_string();
+                }
+            }
+        }
+        REQUIRE(symtab_index != 0);
+        std::size_t tail = name.find('_') + 1;
+        std::string needle = name.substr(tail);
+        std::uint32_t tail_offset = name_offset + static_cast<std::uint32_t>(tail);
+
+        std::vector<std::byte> bytes = generate_elf(spec);
+        std::size_t st_name = symtab_offset + 2 * sizeof(Elf64::Sym);
+        for (int b = 0; b < 4; ++b)
+        {
+            bytes[st_name + b] = std::byte((tail_offset >> (8 * b)) & 0xff);
+        }
+        std::ofstream(file_name, std::ios::binary).write(reinterpret_cast<char const*>(bytes.data()), bytes.size());
+
+        ElfFile elf_file(file_name);
+        auto hits = search(elf_file, needle);
+        CHECK(hit_set(hits).size() == hits.size());
+        CHECK(hit_set(hits) == expected_hits(elf_file, needle));
+        CHECK(hit_set(hits).count(Hit{SearchHit::Kind::SymbolName, symtab_index, 1}) == 1);
+        CHECK(hit_set(hits).count(Hit{SearchHit::Kind::SymbolName, symtab_index, 2}) == 1);
+        std::uint32_t strndx = elf_file.section(symtab_index).link();
+        CHECK(hit_set(hits).count(Hit{SearchHit::Kind::String, strndx, name_offset}) == 1);
+        CHECK(hit_set(hits).count(Hit{SearchHit::Kind::String, strndx, tail_offset}) == 0);
+    }
+
+    SECTION("Verify section names are found") {
+        ElfFile elf_file(file_name);
+        auto hits = search(elf_file, ".text");
+        CHECK(hit_set(hits) == expected_hits(elf_file, ".text"));
+        CHECK(count_kind(hits, SearchHit::Kind::SectionName) == spec.section_count_);
+        CHECK(count_kind(hits, SearchHit::Kind::SymbolName) == 0);
+        for (auto const& hit: hits)
+        {
+            if (hit.kind_ == SearchHit::Kind::SectionName)
+            {
+                CHECK(elf_file.section(hit.section_).name_string() == hit.text_);
+            }
+        }
+    }
+
+    SECTION("Verify a search can be stopped partway through") {
+        ElfFile elf_file(file_name);
+        std::vector<SearchHit> hits;
+        bool cancelled = false;
+        CHECK_FALSE(search_elf_file(elf_file, "t",
+                                    [&](SearchHit const& hit) {
+                                        hits.push_back(hit);
+                                        cancelled = true;
+                                        return true;
+                                    },
+                                    [&]{ return cancelled; }));
+        // section names are all visited before the first check
+        CHECK(!hits.empty());
+        CHECK(count_kind(hits, SearchHit::Kind::SectionName) == hits.size());
+
+        std::size_t visits = 0;
+        CHECK_FALSE(search_elf_file(elf_file, "_", [&](SearchHit const&) { return ++visits < 5; }));
+        CHECK(visits == 5);
+    }
+
+    SECTION("Verify a search is cancelled in the middle of a big string table") {
+        spec.string_table_size_ = 4 << 20;
+        write_elf(spec, file_name);
+        ElfFile elf_file(file_name);
+        std::size_t polls = 0;
+        std::size_t visits = 0;
+        CHECK_FALSE(search_elf_file(elf_file, "_",
+                                    [&](SearchHit const& hit) {
+                                        visits += hit.kind_ != SearchHit::Kind::SectionName;
+                                        return true;
+                                    },
+                                    [&]{ return ++polls == 1; }));
+        CHECK(polls == 1);
+        CHECK(visits == 0);
+    }
+
+    SECTION("Verify a match straddling two scan windows is found") {
+        spec.string_table_size_ = 3 << 20;
+        write_elf(spec, file_name);
+        ElfFile elf_file(file_name);
+        Section_STRTAB const* strtab = nullptr;
+        std::uint32_t strtab_index = 0;
+        for (std::uint32_t i = 0; i < elf_file.section_table().section_count(); ++i)
+        {
+            if (auto const* symtab = dynamic_cast<Section_SYMTAB const*>(&elf_file.section(i)))
+            {
+                strtab = &symtab->string_table();
+                strtab_index = symtab->link();
+            }
+        }
+        REQUIRE(strtab != nullptr);
+
+        // Strings are scanned a megabyte at a time.
+        std::string_view table = strtab->table_bytes();
+        std::size_t const boundary = 1 << 20;
+        std::size_t const length = 8;
+        std::size_t at = boundary - length + 1;
+        while (at < boundary && table.substr(at, length).find('\0') != std::string_view::npos)
+        {
+            ++at;
+        }
+        REQUIRE(at < boundary);
+        std::string needle(table.substr(at, length));
+        std::uint32_t start = static_cast<std::uint32_t>(table.rfind('\0', at) + 1);
+
+        auto hits = search(elf_file, needle);
+        CHECK(hit_set(hits) == expected_hits(elf_file, needle));
+        CHECK(hit_set(hits).count(Hit{SearchHit::Kind::String, strtab_index, start}) == 1);
+    }
+
+    SECTION("Verify a long scan without matches can still be cancelled") {
+        spec.string_table_size_ = 8 << 20;
+        write_elf(spec, file_name);
+        ElfFile elf_file(file_name);
+        std::size_t polls = 0;
+        CHECK(search_elf_file(elf_file, "no such name", [](SearchHit const&) { return true; },
+                              [&polls]{ ++polls; return false; }));
+        // at least once a megabyte
+        CHECK(polls >= 8);
+
+        polls = 0;
+        CHECK_FALSE(search_elf_file(elf_file, "no such name", [](SearchHit const&) { return true; },
+                                    [&polls]{ return ++polls == 2; }));
+        CHECK(polls == 2);
+    }
+
+    fs::remove(file_name);
+}
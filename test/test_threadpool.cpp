@@ -0,0 +1,116 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "test/catch.hpp"
+#include "libedhel/threadpool.h"
+
+#include <atomic>
+#include <stdexcept>
+
+
+TEST_CASE("ThreadPool functionality") {
+    SECTION("Verify every task in a group is run") {
+        ThreadPool pool(3);
+        TaskGroup group(pool);
+        std::atomic<int> count{0};
+        for (int i = 0; i < 1000; ++i)
+        {
+            group.run([&count]{ ++count; });
+        }
+        group.wait();
+        CHECK(count == 1000);
+    }
+
+    SECTION("Verify a pool without workers runs tasks while waiting") {
+        ThreadPool pool(0);
+        TaskGroup group(pool);
+        int count = 0;
+        for (int i = 0; i < 10; ++i)
+        {
+            group.run([&count]{ ++count; });
+        }
+        group.wait();
+        CHECK(count == 10);
+    }
+
+    SECTION("Verify tasks can wait on groups of their own") {
+        ThreadPool pool(2);
+        TaskGroup outer(pool);
+        std::atomic<int> count{0};
+        for (int i = 0; i < 8; ++i)
+        {
+            outer.run([&pool, &count]{
+                TaskGroup inner(pool);
+                for (int j = 0; j < 8; ++j)
+                {
+                    inner.run([&count]{ ++count; });
+                }
+                inner.wait();
+            });
+        }
+        outer.wait();
+        CHECK(count == 64);
+    }
+
+    SECTION("Verify an exception cancels the group and is rethrown") {
+        ThreadPool pool(0);
+        TaskGroup group(pool);
+        int count = 0;
+        for (int i = 0; i < 4; ++i)
+        {
+            group.run([&count]{ ++count; });
+        }
+        // a pool without workers runs its queue newest first, so this throws
+        // before any of the others get a chance to run
+        group.run([]{ throw std::runtime_error("task failed"); });
+        CHECK_THROWS_AS(group.wait(), std::runtime_error);
+        CHECK(count == 0);
+        CHECK(!group.is_cancelled());
+
+        group.run([&count]{ ++count; });
+        group.wait();
+        CHECK(count == 1);
+    }
+
+    SECTION("Verify waiting on a group runs none of another group's tasks") {
+        ThreadPool pool(0);
+        TaskGroup mine(pool);
+        TaskGroup theirs(pool);
+        int my_count = 0;
+        int their_count = 0;
+        theirs.run([&their_count]{ ++their_count; });
+        mine.run([&my_count]{ ++my_count; });
+        theirs.run([&their_count]{ ++their_count; });
+        mine.wait();
+        CHECK(my_count == 1);
+        CHECK(their_count == 0);
+        theirs.wait();
+        CHECK(their_count == 2);
+    }
+
+    SECTION("Verify cancelled tasks are skipped") {
+        ThreadPool pool(0);
+        TaskGroup group(pool);
+        int count = 0;
+        group.run([&count]{ ++count; });
+        group.cancel();
+        CHECK(group.is_cancelled());
+        group.wait();
+        CHECK(count == 0);
+    }
+}
@@ -0,0 +1,99 @@
+/*
+ * Copyright 2020  Stephen M. Webb <stephen.webb@bregmasoft.ca>
+ * 
+ * This file is part of Edhelind.
+ * 
+ * Edhelind is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ * 
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ * 
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#include "test/catch.hpp"
+#include "libedhel/trace.h"
+
+#include <cstdio>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+
+
+TEST_CASE("Trace functionality") {
+    std::string file_name = (std::filesystem::temp_directory_path() / "edhelind_test_trace.json").string();
+
+#if defined(EDHELIND_TRACING)
+    SECTION("Verify zones on several threads are written out") {
+        REQUIRE(trace_start(file_name));
+        {
+            EDHEL_TRACE_ZONE("outer zone", std::string("a \"quoted\" detail"));
+            std::thread thread([] { EDHEL_TRACE_ZONE("thread zone"); });
+            thread.join();
+        }
+        REQUIRE(trace_stop());
+
+        std::ifstream trace(file_name);
+        std::stringstream contents;
+        contents << trace.rdbuf();
+        CHECK(contents.str().find("\"traceEvents\"") != std::string::npos);
+        CHECK(contents.str().find("\"name\":\"outer zone\"") != std::string::npos);
+        CHECK(contents.str().find("\"detail\":\"a \\\"quoted\\\" detail\"") != std::string::npos);
+        CHECK(contents.str().find("\"name\":\"thread zone\"") != std::string::npos);
+        CHECK(!trace_stop());
+        std::remove(file_name.c_str());
+    }
+
+    SECTION("Verify zones outside a trace are not recorded") {
+        {
+            EDHEL_TRACE_ZONE("untraced zone");
+        }
+        REQUIRE(trace_start(file_name));
+        REQUIRE(trace_stop());
+
+        std::ifstream trace(file_name);
+        std::stringstream contents;
+        contents << trace.rdbuf();
+        CHECK(contents.str().find("untraced zone") == std::string::npos);
+        std::remove(file_name.c_str());
+    }
+
+    SECTION("Verify a zone's detail is only made while tracing") {
+        int details_made = 0;
+        auto detail = [&details_made]() {
+            ++details_made;
+            return std::string("made detail");
+        };
+        {
+            EDHEL_TRACE_ZONE("untraced zone", detail());
+        }
+        CHECK(details_made == 0);
+
+        REQUIRE(trace_start(file_name));
+        {
+            EDHEL_TRACE_ZONE("traced zone", detail());
+        }
+        REQUIRE(trace_stop());
+        CHECK(details_made == 1);
+
+        std::ifstream trace(file_name);
+        std::stringstream contents;
+        contents << trace.rdbuf();
+        CHECK(contents.str().find("\"detail\":\"made detail\"") != std::string::npos);
+        std::remove(file_name.c_str());
+    }
+#else
+    SECTION("Verify tracing reports it is not available") {
+        EDHEL_TRACE_ZONE("compiled out");
+        CHECK(!trace_start(file_name));
+        CHECK(!trace_stop());
+    }
+#endif
+}